@@ -8,6 +8,8 @@ abt_sources += \
 	arch/abtd_affinity_parser.c \
 	arch/abtd_env.c \
 	arch/abtd_futex.c \
+	arch/abtd_membarrier.c \
+	arch/abtd_stack_grow.c \
 	arch/abtd_stream.c \
 	arch/abtd_time.c \
 	arch/abtd_ythread.c
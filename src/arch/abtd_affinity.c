@@ -181,10 +181,29 @@ typedef cpuset_t cpu_set_t;
 #endif
 #endif /* HAVE_PTHREAD_SETAFFINITY_NP */
 
+#ifdef __linux__
+#include <dirent.h>
+#endif
+
+/* Location of a CPU.  -1 means unknown. */
+typedef struct {
+    int core_id;
+    int package_id;
+    int llc_id;
+    int node_id;
+} cpu_topology;
+
 typedef struct {
     ABTD_affinity_cpuset initial_cpuset;
     uint32_t num_cpusets;
     ABTD_affinity_cpuset *cpusets;
+    /* topologies[i] is the topology of initial_cpuset.cpuids[i].  NULL if not
+     * available. */
+    cpu_topology *topologies;
+    /* OS node IDs of NUMA nodes that have CPUs in initial_cpuset.  The index of
+     * this array is used as a node index.  NULL if not available. */
+    int num_nodes;
+    int *node_ids;
 } global_affinity;
 
 static global_affinity g_affinity;
@@ -293,11 +312,121 @@ ABTU_ret_err static int apply_cpuset(pthread_t native_thread,
 #endif
 }
 
+static int read_sysfs_int(const char *path)
+{
+    int val = -1;
+    FILE *p_file = fopen(path, "r");
+    if (p_file) {
+        if (fscanf(p_file, "%d", &val) != 1)
+            val = -1;
+        fclose(p_file);
+    }
+    return val;
+}
+
+static void read_cpu_topology(int cpuid, cpu_topology *p_topology)
+{
+    p_topology->core_id = -1;
+    p_topology->package_id = -1;
+    p_topology->llc_id = -1;
+    p_topology->node_id = -1;
+#ifdef __linux__
+    char path[128];
+    const char *cpu_dir = "/sys/devices/system/cpu";
+    snprintf(path, sizeof(path), "%s/cpu%d/topology/core_id", cpu_dir, cpuid);
+    p_topology->core_id = read_sysfs_int(path);
+    snprintf(path, sizeof(path), "%s/cpu%d/topology/physical_package_id",
+             cpu_dir, cpuid);
+    p_topology->package_id = read_sysfs_int(path);
+    snprintf(path, sizeof(path), "%s/cpu%d/cache/index3/level", cpu_dir, cpuid);
+    if (read_sysfs_int(path) == 3) {
+        snprintf(path, sizeof(path), "%s/cpu%d/cache/index3/id", cpu_dir,
+                 cpuid);
+        p_topology->llc_id = read_sysfs_int(path);
+    }
+    /* The CPU directory has a link named "node<N>". */
+    snprintf(path, sizeof(path), "%s/cpu%d", cpu_dir, cpuid);
+    DIR *p_dir = opendir(path);
+    if (p_dir) {
+        struct dirent *p_ent;
+        while ((p_ent = readdir(p_dir)) != NULL) {
+            int node_id;
+            if (sscanf(p_ent->d_name, "node%d", &node_id) == 1) {
+                p_topology->node_id = node_id;
+                break;
+            }
+        }
+        closedir(p_dir);
+    }
+#endif
+}
+
+static const cpu_topology *get_cpu_topology(int cpuid)
+{
+    if (g_affinity.topologies) {
+        size_t i;
+        for (i = 0; i < g_affinity.initial_cpuset.num_cpuids; i++) {
+            if (g_affinity.initial_cpuset.cpuids[i] == cpuid)
+                return &g_affinity.topologies[i];
+        }
+    }
+    return NULL;
+}
+
+static void init_node_ids(void)
+{
+    g_affinity.num_nodes = 0;
+    g_affinity.node_ids = NULL;
+    if (!g_affinity.topologies)
+        return;
+    size_t i;
+    int j, num_nodes = 0;
+    int *node_ids;
+    /* The node information is optional, so ignore an allocation failure. */
+    int ret = ABTU_malloc(sizeof(int) * g_affinity.initial_cpuset.num_cpuids,
+                          (void **)&node_ids);
+    if (ret != ABT_SUCCESS)
+        return;
+    for (i = 0; i < g_affinity.initial_cpuset.num_cpuids; i++) {
+        int node_id = g_affinity.topologies[i].node_id;
+        if (node_id == -1)
+            continue;
+        for (j = 0; j < num_nodes; j++) {
+            if (node_ids[j] == node_id)
+                break;
+        }
+        if (j == num_nodes)
+            node_ids[num_nodes++] = node_id;
+    }
+    if (num_nodes == 0) {
+        ABTU_free(node_ids);
+        return;
+    }
+    g_affinity.num_nodes = num_nodes;
+    g_affinity.node_ids = node_ids;
+}
+
+static int get_cpu_node(int cpuid)
+{
+    const cpu_topology *p_topology = get_cpu_topology(cpuid);
+    if (p_topology && p_topology->node_id != -1) {
+        int i;
+        for (i = 0; i < g_affinity.num_nodes; i++) {
+            if (g_affinity.node_ids[i] == p_topology->node_id)
+                return i;
+        }
+    }
+    return -1;
+}
+
 void ABTD_affinity_init(ABTI_global *p_global, const char *affinity_str)
 {
     g_affinity.num_cpusets = 0;
     g_affinity.cpusets = NULL;
     g_affinity.initial_cpuset.cpuids = NULL;
+    g_affinity.topologies = NULL;
+    g_affinity.num_nodes = 0;
+    g_affinity.node_ids = NULL;
     pthread_t self_native_thread = pthread_self();
     ABTD_affinity_list *p_list = NULL;
 
@@ -310,6 +439,19 @@ void ABTD_affinity_init(ABTI_global *p_global, const char *affinity_str)
     if (ret != ABT_SUCCESS || g_affinity.initial_cpuset.num_cpuids == 0)
         goto FAILED;
     p_global->set_affinity = ABT_TRUE;
+    /* The topology is optional, so ignore an allocation failure. */
+    ret = ABTU_malloc(sizeof(cpu_topology) *
+                          g_affinity.initial_cpuset.num_cpuids,
+                      (void **)&g_affinity.topologies);
+    if (ret == ABT_SUCCESS) {
+        for (i = 0; i < g_affinity.initial_cpuset.num_cpuids; i++) {
+            read_cpu_topology(g_affinity.initial_cpuset.cpuids[i],
+                              &g_affinity.topologies[i]);
+        }
+    } else {
+        g_affinity.topologies = NULL;
+    }
+    init_node_ids();
     ret = ABTD_affinity_list_create(affinity_str, &p_list);
     if (ret == ABT_SUCCESS) {
         if (p_list->num == 0) {
@@ -397,6 +539,11 @@ FAILED:
     g_affinity.num_cpusets = 0;
     ABTU_free(g_affinity.cpusets);
     g_affinity.cpusets = NULL;
+    ABTU_free(g_affinity.topologies);
+    g_affinity.topologies = NULL;
+    ABTU_free(g_affinity.node_ids);
+    g_affinity.node_ids = NULL;
+    g_affinity.num_nodes = 0;
     p_global->set_affinity = ABT_FALSE;
     return;
 }
@@ -422,6 +569,11 @@ void ABTD_affinity_finalize(ABTI_global *p_global)
         ABTU_free(g_affinity.cpusets);
         g_affinity.cpusets = NULL;
         g_affinity.num_cpusets = 0;
+        ABTU_free(g_affinity.topologies);
+        g_affinity.topologies = NULL;
+        ABTU_free(g_affinity.node_ids);
+        g_affinity.node_ids = NULL;
+        g_affinity.num_nodes = 0;
     }
 }
 
@@ -447,6 +599,66 @@ ABTU_ret_err int ABTD_affinity_cpuset_apply_default(ABTD_xstream_context *p_ctx,
     return apply_cpuset(p_ctx->native_thread, p_cpuset);
 }
 
+ABTD_affinity_distance ABTD_affinity_get_distance(int cpuid1, int cpuid2)
+{
+    if (cpuid1 == cpuid2)
+        return ABTD_AFFINITY_DISTANCE_CORE;
+    const cpu_topology *p_topo1 = get_cpu_topology(cpuid1);
+    const cpu_topology *p_topo2 = get_cpu_topology(cpuid2);
+    if (!p_topo1 || !p_topo2)
+        return ABTD_AFFINITY_DISTANCE_REMOTE;
+    if (p_topo1->package_id == p_topo2->package_id) {
+        if (p_topo1->core_id != -1 && p_topo1->core_id == p_topo2->core_id)
+            return ABTD_AFFINITY_DISTANCE_CORE;
+        if (p_topo1->llc_id != -1 && p_topo1->llc_id == p_topo2->llc_id)
+            return ABTD_AFFINITY_DISTANCE_CACHE;
+    }
+    if (p_topo1->node_id != -1 && p_topo1->node_id == p_topo2->node_id)
+        return ABTD_AFFINITY_DISTANCE_CACHE;
+    if (p_topo1->llc_id == -1 && p_topo1->node_id == -1 &&
+        p_topo1->package_id != -1 &&
+        p_topo1->package_id == p_topo2->package_id) {
+        /* Only the package information is available. */
+        return ABTD_AFFINITY_DISTANCE_CACHE;
+    }
+    return ABTD_AFFINITY_DISTANCE_REMOTE;
+}
+
+int ABTD_affinity_get_num_nodes(void)
+{
+    return g_affinity.num_nodes > 0 ? g_affinity.num_nodes : 1;
+}
+
+int ABTD_affinity_get_node_id(int node)
+{
+    if (node < 0 || node >= g_affinity.num_nodes)
+        return -1;
+    return g_affinity.node_ids[node];
+}
+
+int ABTD_affinity_cpuset_get_node(const ABTD_affinity_cpuset *p_cpuset)
+{
+    /* Return the node of the first CPU whose node is known.  An empty cpuset
+     * means the initial one. */
+    const ABTD_affinity_cpuset *p_target =
+        p_cpuset->num_cpuids ? p_cpuset : &g_affinity.initial_cpuset;
+    size_t i;
+    for (i = 0; i < p_target->num_cpuids; i++) {
+        int node = get_cpu_node(p_target->cpuids[i]);
+        if (node != -1)
+            return node;
+    }
+    return -1;
+}
+
+int ABTD_affinity_get_default_node(int rank)
+{
+    if (g_affinity.num_cpusets == 0)
+        return -1;
+    return ABTD_affinity_cpuset_get_node(
+        &g_affinity.cpusets[rank % g_affinity.num_cpusets]);
+}
+
 void ABTD_affinity_cpuset_destroy(ABTD_affinity_cpuset *p_cpuset)
 {
     if (p_cpuset) {
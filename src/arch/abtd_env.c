@@ -19,6 +19,9 @@
 #define ABTD_MEM_MAX_NUM_STACKS 1024
 #define ABTD_MEM_MAX_TOTAL_STACK_SIZE (64 * 1024 * 1024)
 #define ABTD_MEM_MAX_NUM_DESCS 4096
+#define ABTD_MEM_NUM_LOCAL_BUCKETS 2
+#define ABTD_MEM_MAX_STACK_CLASS_SIZE (1024 * 1024)
+#define ABTD_STACK_USAGE_KEEP_SIZE (8 * 1024)
 
 /* To avoid potential overflow, we intentionally use a smaller value than the
  * real limit. */
@@ -90,13 +93,42 @@ void ABTD_env_init(ABTI_global *p_global)
     /* Default nanoseconds for scheduler sleep */
     p_global->sched_sleep_nsec = ABTD_env_get_sched_sleep_nsec();
 
+#ifdef ABT_CONFIG_USE_MEM_POOL
+    /* ABT_STACK_GROW_MAX_SIZE, ABT_ENV_STACK_GROW_MAX_SIZE
+     * Maximum size of growable ULT stacks.  If it is larger than the default
+     * ULT stack size, each stack of the default size reserves this size, but
+     * only the default size from its top is writable at first.  Pages below
+     * it are made writable when a ULT writes to them and made read-only again
+     * when the stack is returned to a memory pool.  Since the protected pages
+     * stay readable, only writes make a stack grow.  The bottom page of a
+     * growable stack is always protected by its memory pool regardless of
+     * ABT_STACK_OVERFLOW_CHECK.  The default ULT stack size becomes this size.
+     * 0 disables growable stacks. */
+    const size_t stack_grow_commit_size =
+        ABTU_roundup_size(p_global->thread_stacksize, p_global->sys_page_size);
+    const size_t stack_grow_max_size =
+        ABTU_roundup_size(load_env_size("STACK_GROW_MAX_SIZE", 0, 0,
+                                        ABTD_ENV_SIZE_MAX),
+                          p_global->sys_page_size);
+    if (stack_grow_max_size >
+        stack_grow_commit_size + p_global->sys_page_size) {
+        p_global->stack_grow_commit_size = stack_grow_commit_size;
+        p_global->thread_stacksize = stack_grow_max_size;
+    } else {
+        p_global->stack_grow_commit_size = 0;
+    }
+#endif
+
     /* ABT_MUTEX_MAX_HANDOVERS, ABT_ENV_MUTEX_MAX_HANDOVERS
-     * Default maximum number of mutex handover */
+     * Maximum number of consecutive handovers of a mutex.  After this number
+     * of handovers, unlock releases the mutex and wakes up waiters. */
     p_global->mutex_max_handovers =
         load_env_uint32("MUTEX_MAX_HANDOVERS", 64, 1, ABTD_ENV_UINT32_MAX);
 
     /* ABT_MUTEX_MAX_WAKEUPS, ABT_ENV_MUTEX_MAX_WAKEUPS
-     * Default maximum number of mutex wakeup operations */
+     * Maximum number of waiting ULTs that unlock wakes up when it releases a
+     * mutex without a handover.  Waiting external threads are always woken
+     * up, and tasklets do not wait on the waiter list. */
     p_global->mutex_max_wakeups =
         load_env_uint32("MUTEX_MAX_WAKEUPS", 1, 1, ABTD_ENV_UINT32_MAX);
 
@@ -133,6 +165,15 @@ void ABTD_env_init(ABTI_global *p_global)
                                         ABTD_ENV_SIZE_MAX),
                           ABT_CONFIG_STATIC_CACHELINE_SIZE);
 
+    /* ABT_MEM_NUM_LOCAL_BUCKETS, ABT_ENV_MEM_NUM_LOCAL_BUCKETS
+     * Number of buckets that each ES keeps in each memory pool.  Each bucket of
+     * the stack pool (the descriptor pool) has ABT_MEM_MAX_NUM_STACKS
+     * (ABT_MEM_MAX_NUM_DESCS) divided by this number of elements, so a larger
+     * value makes an ES exchange smaller buckets with the global pool. */
+    p_global->mem_num_local_buckets =
+        load_env_uint32("MEM_NUM_LOCAL_BUCKETS", ABTD_MEM_NUM_LOCAL_BUCKETS, 2,
+                        ABT_MEM_POOL_MAX_LOCAL_BUCKETS);
+
     /* ABT_MEM_MAX_NUM_STACKS, ABT_ENV_MEM_MAX_NUM_STACKS
      * Maximum number of stacks that each ES can keep during execution. */
     /* If each execution stream caches too many stacks in total, let's reduce
@@ -141,23 +182,91 @@ void ABTD_env_init(ABTI_global *p_global)
         ABTU_min_uint32(ABTD_MEM_MAX_TOTAL_STACK_SIZE /
                             p_global->thread_stacksize,
                         ABTD_MEM_MAX_NUM_STACKS);
-    /* The value must be a multiple of ABT_MEM_POOL_MAX_LOCAL_BUCKETS. */
+    /* The value must be a multiple of mem_num_local_buckets. */
     p_global->mem_max_stacks =
         ABTU_roundup_uint32(load_env_uint32("MEM_MAX_NUM_STACKS",
                                             default_mem_max_stacks,
-                                            ABT_MEM_POOL_MAX_LOCAL_BUCKETS,
+                                            p_global->mem_num_local_buckets,
                                             ABTD_ENV_UINT32_MAX),
-                            ABT_MEM_POOL_MAX_LOCAL_BUCKETS);
+                            p_global->mem_num_local_buckets);
 
     /* ABT_MEM_MAX_NUM_DESCS, ABT_ENV_MEM_MAX_NUM_DESCS
      * Maximum number of descriptors that each ES can keep during execution */
-    /* The value must be a multiple of ABT_MEM_POOL_MAX_LOCAL_BUCKETS. */
+    /* The value must be a multiple of mem_num_local_buckets. */
     p_global->mem_max_descs =
         ABTU_roundup_uint32(load_env_uint32("MEM_MAX_NUM_DESCS",
                                             ABTD_MEM_MAX_NUM_DESCS,
-                                            ABT_MEM_POOL_MAX_LOCAL_BUCKETS,
+                                            p_global->mem_num_local_buckets,
                                             ABTD_ENV_UINT32_MAX),
-                            ABT_MEM_POOL_MAX_LOCAL_BUCKETS);
+                            p_global->mem_num_local_buckets);
+
+    /* ABT_MEM_REMOTE_FREE, ABT_ENV_MEM_REMOTE_FREE
+     * If it is true, stacks and descriptors that are freed by a thread other
+     * than the ES that allocated them are returned to that ES through a
+     * lock-free list instead of being cached by the freeing thread.  Each list
+     * holds at most as many elements as the ES can keep. */
+    p_global->mem_remote_free = load_env_bool("MEM_REMOTE_FREE", ABT_FALSE);
+
+    /* ABT_MEM_SHARDED_LIFO, ABT_ENV_MEM_SHARDED_LIFO
+     * If it is true, global memory pools keep buckets in LIFOs that consist of
+     * multiple spinlock-protected shards instead of a single LIFO.  This
+     * reduces contention when many ESs exchange buckets at the same time.  It
+     * is enabled by default if a lock-free LIFO is not available since the
+     * single LIFO is then protected by a single lock. */
+#if ABTD_ATOMIC_SUPPORT_TAGGED_PTR
+    const ABT_bool default_mem_sharded_lifo = ABT_FALSE;
+#else
+    const ABT_bool default_mem_sharded_lifo = ABT_TRUE;
+#endif
+    p_global->mem_sharded_lifo =
+        load_env_bool("MEM_SHARDED_LIFO", default_mem_sharded_lifo);
+
+    /* ABT_MEM_NUM_NODES, ABT_ENV_MEM_NUM_NODES
+     * Number of NUMA nodes that memory pools emulate.  If it is positive, ESs
+     * are assigned to the nodes in a round-robin manner by their ranks
+     * regardless of the CPU topology.  0 uses the NUMA nodes of the CPU
+     * topology. */
+    p_global->mem_num_nodes =
+        load_env_int("MEM_NUM_NODES", 0, 0, ABT_MEM_POOL_MAX_NODES);
+
+    /* ABT_MEM_MAX_STACK_CLASS_SIZE, ABT_ENV_MEM_MAX_STACK_CLASS_SIZE
+     * Maximum stack size that is taken from a memory pool of a stack size
+     * class.  A larger non-default stack is allocated by malloc().  0 disables
+     * stack size classes. */
+    p_global->mem_max_stack_class_size =
+        load_env_size("MEM_MAX_STACK_CLASS_SIZE", ABTD_MEM_MAX_STACK_CLASS_SIZE,
+                      0,
+                      ((size_t)1) << (ABTI_MEM_STACK_CLASS_MIN_SHIFT +
+                                      ABTI_MEM_NUM_STACK_CLASSES - 1));
+
+    /* ABT_MEM_TRIM_HIGH_WATER, ABT_ENV_MEM_TRIM_HIGH_WATER
+     * Total size of memory pool pages above which execution streams
+     * periodically return idle pages to the OS.  0 disables the background
+     * trimming.  ABT_mem_trim() is available regardless of this value. */
+    p_global->mem_trim_high_water =
+        load_env_size("MEM_TRIM_HIGH_WATER", 0, 0, ABTD_ENV_SIZE_MAX);
+
+    /* ABT_STACK_USAGE_SAMPLING, ABT_ENV_STACK_USAGE_SAMPLING
+     * Track the usage of one in N ULT stacks taken from memory pools.  A
+     * tracked stack is filled with a watermark pattern, so a smaller value
+     * gives more accurate statistics at a higher cost.  0 disables tracking. */
+    p_global->stack_usage_sampling =
+        load_env_uint32("STACK_USAGE_SAMPLING", 0, 0, ABTD_ENV_UINT32_MAX);
+    if (p_global->stack_grow_commit_size) {
+        /* A watermark pattern cannot be written to inaccessible pages of
+         * growable stacks. */
+        p_global->stack_usage_sampling = 0;
+    }
+
+    /* ABT_STACK_USAGE_KEEP_SIZE, ABT_ENV_STACK_USAGE_KEEP_SIZE
+     * When a tracked stack is returned to a memory pool, pages of the stack
+     * beyond this size from the stack top are returned to the OS.  Only tracked
+     * stacks are released since the depth of the other stacks is unknown, so
+     * dirty tails of untracked stacks stay until ABT_mem_trim() or the
+     * background trimming releases them in the pool. */
+    p_global->stack_usage_keep_size =
+        load_env_size("STACK_USAGE_KEEP_SIZE", ABTD_STACK_USAGE_KEEP_SIZE, 0,
+                      ABTD_ENV_SIZE_MAX);
 
     /* ABT_MEM_LP_ALLOC, ABT_ENV_MEM_LP_ALLOC
      * How to allocate large pages.  The default is to use mmap() for huge
@@ -218,6 +327,21 @@ void ABTD_env_init(ABTI_global *p_global)
     } else {
         p_global->mem_lp_alloc = lp_alloc;
     }
+
+    /* ABT_MEM_PREALLOC_THREADS, ABT_ENV_MEM_PREALLOC_THREADS
+     * Number of ULTs whose stacks and descriptors are allocated and touched in
+     * ABT_init(), so creating up to this number of ULTs neither allocates
+     * memory nor causes a page fault.  Note that trimming releases idle
+     * preallocated memory as well. */
+    p_global->mem_prealloc_threads =
+        load_env_uint32("MEM_PREALLOC_THREADS", 0, 0, ABTD_ENV_UINT32_MAX);
+
+    /* ABT_MEM_PREALLOC_STRICT, ABT_ENV_MEM_PREALLOC_STRICT
+     * If it is true, ABT_init() fails with ABT_ERR_MEM when preallocated pages
+     * are not of the first large page type of ABT_MEM_LP_ALLOC (e.g., when
+     * huge pages run out) instead of silently using the fallback type. */
+    p_global->mem_prealloc_strict =
+        load_env_bool("MEM_PREALLOC_STRICT", ABT_FALSE);
 #endif
 
     /* Whether to print the configuration on ABT_init() */
@@ -0,0 +1,49 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include "abti.h"
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/syscall.h>
+#endif
+
+/* The following is taken from <linux/membarrier.h> so that Argobots builds
+ * with old kernel headers. */
+#define ABTD_MEMBARRIER_CMD_QUERY 0
+#define ABTD_MEMBARRIER_CMD_PRIVATE_EXPEDITED (1 << 3)
+#define ABTD_MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED (1 << 4)
+
+/* Check if membarrier() can make every running thread of this process execute
+ * a full memory barrier.  If so, a fence on a frequent path can be replaced by
+ * a compiler barrier as long as the paired, infrequent path calls
+ * ABTD_membarrier_heavy(). */
+void ABTD_membarrier_init(ABTI_global *p_global)
+{
+    p_global->use_membarrier = ABT_FALSE;
+#if defined(__linux__) && defined(SYS_membarrier)
+    long cmds = syscall(SYS_membarrier, ABTD_MEMBARRIER_CMD_QUERY, 0);
+    if (cmds < 0 || !(cmds & ABTD_MEMBARRIER_CMD_PRIVATE_EXPEDITED) ||
+        !(cmds & ABTD_MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED))
+        return;
+    if (syscall(SYS_membarrier, ABTD_MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED,
+                0) != 0)
+        return;
+    p_global->use_membarrier = ABT_TRUE;
+#endif
+}
+
+/* Make all the running threads of this process execute a full memory barrier.
+ * This must be called only if ABTD_membarrier_init() has enabled
+ * use_membarrier. */
+void ABTD_membarrier_heavy(void)
+{
+#if defined(__linux__) && defined(SYS_membarrier)
+    if (syscall(SYS_membarrier, ABTD_MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0) == 0)
+        return;
+#endif
+    /* Unreachable once registered, but keep this thread's side correct. */
+    ABTD_atomic_seq_cst_mem_barrier();
+}
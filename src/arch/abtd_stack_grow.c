@@ -0,0 +1,175 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include "abti.h"
+#include <signal.h>
+#include <string.h>
+
+/* Growable ULT stacks.  Protected pages of a growable stack are made writable
+ * by a SIGSEGV handler when a ULT writes to them.  ABTU_mprotect() leaves
+ * protected pages readable, so reading them does not make the stack grow.  The
+ * handler runs on an alternate signal stack of each execution stream since the
+ * stack of the faulting ULT has no space for it. */
+
+#ifdef ABT_CONFIG_USE_MEM_POOL
+
+/* SIGSTKSZ is not a constant on some systems. */
+#define ABTD_STACK_GROW_SIGALTSTACK_SIZE (64 * 1024)
+/* Size that is additionally made accessible below a fault address to avoid a
+ * fault per page. */
+#define ABTD_STACK_GROW_CHUNK_SIZE (64 * 1024)
+
+static ABT_bool g_stack_grow_initialized = ABT_FALSE;
+static struct sigaction g_stack_grow_old_action;
+static ABTD_XSTREAM_LOCAL void *lp_sigaltstack = NULL;
+
+/* This function must be async-signal-safe. */
+static ABT_bool stack_grow_commit(void *addr)
+{
+    ABTI_global *p_global = ABTI_global_get_global_or_null();
+    if (!p_global || !p_global->stack_grow_commit_size)
+        return ABT_FALSE;
+    ABTI_xstream *p_local_xstream =
+        ABTI_local_get_xstream_or_null(ABTI_local_get_local_uninlined());
+    if (!p_local_xstream)
+        return ABT_FALSE;
+    ABTI_thread *p_thread = p_local_xstream->p_thread;
+    if (!p_thread ||
+        !(p_thread->type &
+          (ABTI_THREAD_TYPE_MEM_MEMPOOL_DESC_STACK |
+           ABTI_THREAD_TYPE_MEM_MEMPOOL_DESC_MEMPOOL_LAZY_STACK |
+           ABTI_THREAD_TYPE_MEM_MALLOC_DESC_MEMPOOL_LAZY_STACK)))
+        return ABT_FALSE;
+    /* Only stacks of the default size are growable. */
+    ABTI_ythread *p_ythread = ABTI_thread_get_ythread(p_thread);
+    void *p_stacktop = ABTD_ythread_context_get_stacktop(&p_ythread->ctx);
+    size_t stacksize = ABTD_ythread_context_get_stacksize(&p_ythread->ctx);
+    if (!p_stacktop || !ABTI_mem_is_growable_stack(p_global, stacksize))
+        return ABT_FALSE;
+    char *p_begin, *p_end;
+    ABTI_mem_get_stack_grow_range(p_global, p_stacktop, stacksize, &p_begin,
+                                  &p_end);
+    if ((uintptr_t)addr < (uintptr_t)p_begin ||
+        (uintptr_t)addr >= (uintptr_t)p_end)
+        return ABT_FALSE;
+    /* Make all the pages between the fault address and the accessible part
+     * accessible since the stack grows downward. */
+    char *p_fault_page =
+        (char *)(((uintptr_t)addr) & ~(uintptr_t)(p_global->sys_page_size - 1));
+    char *p_commit = p_begin;
+    if ((size_t)(p_fault_page - p_begin) > ABTD_STACK_GROW_CHUNK_SIZE)
+        p_commit = p_fault_page - ABTD_STACK_GROW_CHUNK_SIZE;
+    if (ABTU_mprotect(p_commit, p_end - p_commit, ABT_FALSE) != ABT_SUCCESS)
+        return ABT_FALSE;
+    p_thread->type |= ABTI_THREAD_TYPE_STACK_GROWN;
+    return ABT_TRUE;
+}
+
+static void stack_grow_sigsegv_handler(int sig, siginfo_t *p_info,
+                                       void *p_ucontext)
+{
+    if (stack_grow_commit(p_info->si_addr))
+        return;
+    /* This fault is not caused by stack growth. */
+    if (g_stack_grow_old_action.sa_flags & SA_SIGINFO) {
+        g_stack_grow_old_action.sa_sigaction(sig, p_info, p_ucontext);
+    } else if (g_stack_grow_old_action.sa_handler == SIG_DFL ||
+               g_stack_grow_old_action.sa_handler == SIG_IGN) {
+        /* The faulting instruction is executed again and raises SIGSEGV with
+         * the default action. */
+        signal(sig, SIG_DFL);
+    } else {
+        g_stack_grow_old_action.sa_handler(sig);
+    }
+}
+
+ABTU_ret_err int ABTD_stack_grow_init(void)
+{
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_sigaction = stack_grow_sigsegv_handler;
+    action.sa_flags = SA_SIGINFO | SA_ONSTACK;
+    sigemptyset(&action.sa_mask);
+    if (sigaction(SIGSEGV, &action, &g_stack_grow_old_action) != 0)
+        ABTI_HANDLE_ERROR(ABT_ERR_SYS);
+    g_stack_grow_initialized = ABT_TRUE;
+    /* The caller is the primary execution stream. */
+    int abt_errno = ABTD_stack_grow_init_thread();
+    if (abt_errno != ABT_SUCCESS) {
+        ABTD_stack_grow_finalize();
+        ABTI_HANDLE_ERROR(abt_errno);
+    }
+    return ABT_SUCCESS;
+}
+
+void ABTD_stack_grow_finalize(void)
+{
+    if (!g_stack_grow_initialized)
+        return;
+    ABTD_stack_grow_finalize_thread();
+    int ret = sigaction(SIGSEGV, &g_stack_grow_old_action, NULL);
+    ABTI_ASSERT(ret == 0);
+    g_stack_grow_initialized = ABT_FALSE;
+}
+
+ABTU_ret_err int ABTD_stack_grow_init_thread(void)
+{
+    ABTI_global *p_global = ABTI_global_get_global();
+    if (!p_global->stack_grow_commit_size)
+        return ABT_SUCCESS;
+    stack_t ss;
+    if (sigaltstack(NULL, &ss) == 0 && !(ss.ss_flags & SS_DISABLE)) {
+        /* This thread already has an alternate signal stack. */
+        return ABT_SUCCESS;
+    }
+    void *p_stack;
+    int abt_errno =
+        ABTU_malloc(ABTD_STACK_GROW_SIGALTSTACK_SIZE, (void **)&p_stack);
+    ABTI_CHECK_ERROR(abt_errno);
+    ss.ss_sp = p_stack;
+    ss.ss_size = ABTD_STACK_GROW_SIGALTSTACK_SIZE;
+    ss.ss_flags = 0;
+    if (sigaltstack(&ss, NULL) != 0) {
+        ABTU_free(p_stack);
+        ABTI_HANDLE_ERROR(ABT_ERR_SYS);
+    }
+    lp_sigaltstack = p_stack;
+    return ABT_SUCCESS;
+}
+
+void ABTD_stack_grow_finalize_thread(void)
+{
+    if (!lp_sigaltstack)
+        return;
+    stack_t ss;
+    memset(&ss, 0, sizeof(ss));
+    ss.ss_flags = SS_DISABLE;
+    int ret = sigaltstack(&ss, NULL);
+    ABTI_ASSERT(ret == 0);
+    ABTU_free(lp_sigaltstack);
+    lp_sigaltstack = NULL;
+}
+
+#else /* !ABT_CONFIG_USE_MEM_POOL */
+
+ABTU_ret_err int ABTD_stack_grow_init(void)
+{
+    return ABT_SUCCESS;
+}
+
+void ABTD_stack_grow_finalize(void)
+{
+}
+
+ABTU_ret_err int ABTD_stack_grow_init_thread(void)
+{
+    return ABT_SUCCESS;
+}
+
+void ABTD_stack_grow_finalize_thread(void)
+{
+}
+
+#endif /* !ABT_CONFIG_USE_MEM_POOL */
@@ -10,7 +10,17 @@ static void *xstream_context_thread_func(void *arg)
     ABTD_xstream_context *p_ctx = (ABTD_xstream_context *)arg;
     void *(*thread_f)(void *) = p_ctx->thread_f;
     void *p_arg = p_ctx->p_arg;
-    ABTI_ASSERT(p_ctx->state == ABTD_XSTREAM_CONTEXT_STATE_RUNNING);
+    /* Report the result of the initialization of this thread to
+     * ABTD_xstream_context_create(), which is waiting for it. */
+    int abt_errno = ABTD_stack_grow_init_thread();
+    pthread_mutex_lock(&p_ctx->state_lock);
+    ABTI_ASSERT(p_ctx->state == ABTD_XSTREAM_CONTEXT_STATE_INIT);
+    p_ctx->init_abt_errno = abt_errno;
+    p_ctx->state = ABTD_XSTREAM_CONTEXT_STATE_RUNNING;
+    pthread_cond_signal(&p_ctx->state_cond);
+    pthread_mutex_unlock(&p_ctx->state_lock);
+    if (abt_errno != ABT_SUCCESS)
+        return NULL;
     while (1) {
         /* Execute a main execution stream function. */
         thread_f(p_arg);
@@ -42,6 +52,7 @@ static void *xstream_context_thread_func(void *arg)
         if (!restart)
             break;
     }
+    ABTD_stack_grow_finalize_thread();
     return NULL;
 }
 
@@ -55,8 +66,8 @@ ABTU_ret_err int ABTD_xstream_context_create(void *(*f_xstream)(void *),
      * updated with a lock in the other places.  This assumption is wrong.  The
      * following suppresses a false positive. */
     /* coverity[missing_lock] */
-    p_ctx->state = ABTD_XSTREAM_CONTEXT_STATE_RUNNING;
-    int ret, init_stage = 0;
+    p_ctx->state = ABTD_XSTREAM_CONTEXT_STATE_INIT;
+    int ret, abt_errno = ABT_ERR_SYS, init_stage = 0;
     ret = pthread_mutex_init(&p_ctx->state_lock, NULL);
     if (ret != 0)
         goto FAILED;
@@ -71,6 +82,20 @@ ABTU_ret_err int ABTD_xstream_context_create(void *(*f_xstream)(void *),
                          xstream_context_thread_func, p_ctx);
     if (ret != 0)
         goto FAILED;
+
+    /* Wait until the new thread initializes itself. */
+    pthread_mutex_lock(&p_ctx->state_lock);
+    while (p_ctx->state == ABTD_XSTREAM_CONTEXT_STATE_INIT) {
+        pthread_cond_wait(&p_ctx->state_cond, &p_ctx->state_lock);
+    }
+    abt_errno = p_ctx->init_abt_errno;
+    pthread_mutex_unlock(&p_ctx->state_lock);
+    if (abt_errno != ABT_SUCCESS) {
+        /* The new thread has terminated without calling f_xstream. */
+        ret = pthread_join(p_ctx->native_thread, NULL);
+        ABTI_ASSERT(ret == 0);
+        goto FAILED;
+    }
     init_stage = 3;
 
     return ABT_SUCCESS;
@@ -84,7 +109,7 @@ FAILED:
         ABTI_ASSERT(ret == 0);
     }
     p_ctx->state = ABTD_XSTREAM_CONTEXT_STATE_UNINIT;
-    ABTI_HANDLE_ERROR(ABT_ERR_SYS);
+    ABTI_HANDLE_ERROR(abt_errno);
 }
 
 void ABTD_xstream_context_free(ABTD_xstream_context *p_ctx)
@@ -147,7 +172,9 @@ void ABTD_xstream_context_print(ABTD_xstream_context *p_ctx, FILE *p_os,
         fprintf(p_os, "%*s== NULL XSTREAM CONTEXT ==\n", indent, "");
     } else {
         const char *state;
-        if (p_ctx->state == ABTD_XSTREAM_CONTEXT_STATE_RUNNING) {
+        if (p_ctx->state == ABTD_XSTREAM_CONTEXT_STATE_INIT) {
+            state = "INIT";
+        } else if (p_ctx->state == ABTD_XSTREAM_CONTEXT_STATE_RUNNING) {
             state = "RUNNING";
         } else if (p_ctx->state == ABTD_XSTREAM_CONTEXT_STATE_WAITING) {
             state = "WAITING";
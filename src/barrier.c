@@ -5,6 +5,19 @@
 
 #include "abti.h"
 
+static ABTI_barrier_slot *barrier_get_slot(ABTI_barrier *p_barrier,
+                                           ABTI_local *p_local);
+static ABT_bool barrier_arrive(ABTI_local **pp_local, ABTI_barrier *p_barrier,
+                               ABT_bool is_waiting, uint64_t *p_phase);
+static void barrier_add_arrivals(ABTI_local *p_local, ABTI_barrier *p_barrier,
+                                 size_t num_arrivals);
+static void barrier_wait_phase(ABTI_local **pp_local, ABTI_barrier *p_barrier,
+                               uint64_t phase);
+static void barrier_wait_and_unlock(ABTI_local **pp_local,
+                                    ABTI_barrier *p_barrier,
+                                    ABTI_barrier_slot *p_slot, uint64_t phase);
+static void barrier_release_ref(ABTI_barrier *p_barrier);
+
 /** @defgroup BARRIER Barrier
  * This group is for Barrier.
  */
@@ -54,6 +67,7 @@ int ABT_barrier_create(uint32_t num_waiters, ABT_barrier *newbarrier)
     *newbarrier = ABT_BARRIER_NULL;
 #endif
     int abt_errno;
+    ABTI_global *p_global = ABTI_global_get_global();
     ABTI_barrier *p_newbarrier;
     ABTI_CHECK_TRUE(num_waiters != 0, ABT_ERR_INV_ARG);
     size_t arg_num_waiters = num_waiters;
@@ -61,10 +75,33 @@ int ABT_barrier_create(uint32_t num_waiters, ABT_barrier *newbarrier)
     abt_errno = ABTU_malloc(sizeof(ABTI_barrier), (void **)&p_newbarrier);
     ABTI_CHECK_ERROR(abt_errno);
 
-    ABTD_spinlock_clear(&p_newbarrier->lock);
+    /* Use one slot per core unless the barrier is small.  Work units on the
+     * same execution stream combine their arrivals in a slot. */
+    int i, num_slots = 1;
+    while (num_slots < p_global->num_cores &&
+           (size_t)num_slots < arg_num_waiters)
+        num_slots *= 2;
+    abt_errno = ABTU_memalign(ABT_CONFIG_STATIC_CACHELINE_SIZE,
+                              sizeof(ABTI_barrier_slot) * (num_slots + 1),
+                              (void **)&p_newbarrier->slots);
+    if (ABTI_IS_ERROR_CHECK_ENABLED && abt_errno != ABT_SUCCESS) {
+        ABTU_free(p_newbarrier);
+        ABTI_HANDLE_ERROR(abt_errno);
+    }
+    for (i = 0; i < num_slots + 1; i++) {
+        ABTI_barrier_slot *p_slot = &p_newbarrier->slots[i];
+        ABTD_spinlock_clear(&p_slot->lock);
+        p_slot->num_pending = 0;
+        ABTI_waitlist_init(&p_slot->waitlists[0]);
+        ABTI_waitlist_init(&p_slot->waitlists[1]);
+        p_slot->p_first_flags[0] = NULL;
+        p_slot->p_first_flags[1] = NULL;
+    }
+    p_newbarrier->num_slots = num_slots;
     p_newbarrier->num_waiters = arg_num_waiters;
-    p_newbarrier->counter = 0;
-    ABTI_waitlist_init(&p_newbarrier->waitlist);
+    ABTD_atomic_relaxed_store_size(&p_newbarrier->counter, 0);
+    ABTD_atomic_relaxed_store_uint64(&p_newbarrier->phase, 0);
+    ABTD_atomic_relaxed_store_int(&p_newbarrier->refcount, 1);
     /* Return value */
     *newbarrier = ABTI_barrier_get_handle(p_newbarrier);
     return ABT_SUCCESS;
@@ -105,7 +142,7 @@ int ABT_barrier_reinit(ABT_barrier barrier, uint32_t num_waiters)
 
     ABTI_barrier *p_barrier = ABTI_barrier_get_ptr(barrier);
     ABTI_CHECK_NULL_BARRIER_PTR(p_barrier);
-    ABTI_UB_ASSERT(p_barrier->counter == 0);
+    ABTI_UB_ASSERT(ABTD_atomic_relaxed_load_size(&p_barrier->counter) == 0);
     ABTI_CHECK_TRUE(num_waiters != 0, ABT_ERR_INV_ARG);
     size_t arg_num_waiters = num_waiters;
 
@@ -150,15 +187,10 @@ int ABT_barrier_free(ABT_barrier *barrier)
     ABTI_barrier *p_barrier = ABTI_barrier_get_ptr(h_barrier);
     ABTI_CHECK_NULL_BARRIER_PTR(p_barrier);
 
-    /* The lock needs to be acquired to safely free the barrier structure.
-     * However, we do not have to unlock it because the entire structure is
-     * freed here. */
-    ABTD_spinlock_acquire(&p_barrier->lock);
-
-    /* p_barrier->counter must be checked after taking a lock. */
-    ABTI_UB_ASSERT(p_barrier->counter == 0);
-
-    ABTU_free(p_barrier);
+    ABTI_UB_ASSERT(ABTD_atomic_acquire_load_size(&p_barrier->counter) == 0);
+    /* Work units that are releasing waiters might still access p_barrier, so
+     * the last one frees it. */
+    barrier_release_ref(p_barrier);
 
     /* Return value */
     *barrier = ABT_BARRIER_NULL;
@@ -173,6 +205,11 @@ int ABT_barrier_free(ABT_barrier *barrier)
  * caller suspends until as many waiters as the number of waiters specified by
  * \c ABT_barrier_create() or \c ABT_barrier_reinit() reach \c barrier.
  *
+ * \c ABT_barrier_wait() is equivalent to \c ABT_barrier_arrive() followed by
+ * \c ABT_barrier_wait_phase().  To reduce contention, a ULT that arrives at
+ * \c barrier may yield once so that arrivals of other work units on the same
+ * execution stream are added to \c barrier together.
+ *
  * @changev20
  * \DOC_DESC_V1X_NOTASK{\c ABT_ERR_BARRIER}
  * @endchangev20
@@ -212,23 +249,105 @@ int ABT_barrier_wait(ABT_barrier barrier)
     }
 #endif
 
-    ABTD_spinlock_acquire(&p_barrier->lock);
-
-    ABTI_ASSERT(p_barrier->counter < p_barrier->num_waiters);
-    p_barrier->counter++;
-
-    /* If we do not have all the waiters yet */
-    if (p_barrier->counter < p_barrier->num_waiters) {
-        ABTI_waitlist_wait_and_unlock(&p_local, &p_barrier->waitlist,
-                                      &p_barrier->lock,
-                                      ABT_SYNC_EVENT_TYPE_BARRIER,
-                                      (void *)p_barrier);
-    } else {
-        ABTI_waitlist_broadcast(p_local, &p_barrier->waitlist);
-        /* Reset counter */
-        p_barrier->counter = 0;
-        ABTD_spinlock_release(&p_barrier->lock);
+    uint64_t phase;
+    if (!barrier_arrive(&p_local, p_barrier, ABT_TRUE, &phase))
+        barrier_wait_phase(&p_local, p_barrier, phase);
+    return ABT_SUCCESS;
+}
+
+/**
+ * @ingroup BARRIER
+ * @brief   Arrive at a barrier without waiting.
+ *
+ * \c ABT_barrier_arrive() counts the caller as a waiter of the barrier
+ * \c barrier and returns the current phase of \c barrier through \c phase
+ * without waiting for the other waiters.  The caller must pass \c phase to
+ * \c ABT_barrier_wait_phase() before it arrives at \c barrier again.  The
+ * caller can do work that does not depend on the other waiters between the
+ * two calls.
+ *
+ * The phase of \c barrier is incremented every time all the waiters arrive at
+ * \c barrier.
+ *
+ * @contexts
+ * \DOC_CONTEXT_INIT \DOC_CONTEXT_NOCTXSWITCH
+ *
+ * @errors
+ * \DOC_ERROR_SUCCESS
+ * \DOC_ERROR_INV_BARRIER_HANDLE{\c barrier}
+ *
+ * @undefined
+ * \DOC_UNDEFINED_UNINIT
+ * \DOC_UNDEFINED_NULL_PTR{\c phase}
+ *
+ * @param[in]  barrier  barrier handle
+ * @param[out] phase    phase of the barrier
+ * @return Error code
+ */
+int ABT_barrier_arrive(ABT_barrier barrier, uint64_t *phase)
+{
+    ABTI_UB_ASSERT(ABTI_initialized());
+    ABTI_UB_ASSERT(phase);
+
+    ABTI_local *p_local = ABTI_local_get_local();
+    ABTI_barrier *p_barrier = ABTI_barrier_get_ptr(barrier);
+    ABTI_CHECK_NULL_BARRIER_PTR(p_barrier);
+
+    /* barrier_arrive() does not wait if is_waiting is ABT_FALSE. */
+    barrier_arrive(&p_local, p_barrier, ABT_FALSE, phase);
+    return ABT_SUCCESS;
+}
+
+/**
+ * @ingroup BARRIER
+ * @brief   Wait for the completion of a phase of a barrier.
+ *
+ * \c ABT_barrier_wait_phase() waits until all the waiters of the barrier
+ * \c barrier arrive at \c barrier in the phase \c phase.  \c phase must be
+ * a value returned by \c ABT_barrier_arrive().  If the phase has already
+ * completed, \c ABT_barrier_wait_phase() returns immediately.
+ *
+ * @changev20
+ * \DOC_DESC_V1X_NOTASK{\c ABT_ERR_BARRIER}
+ * @endchangev20
+ *
+ * @contexts
+ * \DOC_V1X \DOC_CONTEXT_INIT_NOTASK \DOC_CONTEXT_CTXSWITCH_CONDITIONAL{the
+ * phase \c phase of \c barrier has not completed}\n
+ * \DOC_V20 \DOC_CONTEXT_INIT \DOC_CONTEXT_CTXSWITCH_CONDITIONAL{the phase
+ * \c phase of \c barrier has not completed}
+ *
+ * @errors
+ * \DOC_ERROR_SUCCESS
+ * \DOC_ERROR_INV_BARRIER_HANDLE{\c barrier}
+ * \DOC_V1X \DOC_ERROR_TASK{\c ABT_ERR_BARRIER}
+ *
+ * @undefined
+ * \DOC_UNDEFINED_UNINIT
+ *
+ * @param[in] barrier  barrier handle
+ * @param[in] phase    phase of the barrier
+ * @return Error code
+ */
+int ABT_barrier_wait_phase(ABT_barrier barrier, uint64_t phase)
+{
+    ABTI_UB_ASSERT(ABTI_initialized());
+
+    ABTI_local *p_local = ABTI_local_get_local();
+    ABTI_barrier *p_barrier = ABTI_barrier_get_ptr(barrier);
+    ABTI_CHECK_NULL_BARRIER_PTR(p_barrier);
+
+#ifndef ABT_CONFIG_ENABLE_VER_20_API
+    /* Calling a barrier on a tasklet is not allowed. */
+    if (ABTI_IS_ERROR_CHECK_ENABLED && p_local) {
+        ABTI_xstream *p_local_xstream = ABTI_local_get_xstream(p_local);
+        ABTI_CHECK_TRUE(p_local_xstream->p_thread->type &
+                            ABTI_THREAD_TYPE_YIELDABLE,
+                        ABT_ERR_BARRIER);
     }
+#endif
+
+    barrier_wait_phase(&p_local, p_barrier, phase);
     return ABT_SUCCESS;
 }
 
@@ -266,3 +385,166 @@ int ABT_barrier_get_num_waiters(ABT_barrier barrier, uint32_t *num_waiters)
     *num_waiters = p_barrier->num_waiters;
     return ABT_SUCCESS;
 }
+
+/*****************************************************************************/
+/* Internal static functions                                                 */
+/*****************************************************************************/
+
+static ABTI_barrier_slot *barrier_get_slot(ABTI_barrier *p_barrier,
+                                           ABTI_local *p_local)
+{
+    ABTI_xstream *p_local_xstream = ABTI_local_get_xstream_or_null(p_local);
+    if (ABTI_IS_EXT_THREAD_ENABLED && !p_local_xstream) {
+        /* External threads share the last slot. */
+        return &p_barrier->slots[p_barrier->num_slots];
+    }
+    return &p_barrier->slots[p_local_xstream->rank &
+                             (p_barrier->num_slots - 1)];
+}
+
+/* If is_waiting is ABT_TRUE, the caller waits for the phase after this
+ * function.  Returns ABT_TRUE if this function has already waited for it. */
+static ABT_bool barrier_arrive(ABTI_local **pp_local, ABTI_barrier *p_barrier,
+                               ABT_bool is_waiting, uint64_t *p_phase)
+{
+    /* The phase does not change until this arrival is added to counter. */
+    uint64_t phase = ABTD_atomic_acquire_load_uint64(&p_barrier->phase);
+    *p_phase = phase;
+    ABTI_xstream *p_local_xstream = ABTI_local_get_xstream_or_null(*pp_local);
+    if (ABTI_IS_EXT_THREAD_ENABLED && !p_local_xstream) {
+        barrier_add_arrivals(*pp_local, p_barrier, 1);
+        return ABT_FALSE;
+    }
+    ABTI_barrier_slot *p_slot = barrier_get_slot(p_barrier, *pp_local);
+    ABTI_ythread *p_ythread =
+        is_waiting
+            ? ABTI_thread_get_ythread_or_null(p_local_xstream->p_thread)
+            : NULL;
+    /* Yielding to combine arrivals pays off only if other work units on this
+     * execution stream can arrive at the same slot in the meantime. */
+    ABT_bool is_combining =
+        p_ythread && p_barrier->num_slots > 1 &&
+        ABTI_sched_has_unit(p_local_xstream->p_main_sched);
+    ABTD_spinlock_acquire(&p_slot->lock);
+    size_t num_arrivals = ++p_slot->num_pending;
+    size_t counter = ABTD_atomic_relaxed_load_size(&p_barrier->counter);
+    if (!p_ythread || counter + num_arrivals >= p_barrier->num_waiters ||
+        (num_arrivals == 1 && !is_combining)) {
+        /* This work unit adds the pending arrivals in addition to its own if it
+         * cannot wait for others, if its arrival completes the phase, or if it
+         * is the first arrival that is unlikely to be combined with others.  A
+         * tasklet that blocks the execution stream must not depend on a ULT
+         * that is deferring its arrival. */
+        p_slot->num_pending = 0;
+        ABTD_spinlock_release(&p_slot->lock);
+        barrier_add_arrivals(*pp_local, p_barrier, num_arrivals);
+        return ABT_FALSE;
+    } else if (num_arrivals != 1) {
+        /* A ULT that arrived first will add this arrival, so the phase cannot
+         * complete before this ULT starts waiting. */
+        barrier_wait_and_unlock(pp_local, p_barrier, p_slot, phase);
+        return ABT_TRUE;
+    }
+    ABTD_spinlock_release(&p_slot->lock);
+    /* Let the other work units on this execution stream arrive so that their
+     * arrivals are added at once. */
+    ABTI_ythread_yield(&p_local_xstream, p_ythread,
+                       ABTI_YTHREAD_YIELD_KIND_YIELD_LOOP,
+                       ABT_SYNC_EVENT_TYPE_BARRIER, (void *)p_barrier);
+    *pp_local = ABTI_xstream_get_local(p_local_xstream);
+    ABTD_spinlock_acquire(&p_slot->lock);
+    num_arrivals = p_slot->num_pending;
+    p_slot->num_pending = 0;
+    ABTD_spinlock_release(&p_slot->lock);
+    /* num_arrivals can be zero if another work unit has added them. */
+    if (num_arrivals != 0)
+        barrier_add_arrivals(*pp_local, p_barrier, num_arrivals);
+    return ABT_FALSE;
+}
+
+static void barrier_add_arrivals(ABTI_local *p_local, ABTI_barrier *p_barrier,
+                                 size_t num_arrivals)
+{
+    size_t counter =
+        ABTD_atomic_fetch_add_size(&p_barrier->counter, num_arrivals) +
+        num_arrivals;
+    ABTI_ASSERT(counter <= p_barrier->num_waiters);
+    if (counter != p_barrier->num_waiters)
+        return;
+
+    /* All the waiters have arrived.  Waiters can return and free p_barrier
+     * once the phase is updated, so keep p_barrier until this function
+     * finishes. */
+    ABTD_atomic_fetch_add_int(&p_barrier->refcount, 1);
+    ABTD_atomic_relaxed_store_size(&p_barrier->counter, 0);
+    uint64_t phase = ABTD_atomic_relaxed_load_uint64(&p_barrier->phase);
+    ABTD_atomic_release_store_uint64(&p_barrier->phase, phase + 1);
+    /* Wake up all the waiters of the local slot.  As for the other slots, wake
+     * up only the first waiter of each slot, which wakes up the others on its
+     * execution stream. */
+    ABTI_barrier_slot *p_local_slot = barrier_get_slot(p_barrier, p_local);
+    int i, parity = (int)(phase & 1);
+    for (i = 0; i < p_barrier->num_slots + 1; i++) {
+        ABTI_barrier_slot *p_slot = &p_barrier->slots[i];
+        ABTD_spinlock_acquire(&p_slot->lock);
+        ABT_bool *p_first_flag = p_slot->p_first_flags[parity];
+        if (p_first_flag) {
+            p_slot->p_first_flags[parity] = NULL;
+            if (p_slot == p_local_slot) {
+                ABTI_waitlist_broadcast(p_local, &p_slot->waitlists[parity]);
+            } else {
+                /* The first waiter accesses p_barrier after it is woken up. */
+                ABTD_atomic_fetch_add_int(&p_barrier->refcount, 1);
+                *p_first_flag = ABT_TRUE;
+                ABTI_waitlist_signal(p_local, &p_slot->waitlists[parity]);
+            }
+        }
+        ABTD_spinlock_release(&p_slot->lock);
+    }
+    barrier_release_ref(p_barrier);
+}
+
+static void barrier_wait_phase(ABTI_local **pp_local, ABTI_barrier *p_barrier,
+                               uint64_t phase)
+{
+    if (ABTD_atomic_acquire_load_uint64(&p_barrier->phase) != phase)
+        return;
+    ABTI_barrier_slot *p_slot = barrier_get_slot(p_barrier, *pp_local);
+    ABTD_spinlock_acquire(&p_slot->lock);
+    /* The phase must be checked again while taking a lock since a releaser
+     * takes the same lock after updating the phase. */
+    if (ABTD_atomic_relaxed_load_uint64(&p_barrier->phase) != phase) {
+        ABTD_spinlock_release(&p_slot->lock);
+        return;
+    }
+    barrier_wait_and_unlock(pp_local, p_barrier, p_slot, phase);
+}
+
+static void barrier_wait_and_unlock(ABTI_local **pp_local,
+                                    ABTI_barrier *p_barrier,
+                                    ABTI_barrier_slot *p_slot, uint64_t phase)
+{
+    int parity = (int)(phase & 1);
+    ABT_bool is_first = ABT_FALSE;
+    if (!p_slot->p_first_flags[parity])
+        p_slot->p_first_flags[parity] = &is_first;
+    ABTI_waitlist_wait_and_unlock(pp_local, &p_slot->waitlists[parity],
+                                  &p_slot->lock, ABT_SYNC_EVENT_TYPE_BARRIER,
+                                  (void *)p_barrier);
+    if (is_first) {
+        /* The other waiters in this slot do not touch p_barrier after they are
+         * woken up.  Waiters of the next phase use the other waitlist. */
+        ABTD_spinlock_acquire(&p_slot->lock);
+        ABTI_waitlist_broadcast(*pp_local, &p_slot->waitlists[parity]);
+        ABTD_spinlock_release(&p_slot->lock);
+        barrier_release_ref(p_barrier);
+    }
+}
+
+static void barrier_release_ref(ABTI_barrier *p_barrier)
+{
+    if (ABTD_atomic_fetch_sub_int(&p_barrier->refcount, 1) == 1) {
+        ABTU_free(p_barrier->slots);
+        ABTU_free(p_barrier);
+    }
+}
@@ -5,6 +5,10 @@
 
 #include "abti.h"
 
+static void future_complete(ABTI_local *p_local, ABTI_future *p_future);
+static void future_add_continuation(ABTI_future *p_future,
+                                    ABTI_thread *p_thread);
+
 /** @defgroup FUTURE Future
  * This group is for Future.
  */
@@ -71,7 +75,11 @@ int ABT_future_create(uint32_t num_compartments, void (*cb_func)(void **arg),
     abt_errno = ABTU_malloc(sizeof(ABTI_future), (void **)&p_future);
     ABTI_CHECK_ERROR(abt_errno);
     ABTD_spinlock_clear(&p_future->lock);
-    ABTD_atomic_relaxed_store_size(&p_future->counter, 0);
+    ABTD_atomic_relaxed_store_size(&p_future->num_reserved, 0);
+    ABTD_atomic_relaxed_store_size(&p_future->num_filled, 0);
+    /* A future that has no compartment is always ready. */
+    ABTD_atomic_relaxed_store_int(&p_future->is_ready,
+                                  arg_num_compartments == 0 ? 1 : 0);
     p_future->num_compartments = arg_num_compartments;
     if (arg_num_compartments > 0) {
         abt_errno = ABTU_malloc(arg_num_compartments * sizeof(void *),
@@ -85,6 +93,8 @@ int ABT_future_create(uint32_t num_compartments, void (*cb_func)(void **arg),
     }
     p_future->p_callback = cb_func;
     ABTI_waitlist_init(&p_future->waitlist);
+    p_future->p_continuation_head = NULL;
+    p_future->p_continuation_tail = NULL;
 
     *newfuture = ABTI_future_get_handle(p_future);
     return ABT_SUCCESS;
@@ -98,7 +108,10 @@ int ABT_future_create(uint32_t num_compartments, void (*cb_func)(void **arg),
  * and sets \c future to \c ABT_FUTURE_NULL.
  *
  * @note
- * This routine frees \c future regardless of its readiness.
+ * This routine frees \c future regardless of its readiness.  However,
+ * \c future may not be freed while it has work units that are registered by
+ * \c ABT_future_add_thread() or \c ABT_future_add_task() and have not been
+ * pushed to their pools.
  *
  * @contexts
  * \DOC_CONTEXT_INIT \DOC_CONTEXT_NOCTXSWITCH
@@ -129,6 +142,7 @@ int ABT_future_free(ABT_future *future)
      * freed here. */
     ABTD_spinlock_acquire(&p_future->lock);
     ABTI_UB_ASSERT(ABTI_waitlist_is_empty(&p_future->waitlist));
+    ABTI_UB_ASSERT(!p_future->p_continuation_head);
 
     ABTU_free(p_future->array);
     ABTU_free(p_future);
@@ -187,9 +201,10 @@ int ABT_future_wait(ABT_future future)
     }
 #endif
 
+    if (ABTD_atomic_acquire_load_int(&p_future->is_ready))
+        return ABT_SUCCESS;
     ABTD_spinlock_acquire(&p_future->lock);
-    if (ABTD_atomic_relaxed_load_size(&p_future->counter) <
-        p_future->num_compartments) {
+    if (!ABTD_atomic_relaxed_load_int(&p_future->is_ready)) {
         ABTI_waitlist_wait_and_unlock(&p_local, &p_future->waitlist,
                                       &p_future->lock,
                                       ABT_SYNC_EVENT_TYPE_FUTURE,
@@ -234,8 +249,8 @@ int ABT_future_test(ABT_future future, ABT_bool *is_ready)
     ABTI_future *p_future = ABTI_future_get_ptr(future);
     ABTI_CHECK_NULL_FUTURE_PTR(p_future);
 
-    size_t counter = ABTD_atomic_acquire_load_size(&p_future->counter);
-    *is_ready = (counter == p_future->num_compartments) ? ABT_TRUE : ABT_FALSE;
+    *is_ready = ABTD_atomic_acquire_load_int(&p_future->is_ready) ? ABT_TRUE
+                                                                   : ABT_FALSE;
     return ABT_SUCCESS;
 }
 
@@ -247,7 +262,10 @@ int ABT_future_test(ABT_future future, ABT_bool *is_ready)
  * the future \c future.  If all the compartments of \c future are set, this
  * routine makes \c future ready and wakes up all waiters that are blocked on
  * \c future.  If the callback function is set to \c future, the callback
- * function is triggered before \c future is set to ready.
+ * function is triggered before \c future is set to ready.  The caller that sets
+ * the last compartment calls the callback function without holding any lock
+ * and pushes work units registered by \c ABT_future_add_thread() and
+ * \c ABT_future_add_task() to their pools.
  *
  * \DOC_DESC_ATOMICITY_FUTURE_READINESS
  *
@@ -275,31 +293,21 @@ int ABT_future_set(ABT_future future, void *value)
     ABTI_future *p_future = ABTI_future_get_ptr(future);
     ABTI_CHECK_NULL_FUTURE_PTR(p_future);
 
-    ABTD_spinlock_acquire(&p_future->lock);
-
-    size_t counter = ABTD_atomic_relaxed_load_size(&p_future->counter);
     size_t num_compartments = p_future->num_compartments;
+    /* Take a compartment without a lock. */
+    size_t index = ABTD_atomic_fetch_add_size(&p_future->num_reserved, 1);
 #ifndef ABT_CONFIG_DISABLE_ERROR_CHECK
     /* If num_compartments is 0, this routine always returns ABT_ERR_FUTURE */
-    if (counter >= num_compartments) {
-        ABTD_spinlock_release(&p_future->lock);
+    if (index >= num_compartments) {
         ABTI_HANDLE_ERROR(ABT_ERR_FUTURE);
     }
 #endif
-    p_future->array[counter] = value;
-    counter++;
-    /* Call a callback function before setting the counter. */
-    if (counter == num_compartments && p_future->p_callback != NULL) {
-        (*p_future->p_callback)(p_future->array);
-    }
-
-    ABTD_atomic_release_store_size(&p_future->counter, counter);
-
-    if (counter == num_compartments) {
-        ABTI_waitlist_broadcast(p_local, &p_future->waitlist);
-    }
-
-    ABTD_spinlock_release(&p_future->lock);
+    p_future->array[index] = value;
+    /* The caller that fills the last compartment makes the future ready.
+     * fetch_add() makes the values visible to it. */
+    size_t num_filled = ABTD_atomic_fetch_add_size(&p_future->num_filled, 1);
+    if (num_filled + 1 == num_compartments)
+        future_complete(p_local, p_future);
     return ABT_SUCCESS;
 }
 
@@ -343,7 +351,195 @@ int ABT_future_reset(ABT_future future)
 
     ABTD_spinlock_acquire(&p_future->lock);
     ABTI_UB_ASSERT(ABTI_waitlist_is_empty(&p_future->waitlist));
-    ABTD_atomic_release_store_size(&p_future->counter, 0);
+    ABTD_atomic_relaxed_store_size(&p_future->num_reserved, 0);
+    ABTD_atomic_relaxed_store_size(&p_future->num_filled, 0);
+    if (p_future->num_compartments != 0)
+        ABTD_atomic_release_store_int(&p_future->is_ready, 0);
     ABTD_spinlock_release(&p_future->lock);
     return ABT_SUCCESS;
 }
+
+/**
+ * @ingroup FUTURE
+ * @brief   Create a new ULT that runs when a future gets ready.
+ *
+ * \c ABT_future_add_thread() creates a new ULT, given by the attributes
+ * \c attr, associates it with the pool \c pool, and returns its handle through
+ * \c newthread.  The created ULT is pushed to \c pool when the future
+ * \c future gets ready, so no ULT needs to wait on \c future to start the work
+ * that depends on \c future.  If \c future is already ready, this routine
+ * pushes the created ULT to \c pool immediately.  The created ULT calls
+ * \c thread_func() with \c arg.
+ *
+ * \c attr can be created by \c ABT_thread_attr_create().  If the user passes
+ * \c ABT_THREAD_ATTR_NULL for \c attr, the default ULT attribute is used.
+ *
+ * @note
+ * \DOC_NOTE_DEFAULT_THREAD_ATTRIBUTE
+ *
+ * This routine copies \c attr, so the user can free \c attr after this routine
+ * returns.
+ *
+ * If \c newthread is \c NULL, this routine creates an unnamed ULT.  An unnamed
+ * ULT is automatically released on the completion of \c thread_func().
+ * Otherwise, \c newthread must be explicitly freed by \c ABT_thread_free().
+ *
+ * @contexts
+ * \DOC_CONTEXT_INIT \DOC_CONTEXT_NOCTXSWITCH
+ *
+ * @errors
+ * \DOC_ERROR_SUCCESS
+ * \DOC_ERROR_INV_FUTURE_HANDLE{\c future}
+ * \DOC_ERROR_INV_POOL_HANDLE{\c pool}
+ * \DOC_ERROR_RESOURCE
+ * \DOC_ERROR_RESOURCE_UNIT_CREATE
+ *
+ * @undefined
+ * \DOC_UNDEFINED_UNINIT
+ * \DOC_UNDEFINED_NULL_PTR{\c thread_func}
+ *
+ * @param[in]  future       future handle
+ * @param[in]  pool         pool handle
+ * @param[in]  thread_func  function to be executed by a new ULT
+ * @param[in]  arg          argument for \c thread_func()
+ * @param[in]  attr         ULT attribute
+ * @param[out] newthread    ULT handle
+ * @return Error code
+ */
+int ABT_future_add_thread(ABT_future future, ABT_pool pool,
+                          void (*thread_func)(void *), void *arg,
+                          ABT_thread_attr attr, ABT_thread *newthread)
+{
+    ABTI_UB_ASSERT(ABTI_initialized());
+    ABTI_UB_ASSERT(thread_func);
+
+    ABTI_global *p_global;
+    ABTI_SETUP_GLOBAL(&p_global);
+    ABTI_local *p_local = ABTI_local_get_local();
+    ABTI_future *p_future = ABTI_future_get_ptr(future);
+    ABTI_CHECK_NULL_FUTURE_PTR(p_future);
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    ABTI_CHECK_NULL_POOL_PTR(p_pool);
+
+    ABTI_thread *p_newthread;
+    int abt_errno =
+        ABTI_thread_create_unpushed(p_global, p_local, p_pool, thread_func, arg,
+                                    ABTI_thread_attr_get_ptr(attr),
+                                    newthread ? ABT_TRUE : ABT_FALSE,
+                                    &p_newthread);
+    ABTI_CHECK_ERROR(abt_errno);
+    /* An unnamed ULT may not be accessed after it is pushed. */
+    if (newthread)
+        *newthread = ABTI_thread_get_handle(p_newthread);
+    future_add_continuation(p_future, p_newthread);
+    return ABT_SUCCESS;
+}
+
+/**
+ * @ingroup FUTURE
+ * @brief   Create a new tasklet that runs when a future gets ready.
+ *
+ * \c ABT_future_add_task() creates a new tasklet, associates it with the pool
+ * \c pool, and returns its handle through \c newtask.  The created tasklet is
+ * pushed to \c pool when the future \c future gets ready.  If \c future is
+ * already ready, this routine pushes the created tasklet to \c pool
+ * immediately.  The created tasklet calls \c task_func() with \c arg.
+ *
+ * If \c newtask is \c NULL, this routine creates an unnamed tasklet.  An
+ * unnamed tasklet is automatically released on the completion of
+ * \c task_func().  Otherwise, \c newtask must be explicitly freed by
+ * \c ABT_thread_free().
+ *
+ * @contexts
+ * \DOC_CONTEXT_INIT \DOC_CONTEXT_NOCTXSWITCH
+ *
+ * @errors
+ * \DOC_ERROR_SUCCESS
+ * \DOC_ERROR_INV_FUTURE_HANDLE{\c future}
+ * \DOC_ERROR_INV_POOL_HANDLE{\c pool}
+ * \DOC_ERROR_RESOURCE
+ * \DOC_ERROR_RESOURCE_UNIT_CREATE
+ *
+ * @undefined
+ * \DOC_UNDEFINED_UNINIT
+ * \DOC_UNDEFINED_NULL_PTR{\c task_func}
+ *
+ * @param[in]  future     future handle
+ * @param[in]  pool       pool handle
+ * @param[in]  task_func  function to be executed by a new tasklet
+ * @param[in]  arg        argument for \c task_func()
+ * @param[out] newtask    tasklet handle
+ * @return Error code
+ */
+int ABT_future_add_task(ABT_future future, ABT_pool pool,
+                        void (*task_func)(void *), void *arg, ABT_task *newtask)
+{
+    ABTI_UB_ASSERT(ABTI_initialized());
+    ABTI_UB_ASSERT(task_func);
+
+    ABTI_global *p_global = ABTI_global_get_global();
+    ABTI_local *p_local = ABTI_local_get_local();
+    ABTI_future *p_future = ABTI_future_get_ptr(future);
+    ABTI_CHECK_NULL_FUTURE_PTR(p_future);
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    ABTI_CHECK_NULL_POOL_PTR(p_pool);
+
+    ABTI_thread *p_newtask;
+    int abt_errno =
+        ABTI_task_create_unpushed(p_global, p_local, p_pool, task_func, arg,
+                                  newtask ? ABT_TRUE : ABT_FALSE, &p_newtask);
+    ABTI_CHECK_ERROR(abt_errno);
+    /* An unnamed tasklet may not be accessed after it is pushed. */
+    if (newtask)
+        *newtask = ABTI_thread_get_handle(p_newtask);
+    future_add_continuation(p_future, p_newtask);
+    return ABT_SUCCESS;
+}
+
+/*****************************************************************************/
+/* Internal static functions                                                 */
+/*****************************************************************************/
+
+static void future_complete(ABTI_local *p_local, ABTI_future *p_future)
+{
+    /* Call a callback function before making the future ready. */
+    if (p_future->p_callback != NULL)
+        (*p_future->p_callback)(p_future->array);
+
+    ABTD_spinlock_acquire(&p_future->lock);
+    ABTD_atomic_release_store_int(&p_future->is_ready, 1);
+    ABTI_waitlist_broadcast(p_local, &p_future->waitlist);
+    ABTI_thread *p_thread = p_future->p_continuation_head;
+    p_future->p_continuation_head = NULL;
+    p_future->p_continuation_tail = NULL;
+    ABTD_spinlock_release(&p_future->lock);
+
+    /* p_future may be freed after the lock is released. */
+    while (p_thread) {
+        ABTI_thread *p_next = p_thread->p_next;
+        p_thread->p_next = NULL;
+        ABTI_pool_push(p_thread->p_pool, p_thread->unit,
+                       ABT_POOL_CONTEXT_OP_THREAD_CREATE);
+        p_thread = p_next;
+    }
+}
+
+static void future_add_continuation(ABTI_future *p_future,
+                                    ABTI_thread *p_thread)
+{
+    p_thread->p_next = NULL;
+    ABTD_spinlock_acquire(&p_future->lock);
+    if (!ABTD_atomic_relaxed_load_int(&p_future->is_ready)) {
+        if (p_future->p_continuation_tail) {
+            p_future->p_continuation_tail->p_next = p_thread;
+        } else {
+            p_future->p_continuation_head = p_thread;
+        }
+        p_future->p_continuation_tail = p_thread;
+        ABTD_spinlock_release(&p_future->lock);
+    } else {
+        ABTD_spinlock_release(&p_future->lock);
+        ABTI_pool_push(p_thread->p_pool, p_thread->unit,
+                       ABT_POOL_CONTEXT_OP_THREAD_CREATE);
+    }
+}
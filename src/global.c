@@ -206,6 +206,7 @@ ABTU_ret_err static int init_library(void)
 
     /* Initialize the system environment */
     ABTD_env_init(p_global);
+    ABTD_membarrier_init(p_global);
 
     /* Initialize memory pool */
     abt_errno = ABTI_mem_init(p_global);
@@ -15,6 +15,7 @@
 
 /* Data Types */
 typedef enum {
+    ABTD_XSTREAM_CONTEXT_STATE_INIT,
     ABTD_XSTREAM_CONTEXT_STATE_RUNNING,
     ABTD_XSTREAM_CONTEXT_STATE_WAITING,
     ABTD_XSTREAM_CONTEXT_STATE_REQ_JOIN,
@@ -28,6 +29,7 @@ typedef struct ABTD_xstream_context {
     ABTD_xstream_context_state state;
     pthread_mutex_t state_lock;
     pthread_cond_t state_cond;
+    int init_abt_errno; /* Result of the initialization of the native thread */
 } ABTD_xstream_context;
 typedef pthread_mutex_t ABTD_xstream_mutex;
 #ifdef HAVE_PTHREAD_BARRIER_INIT
@@ -58,6 +60,10 @@ uint32_t ABTD_env_get_sched_event_freq(void);
 uint64_t ABTD_env_get_sched_sleep_nsec(void);
 ABT_bool ABTD_env_get_stack_guard_mprotect(ABT_bool *is_strict);
 
+/* Asymmetric memory barrier */
+void ABTD_membarrier_init(ABTI_global *p_global);
+void ABTD_membarrier_heavy(void);
+
 /* ES Context */
 ABTU_ret_err int ABTD_xstream_context_create(void *(*f_xstream)(void *),
                                              void *p_arg,
@@ -69,6 +75,12 @@ void ABTD_xstream_context_set_self(ABTD_xstream_context *p_ctx);
 void ABTD_xstream_context_print(ABTD_xstream_context *p_ctx, FILE *p_os,
                                 int indent);
 
+/* Growable stacks */
+ABTU_ret_err int ABTD_stack_grow_init(void);
+void ABTD_stack_grow_finalize(void);
+ABTU_ret_err int ABTD_stack_grow_init_thread(void);
+void ABTD_stack_grow_finalize_thread(void);
+
 /* ES Affinity */
 void ABTD_affinity_init(ABTI_global *p_global, const char *affinity_str);
 void ABTD_affinity_finalize(ABTI_global *p_global);
@@ -80,6 +92,21 @@ ABTD_affinity_cpuset_apply(ABTD_xstream_context *p_ctx,
                            const ABTD_affinity_cpuset *p_cpuset);
 int ABTD_affinity_cpuset_apply_default(ABTD_xstream_context *p_ctx, int rank);
 void ABTD_affinity_cpuset_destroy(ABTD_affinity_cpuset *p_cpuset);
+/* Distance between two CPUs.  A smaller value means closer. */
+typedef enum {
+    ABTD_AFFINITY_DISTANCE_CORE = 0, /* Same core (e.g., hardware threads) */
+    ABTD_AFFINITY_DISTANCE_CACHE,    /* Same last-level cache or NUMA node */
+    ABTD_AFFINITY_DISTANCE_REMOTE,   /* Others or unknown */
+} ABTD_affinity_distance;
+#define ABTD_AFFINITY_NUM_DISTANCES 3
+ABTD_affinity_distance ABTD_affinity_get_distance(int cpuid1, int cpuid2);
+/* NUMA nodes are identified by indices from 0 to (the number of nodes - 1).
+ * The number of nodes is 1 if the topology is unknown.  The other functions
+ * return -1 if the node is unknown. */
+int ABTD_affinity_get_num_nodes(void);
+int ABTD_affinity_get_node_id(int node);
+int ABTD_affinity_cpuset_get_node(const ABTD_affinity_cpuset *p_cpuset);
+int ABTD_affinity_get_default_node(int rank);
 
 /* ES Affinity Parser */
 typedef struct ABTD_affinity_id_list {
@@ -1249,6 +1249,17 @@ static inline void ABTD_atomic_mem_barrier(void)
 #endif
 }
 
+/* A sequentially consistent fence, which also orders a preceding store with a
+ * following load. */
+static inline void ABTD_atomic_seq_cst_mem_barrier(void)
+{
+#ifdef ABT_CONFIG_HAVE_ATOMIC_BUILTIN
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+#else
+    __sync_synchronize();
+#endif
+}
+
 static inline void ABTD_compiler_barrier(void)
 {
     __asm__ __volatile__("" ::: "memory");
@@ -111,18 +111,40 @@ enum ABTI_stack_guard {
  * memory pool (so p_stack can be NULL). */
 #define ABTI_THREAD_TYPE_MEM_MALLOC_DESC_MEMPOOL_LAZY_STACK                    \
     ((ABTI_thread_type)(0x1 << 12))
+/* Both a thread descriptor and a ULT stack of a non-default size are allocated
+ * together from a memory pool of the corresponding stack size class. */
+#define ABTI_THREAD_TYPE_MEM_MEMPOOL_DESC_CLASS_STACK                          \
+    ((ABTI_thread_type)(0x1 << 13))
 
 #define ABTI_THREAD_TYPES_MEM                                                  \
     (ABTI_THREAD_TYPE_MEM_MEMPOOL_DESC | ABTI_THREAD_TYPE_MEM_MALLOC_DESC |    \
      ABTI_THREAD_TYPE_MEM_MEMPOOL_DESC_STACK |                                 \
      ABTI_THREAD_TYPE_MEM_MALLOC_DESC_STACK |                                  \
      ABTI_THREAD_TYPE_MEM_MEMPOOL_DESC_MEMPOOL_LAZY_STACK |                    \
-     ABTI_THREAD_TYPE_MEM_MALLOC_DESC_MEMPOOL_LAZY_STACK)
+     ABTI_THREAD_TYPE_MEM_MALLOC_DESC_MEMPOOL_LAZY_STACK |                     \
+     ABTI_THREAD_TYPE_MEM_MEMPOOL_DESC_CLASS_STACK)
+/* The stack of this ULT is filled with a watermark pattern to track its usage.
+ */
+#define ABTI_THREAD_TYPE_STACK_USAGE ((ABTI_thread_type)(0x1 << 14))
+/* The growable stack of this ULT has grown, so it needs to be shrunk before it
+ * is returned to a memory pool. */
+#define ABTI_THREAD_TYPE_STACK_GROWN ((ABTI_thread_type)(0x1 << 15))
+
+/* Stack size classes.  The stack size of the i-th class is
+ * 2^(ABTI_MEM_STACK_CLASS_MIN_SHIFT + i) bytes (i.e., 16 KB to 32 MB). */
+#define ABTI_MEM_STACK_CLASS_MIN_SHIFT 14
+#define ABTI_MEM_NUM_STACK_CLASSES 12
 
 /* ABTI_MUTEX_ATTR_NONE must be 0. See ABT_MUTEX_INITIALIZER. */
 #define ABTI_MUTEX_ATTR_NONE 0
 /* ABTI_MUTEX_ATTR_RECURSIVE must be 1. See ABT_RECURSIVE_MUTEX_INITIALIZER. */
 #define ABTI_MUTEX_ATTR_RECURSIVE 1
+#define ABTI_MUTEX_ATTR_QUEUED 2
+
+#define ABTI_RWLOCK_WRITE_FLAG_NONE 0
+/* A writer waits for readers to release a lock. */
+#define ABTI_RWLOCK_WRITE_FLAG_PENDING 1
+#define ABTI_RWLOCK_WRITE_FLAG_LOCKED 2
 
 /* Macro functions */
 #define ABTI_UNUSED(a) (void)(a)
@@ -132,6 +154,7 @@ typedef struct ABTI_global ABTI_global;
 typedef struct ABTI_local ABTI_local;
 typedef struct ABTI_local_func ABTI_local_func;
 typedef struct ABTI_xstream ABTI_xstream;
+typedef struct ABTI_mem_remote ABTI_mem_remote;
 typedef enum ABTI_xstream_type ABTI_xstream_type;
 typedef struct ABTI_sched ABTI_sched;
 typedef struct ABTI_sched_config ABTI_sched_config;
@@ -145,6 +168,8 @@ typedef struct ABTI_pool_deprecated_def ABTI_pool_deprecated_def;
 typedef struct ABTI_pool_old_def ABTI_pool_old_def;
 typedef struct ABTI_pool_user_def ABTI_pool_user_def;
 typedef struct ABTI_pool_config ABTI_pool_config;
+typedef struct ABTI_pool_waiter ABTI_pool_waiter;
+typedef struct ABTI_pool_waiter_node ABTI_pool_waiter_node;
 typedef struct ABTI_thread ABTI_thread;
 typedef struct ABTI_thread_attr ABTI_thread_attr;
 typedef struct ABTI_ythread ABTI_ythread;
@@ -156,6 +181,7 @@ typedef struct ABTI_ktable ABTI_ktable;
 typedef struct ABTI_waitlist ABTI_waitlist;
 typedef struct ABTI_mutex_attr ABTI_mutex_attr;
 typedef struct ABTI_mutex ABTI_mutex;
+typedef struct ABTI_mutex_queue ABTI_mutex_queue;
 typedef struct ABTI_cond ABTI_cond;
 typedef struct ABTI_rwlock ABTI_rwlock;
 typedef struct ABTI_eventual ABTI_eventual;
@@ -198,16 +224,33 @@ struct ABTI_mutex_attr {
     int attrs; /* bit-or'ed attributes */
 };
 
+/* Queue of a queued mutex.  Check abti_mutex.h for the algorithm. */
+struct ABTI_mutex_queue {
+    ABTD_atomic_ptr p_tail; /* last waiter (ABTI_mutex_qnode *), this queue if
+                             * the lock is taken without waiters, or NULL */
+    ABTD_atomic_ptr p_next; /* first waiter (ABTI_mutex_qnode *) */
+};
+
 struct ABTI_mutex {
     int attrs;               /* attributes copied from ABTI_mutex_attr.  Check
                               * ABT_(RECURSIVE_)MUTEX_INITIALIZER to see how
                               * this variable can be  initialized. */
     ABTD_spinlock lock;      /* lock */
+#ifndef ABT_CONFIG_USE_SIMPLE_MUTEX
+    ABTD_spinlock waiter_lock; /* lock */
+    uint32_t num_handovers;    /* # of consecutive handovers */
+    uint32_t num_ext_waiters;  /* # of external threads in waitlist */
+#endif
     int nesting_cnt;         /* nesting count (if recursive) */
     ABTI_thread_id owner_id; /* owner's ID (if recursive) */
 #ifndef ABT_CONFIG_USE_SIMPLE_MUTEX
-    ABTD_spinlock waiter_lock; /* lock */
-    ABTI_waitlist waitlist;    /* waiting list */
+    union {
+        ABTI_waitlist waitlist; /* waiting list */
+        ABTI_mutex_queue queue; /* waiter queue (if ABTI_MUTEX_ATTR_QUEUED) */
+    } waiters;
+    ABTD_atomic_ptr p_handover; /* waiter to which the lock is being handed
+                                 * over (ABTI_thread *, or ABTI_mutex_qnode *
+                                 * if queued) */
 #endif
 };
 
@@ -240,27 +283,68 @@ struct ABTI_global {
     uint64_t sched_sleep_nsec; /* Default nanoseconds for scheduler sleep */
     ABTI_ythread *p_primary_ythread; /* Primary ULT */
 
-    uint32_t
-        mutex_max_handovers;    /* Default max. # of local handovers (unused) */
-    uint32_t mutex_max_wakeups; /* Default max. # of wakeups (unused) */
-    size_t sys_page_size;       /* System page size (typically, 4KB) */
-    size_t huge_page_size;      /* Huge page size */
+    uint32_t mutex_max_handovers; /* Max. # of consecutive mutex handovers */
+    uint32_t mutex_max_wakeups;   /* Max. # of waiters woken up by unlock */
+    ABT_bool use_membarrier; /* Whether parking on pools issues membarrier() so
+                              * that pushers need no fence */
+    size_t sys_page_size;         /* System page size (typically, 4KB) */
+    size_t huge_page_size;        /* Huge page size */
 #ifdef ABT_CONFIG_USE_MEM_POOL
     size_t mem_page_size;    /* Page size for memory allocation */
     size_t mem_sp_size;      /* Stack page size */
     uint32_t mem_max_stacks; /* Max. # of stacks kept in each ES */
     uint32_t mem_max_descs;  /* Max. # of descriptors kept in each ES */
-    int mem_lp_alloc;        /* How to allocate large pages */
+    uint32_t mem_num_local_buckets; /* # of buckets kept in each local pool */
+    ABT_bool mem_remote_free; /* Whether elements freed by another thread are
+                               * returned to the allocating ES */
+    ABT_bool mem_sharded_lifo; /* Whether global pools keep buckets in sharded
+                                * LIFOs */
+    int mem_num_nodes; /* # of emulated NUMA nodes (0: CPU topology) */
+    uint32_t mem_prealloc_threads; /* # of ULTs whose memory is preallocated */
+    ABT_bool mem_prealloc_strict;  /* Whether preallocation must use the first
+                                    * requested large page type */
+    ABTD_spinlock mem_remote_lock;  /* Protecting p_mem_remotes. */
+    ABTI_mem_remote *p_mem_remotes; /* List of all ABTI_mem_remote. */
+    int mem_lp_alloc;               /* How to allocate large pages */
+    size_t mem_max_stack_class_size; /* Max. stack size that uses a stack size
+                                      * class (0 if disabled) */
+    size_t mem_trim_high_water; /* Size of pages above which idle pages are
+                                 * trimmed in the background (0 if disabled) */
+    size_t stack_grow_commit_size; /* Initially accessible size of growable
+                                    * stacks (0 if disabled) */
+    ABTD_spinlock mem_trim_lock; /* Serialize trimming. */
+    double mem_trim_last_time;   /* Last time of the background trimming */
+    double mem_trim_interval;    /* Interval of the background trimming */
+    uint32_t stack_usage_sampling; /* Track the usage of one in N stacks (0 if
+                                    * disabled) */
+    size_t stack_usage_keep_size;  /* Size from the stack top that is kept
+                                    * when a tracked stack is returned */
+    /* Histogram of the usage of tracked stacks. */
+    ABTD_atomic_uint64
+        stack_usage_histogram[ABT_INFO_STACK_USAGE_HISTOGRAM_SIZE];
+    ABTD_atomic_size max_stack_usage; /* Max. usage of tracked stacks */
+    double mem_stats_start_time; /* Time when memory pools are initialized */
+    /* Number of descriptors and stacks that are allocated by ABTU_malloc()
+     * because no memory pool can be used (e.g., by external threads). */
+    ABTD_atomic_uint64 mem_num_malloc_fallbacks;
 
     ABTI_mem_pool_global_pool mem_pool_stack; /* Pool of stack (default size) */
     ABTI_mem_pool_global_pool mem_pool_desc;  /* Pool of descriptors that can
                                                * store ABTI_task. */
+    /* Pools of stacks of non-default sizes.  Each is used for stacks of the
+     * corresponding stack size class. */
+    ABTI_mem_pool_global_pool
+        mem_pool_stack_classes[ABTI_MEM_NUM_STACK_CLASSES];
 #ifndef ABT_CONFIG_DISABLE_EXT_THREAD
     /* They are used for external threads. */
     ABTD_spinlock mem_pool_stack_lock;
     ABTI_mem_pool_local_pool mem_pool_stack_ext;
     ABTD_spinlock mem_pool_desc_lock;
     ABTI_mem_pool_local_pool mem_pool_desc_ext;
+    /* Local pools of stack size classes are initialized on the first use. */
+    ABTD_spinlock mem_pool_stack_class_lock;
+    ABTI_mem_pool_local_pool
+        mem_pool_stack_class_ext[ABTI_MEM_NUM_STACK_CLASSES];
 #endif
 #endif
     ABTI_stack_guard stack_guard_kind; /* Stack guard type. */
@@ -313,9 +397,26 @@ struct ABTI_xstream {
 #ifdef ABT_CONFIG_USE_MEM_POOL
     ABTI_mem_pool_local_pool mem_pool_stack;
     ABTI_mem_pool_local_pool mem_pool_desc;
+    /* Local pools of stack size classes are initialized on the first use. */
+    ABTI_mem_pool_local_pool mem_pool_stack_classes[ABTI_MEM_NUM_STACK_CLASSES];
+    uint32_t stack_usage_count; /* Stacks taken since the last tracked one */
+    ABTI_mem_remote *p_mem_remote; /* Remote lists of this ES (NULL if the
+                                    * remote free is disabled) */
 #endif
 };
 
+#ifdef ABT_CONFIG_USE_MEM_POOL
+/* Lists of stacks and descriptors that threads other than the allocating ES
+ * return to that ES.  ULTs and tasklets keep a pointer to this object, so it is
+ * not freed but reused by another ES when the ES is freed. */
+struct ABTI_mem_remote {
+    ABTI_mem_pool_remote_list stack; /* For mem_pool_stack */
+    ABTI_mem_pool_remote_list desc;  /* For mem_pool_desc */
+    ABTI_mem_remote *p_next;         /* Next in p_mem_remotes */
+    ABT_bool is_used;                /* Whether an ES is using it */
+};
+#endif
+
 struct ABTI_sched {
     ABTI_sched_used used;           /* To know if it is used and how */
     ABT_bool automatic;             /* To know if automatic data free */
@@ -329,6 +430,8 @@ struct ABTI_sched {
     size_t num_pools;               /* Number of thread pools */
     ABTI_ythread *p_ythread;        /* Associated ULT */
     void *data;                     /* Data for a specific scheduler */
+    ABTD_atomic_ptr p_waiter;       /* ABTI_pool_waiter if it can park */
+    ABTD_spinlock waiter_lock;      /* Protects p_waiter from being freed */
 
     /* Scheduler functions */
     ABT_sched_init_fn init;
@@ -395,6 +498,11 @@ struct ABTI_pool {
     ABTD_atomic_int32 num_blocked; /* Number of blocked ULTs */
     void *data;                    /* Specific data */
     uint64_t id;                   /* ID */
+    /* Schedulers that are parking on this pool.  ABTI_pool_push() checks
+     * num_waiters to wake them up. */
+    ABTD_atomic_int num_waiters;
+    ABTD_spinlock waiter_lock;
+    ABTI_pool_waiter_node *p_waiter_head;
 
     ABTI_pool_required_def required_def;
     ABTI_pool_optional_def optional_def;
@@ -402,6 +510,22 @@ struct ABTI_pool {
     ABTI_pool_old_def old_def;
 };
 
+struct ABTI_pool_waiter_node {
+    ABTI_pool_waiter *p_waiter;
+    ABTI_pool_waiter_node *p_prev;
+    ABTI_pool_waiter_node *p_next;
+};
+
+struct ABTI_pool_waiter {
+    ABTD_spinlock lock;
+    ABTD_atomic_int is_notified;
+#ifndef ABT_CONFIG_ACTIVE_WAIT_POLICY
+    ABTD_futex_multiple futex;
+#endif
+    int num_nodes;
+    ABTI_pool_waiter_node *nodes; /* One node per pool */
+};
+
 struct ABTI_pool_user_def {
     ABT_pool_access dummy_access;
     ABT_unit_get_type_fn dummy_fn1;
@@ -426,6 +550,8 @@ struct ABTI_thread {
     ABTI_thread_type type;        /* Thread type */
     ABT_unit unit;                /* Unit enclosing this thread */
     ABTI_xstream *p_last_xstream; /* Last ES where it ran */
+    ABTI_mem_remote *p_mem_remote; /* Remote lists of the ES that allocated
+                                    * this thread (NULL if none) */
     ABTI_thread *p_parent;        /* Parent thread */
     void (*f_thread)(void *);     /* Thread function */
     void *p_arg;                  /* Thread function argument */
@@ -434,11 +560,14 @@ struct ABTI_thread {
     ABTI_pool *p_pool;            /* Associated pool */
     ABTD_atomic_ptr p_keytable;   /* Thread-specific data (ABTI_ktable *) */
     ABT_unit_id id;               /* ID */
+    int64_t priority;             /* Priority (smaller is higher) */
+    ABTD_atomic_ptr p_mpsc_next;  /* Link of an MPSC pool (ABTD_atomic_ptr *) */
 };
 
 struct ABTI_thread_attr {
     void *p_stack;    /* Stack address */
     size_t stacksize; /* Stack size (in bytes) */
+    int64_t priority; /* Priority */
 #ifndef ABT_CONFIG_DISABLE_MIGRATION
     ABT_bool migratable;              /* Migratability */
     void (*f_cb)(ABT_thread, void *); /* Callback function */
@@ -486,11 +615,27 @@ struct ABTI_cond {
     ABTI_waitlist waitlist;
 };
 
+typedef struct {
+    /* # of readers that took a lock on this slot minus # of readers that
+     * released a lock on this slot.  It can be negative since a ULT can
+     * release a lock on another execution stream. */
+    ABTU_align_member_var(ABT_CONFIG_STATIC_CACHELINE_SIZE)
+        ABTD_atomic_int num_readers;
+} ABTI_rwlock_reader_slot;
+
 struct ABTI_rwlock {
+    /* Whether readers can take a lock only with reader slots. */
+    ABTD_atomic_int reader_bias;
+    int num_reader_slots; /* Power of two */
+    ABTI_rwlock_reader_slot *reader_slots;
     ABTI_mutex mutex;
     ABTI_cond cond;
-    size_t reader_count;
-    int write_flag;
+    /* The following are protected by mutex. */
+    int reader_count; /* # of readers that do not use reader slots */
+    ABTD_atomic_int write_flag; /* ABTI_RWLOCK_WRITE_FLAG_XXX */
+    int num_waiting_writers;
+    ABT_bool prefer_writer;
+    double reader_bias_inhibit_until; /* Time to disallow reader_bias */
 };
 
 struct ABTI_eventual {
@@ -502,19 +647,41 @@ struct ABTI_eventual {
 };
 
 struct ABTI_future {
-    ABTD_spinlock lock;
-    ABTD_atomic_size counter;
+    ABTD_spinlock lock; /* Protects waitlist and continuations. */
+    /* # of compartments that are taken by ABT_future_set() */
+    ABTD_atomic_size num_reserved;
+    /* # of compartments whose values are stored */
+    ABTD_atomic_size num_filled;
+    ABTD_atomic_int is_ready;
     size_t num_compartments;
     void **array;
     void (*p_callback)(void **arg);
     ABTI_waitlist waitlist;
+    /* Work units that are pushed to their pools when the future gets ready.
+     * They are linked by p_next. */
+    ABTI_thread *p_continuation_head;
+    ABTI_thread *p_continuation_tail;
 };
 
+typedef struct {
+    ABTU_align_member_var(ABT_CONFIG_STATIC_CACHELINE_SIZE)
+        ABTD_spinlock lock;
+    /* # of arrivals that have not been added to counter */
+    size_t num_pending;
+    /* Waiters of even and odd phases and flags of the first ones */
+    ABTI_waitlist waitlists[2];
+    ABT_bool *p_first_flags[2];
+} ABTI_barrier_slot;
+
 struct ABTI_barrier {
     size_t num_waiters;
-    volatile size_t counter;
-    ABTD_spinlock lock;
-    ABTI_waitlist waitlist;
+    ABTD_atomic_size counter;
+    ABTD_atomic_uint64 phase;
+    /* References by the user and releasing work units. */
+    ABTD_atomic_int refcount;
+    int num_slots; /* Power of two */
+    /* slots[num_slots] is for external threads. */
+    ABTI_barrier_slot *slots;
 };
 
 struct ABTI_xstream_barrier {
@@ -572,7 +739,11 @@ void ABTI_xstream_print(ABTI_xstream *p_xstream, FILE *p_os, int indent,
 ABT_sched_def *ABTI_sched_get_basic_def(void);
 ABT_sched_def *ABTI_sched_get_basic_wait_def(void);
 ABT_sched_def *ABTI_sched_get_prio_def(void);
+ABT_sched_def *ABTI_sched_get_edf_def(void);
 ABT_sched_def *ABTI_sched_get_randws_def(void);
+ABT_sched_def *ABTI_sched_get_hrandws_def(void);
+void ABTI_sched_randws_print_stats(ABTI_sched *p_sched, FILE *p_os, int indent);
+void ABTI_sched_edf_print_stats(ABTI_sched *p_sched, FILE *p_os, int indent);
 void ABTI_sched_finish(ABTI_sched *p_sched);
 void ABTI_sched_exit(ABTI_sched *p_sched);
 ABTU_ret_err int ABTI_sched_create_basic(ABT_sched_predef predef, int num_pools,
@@ -614,8 +785,27 @@ ABTI_pool_get_randws_def(ABT_pool_access access,
                          ABTI_pool_required_def *p_required_def,
                          ABTI_pool_optional_def *p_optional_def,
                          ABTI_pool_deprecated_def *p_deprecated_def);
+ABTU_ret_err int
+ABTI_pool_get_fifo_lockfree_def(ABT_pool_access access,
+                                ABTI_pool_required_def *p_required_def,
+                                ABTI_pool_optional_def *p_optional_def,
+                                ABTI_pool_deprecated_def *p_deprecated_def);
+ABTU_ret_err int
+ABTI_pool_get_prio_queue_def(ABT_pool_access access,
+                             ABTI_pool_required_def *p_required_def,
+                             ABTI_pool_optional_def *p_optional_def,
+                             ABTI_pool_deprecated_def *p_deprecated_def);
 void ABTI_pool_print(ABTI_pool *p_pool, FILE *p_os, int indent);
 void ABTI_pool_reset_id(void);
+ABTU_ret_err int ABTI_pool_waiter_create(int num_pools,
+                                         ABTI_pool_waiter **pp_waiter);
+void ABTI_pool_waiter_free(ABTI_pool_waiter *p_waiter);
+void ABTI_pool_waiter_park(ABTI_pool_waiter *p_waiter, int num_pools,
+                           const ABT_pool *pools, double time_secs);
+void ABTI_pool_waiter_notify(ABTI_pool_waiter *p_waiter);
+void ABTI_pool_notify_waiters(ABTI_pool *p_pool);
+ABT_thread ABTI_pool_pop_wait_generic(ABTI_pool *p_pool, double time_secs,
+                                      ABT_pool_context context);
 
 /* Pool config */
 ABTU_ret_err int ABTI_pool_config_read(const ABTI_pool_config *p_config,
@@ -644,6 +834,20 @@ ABTU_ret_err int ABTI_thread_revive(ABTI_global *p_global, ABTI_local *p_local,
 void ABTI_thread_join(ABTI_local **pp_local, ABTI_thread *p_thread);
 void ABTI_thread_free(ABTI_global *p_global, ABTI_local *p_local,
                       ABTI_thread *p_thread);
+ABTU_ret_err int ABTI_thread_create_unpushed(ABTI_global *p_global,
+                                             ABTI_local *p_local,
+                                             ABTI_pool *p_pool,
+                                             void (*thread_func)(void *),
+                                             void *arg,
+                                             ABTI_thread_attr *p_attr,
+                                             ABT_bool is_named,
+                                             ABTI_thread **pp_newthread);
+ABTU_ret_err int ABTI_task_create_unpushed(ABTI_global *p_global,
+                                           ABTI_local *p_local,
+                                           ABTI_pool *p_pool,
+                                           void (*task_func)(void *), void *arg,
+                                           ABT_bool is_named,
+                                           ABTI_thread **pp_newtask);
 void ABTI_thread_handle_request_cancel(ABTI_global *p_global,
                                        ABTI_xstream *p_local_xstream,
                                        ABTI_thread *p_thread);
@@ -27,7 +27,28 @@ ABTU_ret_err int ABTI_mem_init_local(ABTI_global *p_global,
                                      ABTI_xstream *p_local_xstream);
 void ABTI_mem_finalize(ABTI_global *p_global);
 void ABTI_mem_finalize_local(ABTI_xstream *p_local_xstream);
+int ABTI_mem_get_default_node(ABTI_global *p_global, int rank);
+void ABTI_mem_set_local_node(ABTI_xstream *p_xstream, int node);
 int ABTI_mem_check_lp_alloc(ABTI_global *p_global, int lp_alloc);
+uint64_t ABTI_mem_get_num_remote_buckets(ABTI_global *p_global);
+size_t ABTI_mem_get_page_mem_size(ABTI_global *p_global);
+ABTU_ret_err int ABTI_mem_trim(ABTI_global *p_global, size_t *p_trimmed_size);
+void ABTI_mem_trim_background(ABTI_global *p_global);
+void ABTI_mem_record_stack_usage(ABTI_global *p_global, void *p_stacktop,
+                                 size_t stacksize);
+void ABTI_mem_flush_local_stats(ABTI_xstream *p_local_xstream);
+
+/* Minimum and maximum intervals (in seconds) of the background trimming. */
+#define ABTI_MEM_TRIM_INTERVAL 1.0
+#define ABTI_MEM_TRIM_MAX_INTERVAL 64.0
+
+static inline void ABTI_mem_check_trim(ABTI_global *p_global)
+{
+#ifdef ABT_CONFIG_USE_MEM_POOL
+    if (ABTU_unlikely(p_global->mem_trim_high_water != 0))
+        ABTI_mem_trim_background(p_global);
+#endif
+}
 
 #define ABTI_STACK_CANARY_VALUE ((uint64_t)0xbaadc0debaadc0de)
 
@@ -53,6 +74,21 @@ static inline void ABTI_mem_check_stack_canary(void *p_stack)
 }
 #endif
 
+/* Return ABT_TRUE if a stack of stacksize is growable if it is taken from a
+ * memory pool.  The memory pool protects the bottom of such a stack. */
+static inline ABT_bool ABTI_mem_is_growable_stack(const ABTI_global *p_global,
+                                                  size_t stacksize)
+{
+#ifdef ABT_CONFIG_USE_MEM_POOL
+    return (p_global->stack_grow_commit_size &&
+            stacksize == p_global->thread_stacksize)
+               ? ABT_TRUE
+               : ABT_FALSE;
+#else
+    return ABT_FALSE;
+#endif
+}
+
 /* p_stack can be NULL. */
 static inline void ABTI_mem_register_stack(const ABTI_global *p_global,
                                            void *p_stacktop, size_t stacksize,
@@ -83,7 +119,7 @@ static inline void ABTI_mem_register_stack(const ABTI_global *p_global,
 #if ABT_CONFIG_STACK_CHECK_TYPE == ABTI_STACK_CHECK_TYPE_CANARY
         if (!(p_global->stack_guard_kind == ABTI_STACK_GUARD_MPROTECT ||
               p_global->stack_guard_kind == ABTI_STACK_GUARD_MPROTECT_STRICT) &&
-            p_stack) {
+            !ABTI_mem_is_growable_stack(p_global, stacksize) && p_stack) {
             ABTI_mem_write_stack_canary(p_stack);
         }
 #endif
@@ -119,7 +155,7 @@ static inline void ABTI_mem_unregister_stack(const ABTI_global *p_global,
 #if ABT_CONFIG_STACK_CHECK_TYPE == ABTI_STACK_CHECK_TYPE_CANARY
         if (!(p_global->stack_guard_kind == ABTI_STACK_GUARD_MPROTECT ||
               p_global->stack_guard_kind == ABTI_STACK_GUARD_MPROTECT_STRICT) &&
-            p_stack) {
+            !ABTI_mem_is_growable_stack(p_global, stacksize) && p_stack) {
             ABTI_mem_check_stack_canary(p_stack);
         }
 #endif
@@ -127,6 +163,33 @@ static inline void ABTI_mem_unregister_stack(const ABTI_global *p_global,
     ABTI_VALGRIND_UNREGISTER_STACK(p_stack);
 }
 
+#ifdef ABT_CONFIG_USE_MEM_POOL
+/* Return mem to the remote list of p_mem_remote if the caller is not the ES
+ * that owns p_mem_remote.  Return ABT_TRUE if mem has been returned. */
+static inline ABT_bool ABTI_mem_free_remote(ABTI_xstream *p_local_xstream,
+                                            ABTI_mem_remote *p_mem_remote,
+                                            ABT_bool is_stack, void *mem)
+{
+    if (ABTU_likely(!p_mem_remote || (p_local_xstream &&
+                                      p_local_xstream->p_mem_remote ==
+                                          p_mem_remote)))
+        return ABT_FALSE;
+    return ABTI_mem_pool_remote_free(is_stack ? &p_mem_remote->stack
+                                              : &p_mem_remote->desc,
+                                     mem);
+}
+#endif
+
+/* Count an allocation that uses ABTU_malloc() instead of a memory pool. */
+static inline void ABTI_mem_count_malloc_fallback(void)
+{
+#ifdef ABT_CONFIG_USE_MEM_POOL
+    ABTD_atomic_fetch_add_uint64(&ABTI_global_get_global()
+                                      ->mem_num_malloc_fallbacks,
+                                 1);
+#endif
+}
+
 ABTU_ret_err static inline int ABTI_mem_alloc_nythread(ABTI_local *p_local,
                                                        ABTI_thread **pp_thread)
 {
@@ -140,12 +203,14 @@ ABTU_ret_err static inline int ABTI_mem_alloc_nythread(ABTI_local *p_local,
                                             (void **)&p_thread);
         ABTI_CHECK_ERROR(abt_errno);
         p_thread->type = ABTI_THREAD_TYPE_MEM_MEMPOOL_DESC;
+        p_thread->p_mem_remote = p_local_xstream->p_mem_remote;
     } else
 #endif
     {
         int abt_errno =
             ABTU_malloc(ABTI_MEM_POOL_DESC_ELEM_SIZE, (void **)&p_thread);
         ABTI_CHECK_ERROR(abt_errno);
+        ABTI_mem_count_malloc_fallback();
         p_thread->type = ABTI_THREAD_TYPE_MEM_MALLOC_DESC;
     }
     *pp_thread = p_thread;
@@ -159,6 +224,9 @@ static inline void ABTI_mem_free_nythread_mempool_impl(ABTI_global *p_global,
     /* Return a descriptor. */
 #ifdef ABT_CONFIG_USE_MEM_POOL
     ABTI_xstream *p_local_xstream = ABTI_local_get_xstream_or_null(p_local);
+    if (ABTI_mem_free_remote(p_local_xstream, p_thread->p_mem_remote, ABT_FALSE,
+                             p_thread))
+        return;
 #ifdef ABT_CONFIG_DISABLE_EXT_THREAD
     /* Came from a memory pool. */
     ABTI_mem_pool_free(&p_local_xstream->mem_pool_desc, p_thread);
@@ -196,12 +264,14 @@ ABTI_mem_alloc_ythread_desc_impl(ABTI_local *p_local, ABT_bool use_lazy_stack,
             use_lazy_stack
                 ? ABTI_THREAD_TYPE_MEM_MEMPOOL_DESC_MEMPOOL_LAZY_STACK
                 : ABTI_THREAD_TYPE_MEM_MEMPOOL_DESC;
+        p_ythread->thread.p_mem_remote = p_local_xstream->p_mem_remote;
     } else
 #endif
     {
         int abt_errno =
             ABTU_malloc(ABTI_MEM_POOL_DESC_ELEM_SIZE, (void **)&p_ythread);
         ABTI_CHECK_ERROR(abt_errno);
+        ABTI_mem_count_malloc_fallback();
         p_ythread->thread.type =
             use_lazy_stack ? ABTI_THREAD_TYPE_MEM_MALLOC_DESC_MEMPOOL_LAZY_STACK
                            : ABTI_THREAD_TYPE_MEM_MALLOC_DESC;
@@ -216,6 +286,9 @@ static inline void ABTI_mem_free_ythread_desc_mempool_impl(
     /* Return a descriptor. */
 #ifdef ABT_CONFIG_USE_MEM_POOL
     ABTI_xstream *p_local_xstream = ABTI_local_get_xstream_or_null(p_local);
+    if (ABTI_mem_free_remote(p_local_xstream, p_ythread->thread.p_mem_remote,
+                             ABT_FALSE, p_ythread))
+        return;
 #ifdef ABT_CONFIG_DISABLE_EXT_THREAD
     /* Came from a memory pool. */
     ABTI_mem_pool_free(&p_local_xstream->mem_pool_desc, p_ythread);
@@ -236,6 +309,105 @@ static inline void ABTI_mem_free_ythread_desc_mempool_impl(
 #endif
 }
 
+/* Stack usage tracking.  A tracked stack is filled with a watermark pattern
+ * when it is given to a ULT.  When the stack is returned, the deepest word that
+ * has been overwritten tells the stack usage. */
+#define ABTI_STACK_USAGE_PATTERN ((uint64_t)0xa5c3e1f0a5c3e1f0)
+
+/* Return the lowest word that is tracked.  A stack guard and a stack canary at
+ * the bottom of the stack are excluded. */
+static inline uint64_t *
+ABTI_mem_get_stack_usage_bottom(const ABTI_global *p_global, void *p_stacktop,
+                                size_t stacksize)
+{
+    char *p_stack = ((char *)p_stacktop) - stacksize;
+    if (p_global->stack_guard_kind == ABTI_STACK_GUARD_MPROTECT ||
+        p_global->stack_guard_kind == ABTI_STACK_GUARD_MPROTECT_STRICT) {
+        p_stack = ((char *)ABTU_roundup_ptr(p_stack, p_global->sys_page_size)) +
+                  p_global->sys_page_size;
+    } else {
+#if ABT_CONFIG_STACK_CHECK_TYPE == ABTI_STACK_CHECK_TYPE_CANARY
+        /* See ABTI_mem_write_stack_canary(). */
+        p_stack += ABTU_roundup_uint64(ABT_CONFIG_STACK_CHECK_CANARY_SIZE, 8) *
+                   sizeof(uint64_t);
+#endif
+    }
+    return (uint64_t *)ABTU_roundup_ptr(p_stack, sizeof(uint64_t));
+}
+
+/* Called when p_ythread takes a stack from a memory pool. */
+static inline void ABTI_mem_start_stack_usage(ABTI_global *p_global,
+                                              ABTI_xstream *p_local_xstream,
+                                              ABTI_ythread *p_ythread,
+                                              void *p_stacktop,
+                                              size_t stacksize)
+{
+#ifdef ABT_CONFIG_USE_MEM_POOL
+    const uint32_t sampling = p_global->stack_usage_sampling;
+    if (ABTU_likely(sampling == 0))
+        return;
+    if (++p_local_xstream->stack_usage_count < sampling)
+        return;
+    p_local_xstream->stack_usage_count = 0;
+    uint64_t *p_word =
+        ABTI_mem_get_stack_usage_bottom(p_global, p_stacktop, stacksize);
+    while ((uintptr_t)p_word < (uintptr_t)p_stacktop)
+        *(p_word++) = ABTI_STACK_USAGE_PATTERN;
+    p_ythread->thread.type |= ABTI_THREAD_TYPE_STACK_USAGE;
+#endif
+}
+
+/* Called before p_ythread returns its stack to a memory pool. */
+static inline void ABTI_mem_finish_stack_usage(ABTI_global *p_global,
+                                               ABTI_ythread *p_ythread,
+                                               void *p_stacktop,
+                                               size_t stacksize)
+{
+#ifdef ABT_CONFIG_USE_MEM_POOL
+    if (ABTU_likely(!(p_ythread->thread.type & ABTI_THREAD_TYPE_STACK_USAGE)))
+        return;
+    p_ythread->thread.type &= ~ABTI_THREAD_TYPE_STACK_USAGE;
+    ABTI_mem_record_stack_usage(p_global, p_stacktop, stacksize);
+#endif
+}
+
+#ifdef ABT_CONFIG_USE_MEM_POOL
+/* Get the range of a growable stack that is inaccessible until the stack
+ * grows.  It excludes the guard page at the bottom of the stack. */
+static inline void ABTI_mem_get_stack_grow_range(const ABTI_global *p_global,
+                                                 void *p_stacktop,
+                                                 size_t stacksize,
+                                                 char **pp_begin, char **pp_end)
+{
+    char *p_stack = (char *)ABTU_roundup_ptr(((char *)p_stacktop) - stacksize,
+                                             p_global->sys_page_size);
+    *pp_begin = p_stack + p_global->sys_page_size;
+    *pp_end = ((char *)p_stacktop) - p_global->stack_grow_commit_size;
+}
+#endif
+
+/* Called before p_ythread returns its stack to a memory pool.  If the stack has
+ * grown, pages that have become accessible are released and protected
+ * again. */
+static inline void ABTI_mem_shrink_stack(ABTI_global *p_global,
+                                         ABTI_ythread *p_ythread,
+                                         void *p_stacktop, size_t stacksize)
+{
+#ifdef ABT_CONFIG_USE_MEM_POOL
+    if (ABTU_likely(!(p_ythread->thread.type & ABTI_THREAD_TYPE_STACK_GROWN)))
+        return;
+    p_ythread->thread.type &= ~ABTI_THREAD_TYPE_STACK_GROWN;
+    char *p_begin, *p_end;
+    ABTI_mem_get_stack_grow_range(p_global, p_stacktop, stacksize, &p_begin,
+                                  &p_end);
+    /* Even if pages are not released, they are protected. */
+    int abt_errno = ABTU_madvise_dontneed(p_begin, p_end - p_begin);
+    (void)abt_errno;
+    abt_errno = ABTU_mprotect(p_begin, p_end - p_begin, ABT_TRUE);
+    ABTI_ASSERT(abt_errno == ABT_SUCCESS);
+#endif
+}
+
 #ifdef ABT_CONFIG_USE_MEM_POOL
 ABTU_ret_err static inline int ABTI_mem_alloc_ythread_mempool_desc_stack_impl(
     ABTI_mem_pool_local_pool *p_mem_pool_stack, size_t stacksize,
@@ -301,7 +473,10 @@ ABTI_mem_alloc_ythread_mempool_desc_stack(ABTI_global *p_global,
                 &p_stacktop);
             ABTI_CHECK_ERROR(abt_errno);
             p_ythread->thread.type = ABTI_THREAD_TYPE_MEM_MEMPOOL_DESC_STACK;
+            p_ythread->thread.p_mem_remote = p_local_xstream->p_mem_remote;
             ABTI_mem_register_stack(p_global, p_stacktop, stacksize, ABT_FALSE);
+            ABTI_mem_start_stack_usage(p_global, p_local_xstream, p_ythread,
+                                       p_stacktop, stacksize);
         } else {
             /* If an external thread allocates a stack, we use ABTU_malloc. */
             int abt_errno =
@@ -309,6 +484,7 @@ ABTI_mem_alloc_ythread_mempool_desc_stack(ABTI_global *p_global,
                                                               &p_ythread,
                                                               &p_stacktop);
             ABTI_CHECK_ERROR(abt_errno);
+            ABTI_mem_count_malloc_fallback();
             p_ythread->thread.type = ABTI_THREAD_TYPE_MEM_MALLOC_DESC_STACK;
             ABTI_mem_register_stack(p_global, p_stacktop, stacksize, ABT_TRUE);
         }
@@ -359,6 +535,74 @@ ABTU_ret_err static inline int ABTI_mem_alloc_ythread_malloc_desc_stack(
     return ABT_SUCCESS;
 }
 
+#ifdef ABT_CONFIG_USE_MEM_POOL
+static inline size_t ABTI_mem_get_stack_class_size(int stack_class)
+{
+    return ((size_t)1) << (ABTI_MEM_STACK_CLASS_MIN_SHIFT + stack_class);
+}
+
+/* Return the smallest stack size class that can hold stacksize.  Return -1 if
+ * no stack size class is available. */
+static inline int ABTI_mem_get_stack_class(const ABTI_global *p_global,
+                                           size_t stacksize)
+{
+    if (stacksize > p_global->mem_max_stack_class_size)
+        return -1;
+    int stack_class = 0;
+    while (ABTI_mem_get_stack_class_size(stack_class) < stacksize)
+        stack_class++;
+    return stack_class;
+}
+#endif
+
+ABTU_ret_err static inline int
+ABTI_mem_alloc_ythread_mempool_class_desc_stack(ABTI_global *p_global,
+                                                ABTI_local *p_local,
+                                                size_t stacksize,
+                                                ABTI_ythread **pp_ythread)
+{
+#ifdef ABT_CONFIG_USE_MEM_POOL
+    ABTI_xstream *p_local_xstream = ABTI_local_get_xstream_or_null(p_local);
+    int stack_class = ABTI_mem_get_stack_class(p_global, stacksize);
+    /* If an external thread allocates a stack, we use ABTU_malloc. */
+    if (stack_class >= 0 && (!ABTI_IS_EXT_THREAD_ENABLED || p_local_xstream)) {
+        ABTI_mem_pool_local_pool *p_local_pool =
+            &p_local_xstream->mem_pool_stack_classes[stack_class];
+        int abt_errno;
+        if (ABTU_unlikely(!p_local_pool->p_global_pool)) {
+            /* This is the first use of this stack size class. */
+            abt_errno = ABTI_mem_pool_init_local_pool(
+                p_local_pool, &p_global->mem_pool_stack_classes[stack_class],
+                ABTI_mem_pool_get_local_node(&p_local_xstream->mem_pool_stack));
+            if (ABTI_IS_ERROR_CHECK_ENABLED && abt_errno != ABT_SUCCESS) {
+                p_local_pool->p_global_pool = NULL;
+                return abt_errno;
+            }
+        }
+        void *p_stacktop;
+        abt_errno = ABTI_mem_pool_alloc(p_local_pool, &p_stacktop);
+        ABTI_CHECK_ERROR(abt_errno);
+        /* A stack is placed right below a descriptor.  If stacksize is smaller
+         * than the size of the stack size class, the bottom of the memory
+         * segment is not used, so the memory pool does not protect the bottom
+         * of the stack. */
+        ABTI_ythread *p_ythread = (ABTI_ythread *)p_stacktop;
+        p_ythread->thread.type = ABTI_THREAD_TYPE_MEM_MEMPOOL_DESC_CLASS_STACK;
+        ABTI_mem_register_stack(p_global, p_stacktop, stacksize,
+                                stacksize !=
+                                    ABTI_mem_get_stack_class_size(stack_class));
+        ABTI_mem_start_stack_usage(p_global, p_local_xstream, p_ythread,
+                                   p_stacktop, stacksize);
+        ABTD_ythread_context_init(&p_ythread->ctx, p_stacktop, stacksize);
+        *pp_ythread = p_ythread;
+        return ABT_SUCCESS;
+    }
+    ABTI_mem_count_malloc_fallback();
+#endif
+    return ABTI_mem_alloc_ythread_malloc_desc_stack(p_global, stacksize,
+                                                    pp_ythread);
+}
+
 ABTU_ret_err static inline int
 ABTI_mem_alloc_ythread_mempool_desc(ABTI_global *p_global, ABTI_local *p_local,
                                     size_t stacksize, void *p_stacktop,
@@ -379,6 +623,36 @@ ABTI_mem_alloc_ythread_mempool_desc(ABTI_global *p_global, ABTI_local *p_local,
     return ABT_SUCCESS;
 }
 
+#ifdef ABT_CONFIG_USE_MEM_POOL
+/* Return a stack of a stack size class to p_local_pool, which might not have
+ * been initialized yet. */
+static inline void
+ABTI_mem_free_stack_class_impl(ABTI_global *p_global,
+                               ABTI_mem_pool_local_pool *p_local_pool,
+                               int stack_class, int node, void *mem)
+{
+    if (ABTU_unlikely(!p_local_pool->p_global_pool)) {
+        /* The freed stack becomes the first bucket of this local pool. */
+        ABTI_mem_pool_header *p_header = (ABTI_mem_pool_header *)mem;
+        p_local_pool->p_global_pool =
+            &p_global->mem_pool_stack_classes[stack_class];
+        p_local_pool->num_headers_per_bucket =
+            p_local_pool->p_global_pool->num_headers_per_bucket;
+        p_local_pool->num_local_buckets =
+            p_local_pool->p_global_pool->num_local_buckets;
+        p_local_pool->p_remote_list = NULL;
+        p_local_pool->num_allocs = 0;
+        ABTI_mem_pool_set_local_node(p_local_pool, node);
+        p_header->p_next = NULL;
+        p_header->bucket_info.num_headers = 1;
+        p_local_pool->bucket_index = 0;
+        p_local_pool->buckets[0] = p_header;
+    } else {
+        ABTI_mem_pool_free(p_local_pool, mem);
+    }
+}
+#endif
+
 static inline void ABTI_mem_free_thread(ABTI_global *p_global,
                                         ABTI_local *p_local,
                                         ABTI_thread *p_thread)
@@ -387,14 +661,16 @@ static inline void ABTI_mem_free_thread(ABTI_global *p_global,
 #ifdef ABT_CONFIG_USE_MEM_POOL
     if (p_thread->type & ABTI_THREAD_TYPE_MEM_MEMPOOL_DESC_STACK) {
         ABTI_ythread *p_ythread = ABTI_thread_get_ythread(p_thread);
-        ABTI_mem_unregister_stack(p_global,
-                                  ABTD_ythread_context_get_stacktop(
-                                      &p_ythread->ctx),
-                                  ABTD_ythread_context_get_stacksize(
-                                      &p_ythread->ctx),
-                                  ABT_FALSE);
+        void *p_stacktop = ABTD_ythread_context_get_stacktop(&p_ythread->ctx);
+        size_t stacksize = ABTD_ythread_context_get_stacksize(&p_ythread->ctx);
+        ABTI_mem_unregister_stack(p_global, p_stacktop, stacksize, ABT_FALSE);
+        ABTI_mem_finish_stack_usage(p_global, p_ythread, p_stacktop, stacksize);
+        ABTI_mem_shrink_stack(p_global, p_ythread, p_stacktop, stacksize);
 
         ABTI_xstream *p_local_xstream = ABTI_local_get_xstream_or_null(p_local);
+        if (ABTI_mem_free_remote(p_local_xstream, p_thread->p_mem_remote,
+                                 ABT_TRUE, p_ythread))
+            return;
         /* Came from a memory pool. */
 #ifndef ABT_CONFIG_DISABLE_EXT_THREAD
         if (p_local_xstream == NULL) {
@@ -406,6 +682,37 @@ static inline void ABTI_mem_free_thread(ABTI_global *p_global,
         }
 #endif
         ABTI_mem_pool_free(&p_local_xstream->mem_pool_stack, p_ythread);
+    } else if (p_thread->type & ABTI_THREAD_TYPE_MEM_MEMPOOL_DESC_CLASS_STACK) {
+        ABTI_ythread *p_ythread = ABTI_thread_get_ythread(p_thread);
+        void *p_stacktop = ABTD_ythread_context_get_stacktop(&p_ythread->ctx);
+        size_t stacksize = ABTD_ythread_context_get_stacksize(&p_ythread->ctx);
+        int stack_class = ABTI_mem_get_stack_class(p_global, stacksize);
+        ABTI_mem_unregister_stack(p_global, p_stacktop, stacksize,
+                                  stacksize !=
+                                      ABTI_mem_get_stack_class_size(
+                                          stack_class));
+        ABTI_mem_finish_stack_usage(p_global, p_ythread, p_stacktop, stacksize);
+        ABTI_xstream *p_local_xstream = ABTI_local_get_xstream_or_null(p_local);
+        /* Came from a memory pool. */
+#ifndef ABT_CONFIG_DISABLE_EXT_THREAD
+        if (p_local_xstream == NULL) {
+            /* Return a stack to the global pool. */
+            ABTD_spinlock_acquire(&p_global->mem_pool_stack_class_lock);
+            ABTI_mem_free_stack_class_impl(p_global,
+                                           &p_global->mem_pool_stack_class_ext
+                                                [stack_class],
+                                           stack_class, 0, p_ythread);
+            ABTD_spinlock_release(&p_global->mem_pool_stack_class_lock);
+            return;
+        }
+#endif
+        ABTI_mem_free_stack_class_impl(p_global,
+                                       &p_local_xstream->mem_pool_stack_classes
+                                            [stack_class],
+                                       stack_class,
+                                       ABTI_mem_pool_get_local_node(
+                                           &p_local_xstream->mem_pool_stack),
+                                       p_ythread);
     } else
 #endif
         if (p_thread->type &
@@ -457,6 +764,68 @@ static inline void ABTI_mem_free_thread(ABTI_global *p_global,
     }
 }
 
+/* Allocate num ULTs that use a stack of the default size.  If it fails, no ULT
+ * is allocated. */
+ABTU_ret_err static inline int
+ABTI_mem_alloc_ythread_default_many(ABTI_global *p_global, ABTI_local *p_local,
+                                    size_t num, ABTI_ythread **pp_ythreads)
+{
+    size_t i;
+    const size_t stacksize = p_global->thread_stacksize;
+#ifdef ABT_CONFIG_USE_MEM_POOL
+    ABTI_xstream *p_local_xstream = ABTI_local_get_xstream_or_null(p_local);
+    if (!ABTI_IS_EXT_THREAD_ENABLED || p_local_xstream) {
+#ifdef ABT_CONFIG_DISABLE_LAZY_STACK_ALLOC
+        /* Take ULT stacks and descriptors together. */
+        ABTI_ASSERT((stacksize & (ABT_CONFIG_STATIC_CACHELINE_SIZE - 1)) == 0);
+        int abt_errno =
+            ABTI_mem_pool_alloc_many(&p_local_xstream->mem_pool_stack, num,
+                                     (void **)pp_ythreads);
+        ABTI_CHECK_ERROR(abt_errno);
+        for (i = 0; i < num; i++) {
+            ABTI_ythread *p_ythread = pp_ythreads[i];
+            void *p_stacktop = (void *)p_ythread;
+            p_ythread->thread.type = ABTI_THREAD_TYPE_MEM_MEMPOOL_DESC_STACK;
+            p_ythread->thread.p_mem_remote = p_local_xstream->p_mem_remote;
+            ABTI_mem_register_stack(p_global, p_stacktop, stacksize, ABT_FALSE);
+            ABTI_mem_start_stack_usage(p_global, p_local_xstream, p_ythread,
+                                       p_stacktop, stacksize);
+            ABTD_ythread_context_init(&p_ythread->ctx, p_stacktop, stacksize);
+        }
+#else
+        /* Only take descriptors.  Stacks are assigned when ULTs run for the
+         * first time. */
+        int abt_errno =
+            ABTI_mem_pool_alloc_many(&p_local_xstream->mem_pool_desc, num,
+                                     (void **)pp_ythreads);
+        ABTI_CHECK_ERROR(abt_errno);
+        for (i = 0; i < num; i++) {
+            ABTI_ythread *p_ythread = pp_ythreads[i];
+            p_ythread->thread.type =
+                ABTI_THREAD_TYPE_MEM_MEMPOOL_DESC_MEMPOOL_LAZY_STACK;
+            p_ythread->thread.p_mem_remote = p_local_xstream->p_mem_remote;
+            ABTD_ythread_context_init_lazy(&p_ythread->ctx, stacksize);
+        }
+#endif
+        return ABT_SUCCESS;
+    }
+#endif
+    /* Allocate ULTs one by one. */
+    for (i = 0; i < num; i++) {
+        int abt_errno =
+            ABTI_mem_alloc_ythread_mempool_desc_stack(p_global, p_local,
+                                                      stacksize,
+                                                      &pp_ythreads[i]);
+        if (ABTI_IS_ERROR_CHECK_ENABLED && abt_errno != ABT_SUCCESS) {
+            while (i > 0)
+                ABTI_mem_free_thread(p_global, p_local,
+                                     &pp_ythreads[--i]->thread);
+            return abt_errno;
+        }
+    }
+    return ABT_SUCCESS;
+}
+
 ABTU_ret_err static inline int
 ABTI_mem_alloc_ythread_mempool_stack(ABTI_xstream *p_local_xstream,
                                      ABTI_ythread *p_ythread)
@@ -470,6 +839,10 @@ ABTI_mem_alloc_ythread_mempool_stack(ABTI_xstream *p_local_xstream,
         ABTI_mem_pool_alloc(&p_local_xstream->mem_pool_stack, &p_stacktop);
     ABTI_CHECK_ERROR(abt_errno);
     ABTD_ythread_context_lazy_set_stack(&p_ythread->ctx, p_stacktop);
+    ABTI_mem_start_stack_usage(ABTI_global_get_global(), p_local_xstream,
+                               p_ythread, p_stacktop,
+                               ABTD_ythread_context_get_stacksize(
+                                   &p_ythread->ctx));
     return ABT_SUCCESS;
 #else
     /* This function should not be called. */
@@ -486,7 +859,11 @@ ABTI_mem_free_ythread_mempool_stack(ABTI_xstream *p_local_xstream,
     ABTI_UB_ASSERT(p_ythread->thread.type &
                    (ABTI_THREAD_TYPE_MEM_MEMPOOL_DESC_MEMPOOL_LAZY_STACK |
                     ABTI_THREAD_TYPE_MEM_MALLOC_DESC_MEMPOOL_LAZY_STACK));
+    ABTI_global *p_global = ABTI_global_get_global();
     void *p_stacktop = ABTD_ythread_context_get_stacktop(&p_ythread->ctx);
+    size_t stacksize = ABTD_ythread_context_get_stacksize(&p_ythread->ctx);
+    ABTI_mem_finish_stack_usage(p_global, p_ythread, p_stacktop, stacksize);
+    ABTI_mem_shrink_stack(p_global, p_ythread, p_stacktop, stacksize);
     ABTD_ythread_context_lazy_unset_stack(&p_ythread->ctx);
     ABTI_mem_pool_free(&p_local_xstream->mem_pool_stack, p_stacktop);
 #else
@@ -512,6 +889,7 @@ ABTU_ret_err static inline int ABTI_mem_alloc_desc(ABTI_local *p_local,
         /* For external threads */
         int abt_errno = ABTU_malloc(ABTI_MEM_POOL_DESC_SIZE, &p_desc);
         ABTI_CHECK_ERROR(abt_errno);
+        ABTI_mem_count_malloc_fallback();
         *(uint32_t *)(((char *)p_desc) + ABTI_MEM_POOL_DESC_SIZE) = 1;
         *pp_desc = p_desc;
         return ABT_SUCCESS;
@@ -6,9 +6,16 @@
 #ifndef ABTI_MEM_POOL_H_INCLUDED
 #define ABTI_MEM_POOL_H_INCLUDED
 
-#define ABT_MEM_POOL_MAX_LOCAL_BUCKETS 2
+/* Upper bound of the number of buckets that a local pool keeps.  The actual
+ * number is set by ABT_MEM_NUM_LOCAL_BUCKETS. */
+#define ABT_MEM_POOL_MAX_LOCAL_BUCKETS 16
 #define ABT_MEM_POOL_NUM_RETURN_BUCKETS 1
 #define ABT_MEM_POOL_NUM_TAKE_BUCKETS 1
+/* Maximum number of NUMA nodes that have their own buckets and pages.  Nodes
+ * beyond this number share them in a round-robin manner. */
+#define ABT_MEM_POOL_MAX_NODES 8
+/* Number of ABTU_MEM_LARGEPAGE_TYPE values. */
+#define ABTI_MEM_POOL_NUM_LP_TYPES 4
 
 typedef union ABTI_mem_pool_header_bucket_info {
     /* This is used when it is in ABTI_mem_pool_global_pool */
@@ -20,6 +27,10 @@ typedef union ABTI_mem_pool_header_bucket_info {
 typedef struct ABTI_mem_pool_header {
     struct ABTI_mem_pool_header *p_next;
     ABTI_mem_pool_header_bucket_info bucket_info;
+    /* A tag that is set when memory of this element except for the header has
+     * been released to the OS.  This is cleared when the element is carved out
+     * of a page or allocated. */
+    uintptr_t trim_tag;
 } ABTI_mem_pool_header;
 
 typedef struct ABTI_mem_pool_page {
@@ -30,6 +41,8 @@ typedef struct ABTI_mem_pool_page {
     ABTU_MEM_LARGEPAGE_TYPE lp_type;
     void *p_mem_extra;
     size_t mem_extra_size;
+    int node;            /* NUMA node of this page. */
+    size_t trimmed_size; /* Size of memory released to the OS. */
 } ABTI_mem_pool_page;
 
 typedef struct ABTI_mem_pool_global_pool_mprotect_config {
@@ -41,9 +54,55 @@ typedef struct ABTI_mem_pool_global_pool_mprotect_config {
                          of the system page size. */
 } ABTI_mem_pool_global_pool_mprotect_config;
 
+/* Buckets and pages that belong to one NUMA node. */
+typedef struct ABTI_mem_pool_global_pool_node {
+    /* LIFO of available buckets.  Which one is used depends on
+     * use_sharded_lifo of the global pool. */
+    union {
+        ABTI_sync_lifo lifo;
+        ABTI_sync_sharded_lifo sharded_lifo;
+    } bucket_lifo;
+    ABTU_align_member_var(ABT_CONFIG_STATIC_CACHELINE_SIZE)
+        ABTI_sync_lifo mem_page_lifo; /* LIFO of non-empty pages. */
+    ABTU_align_member_var(ABT_CONFIG_STATIC_CACHELINE_SIZE)
+        /* Number of buckets that local pools on this node took from the other
+         * nodes. */
+        ABTD_atomic_uint64 num_remote_buckets;
+} ABTI_mem_pool_global_pool_node;
+
+/* Statistics of a global pool and the local pools that use it.  They are
+ * updated only when buckets or pages move, so the fast path of local pools
+ * does not touch them. */
+typedef struct ABTI_mem_pool_global_pool_stats {
+    ABTD_atomic_uint64 num_allocs; /* Elements allocated from local pools. */
+    ABTD_atomic_uint64 num_takes;  /* Buckets taken by local pools. */
+    ABTD_atomic_uint64 num_returns;     /* Buckets returned by local pools. */
+    ABTD_atomic_uint64 num_new_buckets; /* Buckets made of unused memory. */
+    /* Pages allocated for each ABTU_MEM_LARGEPAGE_TYPE. */
+    ABTD_atomic_uint64 num_pages[ABTI_MEM_POOL_NUM_LP_TYPES];
+    /* Pages that are not of the first requested large page type. */
+    ABTD_atomic_uint64 num_lp_fallbacks;
+    /* Memory at the end of pages that is too small for an element. */
+    ABTD_atomic_size unused_page_mem_size;
+} ABTI_mem_pool_global_pool_stats;
+
+/* Snapshot of ABTI_mem_pool_global_pool_stats. */
+typedef struct ABTI_mem_pool_stats {
+    uint64_t num_allocs;
+    uint64_t num_takes;
+    uint64_t num_returns;
+    uint64_t num_new_buckets;
+    uint64_t num_pages[ABTI_MEM_POOL_NUM_LP_TYPES];
+    uint64_t num_lp_fallbacks;
+    size_t unused_page_mem_size;
+    size_t page_mem_size;
+    size_t element_size;
+    size_t num_headers_per_bucket;
+} ABTI_mem_pool_stats;
+
 /*
  * To efficiently take/return multiple headers per bucket, headers are linked as
- * follows in the global pool (bucket_lifo).
+ * follows in the global pool (bucket_lifo of each node).
  *
  * header (p_next)> header (p_next)> header ... (num_headers_per_bucket)
  *   | (connected via lifo_elem)
@@ -64,26 +123,43 @@ typedef struct ABTI_mem_pool_global_pool {
                             * of the memory segment; i.e., the pool returns
                             * p_header_memory_top + offset. */
     size_t num_headers_per_bucket; /* Number of headers per bucket. */
+    size_t num_local_buckets; /* Max. number of buckets in each local pool. */
     uint32_t
         num_lp_type_requests; /* Number of requests for large page allocation.
                                */
     ABTU_MEM_LARGEPAGE_TYPE
     lp_type_requests[4]; /* Requests for large page allocation */
     ABTI_mem_pool_global_pool_mprotect_config mprotect_config;
-    ABTU_align_member_var(ABT_CONFIG_STATIC_CACHELINE_SIZE)
-        ABTI_sync_lifo bucket_lifo; /* LIFO of available buckets. */
-    ABTU_align_member_var(ABT_CONFIG_STATIC_CACHELINE_SIZE)
-        ABTI_sync_lifo mem_page_lifo; /* LIFO of non-empty pages. */
+    ABT_bool use_sharded_lifo; /* Use ABTI_sync_sharded_lifo for buckets. */
+    int num_nodes;             /* Number of NUMA nodes. */
+    ABTI_mem_pool_global_pool_node nodes[ABT_MEM_POOL_MAX_NODES];
     ABTU_align_member_var(ABT_CONFIG_STATIC_CACHELINE_SIZE)
         ABTD_atomic_ptr p_mem_page_empty; /* List of empty pages. */
+    ABTU_align_member_var(ABT_CONFIG_STATIC_CACHELINE_SIZE)
+        /* Size of pages that are allocated and not released to the OS. */
+        ABTD_atomic_size page_mem_size;
     ABTU_align_member_var(ABT_CONFIG_STATIC_CACHELINE_SIZE)
         /* List of the remaining headers that are not enough to create one
          * complete bucket. This is protected by a spinlock. The number of
          * headers is stored in partial_bucket.bucket_info.num_headers. */
         ABTD_spinlock partial_bucket_lock;
     ABTI_mem_pool_header *partial_bucket;
+    ABTU_align_member_var(ABT_CONFIG_STATIC_CACHELINE_SIZE)
+        ABTI_mem_pool_global_pool_stats stats;
 } ABTI_mem_pool_global_pool;
 
+/*
+ * List of headers that threads other than the owner of a local pool return to
+ * that local pool.  Any thread pushes a header while only the owner takes all
+ * the headers at once, so there is no ABA problem.
+ */
+typedef struct ABTI_mem_pool_remote_list {
+    ABTU_align_member_var(ABT_CONFIG_STATIC_CACHELINE_SIZE)
+        ABTD_atomic_ptr p_head;   /* Headers connected via p_next */
+    ABTD_atomic_size num_headers; /* Approximate number of headers */
+    size_t max_headers; /* Headers are not pushed beyond this number. */
+} ABTI_mem_pool_remote_list;
+
 /*
  * To efficiently take/return multiple headers per bucket, headers are stored as
  * follows in the local pool.
@@ -103,26 +179,73 @@ typedef struct ABTI_mem_pool_local_pool {
     size_t num_headers_per_bucket; /* Cached value to reduce dereference. It
                                       must be equal to
                                       p_global_pool->num_headers_per_bucket. */
+    size_t num_local_buckets; /* Cached value of
+                                 p_global_pool->num_local_buckets. */
+    /* Headers returned by other threads (NULL if not used).  They are taken
+     * before buckets of the global pool. */
+    ABTI_mem_pool_remote_list *p_remote_list;
+    ABTD_atomic_int node; /* NUMA node from which buckets are taken first.  It
+                             can be updated by another thread when the CPU
+                             binding of the owner changes. */
     size_t bucket_index;
+    /* Number of elements allocated since the last flush to the statistics of
+     * the global pool.  Only the owner accesses it. */
+    size_t num_allocs;
     ABTI_mem_pool_header *buckets[ABT_MEM_POOL_MAX_LOCAL_BUCKETS];
 } ABTI_mem_pool_local_pool;
 
 void ABTI_mem_pool_init_global_pool(
     ABTI_mem_pool_global_pool *p_global_pool, size_t num_headers_per_bucket,
-    size_t header_size, size_t header_offset, size_t page_size,
+    size_t num_local_buckets, size_t header_size, size_t header_offset,
+    size_t page_size,
     const ABTU_MEM_LARGEPAGE_TYPE *lp_type_requests,
     uint32_t num_lp_type_requests, size_t alignment_hint,
-    ABTI_mem_pool_global_pool_mprotect_config *p_mprotect_config);
+    ABTI_mem_pool_global_pool_mprotect_config *p_mprotect_config,
+    ABT_bool use_sharded_lifo, int num_nodes);
 void ABTI_mem_pool_destroy_global_pool(
     ABTI_mem_pool_global_pool *p_global_pool);
+uint64_t ABTI_mem_pool_get_num_remote_buckets(
+    const ABTI_mem_pool_global_pool *p_global_pool, int node);
+size_t
+ABTI_mem_pool_get_page_mem_size(const ABTI_mem_pool_global_pool *p_global_pool);
+void ABTI_mem_pool_get_stats(const ABTI_mem_pool_global_pool *p_global_pool,
+                             ABTI_mem_pool_stats *p_stats);
+void ABTI_mem_pool_flush_local_stats(ABTI_mem_pool_local_pool *p_local_pool);
+ABTU_ret_err int
+ABTI_mem_pool_prealloc_global_pool(ABTI_mem_pool_global_pool *p_global_pool,
+                                   size_t num_headers, size_t sys_page_size,
+                                   ABT_bool require_first_type);
+ABTU_ret_err int
+ABTI_mem_pool_trim_global_pool(ABTI_mem_pool_global_pool *p_global_pool,
+                               size_t sys_page_size, size_t huge_page_size,
+                               size_t *p_trimmed_size);
 ABTU_ret_err int
 ABTI_mem_pool_init_local_pool(ABTI_mem_pool_local_pool *p_local_pool,
-                              ABTI_mem_pool_global_pool *p_global_pool);
+                              ABTI_mem_pool_global_pool *p_global_pool,
+                              int node);
 void ABTI_mem_pool_destroy_local_pool(ABTI_mem_pool_local_pool *p_local_pool);
 int ABTI_mem_pool_take_bucket(ABTI_mem_pool_global_pool *p_global_pool,
-                              ABTI_mem_pool_header **p_bucket);
+                              int node, ABTI_mem_pool_header **p_bucket);
 void ABTI_mem_pool_return_bucket(ABTI_mem_pool_global_pool *p_global_pool,
-                                 ABTI_mem_pool_header *bucket);
+                                 int node, ABTI_mem_pool_header *bucket);
+void ABTI_mem_pool_init_remote_list(ABTI_mem_pool_remote_list *p_remote_list,
+                                    size_t max_headers);
+void ABTI_mem_pool_take_remote_list(ABTI_mem_pool_local_pool *p_local_pool);
+void ABTI_mem_pool_return_remote_list(ABTI_mem_pool_global_pool *p_global_pool,
+                                      int node,
+                                      ABTI_mem_pool_remote_list *p_remote_list);
+
+static inline int
+ABTI_mem_pool_get_local_node(ABTI_mem_pool_local_pool *p_local_pool)
+{
+    return ABTD_atomic_relaxed_load_int(&p_local_pool->node);
+}
+
+static inline void
+ABTI_mem_pool_set_local_node(ABTI_mem_pool_local_pool *p_local_pool, int node)
+{
+    ABTD_atomic_relaxed_store_int(&p_local_pool->node, node);
+}
 
 ABTU_ret_err static inline int
 ABTI_mem_pool_alloc(ABTI_mem_pool_local_pool *p_local_pool, void **p_mem)
@@ -135,13 +258,21 @@ ABTI_mem_pool_alloc(ABTI_mem_pool_local_pool *p_local_pool, void **p_mem)
     ABTI_ASSERT(num_headers_in_cur_bucket >= 1);
     if (num_headers_in_cur_bucket == 1) {
         /*cur_bucket will be empty after allocation. */
-        if (bucket_index == 0) {
+        if (bucket_index == 0 && p_local_pool->p_remote_list &&
+            ABTD_atomic_relaxed_load_ptr(
+                &p_local_pool->p_remote_list->p_head)) {
+            /* cur_bucket is the last header in this pool.  Let's reuse headers
+             * that other threads have returned. */
+            ABTI_mem_pool_take_remote_list(p_local_pool);
+        } else if (bucket_index == 0) {
             /* cur_bucket is the last header in this pool.
              * Let's get some buckets from the global pool. */
             size_t i;
+            const int node = ABTI_mem_pool_get_local_node(p_local_pool);
+            ABTI_mem_pool_flush_local_stats(p_local_pool);
             for (i = 0; i < ABT_MEM_POOL_NUM_TAKE_BUCKETS; i++) {
                 int abt_errno =
-                    ABTI_mem_pool_take_bucket(p_local_pool->p_global_pool,
+                    ABTI_mem_pool_take_bucket(p_local_pool->p_global_pool, node,
                                               &p_local_pool->buckets[i]);
                 if (ABTI_IS_ERROR_CHECK_ENABLED && abt_errno != ABT_SUCCESS) {
                     /* Return buckets that have been already taken. */
@@ -149,6 +280,7 @@ ABTI_mem_pool_alloc(ABTI_mem_pool_local_pool *p_local_pool, void **p_mem)
                     size_t j;
                     for (j = 0; j < i; j++) {
                         ABTI_mem_pool_return_bucket(p_local_pool->p_global_pool,
+                                                    node,
                                                     p_local_pool->buckets[j]);
                     }
 #endif
@@ -159,7 +291,7 @@ ABTI_mem_pool_alloc(ABTI_mem_pool_local_pool *p_local_pool, void **p_mem)
         } else {
             p_local_pool->bucket_index = bucket_index - 1;
         }
-        /* Now buckets[bucket_index] is full of headers. */
+        /* Now buckets[bucket_index] has at least one header. */
     } else {
         /* Let's return the header in the bucket. */
         ABTI_mem_pool_header *p_next = cur_bucket->p_next;
@@ -167,6 +299,9 @@ ABTI_mem_pool_alloc(ABTI_mem_pool_local_pool *p_local_pool, void **p_mem)
         p_local_pool->buckets[bucket_index] = p_next;
     }
     /* At least one header is available in the current bucket. */
+    p_local_pool->num_allocs++;
+    /* The element will be dirtied, so trimming must release it again. */
+    cur_bucket->trim_tag = 0;
     *p_mem = (void *)cur_bucket;
     return ABT_SUCCESS;
 }
@@ -181,20 +316,24 @@ static inline void ABTI_mem_pool_free(ABTI_mem_pool_local_pool *p_local_pool,
     if (cur_bucket->bucket_info.num_headers ==
         p_local_pool->num_headers_per_bucket) {
         /* cur_bucket is full. */
-        if (++bucket_index == ABT_MEM_POOL_MAX_LOCAL_BUCKETS) {
+        const size_t num_local_buckets = p_local_pool->num_local_buckets;
+        if (++bucket_index == num_local_buckets) {
             size_t i;
+            const int node = ABTI_mem_pool_get_local_node(p_local_pool);
             /* All buckets are full, so let's return some old buckets. */
             for (i = 0; i < ABT_MEM_POOL_NUM_RETURN_BUCKETS; i++) {
-                ABTI_mem_pool_return_bucket(p_local_pool->p_global_pool,
+                ABTI_mem_pool_return_bucket(p_local_pool->p_global_pool, node,
                                             p_local_pool->buckets[i]);
             }
-            for (i = ABT_MEM_POOL_NUM_RETURN_BUCKETS;
-                 i < ABT_MEM_POOL_MAX_LOCAL_BUCKETS; i++) {
+            ABTD_atomic_fetch_add_uint64(&p_local_pool->p_global_pool->stats
+                                              .num_returns,
+                                         ABT_MEM_POOL_NUM_RETURN_BUCKETS);
+            for (i = ABT_MEM_POOL_NUM_RETURN_BUCKETS; i < num_local_buckets;
+                 i++) {
                 p_local_pool->buckets[i - ABT_MEM_POOL_NUM_RETURN_BUCKETS] =
                     p_local_pool->buckets[i];
             }
-            bucket_index = ABT_MEM_POOL_MAX_LOCAL_BUCKETS -
-                           ABT_MEM_POOL_NUM_RETURN_BUCKETS;
+            bucket_index = num_local_buckets - ABT_MEM_POOL_NUM_RETURN_BUCKETS;
         }
         p_local_pool->bucket_index = bucket_index;
         p_freed_header->p_next = NULL;
@@ -208,4 +347,68 @@ static inline void ABTI_mem_pool_free(ABTI_mem_pool_local_pool *p_local_pool,
     /* At least one header is available in the current bucket. */
 }
 
+/* Return mem to the local pool that owns p_remote_list.  This function can be
+ * called by any thread.  Return ABT_FALSE without returning mem if the list is
+ * full. */
+static inline ABT_bool
+ABTI_mem_pool_remote_free(ABTI_mem_pool_remote_list *p_remote_list, void *mem)
+{
+    if (ABTD_atomic_relaxed_load_size(&p_remote_list->num_headers) >=
+        p_remote_list->max_headers)
+        return ABT_FALSE;
+    /* Count it before pushing it so that the owner does not decrement the
+     * counter below zero. */
+    ABTD_atomic_fetch_add_size(&p_remote_list->num_headers, 1);
+    ABTI_mem_pool_header *p_header = (ABTI_mem_pool_header *)mem;
+    void *p_cur_head;
+    do {
+        p_cur_head = ABTD_atomic_acquire_load_ptr(&p_remote_list->p_head);
+        p_header->p_next = (ABTI_mem_pool_header *)p_cur_head;
+    } while (!ABTD_atomic_bool_cas_weak_ptr(&p_remote_list->p_head,
+                                            p_cur_head, p_header));
+    return ABT_TRUE;
+}
+
+/* Allocate num elements at once.  If it fails, no element is allocated. */
+ABTU_ret_err static inline int
+ABTI_mem_pool_alloc_many(ABTI_mem_pool_local_pool *p_local_pool, size_t num,
+                         void **mems)
+{
+    size_t i = 0;
+    while (i < num) {
+        size_t bucket_index = p_local_pool->bucket_index;
+        ABTI_mem_pool_header *cur_bucket = p_local_pool->buckets[bucket_index];
+        size_t num_headers_in_cur_bucket = cur_bucket->bucket_info.num_headers;
+        /* Headers except for the last one in the current bucket are taken
+         * together, so the bucket information is updated only once.  The last
+         * one is taken by ABTI_mem_pool_alloc(), which refills the local
+         * pool. */
+        size_t num_takes =
+            ABTU_min_size(num - i, num_headers_in_cur_bucket - 1);
+        if (num_takes > 0) {
+            size_t j;
+            for (j = 0; j < num_takes; j++) {
+                /* See ABTI_mem_pool_alloc(). */
+                cur_bucket->trim_tag = 0;
+                mems[i++] = (void *)cur_bucket;
+                cur_bucket = cur_bucket->p_next;
+            }
+            cur_bucket->bucket_info.num_headers =
+                num_headers_in_cur_bucket - num_takes;
+            p_local_pool->buckets[bucket_index] = cur_bucket;
+            p_local_pool->num_allocs += num_takes;
+        } else {
+            int abt_errno = ABTI_mem_pool_alloc(p_local_pool, &mems[i]);
+            if (ABTI_IS_ERROR_CHECK_ENABLED && abt_errno != ABT_SUCCESS) {
+                /* Return elements that have been already taken. */
+                while (i > 0)
+                    ABTI_mem_pool_free(p_local_pool, mems[--i]);
+                return abt_errno;
+            }
+            i++;
+        }
+    }
+    return ABT_SUCCESS;
+}
+
 #endif /* ABTI_MEM_POOL_H_INCLUDED */
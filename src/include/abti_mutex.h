@@ -36,18 +36,214 @@ static inline ABT_mutex ABTI_mutex_get_handle(ABTI_mutex *p_mutex)
 #endif
 }
 
+#ifndef ABT_CONFIG_USE_SIMPLE_MUTEX
+/* If the first waiter is a ULT on the same execution stream, the unlock
+ * operation hands over the lock to it by keeping the lock taken and setting
+ * p_handover to that waiter.  The waiter owns the lock once it resets
+ * p_handover to NULL.  Until then, trylock, spinlock, and lock called by a
+ * tasklet can take over the lock in the same way; otherwise, they might spin
+ * forever while the waiter cannot run on the execution stream that they
+ * occupy. */
+
+/* Return ABT_TRUE if the caller takes the lock handed over to p_thread. */
+static inline ABT_bool ABTI_mutex_take_handover(ABTI_mutex *p_mutex,
+                                                ABTI_thread *p_thread)
+{
+    return (p_thread && ABTD_atomic_bool_cas_strong_ptr(&p_mutex->p_handover,
+                                                        (void *)p_thread,
+                                                        NULL))
+               ? ABT_TRUE
+               : ABT_FALSE;
+}
+
+/* Return ABT_FALSE if the lock is acquired. */
+static inline ABT_bool ABTI_mutex_try_acquire(ABTI_mutex *p_mutex)
+{
+    if (!ABTD_spinlock_try_acquire(&p_mutex->lock))
+        return ABT_FALSE;
+    ABTI_thread *p_thread =
+        (ABTI_thread *)ABTD_atomic_relaxed_load_ptr(&p_mutex->p_handover);
+    return ABTI_mutex_take_handover(p_mutex, p_thread) ? ABT_FALSE : ABT_TRUE;
+}
+
+/* A queued mutex (ABTI_MUTEX_ATTR_QUEUED) is an MCS lock in which
+ * ABTI_mutex_queue serves as the queue node of the lock holder, so a waiter
+ * needs its queue node only until it takes the lock and can keep it on its
+ * stack.  Each waiter waits on its own node: a ULT suspends while an external
+ * thread busy-waits on is_waiting.  The lock is handed over in FIFO order.
+ *
+ * The lock is handed over to a ULT by setting p_handover to its node.  The ULT
+ * owns the lock once it resets p_handover to NULL, so, as with the other
+ * mutexes, trylock, spinlock, and lock called by a tasklet can take over the
+ * lock until then.  They do not join the queue; otherwise, they would wait
+ * behind a suspended ULT that cannot run on the execution stream that they
+ * occupy.  A ULT whose lock has been taken over keeps its place at the head of
+ * the queue and waits for the next handover. */
+typedef struct ABTI_mutex_qnode {
+    ABTD_atomic_ptr p_next;     /* next waiter (ABTI_mutex_qnode *) */
+    ABTD_atomic_int is_waiting; /* 0 once the lock is handed over (if
+                                 * busy-waiting) */
+    ABTI_ythread *p_ythread;    /* waiting ULT (NULL if busy-waiting) */
+    ABTD_spinlock lock;         /* lock for suspending and resuming p_ythread */
+    ABT_bool is_suspended;      /* whether p_ythread is suspended */
+} ABTI_mutex_qnode;
+
+static inline void ABTI_mutex_queue_init(ABTI_mutex_queue *p_queue)
+{
+    ABTD_atomic_relaxed_store_ptr(&p_queue->p_tail, NULL);
+    ABTD_atomic_relaxed_store_ptr(&p_queue->p_next, NULL);
+}
+
+static inline ABT_bool ABTI_mutex_queue_is_locked(ABTI_mutex_queue *p_queue)
+{
+    return ABTD_atomic_acquire_load_ptr(&p_queue->p_tail) ? ABT_TRUE
+                                                          : ABT_FALSE;
+}
+
+/* Return ABT_FALSE if the lock is acquired. */
+static inline ABT_bool ABTI_mutex_queue_try_acquire(ABTI_mutex_queue *p_queue)
+{
+    return ABTD_atomic_bool_cas_strong_ptr(&p_queue->p_tail, NULL,
+                                           (void *)p_queue)
+               ? ABT_FALSE
+               : ABT_TRUE;
+}
+
+/* Return ABT_FALSE if the lock is acquired or taken over from a ULT. */
+static inline ABT_bool ABTI_mutex_queue_try_take(ABTI_mutex *p_mutex)
+{
+    if (!ABTI_mutex_queue_try_acquire(&p_mutex->waiters.queue))
+        return ABT_FALSE;
+    void *p_node = ABTD_atomic_relaxed_load_ptr(&p_mutex->p_handover);
+    return (p_node && ABTD_atomic_bool_cas_strong_ptr(&p_mutex->p_handover,
+                                                      p_node, NULL))
+               ? ABT_FALSE
+               : ABT_TRUE;
+}
+
+/* If p_ythread is NULL, the caller is an external thread and busy-waits. */
+static inline void ABTI_mutex_queue_acquire(ABTI_xstream **pp_local_xstream,
+                                            ABTI_ythread *p_ythread,
+                                            ABTI_mutex *p_mutex)
+{
+    ABTI_mutex_queue *p_queue = &p_mutex->waiters.queue;
+    while (1) {
+        void *p_prev = ABTD_atomic_relaxed_load_ptr(&p_queue->p_tail);
+        if (!p_prev) {
+            if (!ABTI_mutex_queue_try_acquire(p_queue))
+                return;
+            continue;
+        }
+        ABTI_mutex_qnode node;
+        ABTD_atomic_relaxed_store_ptr(&node.p_next, NULL);
+        ABTD_atomic_relaxed_store_int(&node.is_waiting, 1);
+        node.p_ythread = p_ythread;
+        ABTD_spinlock_clear(&node.lock);
+        node.is_suspended = ABT_FALSE;
+        if (!ABTD_atomic_bool_cas_strong_ptr(&p_queue->p_tail, p_prev,
+                                             (void *)&node))
+            continue;
+        /* Link node to its predecessor. */
+        if (p_prev == (void *)p_queue) {
+            ABTD_atomic_release_store_ptr(&p_queue->p_next, (void *)&node);
+        } else {
+            ABTI_mutex_qnode *p_prev_node = (ABTI_mutex_qnode *)p_prev;
+            ABTD_atomic_release_store_ptr(&p_prev_node->p_next, (void *)&node);
+        }
+        /* Wait until the lock is handed over. */
+        if (p_ythread) {
+            while (1) {
+                ABTD_spinlock_acquire(&node.lock);
+                if (ABTD_atomic_bool_cas_strong_ptr(&p_mutex->p_handover,
+                                                    (void *)&node, NULL)) {
+                    ABTD_spinlock_release(&node.lock);
+                    break;
+                }
+                /* The lock has not been handed over or has been taken over. */
+                node.is_suspended = ABT_TRUE;
+                ABTI_ythread_suspend_unlock(pp_local_xstream, p_ythread,
+                                            &node.lock,
+                                            ABT_SYNC_EVENT_TYPE_MUTEX,
+                                            (void *)p_mutex);
+            }
+        } else {
+            while (ABTD_atomic_acquire_load_int(&node.is_waiting))
+                ABTD_atomic_pause();
+        }
+        /* This waiter takes the lock.  Replace node with p_queue since node
+         * is about to be freed. */
+        void *p_next = ABTD_atomic_acquire_load_ptr(&node.p_next);
+        if (!p_next) {
+            ABTD_atomic_relaxed_store_ptr(&p_queue->p_next, NULL);
+            if (ABTD_atomic_bool_cas_strong_ptr(&p_queue->p_tail,
+                                                (void *)&node, (void *)p_queue))
+                return;
+            /* A new waiter is being linked to node. */
+            while (!(p_next = ABTD_atomic_acquire_load_ptr(&node.p_next)))
+                ABTD_atomic_pause();
+        }
+        ABTD_atomic_relaxed_store_ptr(&p_queue->p_next, p_next);
+        return;
+    }
+}
+
+static inline void ABTI_mutex_queue_release(ABTI_local *p_local,
+                                            ABTI_mutex *p_mutex)
+{
+    ABTI_mutex_queue *p_queue = &p_mutex->waiters.queue;
+    ABTI_mutex_qnode *p_next =
+        (ABTI_mutex_qnode *)ABTD_atomic_acquire_load_ptr(&p_queue->p_next);
+    if (!p_next) {
+        if (ABTD_atomic_bool_cas_strong_ptr(&p_queue->p_tail, (void *)p_queue,
+                                            NULL))
+            return;
+        /* A new waiter is being linked to p_queue. */
+        while (!(p_next = (ABTI_mutex_qnode *)ABTD_atomic_acquire_load_ptr(
+                     &p_queue->p_next)))
+            ABTD_atomic_pause();
+    }
+    /* Hand over the lock to p_next.  p_next may not be accessed once its
+     * waiter observes is_waiting == 0 or resets p_handover. */
+    ABTI_ythread *p_ythread = p_next->p_ythread;
+    if (p_ythread) {
+        ABTD_spinlock_acquire(&p_next->lock);
+        ABT_bool is_suspended = p_next->is_suspended;
+        p_next->is_suspended = ABT_FALSE;
+        ABTD_atomic_release_store_ptr(&p_mutex->p_handover, (void *)p_next);
+        ABTD_spinlock_release(&p_next->lock);
+        if (is_suspended)
+            ABTI_ythread_resume_and_push(p_local, p_ythread);
+    } else {
+        ABTD_atomic_release_store_int(&p_next->is_waiting, 0);
+    }
+}
+#endif
+
 static inline void ABTI_mutex_init(ABTI_mutex *p_mutex)
 {
     ABTD_spinlock_clear(&p_mutex->lock);
 #ifndef ABT_CONFIG_USE_SIMPLE_MUTEX
     ABTD_spinlock_clear(&p_mutex->waiter_lock);
-    ABTI_waitlist_init(&p_mutex->waitlist);
+    p_mutex->num_handovers = 0;
+    p_mutex->num_ext_waiters = 0;
+    ABTI_waitlist_init(&p_mutex->waiters.waitlist);
+    ABTD_atomic_relaxed_store_ptr(&p_mutex->p_handover, NULL);
 #endif
     p_mutex->attrs = ABTI_MUTEX_ATTR_NONE;
     p_mutex->nesting_cnt = 0;
     p_mutex->owner_id = 0;
 }
 
+static inline void ABTI_mutex_init_with_attrs(ABTI_mutex *p_mutex, int attrs)
+{
+    ABTI_mutex_init(p_mutex);
+    p_mutex->attrs = attrs;
+#ifndef ABT_CONFIG_USE_SIMPLE_MUTEX
+    if (attrs & ABTI_MUTEX_ATTR_QUEUED)
+        ABTI_mutex_queue_init(&p_mutex->waiters.queue);
+#endif
+}
+
 static inline void ABTI_mutex_fini(ABTI_mutex *p_mutex)
 {
 #ifndef ABT_CONFIG_USE_SIMPLE_MUTEX
@@ -55,10 +251,52 @@ static inline void ABTI_mutex_fini(ABTI_mutex *p_mutex)
 #endif
 }
 
+static inline void ABTI_mutex_spinlock_no_recursion(ABTI_mutex *p_mutex)
+{
+#ifndef ABT_CONFIG_USE_SIMPLE_MUTEX
+    if (p_mutex->attrs & ABTI_MUTEX_ATTR_QUEUED) {
+        /* Busy-wait outside the queue. */
+        while (ABTI_mutex_queue_try_take(p_mutex)) {
+            while (ABTI_mutex_queue_is_locked(&p_mutex->waiters.queue) &&
+                   !ABTD_atomic_relaxed_load_ptr(&p_mutex->p_handover))
+                ;
+        }
+        return;
+    }
+    while (ABTI_mutex_try_acquire(p_mutex)) {
+        while (ABTD_spinlock_is_locked(&p_mutex->lock) &&
+               !ABTD_atomic_relaxed_load_ptr(&p_mutex->p_handover))
+            ;
+    }
+#else
+    ABTD_spinlock_acquire(&p_mutex->lock);
+#endif
+}
+
 static inline void ABTI_mutex_lock_no_recursion(ABTI_local **pp_local,
                                                 ABTI_mutex *p_mutex)
 {
 #ifndef ABT_CONFIG_USE_SIMPLE_MUTEX
+    ABTI_xstream *p_local_xstream = ABTI_local_get_xstream_or_null(*pp_local);
+    ABTI_thread *p_self = NULL;
+    if (!ABTI_IS_EXT_THREAD_ENABLED || p_local_xstream)
+        p_self = p_local_xstream->p_thread;
+    ABTI_ythread *p_ythread =
+        p_self ? ABTI_thread_get_ythread_or_null(p_self) : NULL;
+    if (p_self && !p_ythread) {
+        /* A tasklet occupies its execution stream while waiting, so the lock
+         * might be handed over to a ULT that cannot run until the tasklet
+         * finishes.  Busy-wait outside the waiters so that it can take over
+         * such a lock. */
+        ABTI_mutex_spinlock_no_recursion(p_mutex);
+        return;
+    }
+    if (p_mutex->attrs & ABTI_MUTEX_ATTR_QUEUED) {
+        ABTI_mutex_queue_acquire(&p_local_xstream, p_ythread, p_mutex);
+        if (p_ythread)
+            *pp_local = ABTI_xstream_get_local(p_local_xstream);
+        return;
+    }
     while (ABTD_spinlock_try_acquire(&p_mutex->lock)) {
         /* Failed to take a lock, so let's add it to the waiter list. */
         ABTD_spinlock_acquire(&p_mutex->waiter_lock);
@@ -68,11 +306,16 @@ static inline void ABTI_mutex_lock_no_recursion(ABTI_local **pp_local,
             ABTD_spinlock_release(&p_mutex->waiter_lock);
             break;
         }
-        /* Wait on waitlist. */
-        ABTI_waitlist_wait_and_unlock(pp_local, &p_mutex->waitlist,
+        /* Wait on waitlist.  Unlock always wakes up external threads. */
+        if (!p_ythread)
+            p_mutex->num_ext_waiters++;
+        ABTI_waitlist_wait_and_unlock(pp_local, &p_mutex->waiters.waitlist,
                                       &p_mutex->waiter_lock,
                                       ABT_SYNC_EVENT_TYPE_MUTEX,
                                       (void *)p_mutex);
+        /* The lock might have been handed over to this waiter. */
+        if (ABTI_mutex_take_handover(p_mutex, p_self))
+            break;
     }
     /* Take a lock. */
 #else
@@ -116,13 +359,26 @@ static inline void ABTI_mutex_lock(ABTI_local **pp_local, ABTI_mutex *p_mutex)
 
 static inline ABT_bool ABTI_mutex_is_locked(ABTI_mutex *p_mutex)
 {
+#ifndef ABT_CONFIG_USE_SIMPLE_MUTEX
+    if (p_mutex->attrs & ABTI_MUTEX_ATTR_QUEUED)
+        return ABTI_mutex_queue_is_locked(&p_mutex->waiters.queue);
+#endif
     return ABTD_spinlock_is_locked(&p_mutex->lock);
 }
 
 static inline int ABTI_mutex_trylock_no_recursion(ABTI_mutex *p_mutex)
 {
+#ifndef ABT_CONFIG_USE_SIMPLE_MUTEX
+    if (p_mutex->attrs & ABTI_MUTEX_ATTR_QUEUED) {
+        return ABTI_mutex_queue_try_take(p_mutex) ? ABT_ERR_MUTEX_LOCKED
+                                                  : ABT_SUCCESS;
+    }
+    return ABTI_mutex_try_acquire(p_mutex) ? ABT_ERR_MUTEX_LOCKED
+                                           : ABT_SUCCESS;
+#else
     return ABTD_spinlock_try_acquire(&p_mutex->lock) ? ABT_ERR_MUTEX_LOCKED
                                                      : ABT_SUCCESS;
+#endif
 }
 
 static inline int ABTI_mutex_trylock(ABTI_local *p_local, ABTI_mutex *p_mutex)
@@ -147,11 +403,6 @@ static inline int ABTI_mutex_trylock(ABTI_local *p_local, ABTI_mutex *p_mutex)
     }
 }
 
-static inline void ABTI_mutex_spinlock_no_recursion(ABTI_mutex *p_mutex)
-{
-    ABTD_spinlock_acquire(&p_mutex->lock);
-}
-
 static inline void ABTI_mutex_spinlock(ABTI_local *p_local, ABTI_mutex *p_mutex)
 {
     if (p_mutex->attrs & ABTI_MUTEX_ATTR_RECURSIVE) {
@@ -174,10 +425,53 @@ static inline void ABTI_mutex_unlock_no_recursion(ABTI_local *p_local,
                                                   ABTI_mutex *p_mutex)
 {
 #ifndef ABT_CONFIG_USE_SIMPLE_MUTEX
+    if (p_mutex->attrs & ABTI_MUTEX_ATTR_QUEUED) {
+        ABTI_mutex_queue_release(p_local, p_mutex);
+        return;
+    }
+    /* ABT_mutex_memory can be used before Argobots is initialized. */
+    ABTI_global *p_global = ABTI_global_get_global_or_null();
+    uint32_t max_handovers = p_global ? p_global->mutex_max_handovers : 0;
+    uint32_t max_wakeups = p_global ? p_global->mutex_max_wakeups : 1;
+    ABTI_xstream *p_local_xstream = ABTI_local_get_xstream_or_null(p_local);
+
     ABTD_spinlock_acquire(&p_mutex->waiter_lock);
-    ABTD_spinlock_release(&p_mutex->lock);
     /* Operations of waitlist must be done while taking waiter_lock. */
-    ABTI_waitlist_broadcast(p_local, &p_mutex->waitlist);
+    ABTI_thread *p_head = p_mutex->waiters.waitlist.p_head;
+    ABTI_ythread *p_head_ythread =
+        p_head ? ABTI_thread_get_ythread_or_null(p_head) : NULL;
+    if (p_head_ythread && p_local_xstream &&
+        p_head_ythread->thread.p_last_xstream == p_local_xstream &&
+        p_mutex->num_handovers < max_handovers) {
+        /* Hand over the lock to the first waiter without releasing it.  The
+         * handover is limited to a ULT on the same execution stream, which
+         * runs soon; handing over the lock to a waiter that needs to be
+         * scheduled by the OS would stall all the other lockers. */
+        p_mutex->num_handovers++;
+        ABTD_atomic_release_store_ptr(&p_mutex->p_handover,
+                                      (void *)&p_head_ythread->thread);
+        ABTI_waitlist_signal(p_local, &p_mutex->waiters.waitlist);
+    } else {
+        /* Release the lock so that a running work unit can take it and wake
+         * up at most max_wakeups ULTs, which compete for the lock.  Waking up
+         * all the ULTs only makes them contend for the lock.  External threads
+         * are always woken up since they do not depend on an execution stream
+         * that might be occupied by a work unit waiting for them. */
+        p_mutex->num_handovers = 0;
+        ABTD_spinlock_release(&p_mutex->lock);
+        if (p_mutex->num_ext_waiters) {
+            p_mutex->num_ext_waiters = 0;
+            ABTI_waitlist_signal_ythreads(p_local, &p_mutex->waiters.waitlist,
+                                          max_wakeups);
+        } else {
+            uint32_t i;
+            for (i = 0; i < max_wakeups; i++) {
+                if (ABTI_waitlist_is_empty(&p_mutex->waiters.waitlist))
+                    break;
+                ABTI_waitlist_signal(p_local, &p_mutex->waiters.waitlist);
+            }
+        }
+    }
     ABTD_spinlock_release(&p_mutex->waiter_lock);
 #else
     ABTD_spinlock_release(&p_mutex->lock);
@@ -50,12 +50,32 @@ static inline void ABTI_pool_dec_num_blocked(ABTI_pool *p_pool)
     ABTD_atomic_fetch_sub_int32(&p_pool->num_blocked, 1);
 }
 
+/* Wake up schedulers parking on this pool.  The preceding push must be ordered
+ * before the load of num_waiters; ABTI_pool_waiter_park() does the opposite,
+ * so either this pusher sees the waiter or the waiter sees the work unit (see
+ * ABTI_pool_waiter_park()).  If membarrier() is available, the parking side
+ * issues it to execute a fence on behalf of this pusher, so this frequent path
+ * needs only a compiler barrier.  No lock is taken if nobody parks. */
+static inline void ABTI_pool_wake_waiters(ABTI_pool *p_pool)
+{
+    if (ABTI_global_get_global()->use_membarrier) {
+        ABTD_compiler_barrier();
+    } else {
+        ABTD_atomic_seq_cst_mem_barrier();
+    }
+    if (ABTU_unlikely(ABTD_atomic_relaxed_load_int(&p_pool->num_waiters) >
+                      0)) {
+        ABTI_pool_notify_waiters(p_pool);
+    }
+}
+
 static inline void ABTI_pool_push(ABTI_pool *p_pool, ABT_unit unit,
                                   ABT_pool_context context)
 {
     /* Push unit into pool */
     LOG_DEBUG_POOL_PUSH(p_pool, unit);
     p_pool->required_def.p_push(ABTI_pool_get_handle(p_pool), unit, context);
+    ABTI_pool_wake_waiters(p_pool);
 }
 
 static inline void ABTI_pool_add_thread(ABTI_thread *p_thread,
@@ -79,11 +99,15 @@ ABTU_ret_err static inline int ABTI_pool_remove(ABTI_pool *p_pool,
 static inline ABT_thread ABTI_pool_pop_wait(ABTI_pool *p_pool, double time_secs,
                                             ABT_pool_context context)
 {
-    ABTI_UB_ASSERT(p_pool->optional_def.p_pop_wait);
-    ABT_thread thread =
-        p_pool->optional_def.p_pop_wait(ABTI_pool_get_handle(p_pool), time_secs,
-                                        context);
-    LOG_DEBUG_POOL_POP(p_pool, thread);
+    ABT_thread thread;
+    if (p_pool->optional_def.p_pop_wait) {
+        thread = p_pool->optional_def.p_pop_wait(ABTI_pool_get_handle(p_pool),
+                                                 time_secs, context);
+        LOG_DEBUG_POOL_POP(p_pool, thread);
+    } else {
+        /* ABTI_pool_pop() logs it. */
+        thread = ABTI_pool_pop_wait_generic(p_pool, time_secs, context);
+    }
     return thread;
 }
 
@@ -116,6 +140,7 @@ static inline void ABTI_pool_push_many(ABTI_pool *p_pool, const ABT_unit *units,
     p_pool->optional_def.p_push_many(ABTI_pool_get_handle(p_pool), units, num,
                                      context);
     LOG_DEBUG_POOL_PUSH_MANY(p_pool, units, num);
+    ABTI_pool_wake_waiters(p_pool);
 }
 
 /* Increase num_scheds to mark the pool as having another scheduler. If the
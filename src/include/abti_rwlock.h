@@ -41,4 +41,78 @@ static inline ABT_rwlock ABTI_rwlock_get_handle(ABTI_rwlock *p_rwlock)
 #endif
 }
 
+/* A readers-writer lock is biased to readers (BRAVO) while reader_bias is set:
+ * a reader takes a lock by incrementing a reader slot of its execution stream
+ * instead of taking mutex.  A writer revokes reader_bias and waits until all
+ * the readers on reader slots release the lock.  Since a revocation is costly,
+ * reader_bias is not set again for a while after it. */
+
+/* Multiplied by the time of the last revocation. */
+#define ABTI_RWLOCK_READER_BIAS_INHIBIT_FACTOR 9.0
+
+static inline ABTI_rwlock_reader_slot *
+ABTI_rwlock_get_reader_slot(ABTI_rwlock *p_rwlock,
+                            ABTI_xstream *p_local_xstream)
+{
+    return &p_rwlock->reader_slots[p_local_xstream->rank &
+                                   (p_rwlock->num_reader_slots - 1)];
+}
+
+/* Move the counts of reader slots to reader_count and return the number of
+ * readers that hold a lock.  mutex must be locked and reader_bias must be
+ * unset.  Moving the counts does not change the total count, so readers on
+ * reader slots can release a lock in the middle of it. */
+static inline int ABTI_rwlock_collect_readers(ABTI_rwlock *p_rwlock)
+{
+    int i;
+    for (i = 0; i < p_rwlock->num_reader_slots; i++) {
+        p_rwlock->reader_count +=
+            ABTD_atomic_exchange_int(&p_rwlock->reader_slots[i].num_readers, 0);
+    }
+    return p_rwlock->reader_count;
+}
+
+/* Release a lock taken by a reader on a reader slot.  *pp_local is updated if
+ * the caller blocks on the mutex and resumes on another execution stream. */
+static inline void
+ABTI_rwlock_release_reader_slot(ABTI_local **pp_local, ABTI_rwlock *p_rwlock,
+                                ABTI_rwlock_reader_slot *p_slot)
+{
+    ABTD_atomic_fetch_sub_int(&p_slot->num_readers, 1);
+    /* This fence pairs with that in ABTI_rwlock_revoke_reader_bias(). */
+    ABTD_atomic_seq_cst_mem_barrier();
+    if (!ABTD_atomic_acquire_load_int(&p_rwlock->reader_bias)) {
+        /* A writer might be waiting for this reader. */
+        ABTI_mutex_lock(pp_local, &p_rwlock->mutex);
+        ABTI_cond_broadcast(*pp_local, &p_rwlock->cond);
+        ABTI_mutex_unlock(*pp_local, &p_rwlock->mutex);
+    }
+}
+
+/* Return ABT_FALSE if a lock is taken on a reader slot. */
+static inline ABT_bool
+ABTI_rwlock_try_rdlock_reader_slot(ABTI_local **pp_local, ABTI_rwlock *p_rwlock)
+{
+    ABTI_xstream *p_local_xstream = ABTI_local_get_xstream_or_null(*pp_local);
+    if ((ABTI_IS_EXT_THREAD_ENABLED && !p_local_xstream) ||
+        !ABTD_atomic_acquire_load_int(&p_rwlock->reader_bias))
+        return ABT_TRUE;
+    ABTI_rwlock_reader_slot *p_slot =
+        ABTI_rwlock_get_reader_slot(p_rwlock, p_local_xstream);
+    ABTD_atomic_fetch_add_int(&p_slot->num_readers, 1);
+    ABTD_atomic_seq_cst_mem_barrier();
+    if (ABTD_atomic_acquire_load_int(&p_rwlock->reader_bias))
+        return ABT_FALSE;
+    /* A writer is revoking reader_bias. */
+    ABTI_rwlock_release_reader_slot(pp_local, p_rwlock, p_slot);
+    return ABT_TRUE;
+}
+
+/* mutex must be locked. */
+static inline void ABTI_rwlock_revoke_reader_bias(ABTI_rwlock *p_rwlock)
+{
+    ABTD_atomic_relaxed_store_int(&p_rwlock->reader_bias, 0);
+    ABTD_atomic_seq_cst_mem_barrier();
+}
+
 #endif /* ABTI_RWLOCK_H_INCLUDED */
@@ -57,9 +57,34 @@ static inline void ABTI_sched_discard_and_free(ABTI_global *p_global,
     }
 }
 
+/* Set the waiter of the scheduler.  The previous waiter may be freed after
+ * this routine returns since no ABTI_sched_wake() accesses it anymore. */
+static inline void ABTI_sched_set_waiter(ABTI_sched *p_sched,
+                                         ABTI_pool_waiter *p_waiter)
+{
+    ABTD_spinlock_acquire(&p_sched->waiter_lock);
+    ABTD_atomic_relaxed_store_ptr(&p_sched->p_waiter, (void *)p_waiter);
+    ABTD_spinlock_release(&p_sched->waiter_lock);
+}
+
+/* Wake up the scheduler if it is parking so that it checks requests. */
+static inline void ABTI_sched_wake(ABTI_sched *p_sched)
+{
+    if (!ABTD_atomic_relaxed_load_ptr(&p_sched->p_waiter))
+        return;
+    /* The lock keeps the waiter from being freed while it is notified. */
+    ABTD_spinlock_acquire(&p_sched->waiter_lock);
+    ABTI_pool_waiter *p_waiter =
+        (ABTI_pool_waiter *)ABTD_atomic_relaxed_load_ptr(&p_sched->p_waiter);
+    if (p_waiter)
+        ABTI_pool_waiter_notify(p_waiter);
+    ABTD_spinlock_release(&p_sched->waiter_lock);
+}
+
 static inline void ABTI_sched_set_request(ABTI_sched *p_sched, uint32_t req)
 {
     ABTD_atomic_fetch_or_uint32(&p_sched->request, req);
+    ABTI_sched_wake(p_sched);
 }
 
 static inline void ABTI_sched_unset_request(ABTI_sched *p_sched, uint32_t req)
@@ -142,4 +142,101 @@ static inline ABTI_sync_lifo_element *ABTI_sync_lifo_pop(ABTI_sync_lifo *p_lifo)
 #endif
 }
 
+/*
+ * ABTI_sync_sharded_lifo consists of multiple list-based LIFOs (shards), each
+ * of which is protected by a spinlock, so it does not need atomic operations
+ * for two consecutive pointers to avoid the ABA problem.  Threads start from
+ * different shards according to their hints and move to another shard instead
+ * of waiting for a busy one, which spreads contention on a single top pointer
+ * over shards.  The order of elements is LIFO only within each shard, and pop
+ * can miss an element that is pushed concurrently to a shard that has been
+ * checked.
+ */
+#define ABTI_SYNC_SHARDED_LIFO_NUM_SHARDS_LOG2 3
+#define ABTI_SYNC_SHARDED_LIFO_NUM_SHARDS                                      \
+    (1 << ABTI_SYNC_SHARDED_LIFO_NUM_SHARDS_LOG2)
+
+typedef struct {
+    ABTU_align_member_var(ABT_CONFIG_STATIC_CACHELINE_SIZE)
+        ABTD_spinlock lock;
+    ABTD_atomic_ptr p_top;
+} ABTI_sync_sharded_lifo_shard;
+
+typedef struct {
+    ABTI_sync_sharded_lifo_shard shards[ABTI_SYNC_SHARDED_LIFO_NUM_SHARDS];
+} ABTI_sync_sharded_lifo;
+
+static inline void ABTI_sync_sharded_lifo_init(ABTI_sync_sharded_lifo *p_lifo)
+{
+    ABTI_ASSERT(p_lifo);
+    int i;
+    for (i = 0; i < ABTI_SYNC_SHARDED_LIFO_NUM_SHARDS; i++) {
+        ABTD_spinlock_clear(&p_lifo->shards[i].lock);
+        ABTD_atomic_relaxed_store_ptr(&p_lifo->shards[i].p_top, NULL);
+    }
+}
+
+static inline void
+ABTI_sync_sharded_lifo_destroy(ABTI_sync_sharded_lifo *p_lifo)
+{
+    ; /* Do nothing. */
+}
+
+/* Return the first shard for hint, which is typically an address.  Nearby
+ * addresses are mapped to different shards. */
+static inline int ABTI_sync_sharded_lifo_get_shard(uintptr_t hint)
+{
+    return (int)((((uint64_t)hint) * (uint64_t)0x9e3779b97f4a7c15) >>
+                 (64 - ABTI_SYNC_SHARDED_LIFO_NUM_SHARDS_LOG2));
+}
+
+static inline void
+ABTI_sync_sharded_lifo_push(ABTI_sync_sharded_lifo *p_lifo, uintptr_t hint,
+                            ABTI_sync_lifo_element *p_elem)
+{
+    const int shard = ABTI_sync_sharded_lifo_get_shard(hint);
+    ABTI_sync_sharded_lifo_shard *p_shard;
+    int i;
+    for (i = 0;; i++) {
+        p_shard = &p_lifo->shards[(shard + i) &
+                                  (ABTI_SYNC_SHARDED_LIFO_NUM_SHARDS - 1)];
+        if (i == ABTI_SYNC_SHARDED_LIFO_NUM_SHARDS) {
+            /* All the shards are busy.  Wait for the first one. */
+            ABTD_spinlock_acquire(&p_shard->lock);
+            break;
+        } else if (!ABTD_spinlock_try_acquire(&p_shard->lock)) {
+            break;
+        }
+    }
+    p_elem->p_next =
+        (ABTI_sync_lifo_element *)ABTD_atomic_relaxed_load_ptr(&p_shard->p_top);
+    ABTD_atomic_relaxed_store_ptr(&p_shard->p_top, p_elem);
+    ABTD_spinlock_release(&p_shard->lock);
+}
+
+static inline ABTI_sync_lifo_element *
+ABTI_sync_sharded_lifo_pop(ABTI_sync_sharded_lifo *p_lifo, uintptr_t hint)
+{
+    const int shard = ABTI_sync_sharded_lifo_get_shard(hint);
+    int i;
+    for (i = 0; i < ABTI_SYNC_SHARDED_LIFO_NUM_SHARDS; i++) {
+        ABTI_sync_sharded_lifo_shard *p_shard =
+            &p_lifo->shards[(shard + i) &
+                            (ABTI_SYNC_SHARDED_LIFO_NUM_SHARDS - 1)];
+        /* Skip an empty shard without taking its lock. */
+        if (!ABTD_atomic_relaxed_load_ptr(&p_shard->p_top))
+            continue;
+        ABTD_spinlock_acquire(&p_shard->lock);
+        ABTI_sync_lifo_element *p_cur_top =
+            (ABTI_sync_lifo_element *)ABTD_atomic_relaxed_load_ptr(
+                &p_shard->p_top);
+        if (p_cur_top)
+            ABTD_atomic_relaxed_store_ptr(&p_shard->p_top, p_cur_top->p_next);
+        ABTD_spinlock_release(&p_shard->lock);
+        if (p_cur_top)
+            return p_cur_top;
+    }
+    return NULL;
+}
+
 #endif /* ABTI_SYNC_LIFO_H_INCLUDED */
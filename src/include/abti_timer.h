@@ -15,6 +15,13 @@ static inline double ABTI_get_wtime(void)
     return ABTD_time_read_sec(&t);
 }
 
+/* Convert a deadline (in seconds, based on ABTI_get_wtime()) to a priority of a
+ * work unit.  An earlier deadline gives a smaller (i.e., higher) priority. */
+static inline int64_t ABTI_deadline_to_priority(double deadline)
+{
+    return (int64_t)(deadline * 1.0e9);
+}
+
 static inline ABTI_timer *ABTI_timer_get_ptr(ABT_timer timer)
 {
 #ifndef ABT_CONFIG_DISABLE_ERROR_CHECK
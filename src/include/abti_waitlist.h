@@ -279,6 +279,54 @@ static inline void ABTI_waitlist_broadcast(ABTI_local *p_local,
     }
 }
 
+/* Wake up all the non-yieldable waiters and at most max_ythreads ULTs. */
+static inline void ABTI_waitlist_signal_ythreads(ABTI_local *p_local,
+                                                 ABTI_waitlist *p_waitlist,
+                                                 uint32_t max_ythreads)
+{
+    ABTI_thread *p_prev = NULL, *p_thread = p_waitlist->p_head;
+    ABT_bool wakeup_nonyieldable = ABT_FALSE;
+    while (p_thread) {
+        ABTI_thread *p_next = p_thread->p_next;
+        ABTI_ythread *p_ythread = ABTI_thread_get_ythread_or_null(p_thread);
+        if (p_ythread && max_ythreads == 0) {
+            /* Keep this ULT in the list. */
+            p_prev = p_thread;
+            p_thread = p_next;
+            continue;
+        }
+        /* Remove p_thread from the list. */
+        if (p_prev) {
+            p_prev->p_next = p_next;
+        } else {
+            p_waitlist->p_head = p_next;
+        }
+        if (!p_next)
+            p_waitlist->p_tail = p_prev;
+        p_thread->p_next = NULL;
+        if (p_ythread) {
+            max_ythreads--;
+            ABTI_ythread_resume_and_push(p_local, p_ythread);
+        } else {
+            /* When p_thread is an external thread or a tasklet */
+            wakeup_nonyieldable = ABT_TRUE;
+            ABTD_atomic_release_store_int(&p_thread->state,
+                                          ABT_THREAD_STATE_READY);
+        }
+        /* After updating p_thread->state, p_thread can be updated and
+         * freed. */
+        p_thread = p_next;
+    }
+#ifndef ABT_CONFIG_ACTIVE_WAIT_POLICY
+    if (wakeup_nonyieldable) {
+        ABTD_futex_broadcast(&p_waitlist->futex);
+    }
+#else
+    /* Do nothing. */
+    (void)wakeup_nonyieldable;
+#endif
+}
+
 static inline ABT_bool ABTI_waitlist_is_empty(ABTI_waitlist *p_waitlist)
 {
     return p_waitlist->p_head ? ABT_FALSE : ABT_TRUE;
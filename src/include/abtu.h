@@ -327,6 +327,16 @@ void ABTU_free_largepage(void *ptr, size_t size, ABTU_MEM_LARGEPAGE_TYPE type);
  * (PROT_READ | PROT_WRITE) is permitted if if protect == ABT_FALSE. */
 ABTU_ret_err int ABTU_mprotect(void *addr, size_t size, ABT_bool protect);
 
+/* Release physical pages of a given page-aligned region to the OS.  The region
+ * stays accessible; its pages are filled with zero when they are touched
+ * again. */
+ABTU_ret_err int ABTU_madvise_dontneed(void *addr, size_t size);
+
+/* Set the memory policy of a given page-aligned region so that its pages are
+ * preferably placed on a NUMA node whose OS node ID is node.  It does not move
+ * pages that have been already touched. */
+ABTU_ret_err int ABTU_mbind_preferred(void *addr, size_t size, int node);
+
 /* String-to-integer functions. */
 ABTU_ret_err int ABTU_atoi(const char *str, int *p_val, ABT_bool *p_overflow);
 ABTU_ret_err int ABTU_atoui32(const char *str, uint32_t *p_val,
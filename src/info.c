@@ -10,6 +10,9 @@ ABTU_ret_err static int info_print_thread_stacks_in_pool(ABTI_global *p_global,
                                                          ABTI_pool *p_pool);
 static void info_trigger_print_all_thread_stacks(
     FILE *fp, double timeout, void (*cb_func)(ABT_bool, void *), void *arg);
+#ifdef ABT_CONFIG_USE_MEM_POOL
+static void info_print_mem_stats(ABTI_global *p_global, FILE *fp);
+#endif
 
 /** @defgroup INFO  Information
  * This group is for getting runtime information of Argobots.  The routines in
@@ -192,6 +195,39 @@ static void info_trigger_print_all_thread_stacks(
  *   to \c ABT_TRUE if Argobots is configured to enable lazy allocation for ULT
  *   stacks by default.  Otherwise, \c val is set to \c ABT_FALSE.
  *
+ * - \c ABT_INFO_QUERY_KIND_STACK_USAGE_HISTOGRAM
+ *
+ *   \c val must be a pointer to an array of \c uint64_t that has
+ *   \c ABT_INFO_STACK_USAGE_HISTOGRAM_SIZE elements.  \c val is set to the
+ *   histogram of the usage of ULT stacks that have been tracked since
+ *   \c ABT_init().  The usage of one in N ULT stacks taken from memory pools is
+ *   tracked if the environmental variable \c ABT_STACK_USAGE_SAMPLING is set to
+ *   N.  When a tracked stack is freed, its pages beyond
+ *   \c ABT_STACK_USAGE_KEEP_SIZE bytes from the stack top are returned to the
+ *   OS; pages of untracked stacks are not.  All the elements are set to zero if
+ *   the stack usage is not tracked.
+ *   See \c ABT_INFO_STACK_USAGE_HISTOGRAM_SIZE for the range of each bin.
+ *
+ * - \c ABT_INFO_QUERY_KIND_MAX_STACK_USAGE
+ *
+ *   \c val must be a pointer to a variable of type \c size_t.  \c val is set
+ *   to the maximum usage of ULT stacks in bytes that have been tracked since
+ *   \c ABT_init().  \c val is set to zero if the stack usage is not tracked.
+ *
+ * - \c ABT_INFO_QUERY_KIND_NUM_MEM_NODES
+ *
+ *   \c val must be a pointer to a variable of type \c int.  \c val is set to
+ *   the number of NUMA nodes for which memory pools keep separate buckets and
+ *   pages.  The nodes follow the CPU topology unless the environmental
+ *   variable \c ABT_MEM_NUM_NODES emulates them.  \c val is set to 1 if
+ *   memory pools are disabled.
+ *
+ * - \c ABT_INFO_QUERY_KIND_NUM_MEM_REMOTE_BUCKETS
+ *
+ *   \c val must be a pointer to a variable of type \c uint64_t.  \c val is
+ *   set to the number of buckets of memory pools that execution streams have
+ *   taken from NUMA nodes other than theirs since \c ABT_init().
+ *
  * @changev20
  * \DOC_DESC_V1X_RETURN_INFO_IF_POSSIBLE
  * @endchangev20
@@ -435,6 +471,43 @@ int ABT_info_query_config(ABT_info_query_kind query_kind, void *val)
             *((ABT_bool *)val) = ABT_TRUE;
 #endif
             break;
+        case ABT_INFO_QUERY_KIND_STACK_USAGE_HISTOGRAM: {
+            ABTI_global *p_global;
+            int i;
+            ABTI_SETUP_GLOBAL(&p_global);
+            for (i = 0; i < ABT_INFO_STACK_USAGE_HISTOGRAM_SIZE; i++) {
+#ifdef ABT_CONFIG_USE_MEM_POOL
+                ((uint64_t *)val)[i] = ABTD_atomic_relaxed_load_uint64(
+                    &p_global->stack_usage_histogram[i]);
+#else
+                ((uint64_t *)val)[i] = 0;
+#endif
+            }
+        } break;
+        case ABT_INFO_QUERY_KIND_MAX_STACK_USAGE: {
+            ABTI_global *p_global;
+            ABTI_SETUP_GLOBAL(&p_global);
+#ifdef ABT_CONFIG_USE_MEM_POOL
+            *((size_t *)val) =
+                ABTD_atomic_relaxed_load_size(&p_global->max_stack_usage);
+#else
+            *((size_t *)val) = 0;
+#endif
+        } break;
+        case ABT_INFO_QUERY_KIND_NUM_MEM_NODES: {
+            ABTI_global *p_global;
+            ABTI_SETUP_GLOBAL(&p_global);
+#ifdef ABT_CONFIG_USE_MEM_POOL
+            *((int *)val) = p_global->mem_pool_desc.num_nodes;
+#else
+            *((int *)val) = 1;
+#endif
+        } break;
+        case ABT_INFO_QUERY_KIND_NUM_MEM_REMOTE_BUCKETS: {
+            ABTI_global *p_global;
+            ABTI_SETUP_GLOBAL(&p_global);
+            *((uint64_t *)val) = ABTI_mem_get_num_remote_buckets(p_global);
+        } break;
         default:
             ABTI_HANDLE_ERROR(ABT_ERR_INV_QUERY_KIND);
     }
@@ -490,6 +563,59 @@ int ABT_info_print_config(FILE *fp)
     return ABT_SUCCESS;
 }
 
+/**
+ * @ingroup INFO
+ * @brief   Print statistics of the memory pools of Argobots.
+ *
+ * \c ABT_info_print_mem_stats() writes statistics of the memory pools that
+ * Argobots uses for ULT stacks and work-unit descriptors to the output stream
+ * \c fp.  The statistics include the number of allocations, the number of
+ * buckets that execution streams and external threads take from and return to
+ * the global memory pools, the number and the types of allocated pages, and
+ * the number of allocations that do not use a memory pool.  They are counted
+ * since \c ABT_init() and help to tune \c ABT_MEM_PAGE_SIZE,
+ * \c ABT_MEM_MAX_NUM_STACKS, and \c ABT_MEM_MAX_NUM_DESCS.
+ *
+ * Each execution stream adds its allocations to the statistics when it checks
+ * events, so recent allocations of other execution streams might not be
+ * counted yet.
+ *
+ * @note
+ * \DOC_NOTE_INFO_PRINT
+ *
+ * @contexts
+ * \DOC_CONTEXT_INIT \DOC_CONTEXT_NOCTXSWITCH
+ *
+ * @errors
+ * \DOC_ERROR_SUCCESS
+ * \DOC_ERROR_UNINITIALIZED
+ *
+ * @undefined
+ * \DOC_UNDEFINED_NULL_PTR{\c fp}
+ * \DOC_UNDEFINED_SYS_FILE{\c fp}
+ *
+ * @param[in] fp  output stream
+ * @return Error code
+ */
+int ABT_info_print_mem_stats(FILE *fp)
+{
+    ABTI_UB_ASSERT(fp);
+
+    ABTI_global *p_global;
+    ABTI_SETUP_GLOBAL(&p_global);
+#ifdef ABT_CONFIG_USE_MEM_POOL
+    ABTI_xstream *p_local_xstream =
+        ABTI_local_get_xstream_or_null(ABTI_local_get_local());
+    if (p_local_xstream)
+        ABTI_mem_flush_local_stats(p_local_xstream);
+    info_print_mem_stats(p_global, fp);
+#else
+    fprintf(fp, "Memory pools are disabled.\n");
+#endif
+    fflush(fp);
+    return ABT_SUCCESS;
+}
+
 /**
  * @ingroup INFO
  * @brief   Print the information of all execution streams.
@@ -1203,6 +1329,12 @@ void ABTI_info_print_config(ABTI_global *p_global, FILE *fp)
                 "\n");
     fprintf(fp, " - default scheduler sleep duration : %" PRIu64 " [ns]\n",
             p_global->sched_sleep_nsec);
+    fprintf(fp, " - max. # of mutex handovers: %" PRIu32 "\n",
+            p_global->mutex_max_handovers);
+    fprintf(fp, " - max. # of mutex wakeups: %" PRIu32 "\n",
+            p_global->mutex_max_wakeups);
+    fprintf(fp, " - pool wake-up fence: %s\n",
+            p_global->use_membarrier ? "membarrier" : "seq_cst");
 
     fprintf(fp, " - timer function: "
 #if defined(ABT_CONFIG_USE_CLOCK_GETTIME)
@@ -1221,6 +1353,67 @@ void ABTI_info_print_config(ABTI_global *p_global, FILE *fp)
     fprintf(fp, " - stack page size: %zu KB\n", p_global->mem_sp_size / 1024);
     fprintf(fp, " - max. # of stacks per ES: %u\n", p_global->mem_max_stacks);
     fprintf(fp, " - max. # of descs per ES: %u\n", p_global->mem_max_descs);
+    fprintf(fp, " - # of buckets per local pool: %u\n",
+            p_global->mem_num_local_buckets);
+    fprintf(fp, " - remote free: %s\n",
+            (p_global->mem_remote_free == ABT_TRUE) ? "on" : "off");
+    fprintf(fp, " - sharded bucket LIFO: %s\n",
+            (p_global->mem_sharded_lifo == ABT_TRUE) ? "on" : "off");
+    if (p_global->mem_prealloc_threads) {
+        fprintf(fp, " - preallocated ULTs: %" PRIu32 "%s\n",
+                p_global->mem_prealloc_threads,
+                p_global->mem_prealloc_strict ? " (strict)" : "");
+    } else {
+        fprintf(fp, " - preallocated ULTs: none\n");
+    }
+    fprintf(fp, " - max. stack size of stack size classes: %zu KB\n",
+            p_global->mem_max_stack_class_size / 1024);
+    if (p_global->stack_grow_commit_size) {
+        fprintf(fp, " - growable stacks: %zu KB accessible at first\n",
+                p_global->stack_grow_commit_size / 1024);
+    } else {
+        fprintf(fp, " - growable stacks: off\n");
+    }
+    fprintf(fp, " - # of NUMA nodes: %d%s\n", p_global->mem_pool_desc.num_nodes,
+            p_global->mem_num_nodes ? " (emulated)" : "");
+    fprintf(fp, " - # of buckets taken from remote nodes: %" PRIu64 "\n",
+            ABTI_mem_get_num_remote_buckets(p_global));
+    fprintf(fp, " - size of pages in use: %zu KB\n",
+            ABTI_mem_get_page_mem_size(p_global) / 1024);
+    if (p_global->mem_trim_high_water) {
+        fprintf(fp, " - background trimming high-water mark: %zu KB\n",
+                p_global->mem_trim_high_water / 1024);
+    } else {
+        fprintf(fp, " - background trimming high-water mark: disabled\n");
+    }
+    if (p_global->stack_usage_sampling) {
+        int i;
+        fprintf(fp, " - stack usage tracking: one in %" PRIu32 " stacks\n",
+                p_global->stack_usage_sampling);
+        fprintf(fp, " - kept stack size of tracked stacks: %zu KB\n",
+                p_global->stack_usage_keep_size / 1024);
+        fprintf(fp, " - max. stack usage: %zu B\n",
+                ABTD_atomic_relaxed_load_size(&p_global->max_stack_usage));
+        fprintf(fp, " - stack usage histogram:\n");
+        for (i = 0; i < ABT_INFO_STACK_USAGE_HISTOGRAM_SIZE; i++) {
+            uint64_t count = ABTD_atomic_relaxed_load_uint64(
+                &p_global->stack_usage_histogram[i]);
+            if (i != ABT_INFO_STACK_USAGE_HISTOGRAM_SIZE - 1) {
+                fprintf(fp, "   - <= %zu KB: %" PRIu64 "\n",
+                        ((size_t)ABT_INFO_STACK_USAGE_HISTOGRAM_MIN << i) /
+                            1024,
+                        count);
+            } else {
+                fprintf(fp, "   - > %zu KB: %" PRIu64 "\n",
+                        ((size_t)ABT_INFO_STACK_USAGE_HISTOGRAM_MIN
+                         << (i - 1)) /
+                            1024,
+                        count);
+            }
+        }
+    } else {
+        fprintf(fp, " - stack usage tracking: disabled\n");
+    }
     switch (p_global->mem_lp_alloc) {
         case ABTI_MEM_LP_MALLOC:
             fprintf(fp, " - large page allocation: malloc\n");
@@ -1407,3 +1600,73 @@ ABTU_ret_err static int print_all_thread_stacks(ABTI_global *p_global, FILE *fp)
     info_finalize_pool_set(&pool_set);
     return ABT_SUCCESS;
 }
+
+#ifdef ABT_CONFIG_USE_MEM_POOL
+static void info_print_mem_pool_stats(FILE *fp, const char *name,
+                                      const ABTI_mem_pool_global_pool *p_pool,
+                                      double elapsed_time)
+{
+    ABTI_mem_pool_stats stats;
+    ABTI_mem_pool_get_stats(p_pool, &stats);
+    fprintf(fp, " - %s (element: %zu B, bucket: %zu elements):\n", name,
+            stats.element_size, stats.num_headers_per_bucket);
+    fprintf(fp, "   - # of allocations: %" PRIu64 " (%.1f /s)\n",
+            stats.num_allocs,
+            elapsed_time > 0.0 ? stats.num_allocs / elapsed_time : 0.0);
+    /* A bucket is taken when a local pool runs out of elements. */
+    fprintf(fp, "   - # of buckets taken by local pools: %" PRIu64,
+            stats.num_takes);
+    if (stats.num_allocs != 0) {
+        fprintf(fp, " (%.2f%% of allocations)",
+                100.0 * stats.num_takes / stats.num_allocs);
+    }
+    fprintf(fp, "\n");
+    fprintf(fp, "   - # of buckets returned by local pools: %" PRIu64 "\n",
+            stats.num_returns);
+    fprintf(fp, "   - # of buckets in local pools (approx.): %" PRId64 "\n",
+            (int64_t)(stats.num_takes - stats.num_returns));
+    fprintf(fp, "   - # of buckets made of new memory: %" PRIu64 "\n",
+            stats.num_new_buckets);
+    fprintf(fp,
+            "   - # of pages: %" PRIu64 " (malloc), %" PRIu64
+            " (memalign), %" PRIu64 " (mmap), %" PRIu64 " (mmap hugepage)\n",
+            stats.num_pages[ABTU_MEM_LARGEPAGE_MALLOC],
+            stats.num_pages[ABTU_MEM_LARGEPAGE_MEMALIGN],
+            stats.num_pages[ABTU_MEM_LARGEPAGE_MMAP],
+            stats.num_pages[ABTU_MEM_LARGEPAGE_MMAP_HUGEPAGE]);
+    fprintf(fp, "   - # of pages of a fallback type: %" PRIu64 "\n",
+            stats.num_lp_fallbacks);
+    fprintf(fp, "   - size of pages in use: %zu KB\n",
+            stats.page_mem_size / 1024);
+    /* Memory at the end of a page that cannot hold an element is wasted. */
+    fprintf(fp, "   - size of unused page tails: %zu KB\n",
+            stats.unused_page_mem_size / 1024);
+}
+
+static void info_print_mem_stats(ABTI_global *p_global, FILE *fp)
+{
+    int i;
+    const double elapsed_time =
+        ABTI_get_wtime() - p_global->mem_stats_start_time;
+    fprintf(fp, "Memory Pool Statistics:\n");
+    fprintf(fp, " - elapsed time: %.3f [s]\n", elapsed_time);
+    fprintf(fp, " - # of allocations without memory pools: %" PRIu64 "\n",
+            ABTD_atomic_relaxed_load_uint64(
+                &p_global->mem_num_malloc_fallbacks));
+    info_print_mem_pool_stats(fp, "stacks", &p_global->mem_pool_stack,
+                              elapsed_time);
+    info_print_mem_pool_stats(fp, "descriptors", &p_global->mem_pool_desc,
+                              elapsed_time);
+    for (i = 0; i < ABTI_MEM_NUM_STACK_CLASSES; i++) {
+        const ABTI_mem_pool_global_pool *p_pool =
+            &p_global->mem_pool_stack_classes[i];
+        char name[64];
+        /* Print only stack size classes that have been used. */
+        if (ABTD_atomic_relaxed_load_uint64(&p_pool->stats.num_takes) == 0)
+            continue;
+        sprintf(name, "stacks of %zu KB",
+                ABTI_mem_get_stack_class_size(i) / 1024);
+        info_print_mem_pool_stats(fp, name, p_pool, elapsed_time);
+    }
+}
+#endif
@@ -5,6 +5,7 @@
 
 abt_sources += \
 	mem/malloc.c \
+	mem/mem.c \
 	mem/mem_pool.c \
 	mem/valgrind.c
 
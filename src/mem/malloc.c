@@ -11,7 +11,10 @@
  * ABT_finalize is called.  When an ES terminates its execution, stacks and
  * empty pages that it holds are deallocated.  Non-empty pages are added to the
  * global data.  When ABTI_finalize is called, all memory objects that we have
- * allocated are returned to the higher-level memory allocator. */
+ * allocated are returned to the higher-level memory allocator.  Physical memory
+ * of idle elements in the global pools can be returned to the OS by
+ * ABT_mem_trim() or by the background trimming (ABT_MEM_TRIM_HIGH_WATER), while
+ * their virtual address ranges are kept. */
 
 ABTU_ret_err int ABTI_mem_init(ABTI_global *p_global)
 {
@@ -64,33 +67,125 @@ ABTU_ret_err int ABTI_mem_init(ABTI_global *p_global)
     } else {
         mprotect_config.enabled = ABT_FALSE;
     }
-    if ((stacksize & (2 * ABT_CONFIG_STATIC_CACHELINE_SIZE - 1)) == 0) {
+    ABTI_mem_pool_global_pool_mprotect_config stack_mprotect_config =
+        mprotect_config;
+    size_t stack_page_size = p_global->mem_sp_size;
+    if (p_global->stack_grow_commit_size) {
+        /* Each growable stack starts at a page boundary, and only its top is
+         * accessible at first.  The guard page is included in the protected
+         * part. */
+        stacksize = ABTU_roundup_size(stacksize, p_global->sys_page_size);
+        stack_mprotect_config.enabled = ABT_TRUE;
+        stack_mprotect_config.check_error = ABT_TRUE;
+        stack_mprotect_config.offset = 0;
+        stack_mprotect_config.page_size =
+            thread_stacksize - p_global->stack_grow_commit_size;
+        stack_mprotect_config.alignment = p_global->sys_page_size;
+        if (stack_page_size < stacksize * 4 + sizeof(ABTI_mem_pool_page)) {
+            stack_page_size =
+                ABTU_roundup_size(stacksize * 4 + sizeof(ABTI_mem_pool_page),
+                                  p_global->mem_page_size);
+        }
+    } else if ((stacksize & (2 * ABT_CONFIG_STATIC_CACHELINE_SIZE - 1)) == 0) {
         /* Avoid a multiple of 2 * cacheline size to avoid cache bank conflict.
          */
         stacksize += ABT_CONFIG_STATIC_CACHELINE_SIZE;
     }
+    /* Each NUMA node has its own buckets and pages. */
+    const int num_nodes = p_global->mem_num_nodes
+                              ? p_global->mem_num_nodes
+                              : ABTD_affinity_get_num_nodes();
+    const size_t num_local_buckets = p_global->mem_num_local_buckets;
     ABTI_mem_pool_init_global_pool(&p_global->mem_pool_stack,
-                                   p_global->mem_max_stacks /
-                                       ABT_MEM_POOL_MAX_LOCAL_BUCKETS,
-                                   stacksize, thread_stacksize,
-                                   p_global->mem_sp_size, requested_types,
-                                   num_requested_types, p_global->mem_page_size,
-                                   &mprotect_config);
+                                   p_global->mem_max_stacks / num_local_buckets,
+                                   num_local_buckets, stacksize,
+                                   thread_stacksize, stack_page_size,
+                                   requested_types, num_requested_types,
+                                   p_global->mem_page_size,
+                                   &stack_mprotect_config,
+                                   p_global->mem_sharded_lifo, num_nodes);
+    /* Stacks of non-default sizes.  Each ES caches at most as much memory for
+     * each stack size class as for the default stack size. */
+    int i;
+    const size_t max_cached_stack_mem =
+        (size_t)p_global->mem_max_stacks * thread_stacksize;
+    for (i = 0; i < ABTI_MEM_NUM_STACK_CLASSES; i++) {
+        size_t class_stacksize = ABTI_mem_get_stack_class_size(i);
+        size_t class_header_size =
+            ABTU_roundup_size(class_stacksize + sizeof(ABTI_ythread),
+                              ABT_CONFIG_STATIC_CACHELINE_SIZE);
+        if ((class_header_size & (2 * ABT_CONFIG_STATIC_CACHELINE_SIZE - 1)) ==
+            0) {
+            class_header_size += ABT_CONFIG_STATIC_CACHELINE_SIZE;
+        }
+        size_t max_class_stacks =
+            ABTU_min_size(p_global->mem_max_stacks,
+                          max_cached_stack_mem / class_stacksize);
+        max_class_stacks = ABTU_max_size(max_class_stacks, num_local_buckets);
+        /* A page should have several stacks. */
+        size_t class_page_size = p_global->mem_sp_size;
+        if (class_page_size <
+            class_header_size * 4 + sizeof(ABTI_mem_pool_page)) {
+            class_page_size =
+                ABTU_roundup_size(class_header_size * 4 +
+                                      sizeof(ABTI_mem_pool_page),
+                                  p_global->mem_page_size);
+        }
+        ABTI_mem_pool_init_global_pool(&p_global->mem_pool_stack_classes[i],
+                                       max_class_stacks / num_local_buckets,
+                                       num_local_buckets, class_header_size,
+                                       class_stacksize, class_page_size,
+                                       requested_types, num_requested_types,
+                                       p_global->mem_page_size,
+                                       &mprotect_config,
+                                       p_global->mem_sharded_lifo, num_nodes);
+    }
     /* The last four bytes will be used to store a mempool flag */
     ABTI_STATIC_ASSERT((ABTI_MEM_POOL_DESC_ELEM_SIZE &
                         (ABT_CONFIG_STATIC_CACHELINE_SIZE - 1)) == 0);
     ABTI_mem_pool_init_global_pool(&p_global->mem_pool_desc,
-                                   p_global->mem_max_descs /
-                                       ABT_MEM_POOL_MAX_LOCAL_BUCKETS,
+                                   p_global->mem_max_descs / num_local_buckets,
+                                   num_local_buckets,
                                    ABTI_MEM_POOL_DESC_ELEM_SIZE, 0,
                                    p_global->mem_page_size, requested_types,
                                    num_requested_types, p_global->mem_page_size,
-                                   NULL);
+                                   NULL, p_global->mem_sharded_lifo,
+                                   num_nodes);
+    ABTD_spinlock_clear(&p_global->mem_remote_lock);
+    p_global->p_mem_remotes = NULL;
+    ABTD_spinlock_clear(&p_global->mem_trim_lock);
+    p_global->mem_trim_last_time = 0.0;
+    p_global->mem_trim_interval = ABTI_MEM_TRIM_INTERVAL;
+    for (i = 0; i < ABT_INFO_STACK_USAGE_HISTOGRAM_SIZE; i++) {
+        ABTD_atomic_relaxed_store_uint64(&p_global->stack_usage_histogram[i],
+                                         0);
+    }
+    ABTD_atomic_relaxed_store_size(&p_global->max_stack_usage, 0);
+    p_global->mem_stats_start_time = ABTI_get_wtime();
+    ABTD_atomic_relaxed_store_uint64(&p_global->mem_num_malloc_fallbacks, 0);
+    if (p_global->mem_prealloc_threads) {
+        /* Each ULT needs a stack and a descriptor. */
+        int prealloc_abt_errno =
+            ABTI_mem_pool_prealloc_global_pool(&p_global->mem_pool_stack,
+                                               p_global->mem_prealloc_threads,
+                                               p_global->sys_page_size,
+                                               p_global->mem_prealloc_strict);
+        if (prealloc_abt_errno == ABT_SUCCESS) {
+            prealloc_abt_errno = ABTI_mem_pool_prealloc_global_pool(
+                &p_global->mem_pool_desc, p_global->mem_prealloc_threads,
+                p_global->sys_page_size, p_global->mem_prealloc_strict);
+        }
+        if (prealloc_abt_errno != ABT_SUCCESS) {
+            ABTI_mem_pool_destroy_global_pool(&p_global->mem_pool_stack);
+            ABTI_mem_pool_destroy_global_pool(&p_global->mem_pool_desc);
+            ABTI_HANDLE_ERROR(prealloc_abt_errno);
+        }
+    }
 #ifndef ABT_CONFIG_DISABLE_EXT_THREAD
     int abt_errno;
     ABTD_spinlock_clear(&p_global->mem_pool_stack_lock);
     abt_errno = ABTI_mem_pool_init_local_pool(&p_global->mem_pool_stack_ext,
-                                              &p_global->mem_pool_stack);
+                                              &p_global->mem_pool_stack, 0);
     if (abt_errno != ABT_SUCCESS) {
         ABTI_mem_pool_destroy_global_pool(&p_global->mem_pool_stack);
         ABTI_mem_pool_destroy_global_pool(&p_global->mem_pool_desc);
@@ -98,14 +193,59 @@ ABTU_ret_err int ABTI_mem_init(ABTI_global *p_global)
     }
     ABTD_spinlock_clear(&p_global->mem_pool_desc_lock);
     abt_errno = ABTI_mem_pool_init_local_pool(&p_global->mem_pool_desc_ext,
-                                              &p_global->mem_pool_desc);
+                                              &p_global->mem_pool_desc, 0);
     if (abt_errno != ABT_SUCCESS) {
         ABTI_mem_pool_destroy_local_pool(&p_global->mem_pool_stack_ext);
         ABTI_mem_pool_destroy_global_pool(&p_global->mem_pool_stack);
         ABTI_mem_pool_destroy_global_pool(&p_global->mem_pool_desc);
         ABTI_HANDLE_ERROR(abt_errno);
     }
+    ABTD_spinlock_clear(&p_global->mem_pool_stack_class_lock);
+    for (i = 0; i < ABTI_MEM_NUM_STACK_CLASSES; i++) {
+        p_global->mem_pool_stack_class_ext[i].p_global_pool = NULL;
+    }
 #endif
+    if (p_global->stack_grow_commit_size) {
+        /* Growable stacks need a SIGSEGV handler. */
+        int grow_abt_errno = ABTD_stack_grow_init();
+        if (grow_abt_errno != ABT_SUCCESS) {
+            ABTI_mem_finalize(p_global);
+            ABTI_HANDLE_ERROR(grow_abt_errno);
+        }
+    }
+    return ABT_SUCCESS;
+}
+
+/* Take an unused ABTI_mem_remote or allocate a new one.  Elements that have
+ * been pushed to a reused one after its previous owner was freed are taken by
+ * the new owner. */
+ABTU_ret_err static int mem_get_remote(ABTI_global *p_global,
+                                       ABTI_mem_remote **pp_mem_remote)
+{
+    ABTI_mem_remote *p_mem_remote;
+    ABTD_spinlock_acquire(&p_global->mem_remote_lock);
+    for (p_mem_remote = p_global->p_mem_remotes; p_mem_remote;
+         p_mem_remote = p_mem_remote->p_next) {
+        if (!p_mem_remote->is_used)
+            break;
+    }
+    if (!p_mem_remote) {
+        int abt_errno =
+            ABTU_malloc(sizeof(ABTI_mem_remote), (void **)&p_mem_remote);
+        if (abt_errno != ABT_SUCCESS) {
+            ABTD_spinlock_release(&p_global->mem_remote_lock);
+            ABTI_HANDLE_ERROR(abt_errno);
+        }
+        ABTI_mem_pool_init_remote_list(&p_mem_remote->stack,
+                                       p_global->mem_max_stacks);
+        ABTI_mem_pool_init_remote_list(&p_mem_remote->desc,
+                                       p_global->mem_max_descs);
+        p_mem_remote->p_next = p_global->p_mem_remotes;
+        p_global->p_mem_remotes = p_mem_remote;
+    }
+    p_mem_remote->is_used = ABT_TRUE;
+    ABTD_spinlock_release(&p_global->mem_remote_lock);
+    *pp_mem_remote = p_mem_remote;
     return ABT_SUCCESS;
 }
 
@@ -113,32 +253,290 @@ ABTU_ret_err int ABTI_mem_init_local(ABTI_global *p_global,
                                      ABTI_xstream *p_local_xstream)
 {
     int abt_errno;
+    /* Take buckets from the NUMA node where this ES will run. */
+    int node = ABTI_mem_get_default_node(p_global, p_local_xstream->rank);
+    if (node < 0)
+        node = 0;
     abt_errno = ABTI_mem_pool_init_local_pool(&p_local_xstream->mem_pool_stack,
-                                              &p_global->mem_pool_stack);
+                                              &p_global->mem_pool_stack, node);
     ABTI_CHECK_ERROR(abt_errno);
     abt_errno = ABTI_mem_pool_init_local_pool(&p_local_xstream->mem_pool_desc,
-                                              &p_global->mem_pool_desc);
+                                              &p_global->mem_pool_desc, node);
     if (abt_errno != ABT_SUCCESS) {
         ABTI_mem_pool_destroy_local_pool(&p_local_xstream->mem_pool_stack);
         ABTI_HANDLE_ERROR(abt_errno);
     }
+    int i;
+    for (i = 0; i < ABTI_MEM_NUM_STACK_CLASSES; i++) {
+        p_local_xstream->mem_pool_stack_classes[i].p_global_pool = NULL;
+    }
+    p_local_xstream->stack_usage_count = 0;
+    p_local_xstream->p_mem_remote = NULL;
+    if (p_global->mem_remote_free) {
+        abt_errno = mem_get_remote(p_global, &p_local_xstream->p_mem_remote);
+        if (abt_errno != ABT_SUCCESS) {
+            ABTI_mem_pool_destroy_local_pool(&p_local_xstream->mem_pool_stack);
+            ABTI_mem_pool_destroy_local_pool(&p_local_xstream->mem_pool_desc);
+            ABTI_HANDLE_ERROR(abt_errno);
+        }
+        p_local_xstream->mem_pool_stack.p_remote_list =
+            &p_local_xstream->p_mem_remote->stack;
+        p_local_xstream->mem_pool_desc.p_remote_list =
+            &p_local_xstream->p_mem_remote->desc;
+    }
     return ABT_SUCCESS;
 }
 
 void ABTI_mem_finalize(ABTI_global *p_global)
 {
+    int i;
+    ABTD_stack_grow_finalize();
 #ifndef ABT_CONFIG_DISABLE_EXT_THREAD
     ABTI_mem_pool_destroy_local_pool(&p_global->mem_pool_stack_ext);
     ABTI_mem_pool_destroy_local_pool(&p_global->mem_pool_desc_ext);
+    for (i = 0; i < ABTI_MEM_NUM_STACK_CLASSES; i++) {
+        if (p_global->mem_pool_stack_class_ext[i].p_global_pool) {
+            ABTI_mem_pool_destroy_local_pool(
+                &p_global->mem_pool_stack_class_ext[i]);
+        }
+    }
 #endif
+    /* Elements in the remote lists are released together with pages. */
+    ABTI_mem_remote *p_mem_remote = p_global->p_mem_remotes;
+    while (p_mem_remote) {
+        ABTI_mem_remote *p_next = p_mem_remote->p_next;
+        ABTU_free(p_mem_remote);
+        p_mem_remote = p_next;
+    }
+    p_global->p_mem_remotes = NULL;
     ABTI_mem_pool_destroy_global_pool(&p_global->mem_pool_stack);
     ABTI_mem_pool_destroy_global_pool(&p_global->mem_pool_desc);
+    for (i = 0; i < ABTI_MEM_NUM_STACK_CLASSES; i++) {
+        ABTI_mem_pool_destroy_global_pool(
+            &p_global->mem_pool_stack_classes[i]);
+    }
 }
 
 void ABTI_mem_finalize_local(ABTI_xstream *p_local_xstream)
 {
+    int i;
+    ABTI_mem_remote *p_mem_remote = p_local_xstream->p_mem_remote;
+    if (p_mem_remote) {
+        /* Return elements that have been returned by other threads.  Elements
+         * that are pushed after this are taken by the next user of
+         * p_mem_remote. */
+        ABTI_mem_pool_return_remote_list(p_local_xstream->mem_pool_stack
+                                             .p_global_pool,
+                                         ABTI_mem_pool_get_local_node(
+                                             &p_local_xstream->mem_pool_stack),
+                                         &p_mem_remote->stack);
+        ABTI_mem_pool_return_remote_list(p_local_xstream->mem_pool_desc
+                                             .p_global_pool,
+                                         ABTI_mem_pool_get_local_node(
+                                             &p_local_xstream->mem_pool_desc),
+                                         &p_mem_remote->desc);
+    }
     ABTI_mem_pool_destroy_local_pool(&p_local_xstream->mem_pool_stack);
     ABTI_mem_pool_destroy_local_pool(&p_local_xstream->mem_pool_desc);
+    for (i = 0; i < ABTI_MEM_NUM_STACK_CLASSES; i++) {
+        if (p_local_xstream->mem_pool_stack_classes[i].p_global_pool) {
+            ABTI_mem_pool_destroy_local_pool(
+                &p_local_xstream->mem_pool_stack_classes[i]);
+        }
+    }
+    if (p_mem_remote) {
+        ABTI_global *p_global = ABTI_global_get_global();
+        ABTD_spinlock_acquire(&p_global->mem_remote_lock);
+        p_mem_remote->is_used = ABT_FALSE;
+        ABTD_spinlock_release(&p_global->mem_remote_lock);
+        p_local_xstream->p_mem_remote = NULL;
+    }
+}
+
+int ABTI_mem_get_default_node(ABTI_global *p_global, int rank)
+{
+    if (p_global->mem_num_nodes)
+        return rank % p_global->mem_num_nodes;
+    return p_global->set_affinity ? ABTD_affinity_get_default_node(rank) : -1;
+}
+
+void ABTI_mem_set_local_node(ABTI_xstream *p_xstream, int node)
+{
+    int i;
+    if (node < 0)
+        return;
+    ABTI_mem_pool_set_local_node(&p_xstream->mem_pool_stack, node);
+    ABTI_mem_pool_set_local_node(&p_xstream->mem_pool_desc, node);
+    /* Local pools of stack size classes that are not initialized yet take the
+     * node of mem_pool_stack when they are initialized. */
+    for (i = 0; i < ABTI_MEM_NUM_STACK_CLASSES; i++) {
+        ABTI_mem_pool_set_local_node(&p_xstream->mem_pool_stack_classes[i],
+                                     node);
+    }
+}
+
+/* Flush the statistics counted by the local pools of p_local_xstream, which
+ * must be the caller. */
+void ABTI_mem_flush_local_stats(ABTI_xstream *p_local_xstream)
+{
+    int i;
+    ABTI_mem_pool_flush_local_stats(&p_local_xstream->mem_pool_stack);
+    ABTI_mem_pool_flush_local_stats(&p_local_xstream->mem_pool_desc);
+    for (i = 0; i < ABTI_MEM_NUM_STACK_CLASSES; i++) {
+        if (p_local_xstream->mem_pool_stack_classes[i].p_global_pool) {
+            ABTI_mem_pool_flush_local_stats(
+                &p_local_xstream->mem_pool_stack_classes[i]);
+        }
+    }
+}
+
+/* Return the number of buckets that ESs took from NUMA nodes other than
+ * theirs. */
+uint64_t ABTI_mem_get_num_remote_buckets(ABTI_global *p_global)
+{
+    int node, i;
+    uint64_t num_remote_buckets = 0;
+    const int num_nodes = p_global->mem_pool_desc.num_nodes;
+    for (node = 0; node < num_nodes; node++) {
+        num_remote_buckets +=
+            ABTI_mem_pool_get_num_remote_buckets(&p_global->mem_pool_stack,
+                                                 node);
+        num_remote_buckets +=
+            ABTI_mem_pool_get_num_remote_buckets(&p_global->mem_pool_desc,
+                                                 node);
+        for (i = 0; i < ABTI_MEM_NUM_STACK_CLASSES; i++) {
+            num_remote_buckets += ABTI_mem_pool_get_num_remote_buckets(
+                &p_global->mem_pool_stack_classes[i], node);
+        }
+    }
+    return num_remote_buckets;
+}
+
+size_t ABTI_mem_get_page_mem_size(ABTI_global *p_global)
+{
+    int i;
+    size_t page_mem_size =
+        ABTI_mem_pool_get_page_mem_size(&p_global->mem_pool_stack) +
+        ABTI_mem_pool_get_page_mem_size(&p_global->mem_pool_desc);
+    for (i = 0; i < ABTI_MEM_NUM_STACK_CLASSES; i++) {
+        page_mem_size += ABTI_mem_pool_get_page_mem_size(
+            &p_global->mem_pool_stack_classes[i]);
+    }
+    return page_mem_size;
+}
+
+/* The caller must hold mem_trim_lock.  Memory kept in local pools of ESs and
+ * external threads is not trimmed. */
+ABTU_ret_err static int mem_trim_locked(ABTI_global *p_global,
+                                        size_t *p_trimmed_size)
+{
+    int i, abt_errno;
+    size_t trimmed_size = 0, pool_trimmed_size;
+    const size_t sys_page_size = p_global->sys_page_size;
+    const size_t huge_page_size = p_global->huge_page_size;
+
+    abt_errno = ABTI_mem_pool_trim_global_pool(&p_global->mem_pool_stack,
+                                               sys_page_size, huge_page_size,
+                                               &pool_trimmed_size);
+    if (abt_errno != ABT_SUCCESS)
+        goto fn_exit;
+    trimmed_size += pool_trimmed_size;
+    abt_errno = ABTI_mem_pool_trim_global_pool(&p_global->mem_pool_desc,
+                                               sys_page_size, huge_page_size,
+                                               &pool_trimmed_size);
+    if (abt_errno != ABT_SUCCESS)
+        goto fn_exit;
+    trimmed_size += pool_trimmed_size;
+    for (i = 0; i < ABTI_MEM_NUM_STACK_CLASSES; i++) {
+        abt_errno = ABTI_mem_pool_trim_global_pool(&p_global
+                                                        ->mem_pool_stack_classes
+                                                            [i],
+                                                   sys_page_size,
+                                                   huge_page_size,
+                                                   &pool_trimmed_size);
+        if (abt_errno != ABT_SUCCESS)
+            goto fn_exit;
+        trimmed_size += pool_trimmed_size;
+    }
+fn_exit:
+    p_global->mem_trim_last_time = ABTI_get_wtime();
+    *p_trimmed_size = trimmed_size;
+    return abt_errno;
+}
+
+ABTU_ret_err int ABTI_mem_trim(ABTI_global *p_global, size_t *p_trimmed_size)
+{
+    ABTD_spinlock_acquire(&p_global->mem_trim_lock);
+    int abt_errno = mem_trim_locked(p_global, p_trimmed_size);
+    ABTD_spinlock_release(&p_global->mem_trim_lock);
+    return abt_errno;
+}
+
+void ABTI_mem_trim_background(ABTI_global *p_global)
+{
+    /* Trimming drains the global pools, so it is not performed frequently.
+     * The interval is checked first since the page size is summed over all
+     * the global pools.  mem_trim_last_time and mem_trim_interval are read
+     * without the lock since they are only hints. */
+    if (ABTI_get_wtime() - p_global->mem_trim_last_time <
+        p_global->mem_trim_interval)
+        return;
+    if (ABTI_mem_get_page_mem_size(p_global) <= p_global->mem_trim_high_water)
+        return;
+    if (ABTD_spinlock_try_acquire(&p_global->mem_trim_lock))
+        return; /* Another thread is trimming the memory pools. */
+    size_t trimmed_size;
+    int abt_errno = mem_trim_locked(p_global, &trimmed_size);
+    /* Failure of the background trimming is not fatal.  If nothing is
+     * trimmed, the pages are in use, so trimming backs off until they are
+     * freed. */
+    if (abt_errno == ABT_SUCCESS && trimmed_size != 0) {
+        p_global->mem_trim_interval = ABTI_MEM_TRIM_INTERVAL;
+    } else if (p_global->mem_trim_interval < ABTI_MEM_TRIM_MAX_INTERVAL) {
+        p_global->mem_trim_interval *= 2.0;
+    }
+    ABTD_spinlock_release(&p_global->mem_trim_lock);
+}
+
+void ABTI_mem_record_stack_usage(ABTI_global *p_global, void *p_stacktop,
+                                 size_t stacksize)
+{
+    uint64_t *p_bottom =
+        ABTI_mem_get_stack_usage_bottom(p_global, p_stacktop, stacksize);
+    uint64_t *p_word = p_bottom;
+    while ((uintptr_t)p_word < (uintptr_t)p_stacktop &&
+           *p_word == ABTI_STACK_USAGE_PATTERN)
+        p_word++;
+    size_t usage = ((char *)p_stacktop) - ((char *)p_word);
+
+    int bin = 0;
+    while (bin < ABT_INFO_STACK_USAGE_HISTOGRAM_SIZE - 1 &&
+           usage > ((size_t)ABT_INFO_STACK_USAGE_HISTOGRAM_MIN << bin))
+        bin++;
+    ABTD_atomic_fetch_add_uint64(&p_global->stack_usage_histogram[bin], 1);
+    size_t max_usage =
+        ABTD_atomic_relaxed_load_size(&p_global->max_stack_usage);
+    while (max_usage < usage) {
+        if (ABTD_atomic_bool_cas_weak_size(&p_global->max_stack_usage,
+                                           max_usage, usage))
+            break;
+        max_usage = ABTD_atomic_relaxed_load_size(&p_global->max_stack_usage);
+    }
+
+    /* The watermark pattern has dirtied the whole stack.  Return pages beyond
+     * stack_usage_keep_size from the stack top to the OS so that the next owner
+     * does not inherit them.  An error is ignored since it is a hint. */
+    const size_t sys_page_size = p_global->sys_page_size;
+    if (p_global->stack_usage_keep_size < stacksize) {
+        uintptr_t start = (uintptr_t)ABTU_roundup_ptr(p_bottom, sys_page_size);
+        uintptr_t end =
+            (((uintptr_t)p_stacktop) - p_global->stack_usage_keep_size) &
+            ~(uintptr_t)(sys_page_size - 1);
+        if (start < end) {
+            int ret = ABTU_madvise_dontneed((void *)start, end - start);
+            (void)ret;
+        }
+    }
 }
 
 int ABTI_mem_check_lp_alloc(ABTI_global *p_global, int lp_alloc)
@@ -211,4 +609,42 @@ void ABTI_mem_finalize_local(ABTI_xstream *p_local_xstream)
 {
 }
 
+int ABTI_mem_get_default_node(ABTI_global *p_global, int rank)
+{
+    return -1;
+}
+
+void ABTI_mem_set_local_node(ABTI_xstream *p_xstream, int node)
+{
+}
+
+void ABTI_mem_flush_local_stats(ABTI_xstream *p_local_xstream)
+{
+}
+
+uint64_t ABTI_mem_get_num_remote_buckets(ABTI_global *p_global)
+{
+    return 0;
+}
+
+size_t ABTI_mem_get_page_mem_size(ABTI_global *p_global)
+{
+    return 0;
+}
+
+ABTU_ret_err int ABTI_mem_trim(ABTI_global *p_global, size_t *p_trimmed_size)
+{
+    *p_trimmed_size = 0;
+    return ABT_SUCCESS;
+}
+
+void ABTI_mem_trim_background(ABTI_global *p_global)
+{
+}
+
+void ABTI_mem_record_stack_usage(ABTI_global *p_global, void *p_stacktop,
+                                 size_t stacksize)
+{
+}
+
 #endif /* !ABT_CONFIG_USE_MEM_POOL */
@@ -0,0 +1,55 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include "abti.h"
+
+/** @defgroup MEM Memory Pool
+ * This group is for memory pools of Argobots.
+ */
+
+/**
+ * @ingroup MEM
+ * @brief   Return idle memory of memory pools to the OS.
+ *
+ * \c ABT_mem_trim() returns physical memory of ULT stacks and work-unit
+ * descriptors that are cached in the global memory pools of Argobots but not
+ * used by any work unit to the OS and returns the size of the released memory
+ * in bytes through \c trimmed_size.  The virtual address ranges are kept, so
+ * the released memory is reused without any additional allocation when
+ * Argobots needs more ULT stacks or descriptors.  Memory that is cached by
+ * each execution stream or external thread is not released.
+ *
+ * \c ABT_mem_trim() sets \c trimmed_size to zero if the memory pool is disabled
+ * or if the OS does not support this operation.
+ *
+ * If the environmental variable \c ABT_MEM_TRIM_HIGH_WATER is set to a
+ * non-zero size, execution streams periodically release idle memory in the
+ * same way while the total size of memory pool pages is above that size.
+ *
+ * @contexts
+ * \DOC_CONTEXT_INIT \DOC_CONTEXT_NOCTXSWITCH
+ *
+ * @errors
+ * \DOC_ERROR_SUCCESS
+ * \DOC_ERROR_RESOURCE
+ *
+ * @undefined
+ * \DOC_UNDEFINED_UNINIT
+ * \DOC_UNDEFINED_NULL_PTR{\c trimmed_size}
+ *
+ * @param[out] trimmed_size  size of released memory in bytes
+ * @return Error code
+ */
+int ABT_mem_trim(size_t *trimmed_size)
+{
+    ABTI_UB_ASSERT(trimmed_size);
+
+    ABTI_global *p_global;
+    ABTI_SETUP_GLOBAL(&p_global);
+
+    int abt_errno = ABTI_mem_trim(p_global, trimmed_size);
+    ABTI_CHECK_ERROR(abt_errno);
+    return ABT_SUCCESS;
+}
@@ -23,6 +23,24 @@ mem_pool_lifo_elem_to_header(ABTI_sync_lifo_element *lifo_elem)
                                           lifo_elem)));
 }
 
+/* hint is used to choose a shard of a sharded LIFO.  Callers that pass the
+ * address of their own object start from the same shard. */
+static inline ABTI_mem_pool_header *
+mem_pool_pop_bucket(ABTI_mem_pool_global_pool *p_global_pool, int node,
+                    const void *hint)
+{
+    ABTI_sync_lifo_element *p_lifo_elem;
+    if (p_global_pool->use_sharded_lifo) {
+        p_lifo_elem = ABTI_sync_sharded_lifo_pop(&p_global_pool->nodes[node]
+                                                      .bucket_lifo.sharded_lifo,
+                                                 (uintptr_t)hint);
+    } else {
+        p_lifo_elem =
+            ABTI_sync_lifo_pop(&p_global_pool->nodes[node].bucket_lifo.lifo);
+    }
+    return p_lifo_elem ? mem_pool_lifo_elem_to_header(p_lifo_elem) : NULL;
+}
+
 static ABTU_ret_err int protect_memory(void *addr, size_t size,
                                        size_t page_size, ABT_bool protect,
                                        ABT_bool adjust_size)
@@ -35,9 +53,24 @@ static ABTU_ret_err int protect_memory(void *addr, size_t size,
     return ABTU_mprotect(mprotect_addr, size, protect);
 }
 
+static void mem_pool_push_empty_page(ABTI_mem_pool_global_pool *p_global_pool,
+                                     ABTI_mem_pool_page *p_page)
+{
+    /* Since p_mem_page_empty is push-only except for trimming, which takes all
+     * the pages at once, there's no ABA problem.  Use a simpler lock-free LIFO
+     * algorithm. */
+    void *p_cur_mem_page;
+    do {
+        p_cur_mem_page =
+            ABTD_atomic_acquire_load_ptr(&p_global_pool->p_mem_page_empty);
+        p_page->p_next_empty_page = (ABTI_mem_pool_page *)p_cur_mem_page;
+    } while (!ABTD_atomic_bool_cas_weak_ptr(&p_global_pool->p_mem_page_empty,
+                                            p_cur_mem_page, p_page));
+}
+
 static void
 mem_pool_return_partial_bucket(ABTI_mem_pool_global_pool *p_global_pool,
-                               ABTI_mem_pool_header *bucket)
+                               int node, ABTI_mem_pool_header *bucket)
 {
     int i;
     const int num_headers_per_bucket = p_global_pool->num_headers_per_bucket;
@@ -78,7 +111,7 @@ mem_pool_return_partial_bucket(ABTI_mem_pool_global_pool *p_global_pool,
                     (num_headers_in_partial_bucket + num_headers_in_bucket);
             }
             partial_bucket_header->p_next = bucket;
-            ABTI_mem_pool_return_bucket(p_global_pool,
+            ABTI_mem_pool_return_bucket(p_global_pool, node,
                                         p_global_pool->partial_bucket);
             p_global_pool->partial_bucket = new_partial_bucket;
         }
@@ -88,12 +121,17 @@ mem_pool_return_partial_bucket(ABTI_mem_pool_global_pool *p_global_pool,
 
 void ABTI_mem_pool_init_global_pool(
     ABTI_mem_pool_global_pool *p_global_pool, size_t num_headers_per_bucket,
-    size_t header_size, size_t header_offset, size_t page_size,
+    size_t num_local_buckets, size_t header_size, size_t header_offset,
+    size_t page_size,
     const ABTU_MEM_LARGEPAGE_TYPE *lp_type_requests,
     uint32_t num_lp_type_requests, size_t alignment_hint,
-    ABTI_mem_pool_global_pool_mprotect_config *p_mprotect_config)
+    ABTI_mem_pool_global_pool_mprotect_config *p_mprotect_config,
+    ABT_bool use_sharded_lifo, int num_nodes)
 {
     p_global_pool->num_headers_per_bucket = num_headers_per_bucket;
+    ABTI_ASSERT(num_local_buckets >= ABT_MEM_POOL_NUM_RETURN_BUCKETS + 1 &&
+                num_local_buckets <= ABT_MEM_POOL_MAX_LOCAL_BUCKETS);
+    p_global_pool->num_local_buckets = num_local_buckets;
     ABTI_ASSERT(header_offset + sizeof(ABTI_mem_pool_header) <= header_size);
     p_global_pool->header_size = header_size;
     p_global_pool->header_offset = header_offset;
@@ -131,12 +169,35 @@ void ABTI_mem_pool_init_global_pool(
         }
     }
     p_global_pool->alignment_hint = alignment_hint;
+    p_global_pool->use_sharded_lifo = use_sharded_lifo;
 
-    ABTI_sync_lifo_init(&p_global_pool->mem_page_lifo);
+    ABTI_ASSERT(num_nodes >= 1);
+    p_global_pool->num_nodes = ABTU_min_int(num_nodes, ABT_MEM_POOL_MAX_NODES);
+    int i;
+    for (i = 0; i < p_global_pool->num_nodes; i++) {
+        ABTI_mem_pool_global_pool_node *p_node = &p_global_pool->nodes[i];
+        ABTI_sync_lifo_init(&p_node->mem_page_lifo);
+        if (use_sharded_lifo) {
+            ABTI_sync_sharded_lifo_init(&p_node->bucket_lifo.sharded_lifo);
+        } else {
+            ABTI_sync_lifo_init(&p_node->bucket_lifo.lifo);
+        }
+        ABTD_atomic_relaxed_store_uint64(&p_node->num_remote_buckets, 0);
+    }
     ABTD_atomic_relaxed_store_ptr(&p_global_pool->p_mem_page_empty, NULL);
-    ABTI_sync_lifo_init(&p_global_pool->bucket_lifo);
+    ABTD_atomic_relaxed_store_size(&p_global_pool->page_mem_size, 0);
     ABTD_spinlock_clear(&p_global_pool->partial_bucket_lock);
     p_global_pool->partial_bucket = NULL;
+    ABTI_mem_pool_global_pool_stats *p_stats = &p_global_pool->stats;
+    ABTD_atomic_relaxed_store_uint64(&p_stats->num_allocs, 0);
+    ABTD_atomic_relaxed_store_uint64(&p_stats->num_takes, 0);
+    ABTD_atomic_relaxed_store_uint64(&p_stats->num_returns, 0);
+    ABTD_atomic_relaxed_store_uint64(&p_stats->num_new_buckets, 0);
+    for (i = 0; i < ABTI_MEM_POOL_NUM_LP_TYPES; i++) {
+        ABTD_atomic_relaxed_store_uint64(&p_stats->num_pages[i], 0);
+    }
+    ABTD_atomic_relaxed_store_uint64(&p_stats->num_lp_fallbacks, 0);
+    ABTD_atomic_relaxed_store_size(&p_stats->unused_page_mem_size, 0);
 }
 
 void ABTI_mem_pool_destroy_global_pool(ABTI_mem_pool_global_pool *p_global_pool)
@@ -146,20 +207,25 @@ void ABTI_mem_pool_destroy_global_pool(ABTI_mem_pool_global_pool *p_global_pool)
      * not need to be freed. */
     ABTI_mem_pool_page *p_page;
     ABTI_sync_lifo_element *p_page_lifo_elem;
-    while ((p_page_lifo_elem =
-                ABTI_sync_lifo_pop_unsafe(&p_global_pool->mem_page_lifo))) {
-        p_page = mem_pool_lifo_elem_to_page(p_page_lifo_elem);
-        if (p_global_pool->mprotect_config.enabled) {
-            /* Undo mprotect() */
-            int abt_errno =
-                protect_memory(p_page->mem, p_page->page_size,
-                               p_global_pool->mprotect_config.alignment,
-                               ABT_FALSE, ABT_TRUE);
-            /* This should not fail since the allocated region is not newly
-             * split by this operation. */
-            ABTI_ASSERT(abt_errno == ABT_SUCCESS);
+    int i;
+    for (i = 0; i < p_global_pool->num_nodes; i++) {
+        ABTI_mem_pool_global_pool_node *p_node = &p_global_pool->nodes[i];
+        while ((p_page_lifo_elem =
+                    ABTI_sync_lifo_pop_unsafe(&p_node->mem_page_lifo))) {
+            p_page = mem_pool_lifo_elem_to_page(p_page_lifo_elem);
+            if (p_global_pool->mprotect_config.enabled) {
+                /* Undo mprotect() */
+                int abt_errno =
+                    protect_memory(p_page->mem, p_page->page_size,
+                                   p_global_pool->mprotect_config.alignment,
+                                   ABT_FALSE, ABT_TRUE);
+                /* This should not fail since the allocated region is not newly
+                 * split by this operation. */
+                ABTI_ASSERT(abt_errno == ABT_SUCCESS);
+            }
+            ABTU_free_largepage(p_page->mem, p_page->page_size,
+                                p_page->lp_type);
         }
-        ABTU_free_largepage(p_page->mem, p_page->page_size, p_page->lp_type);
     }
     p_page = (ABTI_mem_pool_page *)ABTD_atomic_relaxed_load_ptr(
         &p_global_pool->p_mem_page_empty);
@@ -178,21 +244,87 @@ void ABTI_mem_pool_destroy_global_pool(ABTI_mem_pool_global_pool *p_global_pool)
         ABTU_free_largepage(p_page->mem, p_page->page_size, p_page->lp_type);
         p_page = p_next;
     }
-    ABTI_sync_lifo_destroy(&p_global_pool->bucket_lifo);
-    ABTI_sync_lifo_destroy(&p_global_pool->mem_page_lifo);
+    for (i = 0; i < p_global_pool->num_nodes; i++) {
+        if (p_global_pool->use_sharded_lifo) {
+            ABTI_sync_sharded_lifo_destroy(
+                &p_global_pool->nodes[i].bucket_lifo.sharded_lifo);
+        } else {
+            ABTI_sync_lifo_destroy(&p_global_pool->nodes[i].bucket_lifo.lifo);
+        }
+        ABTI_sync_lifo_destroy(&p_global_pool->nodes[i].mem_page_lifo);
+    }
+}
+
+uint64_t ABTI_mem_pool_get_num_remote_buckets(
+    const ABTI_mem_pool_global_pool *p_global_pool, int node)
+{
+    if (node >= p_global_pool->num_nodes)
+        return 0;
+    return ABTD_atomic_relaxed_load_uint64(
+        &p_global_pool->nodes[node].num_remote_buckets);
+}
+
+size_t
+ABTI_mem_pool_get_page_mem_size(const ABTI_mem_pool_global_pool *p_global_pool)
+{
+    return ABTD_atomic_relaxed_load_size(&p_global_pool->page_mem_size);
+}
+
+void ABTI_mem_pool_get_stats(const ABTI_mem_pool_global_pool *p_global_pool,
+                             ABTI_mem_pool_stats *p_stats)
+{
+    const ABTI_mem_pool_global_pool_stats *p_pool_stats =
+        &p_global_pool->stats;
+    int i;
+    p_stats->num_allocs =
+        ABTD_atomic_relaxed_load_uint64(&p_pool_stats->num_allocs);
+    p_stats->num_takes =
+        ABTD_atomic_relaxed_load_uint64(&p_pool_stats->num_takes);
+    p_stats->num_returns =
+        ABTD_atomic_relaxed_load_uint64(&p_pool_stats->num_returns);
+    p_stats->num_new_buckets =
+        ABTD_atomic_relaxed_load_uint64(&p_pool_stats->num_new_buckets);
+    for (i = 0; i < ABTI_MEM_POOL_NUM_LP_TYPES; i++) {
+        p_stats->num_pages[i] =
+            ABTD_atomic_relaxed_load_uint64(&p_pool_stats->num_pages[i]);
+    }
+    p_stats->num_lp_fallbacks =
+        ABTD_atomic_relaxed_load_uint64(&p_pool_stats->num_lp_fallbacks);
+    p_stats->unused_page_mem_size =
+        ABTD_atomic_relaxed_load_size(&p_pool_stats->unused_page_mem_size);
+    p_stats->page_mem_size = ABTI_mem_pool_get_page_mem_size(p_global_pool);
+    p_stats->element_size = p_global_pool->header_size;
+    p_stats->num_headers_per_bucket = p_global_pool->num_headers_per_bucket;
+}
+
+/* Add the number of allocations counted by p_local_pool to the statistics of
+ * its global pool.  The owner must call it. */
+void ABTI_mem_pool_flush_local_stats(ABTI_mem_pool_local_pool *p_local_pool)
+{
+    if (p_local_pool->num_allocs == 0)
+        return;
+    ABTD_atomic_fetch_add_uint64(&p_local_pool->p_global_pool->stats
+                                      .num_allocs,
+                                 p_local_pool->num_allocs);
+    p_local_pool->num_allocs = 0;
 }
 
 ABTU_ret_err int
 ABTI_mem_pool_init_local_pool(ABTI_mem_pool_local_pool *p_local_pool,
-                              ABTI_mem_pool_global_pool *p_global_pool)
+                              ABTI_mem_pool_global_pool *p_global_pool,
+                              int node)
 {
     p_local_pool->p_global_pool = p_global_pool;
     p_local_pool->num_headers_per_bucket =
         p_global_pool->num_headers_per_bucket;
+    p_local_pool->num_local_buckets = p_global_pool->num_local_buckets;
+    p_local_pool->p_remote_list = NULL;
+    p_local_pool->num_allocs = 0;
+    ABTI_mem_pool_set_local_node(p_local_pool, node);
     /* There must be always at least one header in the local pool.
      * Let's take one bucket. */
-    int abt_errno =
-        ABTI_mem_pool_take_bucket(p_global_pool, &p_local_pool->buckets[0]);
+    int abt_errno = ABTI_mem_pool_take_bucket(p_global_pool, node,
+                                              &p_local_pool->buckets[0]);
     ABTI_CHECK_ERROR(abt_errno);
     p_local_pool->bucket_index = 0;
     return ABT_SUCCESS;
@@ -202,34 +334,84 @@ void ABTI_mem_pool_destroy_local_pool(ABTI_mem_pool_local_pool *p_local_pool)
 {
     /* Return the remaining buckets to the global pool. */
     int bucket_index = p_local_pool->bucket_index;
+    const int node = ABTI_mem_pool_get_local_node(p_local_pool);
     int i;
+    ABTI_mem_pool_flush_local_stats(p_local_pool);
+    ABTD_atomic_fetch_add_uint64(&p_local_pool->p_global_pool->stats
+                                      .num_returns,
+                                 bucket_index + 1);
     for (i = 0; i < bucket_index; i++) {
-        ABTI_mem_pool_return_bucket(p_local_pool->p_global_pool,
+        ABTI_mem_pool_return_bucket(p_local_pool->p_global_pool, node,
                                     p_local_pool->buckets[i]);
     }
     const size_t num_headers_per_bucket = p_local_pool->num_headers_per_bucket;
     ABTI_mem_pool_header *cur_bucket = p_local_pool->buckets[bucket_index];
     if (cur_bucket->bucket_info.num_headers == num_headers_per_bucket) {
         /* The last bucket is also full. Return the last bucket as well. */
-        ABTI_mem_pool_return_bucket(p_local_pool->p_global_pool,
+        ABTI_mem_pool_return_bucket(p_local_pool->p_global_pool, node,
                                     p_local_pool->buckets[bucket_index]);
     } else {
-        mem_pool_return_partial_bucket(p_local_pool->p_global_pool, cur_bucket);
+        mem_pool_return_partial_bucket(p_local_pool->p_global_pool, node,
+                                       cur_bucket);
     }
 }
 
-ABTU_ret_err int
-ABTI_mem_pool_take_bucket(ABTI_mem_pool_global_pool *p_global_pool,
-                          ABTI_mem_pool_header **p_bucket)
+/* Allocate a new page for node. */
+ABTU_ret_err static int
+mem_pool_alloc_page(ABTI_mem_pool_global_pool *p_global_pool, int node,
+                    ABTI_mem_pool_page **pp_page)
+{
+    const size_t page_size = p_global_pool->page_size;
+    ABTU_MEM_LARGEPAGE_TYPE lp_type;
+    void *p_alloc_mem;
+    int abt_errno =
+        ABTU_alloc_largepage(page_size, p_global_pool->alignment_hint,
+                             p_global_pool->lp_type_requests,
+                             p_global_pool->num_lp_type_requests, &lp_type,
+                             &p_alloc_mem);
+    ABTI_CHECK_ERROR(abt_errno);
+    if (p_global_pool->num_nodes > 1 && lp_type != ABTU_MEM_LARGEPAGE_MALLOC) {
+        /* Place the new page on the local node.  This is a hint, so an error
+         * is ignored. */
+        int ret = ABTU_mbind_preferred(p_alloc_mem, page_size,
+                                       ABTD_affinity_get_node_id(node));
+        (void)ret;
+    }
+    ABTI_mem_pool_page *p_page =
+        (ABTI_mem_pool_page *)(((char *)p_alloc_mem) + page_size -
+                               sizeof(ABTI_mem_pool_page));
+    p_page->mem = p_alloc_mem;
+    p_page->page_size = page_size;
+    p_page->lp_type = lp_type;
+    p_page->p_mem_extra = p_alloc_mem;
+    p_page->mem_extra_size = page_size - sizeof(ABTI_mem_pool_page);
+    p_page->node = node;
+    p_page->trimmed_size = 0;
+    ABTD_atomic_fetch_add_size(&p_global_pool->page_mem_size, page_size);
+    ABTD_atomic_fetch_add_uint64(&p_global_pool->stats.num_pages[lp_type], 1);
+    if (lp_type != p_global_pool->lp_type_requests[0]) {
+        ABTD_atomic_fetch_add_uint64(&p_global_pool->stats.num_lp_fallbacks,
+                                     1);
+    }
+    *pp_page = p_page;
+    return ABT_SUCCESS;
+}
+
+ABTU_ret_err static int
+mem_pool_take_bucket(ABTI_mem_pool_global_pool *p_global_pool, int node,
+                     ABTI_mem_pool_header **p_bucket)
 {
-    /* Try to get a bucket. */
-    ABTI_sync_lifo_element *p_popped_bucket_lifo_elem =
-        ABTI_sync_lifo_pop(&p_global_pool->bucket_lifo);
+    const int num_nodes = p_global_pool->num_nodes;
+    if (node >= num_nodes)
+        node %= num_nodes;
+    ABTI_mem_pool_global_pool_node *p_node = &p_global_pool->nodes[node];
+    /* Try to get a bucket of the local node.  p_bucket, which points to a
+     * local pool, is unique to the caller. */
+    ABTI_mem_pool_header *popped_bucket =
+        mem_pool_pop_bucket(p_global_pool, node, p_bucket);
     const int num_headers_per_bucket = p_global_pool->num_headers_per_bucket;
-    if (ABTU_likely(p_popped_bucket_lifo_elem)) {
+    if (ABTU_likely(popped_bucket)) {
         /* Use this bucket. */
-        ABTI_mem_pool_header *popped_bucket =
-            mem_pool_lifo_elem_to_header(p_popped_bucket_lifo_elem);
         popped_bucket->bucket_info.num_headers = num_headers_per_bucket;
         *p_bucket = popped_bucket;
         return ABT_SUCCESS;
@@ -244,37 +426,49 @@ ABTI_mem_pool_take_bucket(ABTI_mem_pool_global_pool *p_global_pool,
             /* Before really allocating memory, check if a page has unused
              * memory. */
             if ((p_page_lifo_elem =
-                     ABTI_sync_lifo_pop(&p_global_pool->mem_page_lifo))) {
+                     ABTI_sync_lifo_pop(&p_node->mem_page_lifo))) {
                 /* Use a page popped from mem_page_lifo */
                 p_page = mem_pool_lifo_elem_to_page(p_page_lifo_elem);
+                if (p_page->trimmed_size) {
+                    /* This page will be touched again. */
+                    ABTD_atomic_fetch_add_size(&p_global_pool->page_mem_size,
+                                               p_page->trimmed_size);
+                    p_page->trimmed_size = 0;
+                }
             } else {
+                if (num_headers == 0 && num_nodes > 1) {
+                    /* Before allocating new memory, check if the other nodes
+                     * have buckets that are not used. */
+                    for (i = 1; i < num_nodes; i++) {
+                        int remote_node = node + i;
+                        if (remote_node >= num_nodes)
+                            remote_node -= num_nodes;
+                        popped_bucket =
+                            mem_pool_pop_bucket(p_global_pool, remote_node,
+                                                p_bucket);
+                        if (popped_bucket) {
+                            ABTD_atomic_fetch_add_uint64(
+                                &p_node->num_remote_buckets, 1);
+                            popped_bucket->bucket_info.num_headers =
+                                num_headers_per_bucket;
+                            *p_bucket = popped_bucket;
+                            return ABT_SUCCESS;
+                        }
+                    }
+                }
                 /* Let's allocate memory by myself */
-                const size_t page_size = p_global_pool->page_size;
-                ABTU_MEM_LARGEPAGE_TYPE lp_type;
-                void *p_alloc_mem;
-                int abt_errno =
-                    ABTU_alloc_largepage(page_size,
-                                         p_global_pool->alignment_hint,
-                                         p_global_pool->lp_type_requests,
-                                         p_global_pool->num_lp_type_requests,
-                                         &lp_type, &p_alloc_mem);
+                int abt_errno = mem_pool_alloc_page(p_global_pool, node,
+                                                    &p_page);
                 if (ABTI_IS_ERROR_CHECK_ENABLED && abt_errno != ABT_SUCCESS) {
                     /* It fails to take a large page. Let's return. */
                     if (num_headers != 0) {
                         /* p_head has some elements, so let's return them. */
                         p_head->bucket_info.num_headers = num_headers;
-                        mem_pool_return_partial_bucket(p_global_pool, p_head);
+                        mem_pool_return_partial_bucket(p_global_pool, node,
+                                                       p_head);
                     }
                     return abt_errno;
                 }
-                p_page =
-                    (ABTI_mem_pool_page *)(((char *)p_alloc_mem) + page_size -
-                                           sizeof(ABTI_mem_pool_page));
-                p_page->mem = p_alloc_mem;
-                p_page->page_size = page_size;
-                p_page->lp_type = lp_type;
-                p_page->p_mem_extra = p_alloc_mem;
-                p_page->mem_extra_size = page_size - sizeof(ABTI_mem_pool_page);
             }
             /* Take some memory left in this page. */
             int num_provided = p_page->mem_extra_size / header_size;
@@ -292,29 +486,22 @@ ABTI_mem_pool_take_bucket(ABTI_mem_pool_global_pool *p_global_pool,
             if (p_page->mem_extra_size >= header_size) {
                 /* This page still has some extra memory. Someone will use it in
                  * the future. */
-                ABTI_sync_lifo_push(&p_global_pool->mem_page_lifo,
+                ABTI_sync_lifo_push(&p_node->mem_page_lifo,
                                     &p_page->lifo_elem);
             } else {
                 /* No extra memory is left in this page. Let's push it to a list
-                 * of empty pages.  Since mem_page_empty_lifo is push-only and
-                 * thus there's no ABA problem, use a simpler lock-free LIFO
-                 * algorithm. */
-                void *p_cur_mem_page;
-                do {
-                    p_cur_mem_page = ABTD_atomic_acquire_load_ptr(
-                        &p_global_pool->p_mem_page_empty);
-                    p_page->p_next_empty_page =
-                        (ABTI_mem_pool_page *)p_cur_mem_page;
-                } while (!ABTD_atomic_bool_cas_weak_ptr(&p_global_pool
-                                                             ->p_mem_page_empty,
-                                                        p_cur_mem_page,
-                                                        p_page));
+                 * of empty pages. */
+                ABTD_atomic_fetch_add_size(&p_global_pool->stats
+                                                .unused_page_mem_size,
+                                           p_page->mem_extra_size);
+                mem_pool_push_empty_page(p_global_pool, p_page);
             }
 
             size_t header_offset = p_global_pool->header_offset;
             ABTI_mem_pool_header *p_local_tail =
                 (ABTI_mem_pool_header *)(((char *)p_mem_extra) + header_offset);
             p_local_tail->p_next = p_head;
+            p_local_tail->trim_tag = 0;
             ABTI_mem_pool_header *p_prev = p_local_tail;
             if (!p_global_pool->mprotect_config.enabled) {
                 /* Fast path. */
@@ -323,6 +510,7 @@ ABTI_mem_pool_take_bucket(ABTI_mem_pool_global_pool *p_global_pool,
                         (ABTI_mem_pool_header *)(((char *)p_prev) +
                                                  header_size);
                     p_cur->p_next = p_prev;
+                    p_cur->trim_tag = 0;
                     p_prev = p_cur;
                 }
             } else {
@@ -349,6 +537,7 @@ ABTI_mem_pool_take_bucket(ABTI_mem_pool_global_pool *p_global_pool,
                         (ABTI_mem_pool_header *)(((char *)p_prev) +
                                                  header_size);
                     p_cur->p_next = p_prev;
+                    p_cur->trim_tag = 0;
                     p_prev = p_cur;
                     abt_errno =
                         protect_memory((void *)(((char *)p_prev) -
@@ -364,6 +553,9 @@ ABTI_mem_pool_take_bucket(ABTI_mem_pool_global_pool *p_global_pool,
             num_headers += num_provided;
             if (num_headers == num_headers_per_bucket) {
                 p_head->bucket_info.num_headers = num_headers_per_bucket;
+                ABTD_atomic_fetch_add_uint64(&p_global_pool->stats
+                                                  .num_new_buckets,
+                                             1);
                 *p_bucket = p_head;
                 return ABT_SUCCESS;
             }
@@ -371,10 +563,460 @@ ABTI_mem_pool_take_bucket(ABTI_mem_pool_global_pool *p_global_pool,
     }
 }
 
+ABTU_ret_err int
+ABTI_mem_pool_take_bucket(ABTI_mem_pool_global_pool *p_global_pool, int node,
+                          ABTI_mem_pool_header **p_bucket)
+{
+    int abt_errno = mem_pool_take_bucket(p_global_pool, node, p_bucket);
+    ABTI_CHECK_ERROR(abt_errno);
+    ABTD_atomic_fetch_add_uint64(&p_global_pool->stats.num_takes, 1);
+    return ABT_SUCCESS;
+}
+
+/* Allocate pages that can hold num_headers headers in advance and touch them,
+ * so taking buckets from them neither allocates memory nor causes a page
+ * fault.  If require_first_type is ABT_TRUE, it fails with ABT_ERR_MEM when a
+ * page is not of the first requested large page type.  Pages that have been
+ * allocated are kept in p_global_pool even if it fails. */
+ABTU_ret_err int
+ABTI_mem_pool_prealloc_global_pool(ABTI_mem_pool_global_pool *p_global_pool,
+                                   size_t num_headers, size_t sys_page_size,
+                                   ABT_bool require_first_type)
+{
+    const size_t num_headers_per_page =
+        (p_global_pool->page_size - sizeof(ABTI_mem_pool_page)) /
+        p_global_pool->header_size;
+    ABTI_ASSERT(num_headers_per_page != 0);
+    const size_t num_pages =
+        (num_headers + num_headers_per_page - 1) / num_headers_per_page;
+    size_t i, offset;
+    for (i = 0; i < num_pages; i++) {
+        /* Spread pages over NUMA nodes. */
+        const int node = (int)(i % p_global_pool->num_nodes);
+        ABTI_mem_pool_page *p_page;
+        int abt_errno = mem_pool_alloc_page(p_global_pool, node, &p_page);
+        ABTI_CHECK_ERROR(abt_errno);
+        /* ABTI_mem_pool_page at the end of the page has been already
+         * touched. */
+        for (offset = 0; offset < p_page->mem_extra_size;
+             offset += sys_page_size) {
+            ((volatile char *)p_page->mem)[offset] = 0;
+        }
+        ABTI_sync_lifo_push(&p_global_pool->nodes[node].mem_page_lifo,
+                            &p_page->lifo_elem);
+        if (require_first_type &&
+            p_page->lp_type != p_global_pool->lp_type_requests[0]) {
+            ABTI_HANDLE_ERROR(ABT_ERR_MEM);
+        }
+    }
+    return ABT_SUCCESS;
+}
+
 void ABTI_mem_pool_return_bucket(ABTI_mem_pool_global_pool *p_global_pool,
-                                 ABTI_mem_pool_header *bucket)
+                                 int node, ABTI_mem_pool_header *bucket)
+{
+    if (node >= p_global_pool->num_nodes)
+        node %= p_global_pool->num_nodes;
+    /* Simply return that bucket to the pool of the node */
+    if (p_global_pool->use_sharded_lifo) {
+        /* Buckets are spread over shards according to their addresses. */
+        ABTI_sync_sharded_lifo_push(&p_global_pool->nodes[node]
+                                         .bucket_lifo.sharded_lifo,
+                                    (uintptr_t)bucket,
+                                    &bucket->bucket_info.lifo_elem);
+    } else {
+        ABTI_sync_lifo_push(&p_global_pool->nodes[node].bucket_lifo.lifo,
+                            &bucket->bucket_info.lifo_elem);
+    }
+}
+
+void ABTI_mem_pool_init_remote_list(ABTI_mem_pool_remote_list *p_remote_list,
+                                    size_t max_headers)
+{
+    ABTD_atomic_relaxed_store_ptr(&p_remote_list->p_head, NULL);
+    ABTD_atomic_relaxed_store_size(&p_remote_list->num_headers, 0);
+    p_remote_list->max_headers = max_headers;
+}
+
+/* Take all the headers in p_remote_list.  The owner must call it. */
+static ABTI_mem_pool_header *
+mem_pool_take_remote_headers(ABTI_mem_pool_remote_list *p_remote_list)
+{
+    ABTI_mem_pool_header *p_head =
+        (ABTI_mem_pool_header *)ABTD_atomic_exchange_ptr(&p_remote_list->p_head,
+                                                         NULL);
+    size_t num_headers = 0;
+    ABTI_mem_pool_header *p_header = p_head;
+    while (p_header) {
+        num_headers++;
+        p_header = p_header->p_next;
+    }
+    ABTD_atomic_fetch_sub_size(&p_remote_list->num_headers, num_headers);
+    return p_head;
+}
+
+/* Refill p_local_pool, which has no header except for the one that is being
+ * allocated, with headers in its remote list.  The remote list must not be
+ * empty.  Full buckets beyond the capacity of the local pool are returned to
+ * the global pool. */
+void ABTI_mem_pool_take_remote_list(ABTI_mem_pool_local_pool *p_local_pool)
+{
+    ABTI_mem_pool_header *p_header =
+        mem_pool_take_remote_headers(p_local_pool->p_remote_list);
+    ABTI_ASSERT(p_header);
+    const size_t num_headers_per_bucket = p_local_pool->num_headers_per_bucket;
+    const size_t num_local_buckets = p_local_pool->num_local_buckets;
+    const int node = ABTI_mem_pool_get_local_node(p_local_pool);
+    size_t bucket_index = 0;
+    ABTI_mem_pool_header *cur_bucket = NULL;
+    while (p_header) {
+        ABTI_mem_pool_header *p_next = p_header->p_next;
+        if (cur_bucket &&
+            cur_bucket->bucket_info.num_headers == num_headers_per_bucket) {
+            /* cur_bucket is full. */
+            if (bucket_index == num_local_buckets - 1) {
+                ABTI_mem_pool_return_bucket(p_local_pool->p_global_pool, node,
+                                            cur_bucket);
+                ABTD_atomic_fetch_add_uint64(&p_local_pool->p_global_pool
+                                                  ->stats.num_returns,
+                                             1);
+            } else {
+                p_local_pool->buckets[bucket_index++] = cur_bucket;
+            }
+            cur_bucket = NULL;
+        }
+        p_header->p_next = cur_bucket;
+        p_header->bucket_info.num_headers =
+            cur_bucket ? (cur_bucket->bucket_info.num_headers + 1) : 1;
+        cur_bucket = p_header;
+        p_header = p_next;
+    }
+    p_local_pool->buckets[bucket_index] = cur_bucket;
+    p_local_pool->bucket_index = bucket_index;
+}
+
+/* Return all the headers in p_remote_list to p_global_pool.  This is called
+ * when the owner of p_remote_list is freed. */
+void ABTI_mem_pool_return_remote_list(ABTI_mem_pool_global_pool *p_global_pool,
+                                      int node,
+                                      ABTI_mem_pool_remote_list *p_remote_list)
+{
+    ABTI_mem_pool_header *p_header =
+        mem_pool_take_remote_headers(p_remote_list);
+    const size_t num_headers_per_bucket = p_global_pool->num_headers_per_bucket;
+    ABTI_mem_pool_header *cur_bucket = NULL;
+    while (p_header) {
+        ABTI_mem_pool_header *p_next = p_header->p_next;
+        p_header->p_next = cur_bucket;
+        p_header->bucket_info.num_headers =
+            cur_bucket ? (cur_bucket->bucket_info.num_headers + 1) : 1;
+        cur_bucket = p_header;
+        if (cur_bucket->bucket_info.num_headers == num_headers_per_bucket) {
+            ABTI_mem_pool_return_bucket(p_global_pool, node, cur_bucket);
+            cur_bucket = NULL;
+        }
+        p_header = p_next;
+    }
+    if (cur_bucket)
+        mem_pool_return_partial_bucket(p_global_pool, node, cur_bucket);
+}
+
+typedef struct {
+    ABTI_mem_pool_page *p_page;
+    size_t num_free_headers;
+    size_t trimmed_stack_size; /* Size of stacks that have been released */
+    ABT_bool is_released;
+} mem_pool_trim_page;
+
+static int mem_pool_trim_page_cmp(const void *p1, const void *p2)
+{
+    uintptr_t mem1 = (uintptr_t)((const mem_pool_trim_page *)p1)->p_page->mem;
+    uintptr_t mem2 = (uintptr_t)((const mem_pool_trim_page *)p2)->p_page->mem;
+    return mem1 < mem2 ? -1 : (mem1 > mem2 ? 1 : 0);
+}
+
+/* Find a page that contains mem.  pages must be sorted. */
+static mem_pool_trim_page *mem_pool_trim_find_page(mem_pool_trim_page *pages,
+                                                   size_t num_pages, void *mem)
+{
+    size_t lo = 0, hi = num_pages;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        ABTI_mem_pool_page *p_page = pages[mid].p_page;
+        if ((uintptr_t)mem < (uintptr_t)p_page->mem) {
+            hi = mid;
+        } else if ((uintptr_t)mem >=
+                   (uintptr_t)p_page->mem + p_page->page_size) {
+            lo = mid + 1;
+        } else {
+            return &pages[mid];
+        }
+    }
+    return NULL;
+}
+
+/* Release [addr, addr + size) except for partial pages at both ends.  Returns
+ * the size of released memory.  If dry_run is true, it only returns the size.
+ */
+static size_t mem_pool_release_memory(void *addr, size_t size, size_t alignment,
+                                      ABT_bool dry_run)
+{
+    uintptr_t start = (uintptr_t)ABTU_roundup_ptr(addr, alignment);
+    uintptr_t end = ((uintptr_t)addr + size) & ~(uintptr_t)(alignment - 1);
+    if (start >= end)
+        return 0;
+    if (dry_run)
+        return end - start;
+    int abt_errno = ABTU_madvise_dontneed((void *)start, end - start);
+    return abt_errno == ABT_SUCCESS ? (size_t)(end - start) : 0;
+}
+
+static inline uintptr_t mem_pool_get_trim_tag(ABTI_mem_pool_header *p_header)
+{
+    return ((uintptr_t)p_header) ^ (uintptr_t)0x7a7a7a7a;
+}
+
+/* Release a stack of an unused element except for its header. */
+static size_t
+mem_pool_release_stack(const ABTI_mem_pool_global_pool *p_global_pool,
+                       ABTI_mem_pool_header *p_header, size_t sys_page_size,
+                       ABT_bool dry_run)
+{
+    void *p_stack = ((char *)p_header) - p_global_pool->header_offset;
+    if (p_global_pool->mprotect_config.enabled) {
+        /* Skip a protected page. */
+        const ABTI_mem_pool_global_pool_mprotect_config *p_config =
+            &p_global_pool->mprotect_config;
+        p_stack = (void *)(((char *)ABTU_roundup_ptr(((char *)p_stack) +
+                                                         p_config->offset,
+                                                     p_config->alignment)) +
+                           p_config->page_size);
+    }
+    if ((uintptr_t)p_stack >= (uintptr_t)p_header)
+        return 0;
+    return mem_pool_release_memory(p_stack,
+                                   ((char *)p_header) - ((char *)p_stack),
+                                   sys_page_size, dry_run);
+}
+
+/* Take num_headers headers that are linked by p_next and prepend them to
+ * *pp_headers.  Unused elements of each page are counted. */
+static void mem_pool_trim_take_headers(
+    const ABTI_mem_pool_global_pool *p_global_pool, mem_pool_trim_page *pages,
+    size_t num_pages, size_t sys_page_size, ABTI_mem_pool_header *p_header,
+    size_t num_headers, ABTI_mem_pool_header **pp_headers)
 {
-    /* Simply return that bucket to the pool */
-    ABTI_sync_lifo_push(&p_global_pool->bucket_lifo,
-                        &bucket->bucket_info.lifo_elem);
+    size_t i;
+    const ABT_bool is_stack = p_global_pool->header_offset >= sys_page_size;
+    for (i = 0; i < num_headers; i++) {
+        ABTI_mem_pool_header *p_next = p_header->p_next;
+        mem_pool_trim_page *p_trim_page =
+            mem_pool_trim_find_page(pages, num_pages,
+                                    ((char *)p_header) -
+                                        p_global_pool->header_offset);
+        if (p_trim_page) {
+            p_trim_page->num_free_headers++;
+            if (is_stack &&
+                p_header->trim_tag == mem_pool_get_trim_tag(p_header)) {
+                p_trim_page->trimmed_stack_size +=
+                    mem_pool_release_stack(p_global_pool, p_header,
+                                           sys_page_size, ABT_TRUE);
+            }
+        }
+        p_header->p_next = *pp_headers;
+        *pp_headers = p_header;
+        p_header = p_next;
+    }
+}
+
+/*
+ * Trimming releases the following memory to the OS:
+ * 1. Pages of which all the elements are in bucket_lifo.  Such a page is
+ *    reset so that it is used as if it were newly allocated.  The page is not
+ *    unmapped because other threads might be accessing its elements in
+ *    ABTI_sync_lifo_pop(), which is safe as long as the memory is accessible.
+ * 2. Stacks of the other elements in bucket_lifo except for their headers.
+ * Elements in local pools are not trimmed.  The buckets are taken from the
+ * pool until the stacks are released, so a thread that needs a bucket in the
+ * meantime allocates a new page instead of waiting.  Pages are released after
+ * the buckets are returned.  This function must not be called concurrently on
+ * the same global pool.
+ */
+ABTU_ret_err int
+ABTI_mem_pool_trim_global_pool(ABTI_mem_pool_global_pool *p_global_pool,
+                               size_t sys_page_size, size_t huge_page_size,
+                               size_t *p_trimmed_size)
+{
+    const size_t header_size = p_global_pool->header_size;
+    const size_t header_offset = p_global_pool->header_offset;
+    const size_t num_headers_per_bucket = p_global_pool->num_headers_per_bucket;
+    const int num_nodes = p_global_pool->num_nodes;
+    size_t trimmed_size = 0, released_page_mem_size = 0;
+    size_t i, num_pages = 0;
+    int node;
+    ABTI_sync_lifo_element *p_lifo_elem;
+    ABTI_mem_pool_page *p_page, *p_pages;
+    ABTI_mem_pool_header *p_headers[ABT_MEM_POOL_MAX_NODES];
+
+    /* Take all the pages, which are linked by p_next_empty_page. */
+    p_pages = (ABTI_mem_pool_page *)ABTD_atomic_exchange_ptr(
+        &p_global_pool->p_mem_page_empty, NULL);
+    for (p_page = p_pages; p_page; p_page = p_page->p_next_empty_page)
+        num_pages++;
+    for (node = 0; node < num_nodes; node++) {
+        while ((p_lifo_elem =
+                    ABTI_sync_lifo_pop(&p_global_pool->nodes[node]
+                                            .mem_page_lifo))) {
+            p_page = mem_pool_lifo_elem_to_page(p_lifo_elem);
+            p_page->p_next_empty_page = p_pages;
+            p_pages = p_page;
+            num_pages++;
+        }
+    }
+    mem_pool_trim_page *pages = NULL;
+    if (num_pages != 0) {
+        int abt_errno = ABTU_malloc(sizeof(mem_pool_trim_page) * num_pages,
+                                    (void **)&pages);
+        if (ABTI_IS_ERROR_CHECK_ENABLED && abt_errno != ABT_SUCCESS) {
+            /* Return the pages. */
+            while (p_pages) {
+                p_page = p_pages;
+                p_pages = p_page->p_next_empty_page;
+                if (p_page->mem_extra_size >= header_size) {
+                    ABTI_sync_lifo_push(&p_global_pool->nodes[p_page->node]
+                                             .mem_page_lifo,
+                                        &p_page->lifo_elem);
+                } else {
+                    mem_pool_push_empty_page(p_global_pool, p_page);
+                }
+            }
+            return abt_errno;
+        }
+        for (i = 0, p_page = p_pages; p_page;
+             i++, p_page = p_page->p_next_empty_page) {
+            pages[i].p_page = p_page;
+            pages[i].num_free_headers = 0;
+            pages[i].trimmed_stack_size = 0;
+            pages[i].is_released = ABT_FALSE;
+        }
+        qsort(pages, num_pages, sizeof(mem_pool_trim_page),
+              mem_pool_trim_page_cmp);
+    }
+
+    /* Take all the buckets and count unused elements of each page. */
+    for (node = 0; node < num_nodes; node++) {
+        p_headers[node] = NULL;
+        ABTI_mem_pool_header *p_bucket;
+        while ((p_bucket = mem_pool_pop_bucket(p_global_pool, node,
+                                               p_global_pool))) {
+            mem_pool_trim_take_headers(p_global_pool, pages, num_pages,
+                                       sys_page_size, p_bucket,
+                                       num_headers_per_bucket,
+                                       &p_headers[node]);
+        }
+    }
+    ABTD_spinlock_acquire(&p_global_pool->partial_bucket_lock);
+    ABTI_mem_pool_header *p_partial_bucket = p_global_pool->partial_bucket;
+    p_global_pool->partial_bucket = NULL;
+    ABTD_spinlock_release(&p_global_pool->partial_bucket_lock);
+    if (p_partial_bucket) {
+        mem_pool_trim_take_headers(p_global_pool, pages, num_pages,
+                                   sys_page_size, p_partial_bucket,
+                                   p_partial_bucket->bucket_info.num_headers,
+                                   &p_headers[0]);
+    }
+
+    /* Find pages that have no used element.  Their elements are not returned
+     * to the pool. */
+    for (i = 0; i < num_pages; i++) {
+        p_page = pages[i].p_page;
+        size_t num_carved_headers =
+            ((char *)p_page->p_mem_extra - (char *)p_page->mem) / header_size;
+        if (num_carved_headers != 0 &&
+            pages[i].num_free_headers == num_carved_headers)
+            pages[i].is_released = ABT_TRUE;
+    }
+
+    /* Rebuild buckets with the remaining elements.  Stacks of those elements
+     * are released if they have not been released. */
+    for (node = 0; node < num_nodes; node++) {
+        ABTI_mem_pool_header *p_header = p_headers[node];
+        ABTI_mem_pool_header *p_bucket = NULL;
+        size_t num_headers = 0;
+        while (p_header) {
+            ABTI_mem_pool_header *p_next = p_header->p_next;
+            void *p_elem = ((char *)p_header) - header_offset;
+            mem_pool_trim_page *p_trim_page =
+                mem_pool_trim_find_page(pages, num_pages, p_elem);
+            if (p_trim_page && p_trim_page->is_released) {
+                /* This element is a part of a released page. */
+                p_header = p_next;
+                continue;
+            }
+            if (header_offset >= sys_page_size &&
+                p_header->trim_tag != mem_pool_get_trim_tag(p_header)) {
+                size_t released_size =
+                    mem_pool_release_stack(p_global_pool, p_header,
+                                           sys_page_size, ABT_FALSE);
+                if (released_size != 0) {
+                    trimmed_size += released_size;
+                    p_header->trim_tag = mem_pool_get_trim_tag(p_header);
+                }
+            }
+            p_header->p_next = p_bucket;
+            p_bucket = p_header;
+            if (++num_headers == num_headers_per_bucket) {
+                p_bucket->bucket_info.num_headers = num_headers;
+                ABTI_mem_pool_return_bucket(p_global_pool, node, p_bucket);
+                p_bucket = NULL;
+                num_headers = 0;
+            }
+            p_header = p_next;
+        }
+        if (num_headers != 0) {
+            p_bucket->bucket_info.num_headers = num_headers;
+            mem_pool_return_partial_bucket(p_global_pool, node, p_bucket);
+        }
+    }
+
+    /* Release and reset the pages found above, which nobody else can access
+     * now, and return all the pages. */
+    for (i = 0; i < num_pages; i++) {
+        p_page = pages[i].p_page;
+        if (pages[i].is_released) {
+            /* ABTI_mem_pool_page is at the end of the page, which is not
+             * released. */
+            size_t released_size =
+                mem_pool_release_memory(p_page->mem,
+                                        p_page->page_size -
+                                            sizeof(ABTI_mem_pool_page),
+                                        p_page->lp_type ==
+                                                ABTU_MEM_LARGEPAGE_MMAP_HUGEPAGE
+                                            ? huge_page_size
+                                            : sys_page_size,
+                                        ABT_FALSE);
+            /* The page is reset even if it is not released since all of its
+             * elements have been dropped. */
+            p_page->p_mem_extra = p_page->mem;
+            p_page->mem_extra_size =
+                p_page->page_size - sizeof(ABTI_mem_pool_page);
+            p_page->trimmed_size = released_size;
+            /* Some stacks in this page have been already released. */
+            if (released_size > pages[i].trimmed_stack_size)
+                trimmed_size += released_size - pages[i].trimmed_stack_size;
+            released_page_mem_size += released_size;
+        }
+        if (p_page->mem_extra_size >= header_size) {
+            ABTI_sync_lifo_push(&p_global_pool->nodes[p_page->node]
+                                     .mem_page_lifo,
+                                &p_page->lifo_elem);
+        } else {
+            mem_pool_push_empty_page(p_global_pool, p_page);
+        }
+    }
+    ABTU_free(pages);
+    ABTD_atomic_fetch_sub_size(&p_global_pool->page_mem_size,
+                               released_page_mem_size);
+    *p_trimmed_size = trimmed_size;
+    return ABT_SUCCESS;
 }
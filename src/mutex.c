@@ -113,9 +113,8 @@ int ABT_mutex_create_with_attr(ABT_mutex_attr attr, ABT_mutex *newmutex)
     int abt_errno = ABTU_malloc(sizeof(ABTI_mutex), (void **)&p_newmutex);
     ABTI_CHECK_ERROR(abt_errno);
 
-    ABTI_mutex_init(p_newmutex);
-    if (p_attr)
-        p_newmutex->attrs = p_attr->attrs;
+    ABTI_mutex_init_with_attrs(p_newmutex,
+                               p_attr ? p_attr->attrs : ABTI_MUTEX_ATTR_NONE);
 
     /* Return value */
     *newmutex = ABTI_mutex_get_handle(p_newmutex);
@@ -19,6 +19,7 @@
  *
  * The default parameters are as follows:
  * - Not recursive.
+ * - Not queued.
  *
  * \c newattr must be freed by \c ABT_mutex_attr_free() after its use.
  *
@@ -175,3 +176,99 @@ int ABT_mutex_attr_get_recursive(ABT_mutex_attr attr, ABT_bool *recursive)
     }
     return ABT_SUCCESS;
 }
+
+/**
+ * @ingroup MUTEX_ATTR
+ * @brief   Set a queued property in a mutex attribute.
+ *
+ * \c ABT_mutex_attr_set_queued() sets the queued property (i.e., whether the
+ * mutex is a queue-based lock or not) in the mutex attribute \c attr.  If
+ * \c queued is \c ABT_TRUE, the queued flag of \c attr is set.  Otherwise,
+ * the queued flag of \c attr is unset.
+ *
+ * Waiters of a queued mutex are queued in FIFO order and each of them waits
+ * on its own queue node, so the cost of locking and unlocking does not grow
+ * with the number of waiters.  A waiting ULT is suspended while external
+ * threads busy-wait.  \c ABT_mutex_spinlock(), \c ABT_mutex_trylock(), and
+ * \c ABT_mutex_lock() called by a tasklet do not enqueue the caller; they can
+ * take the mutex while its ownership is being handed over to a ULT, which might
+ * not run while the caller occupies its execution stream.
+ *
+ * @note
+ * A queued mutex hands over its ownership directly to the next waiter.  Since
+ * the ownership is handed over in FIFO order, a queued mutex is slow if
+ * execution streams outnumber cores.
+ *
+ * @contexts
+ * \DOC_CONTEXT_INIT \DOC_CONTEXT_NOCTXSWITCH
+ *
+ * @errors
+ * \DOC_ERROR_SUCCESS
+ * \DOC_ERROR_INV_MUTEX_ATTR_HANDLE{\c attr}
+ *
+ * @undefined
+ * \DOC_UNDEFINED_UNINIT
+ * \DOC_UNDEFINED_BOOL{\c queued}
+ * \DOC_UNDEFINED_THREAD_UNSAFE{\c attr}
+ *
+ * @param[in] attr    mutex attribute handle
+ * @param[in] queued  flag for a queue-based lock
+ * @return Error code
+ */
+int ABT_mutex_attr_set_queued(ABT_mutex_attr attr, ABT_bool queued)
+{
+    ABTI_UB_ASSERT(ABTI_initialized());
+    ABTI_UB_ASSERT_BOOL(queued);
+
+    ABTI_mutex_attr *p_attr = ABTI_mutex_attr_get_ptr(attr);
+    ABTI_CHECK_NULL_MUTEX_ATTR_PTR(p_attr);
+
+    /* Set the value */
+    if (queued == ABT_TRUE) {
+        p_attr->attrs |= ABTI_MUTEX_ATTR_QUEUED;
+    } else {
+        p_attr->attrs &= ~ABTI_MUTEX_ATTR_QUEUED;
+    }
+    return ABT_SUCCESS;
+}
+
+/**
+ * @ingroup MUTEX_ATTR
+ * @brief   Get a queued property in a mutex attribute.
+ *
+ * \c ABT_mutex_attr_get_queued() retrieves the queued property (i.e., whether
+ * the mutex is a queue-based lock or not) in the mutex attribute \c attr.  If
+ * \c attr is configured to be queued, \c queued is set to \c ABT_TRUE.
+ * Otherwise, \c queued is set to \c ABT_FALSE.
+ *
+ * @contexts
+ * \DOC_CONTEXT_INIT \DOC_CONTEXT_NOCTXSWITCH
+ *
+ * @errors
+ * \DOC_ERROR_SUCCESS
+ * \DOC_ERROR_INV_MUTEX_ATTR_HANDLE{\c attr}
+ *
+ * @undefined
+ * \DOC_UNDEFINED_UNINIT
+ * \DOC_UNDEFINED_NULL_PTR{\c queued}
+ *
+ * @param[in]  attr    mutex attribute handle
+ * @param[out] queued  flag for a queue-based lock
+ * @return Error code
+ */
+int ABT_mutex_attr_get_queued(ABT_mutex_attr attr, ABT_bool *queued)
+{
+    ABTI_UB_ASSERT(ABTI_initialized());
+    ABTI_UB_ASSERT(queued);
+
+    ABTI_mutex_attr *p_attr = ABTI_mutex_attr_get_ptr(attr);
+    ABTI_CHECK_NULL_MUTEX_ATTR_PTR(p_attr);
+
+    /* Get the value */
+    if (p_attr->attrs & ABTI_MUTEX_ATTR_QUEUED) {
+        *queued = ABT_TRUE;
+    } else {
+        *queued = ABT_FALSE;
+    }
+    return ABT_SUCCESS;
+}
@@ -5,9 +5,15 @@
 
 abt_sources += \
 	pool/fifo.c \
+	pool/fifo_lockfree.c \
 	pool/fifo_wait.c \
 	pool/pool.c \
 	pool/pool_config.c \
 	pool/pool_user_def.c \
+	pool/prio_queue.c \
 	pool/randws.c \
-	pool/thread_queue.h
+	pool/thread_deque.h \
+	pool/thread_heap.h \
+	pool/thread_mpsc_queue.h \
+	pool/thread_queue.h \
+	pool/thread_ring.h
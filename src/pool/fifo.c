@@ -61,7 +61,6 @@ ABTI_pool_get_fifo_def(ABT_pool_access access,
                        ABTI_pool_deprecated_def *p_deprecated_def)
 {
     /* Definitions according to the access type */
-    /* FIXME: need better implementation, e.g., lock-free one */
     switch (access) {
         case ABT_POOL_ACCESS_PRIV:
             p_required_def->p_push = pool_push_private;
@@ -74,6 +73,13 @@ ABTI_pool_get_fifo_def(ABT_pool_access access,
         case ABT_POOL_ACCESS_SPSC:
         case ABT_POOL_ACCESS_MPSC:
         case ABT_POOL_ACCESS_SPMC:
+            /* The lock-free FIFO pool has implementations specialized for
+             * these access types: a wait-free SPSC ring buffer, an intrusive
+             * MPSC queue, and an SPMC ring buffer. */
+            return ABTI_pool_get_fifo_lockfree_def(access, p_required_def,
+                                                   p_optional_def,
+                                                   p_deprecated_def);
+
         case ABT_POOL_ACCESS_MPMC:
             p_required_def->p_push = pool_push_shared;
             p_required_def->p_pop = pool_pop_shared;
@@ -0,0 +1,527 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include "abti.h"
+#include "thread_ring.h"
+#include "thread_mpsc_queue.h"
+#include <time.h>
+
+/* Lock-free FIFO pool implementation.  A bounded ring buffer (thread_ring_t)
+ * is used except for ABT_POOL_ACCESS_MPSC, which uses an intrusive MPSC queue
+ * (thread_mpsc_queue_t) so that producers take only one atomic exchange. */
+
+static int pool_init(ABT_pool pool, ABT_pool_config config);
+static void pool_free(ABT_pool pool);
+static ABT_bool pool_is_empty(ABT_pool pool);
+static size_t pool_get_size(ABT_pool pool);
+static void pool_push_sp(ABT_pool pool, ABT_unit unit,
+                         ABT_pool_context context);
+static void pool_push_mp(ABT_pool pool, ABT_unit unit,
+                         ABT_pool_context context);
+static ABT_thread pool_pop_sc(ABT_pool pool, ABT_pool_context context);
+static ABT_thread pool_pop_mc(ABT_pool pool, ABT_pool_context context);
+static ABT_thread pool_pop_wait(ABT_pool pool, double time_secs,
+                                ABT_pool_context context);
+static void pool_push_many_sp(ABT_pool pool, const ABT_unit *units,
+                              size_t num_units, ABT_pool_context context);
+static void pool_push_many_mp(ABT_pool pool, const ABT_unit *units,
+                              size_t num_units, ABT_pool_context context);
+static void pool_pop_many_sc(ABT_pool pool, ABT_thread *threads,
+                             size_t max_threads, size_t *num_popped,
+                             ABT_pool_context context);
+static void pool_pop_many_mc(ABT_pool pool, ABT_thread *threads,
+                             size_t max_threads, size_t *num_popped,
+                             ABT_pool_context context);
+static void pool_print_all(ABT_pool pool, void *arg,
+                           void (*print_fn)(void *, ABT_thread));
+static ABT_unit pool_create_unit(ABT_pool pool, ABT_thread thread);
+static void pool_free_unit(ABT_pool pool, ABT_unit unit);
+
+/* For backward compatibility */
+static int pool_remove(ABT_pool pool, ABT_unit unit);
+static ABT_unit pool_pop_timedwait(ABT_pool pool, double abstime_secs);
+static ABT_bool pool_unit_is_in_pool(ABT_unit unit);
+
+/* Functions for ABT_POOL_ACCESS_MPSC */
+static int pool_mpsc_init(ABT_pool pool, ABT_pool_config config);
+static void pool_mpsc_free(ABT_pool pool);
+static ABT_bool pool_mpsc_is_empty(ABT_pool pool);
+static size_t pool_mpsc_get_size(ABT_pool pool);
+static void pool_mpsc_push(ABT_pool pool, ABT_unit unit,
+                           ABT_pool_context context);
+static ABT_thread pool_mpsc_pop(ABT_pool pool, ABT_pool_context context);
+static ABT_thread pool_mpsc_pop_wait(ABT_pool pool, double time_secs,
+                                     ABT_pool_context context);
+static void pool_mpsc_push_many(ABT_pool pool, const ABT_unit *units,
+                                size_t num_units, ABT_pool_context context);
+static void pool_mpsc_pop_many(ABT_pool pool, ABT_thread *threads,
+                               size_t max_threads, size_t *num_popped,
+                               ABT_pool_context context);
+static void pool_mpsc_print_all(ABT_pool pool, void *arg,
+                                void (*print_fn)(void *, ABT_thread));
+static int pool_mpsc_remove(ABT_pool pool, ABT_unit unit);
+static ABT_unit pool_mpsc_pop_timedwait(ABT_pool pool, double abstime_secs);
+
+struct data {
+    ABT_pool_access access;
+    thread_ring_t ring;
+};
+typedef struct data data_t;
+
+static inline data_t *pool_get_data_ptr(void *p_data)
+{
+    return (data_t *)p_data;
+}
+
+static inline ABTI_thread *pool_pop_internal(data_t *p_data)
+{
+    if (p_data->access == ABT_POOL_ACCESS_SPMC ||
+        p_data->access == ABT_POOL_ACCESS_MPMC) {
+        return thread_ring_pop_mc(&p_data->ring);
+    } else {
+        return thread_ring_pop_sc(&p_data->ring);
+    }
+}
+
+/* Obtain the lock-free FIFO pool definition according to the access type */
+ABTU_ret_err int
+ABTI_pool_get_fifo_lockfree_def(ABT_pool_access access,
+                                ABTI_pool_required_def *p_required_def,
+                                ABTI_pool_optional_def *p_optional_def,
+                                ABTI_pool_deprecated_def *p_deprecated_def)
+{
+    /* Definitions according to the access type */
+    switch (access) {
+        case ABT_POOL_ACCESS_PRIV:
+        case ABT_POOL_ACCESS_SPSC:
+            p_required_def->p_push = pool_push_sp;
+            p_required_def->p_pop = pool_pop_sc;
+            p_optional_def->p_push_many = pool_push_many_sp;
+            p_optional_def->p_pop_many = pool_pop_many_sc;
+            break;
+
+        case ABT_POOL_ACCESS_MPSC:
+            p_optional_def->p_init = pool_mpsc_init;
+            p_optional_def->p_free = pool_mpsc_free;
+            p_required_def->p_is_empty = pool_mpsc_is_empty;
+            p_optional_def->p_get_size = pool_mpsc_get_size;
+            p_required_def->p_push = pool_mpsc_push;
+            p_required_def->p_pop = pool_mpsc_pop;
+            p_optional_def->p_pop_wait = pool_mpsc_pop_wait;
+            p_optional_def->p_push_many = pool_mpsc_push_many;
+            p_optional_def->p_pop_many = pool_mpsc_pop_many;
+            p_optional_def->p_print_all = pool_mpsc_print_all;
+            p_required_def->p_create_unit = pool_create_unit;
+            p_required_def->p_free_unit = pool_free_unit;
+            p_deprecated_def->p_remove = pool_mpsc_remove;
+            p_deprecated_def->p_pop_timedwait = pool_mpsc_pop_timedwait;
+            p_deprecated_def->u_is_in_pool = pool_unit_is_in_pool;
+            return ABT_SUCCESS;
+
+        case ABT_POOL_ACCESS_SPMC:
+            p_required_def->p_push = pool_push_sp;
+            p_required_def->p_pop = pool_pop_mc;
+            p_optional_def->p_push_many = pool_push_many_sp;
+            p_optional_def->p_pop_many = pool_pop_many_mc;
+            break;
+
+        case ABT_POOL_ACCESS_MPMC:
+            p_required_def->p_push = pool_push_mp;
+            p_required_def->p_pop = pool_pop_mc;
+            p_optional_def->p_push_many = pool_push_many_mp;
+            p_optional_def->p_pop_many = pool_pop_many_mc;
+            break;
+
+        default:
+            ABTI_HANDLE_ERROR(ABT_ERR_INV_POOL_ACCESS);
+    }
+
+    /* Common definitions regardless of the access type */
+    p_optional_def->p_init = pool_init;
+    p_optional_def->p_free = pool_free;
+    p_required_def->p_is_empty = pool_is_empty;
+    p_optional_def->p_get_size = pool_get_size;
+    p_optional_def->p_pop_wait = pool_pop_wait;
+    p_optional_def->p_print_all = pool_print_all;
+    p_required_def->p_create_unit = pool_create_unit;
+    p_required_def->p_free_unit = pool_free_unit;
+
+    p_deprecated_def->p_remove = pool_remove;
+    p_deprecated_def->p_pop_timedwait = pool_pop_timedwait;
+    p_deprecated_def->u_is_in_pool = pool_unit_is_in_pool;
+    return ABT_SUCCESS;
+}
+
+/* Pool functions */
+
+static int pool_init(ABT_pool pool, ABT_pool_config config)
+{
+    ABTI_UNUSED(config);
+    int abt_errno;
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+
+    data_t *p_data;
+    abt_errno = ABTU_memalign(ABT_CONFIG_STATIC_CACHELINE_SIZE, sizeof(data_t),
+                              (void **)&p_data);
+    ABTI_CHECK_ERROR(abt_errno);
+    abt_errno = thread_ring_init(&p_data->ring, THREAD_RING_DEFAULT_CAPACITY);
+    if (abt_errno != ABT_SUCCESS) {
+        ABTU_free(p_data);
+        ABTI_HANDLE_ERROR(abt_errno);
+    }
+    p_data->access = p_pool->access;
+
+    p_pool->data = p_data;
+    return ABT_SUCCESS;
+}
+
+static void pool_free(ABT_pool pool)
+{
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    data_t *p_data = pool_get_data_ptr(p_pool->data);
+    thread_ring_free(&p_data->ring);
+    ABTU_free(p_data);
+}
+
+static ABT_bool pool_is_empty(ABT_pool pool)
+{
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    data_t *p_data = pool_get_data_ptr(p_pool->data);
+    return thread_ring_is_empty(&p_data->ring);
+}
+
+static size_t pool_get_size(ABT_pool pool)
+{
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    data_t *p_data = pool_get_data_ptr(p_pool->data);
+    return thread_ring_get_size(&p_data->ring);
+}
+
+static void pool_push_sp(ABT_pool pool, ABT_unit unit,
+                         ABT_pool_context context)
+{
+    (void)context;
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    data_t *p_data = pool_get_data_ptr(p_pool->data);
+    ABTI_thread *p_thread = ABTI_unit_get_thread_from_builtin_unit(unit);
+    thread_ring_push_sp(&p_data->ring, p_thread);
+}
+
+static void pool_push_mp(ABT_pool pool, ABT_unit unit,
+                         ABT_pool_context context)
+{
+    (void)context;
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    data_t *p_data = pool_get_data_ptr(p_pool->data);
+    ABTI_thread *p_thread = ABTI_unit_get_thread_from_builtin_unit(unit);
+    thread_ring_push_mp(&p_data->ring, p_thread);
+}
+
+static void pool_push_many_sp(ABT_pool pool, const ABT_unit *units,
+                              size_t num_units, ABT_pool_context context)
+{
+    (void)context;
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    data_t *p_data = pool_get_data_ptr(p_pool->data);
+    size_t i;
+    for (i = 0; i < num_units; i++) {
+        ABTI_thread *p_thread =
+            ABTI_unit_get_thread_from_builtin_unit(units[i]);
+        thread_ring_push_sp(&p_data->ring, p_thread);
+    }
+}
+
+static void pool_push_many_mp(ABT_pool pool, const ABT_unit *units,
+                              size_t num_units, ABT_pool_context context)
+{
+    (void)context;
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    data_t *p_data = pool_get_data_ptr(p_pool->data);
+    size_t i;
+    for (i = 0; i < num_units; i++) {
+        ABTI_thread *p_thread =
+            ABTI_unit_get_thread_from_builtin_unit(units[i]);
+        thread_ring_push_mp(&p_data->ring, p_thread);
+    }
+}
+
+static ABT_thread pool_pop_wait(ABT_pool pool, double time_secs,
+                                ABT_pool_context context)
+{
+    (void)context;
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    data_t *p_data = pool_get_data_ptr(p_pool->data);
+    double time_start = 0.0;
+    while (1) {
+        ABTI_thread *p_thread = pool_pop_internal(p_data);
+        if (p_thread)
+            return ABTI_thread_get_handle(p_thread);
+        if (time_start == 0.0) {
+            time_start = ABTI_get_wtime();
+        } else {
+            double elapsed = ABTI_get_wtime() - time_start;
+            if (elapsed > time_secs)
+                return ABT_THREAD_NULL;
+        }
+        /* Sleep. */
+        const int sleep_nsecs = 100;
+        struct timespec ts = { 0, sleep_nsecs };
+        nanosleep(&ts, NULL);
+    }
+}
+
+static ABT_unit pool_pop_timedwait(ABT_pool pool, double abstime_secs)
+{
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    data_t *p_data = pool_get_data_ptr(p_pool->data);
+    while (1) {
+        ABTI_thread *p_thread = pool_pop_internal(p_data);
+        if (p_thread)
+            return ABTI_unit_get_builtin_unit(p_thread);
+        const int sleep_nsecs = 100;
+        struct timespec ts = { 0, sleep_nsecs };
+        nanosleep(&ts, NULL);
+
+        if (ABTI_get_wtime() > abstime_secs)
+            return ABT_UNIT_NULL;
+    }
+}
+
+static ABT_thread pool_pop_sc(ABT_pool pool, ABT_pool_context context)
+{
+    (void)context;
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    data_t *p_data = pool_get_data_ptr(p_pool->data);
+    ABTI_thread *p_thread = thread_ring_pop_sc(&p_data->ring);
+    return ABTI_thread_get_handle(p_thread);
+}
+
+static ABT_thread pool_pop_mc(ABT_pool pool, ABT_pool_context context)
+{
+    (void)context;
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    data_t *p_data = pool_get_data_ptr(p_pool->data);
+    ABTI_thread *p_thread = thread_ring_pop_mc(&p_data->ring);
+    return ABTI_thread_get_handle(p_thread);
+}
+
+static void pool_pop_many_sc(ABT_pool pool, ABT_thread *threads,
+                             size_t max_threads, size_t *num_popped,
+                             ABT_pool_context context)
+{
+    (void)context;
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    data_t *p_data = pool_get_data_ptr(p_pool->data);
+    size_t i;
+    for (i = 0; i < max_threads; i++) {
+        ABTI_thread *p_thread = thread_ring_pop_sc(&p_data->ring);
+        if (!p_thread)
+            break;
+        threads[i] = ABTI_thread_get_handle(p_thread);
+    }
+    *num_popped = i;
+}
+
+static void pool_pop_many_mc(ABT_pool pool, ABT_thread *threads,
+                             size_t max_threads, size_t *num_popped,
+                             ABT_pool_context context)
+{
+    (void)context;
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    data_t *p_data = pool_get_data_ptr(p_pool->data);
+    size_t i;
+    for (i = 0; i < max_threads; i++) {
+        ABTI_thread *p_thread = thread_ring_pop_mc(&p_data->ring);
+        if (!p_thread)
+            break;
+        threads[i] = ABTI_thread_get_handle(p_thread);
+    }
+    *num_popped = i;
+}
+
+static int pool_remove(ABT_pool pool, ABT_unit unit)
+{
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    data_t *p_data = pool_get_data_ptr(p_pool->data);
+    ABTI_thread *p_thread = ABTI_unit_get_thread_from_builtin_unit(unit);
+    return thread_ring_remove(&p_data->ring, p_thread);
+}
+
+static void pool_print_all(ABT_pool pool, void *arg,
+                           void (*print_fn)(void *, ABT_thread))
+{
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    data_t *p_data = pool_get_data_ptr(p_pool->data);
+    thread_ring_print_all(&p_data->ring, arg, print_fn);
+}
+
+/* Pool functions for ABT_POOL_ACCESS_MPSC */
+
+static inline thread_mpsc_queue_t *pool_mpsc_get_queue_ptr(void *p_data)
+{
+    return (thread_mpsc_queue_t *)p_data;
+}
+
+static int pool_mpsc_init(ABT_pool pool, ABT_pool_config config)
+{
+    ABTI_UNUSED(config);
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+
+    thread_mpsc_queue_t *p_queue;
+    int abt_errno =
+        ABTU_memalign(ABT_CONFIG_STATIC_CACHELINE_SIZE,
+                      sizeof(thread_mpsc_queue_t), (void **)&p_queue);
+    ABTI_CHECK_ERROR(abt_errno);
+    thread_mpsc_queue_init(p_queue);
+
+    p_pool->data = p_queue;
+    return ABT_SUCCESS;
+}
+
+static void pool_mpsc_free(ABT_pool pool)
+{
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    thread_mpsc_queue_t *p_queue = pool_mpsc_get_queue_ptr(p_pool->data);
+    thread_mpsc_queue_free(p_queue);
+    ABTU_free(p_queue);
+}
+
+static ABT_bool pool_mpsc_is_empty(ABT_pool pool)
+{
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    thread_mpsc_queue_t *p_queue = pool_mpsc_get_queue_ptr(p_pool->data);
+    return thread_mpsc_queue_is_empty(p_queue);
+}
+
+static size_t pool_mpsc_get_size(ABT_pool pool)
+{
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    thread_mpsc_queue_t *p_queue = pool_mpsc_get_queue_ptr(p_pool->data);
+    return thread_mpsc_queue_get_size(p_queue);
+}
+
+static void pool_mpsc_push(ABT_pool pool, ABT_unit unit,
+                           ABT_pool_context context)
+{
+    (void)context;
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    thread_mpsc_queue_t *p_queue = pool_mpsc_get_queue_ptr(p_pool->data);
+    ABTI_thread *p_thread = ABTI_unit_get_thread_from_builtin_unit(unit);
+    thread_mpsc_queue_push(p_queue, p_thread);
+}
+
+static void pool_mpsc_push_many(ABT_pool pool, const ABT_unit *units,
+                                size_t num_units, ABT_pool_context context)
+{
+    (void)context;
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    thread_mpsc_queue_t *p_queue = pool_mpsc_get_queue_ptr(p_pool->data);
+    size_t i;
+    for (i = 0; i < num_units; i++) {
+        ABTI_thread *p_thread =
+            ABTI_unit_get_thread_from_builtin_unit(units[i]);
+        thread_mpsc_queue_push(p_queue, p_thread);
+    }
+}
+
+static ABT_thread pool_mpsc_pop(ABT_pool pool, ABT_pool_context context)
+{
+    (void)context;
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    thread_mpsc_queue_t *p_queue = pool_mpsc_get_queue_ptr(p_pool->data);
+    ABTI_thread *p_thread = thread_mpsc_queue_pop(p_queue);
+    return ABTI_thread_get_handle(p_thread);
+}
+
+static void pool_mpsc_pop_many(ABT_pool pool, ABT_thread *threads,
+                               size_t max_threads, size_t *num_popped,
+                               ABT_pool_context context)
+{
+    (void)context;
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    thread_mpsc_queue_t *p_queue = pool_mpsc_get_queue_ptr(p_pool->data);
+    thread_mpsc_queue_pop_many(p_queue, threads, max_threads, num_popped);
+}
+
+static ABT_thread pool_mpsc_pop_wait(ABT_pool pool, double time_secs,
+                                     ABT_pool_context context)
+{
+    (void)context;
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    thread_mpsc_queue_t *p_queue = pool_mpsc_get_queue_ptr(p_pool->data);
+    double time_start = 0.0;
+    while (1) {
+        ABTI_thread *p_thread = thread_mpsc_queue_pop(p_queue);
+        if (p_thread)
+            return ABTI_thread_get_handle(p_thread);
+        if (time_start == 0.0) {
+            time_start = ABTI_get_wtime();
+        } else {
+            double elapsed = ABTI_get_wtime() - time_start;
+            if (elapsed > time_secs)
+                return ABT_THREAD_NULL;
+        }
+        /* Sleep. */
+        const int sleep_nsecs = 100;
+        struct timespec ts = { 0, sleep_nsecs };
+        nanosleep(&ts, NULL);
+    }
+}
+
+static ABT_unit pool_mpsc_pop_timedwait(ABT_pool pool, double abstime_secs)
+{
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    thread_mpsc_queue_t *p_queue = pool_mpsc_get_queue_ptr(p_pool->data);
+    while (1) {
+        ABTI_thread *p_thread = thread_mpsc_queue_pop(p_queue);
+        if (p_thread)
+            return ABTI_unit_get_builtin_unit(p_thread);
+        const int sleep_nsecs = 100;
+        struct timespec ts = { 0, sleep_nsecs };
+        nanosleep(&ts, NULL);
+
+        if (ABTI_get_wtime() > abstime_secs)
+            return ABT_UNIT_NULL;
+    }
+}
+
+static int pool_mpsc_remove(ABT_pool pool, ABT_unit unit)
+{
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    thread_mpsc_queue_t *p_queue = pool_mpsc_get_queue_ptr(p_pool->data);
+    ABTI_thread *p_thread = ABTI_unit_get_thread_from_builtin_unit(unit);
+    return thread_mpsc_queue_remove(p_queue, p_thread);
+}
+
+static void pool_mpsc_print_all(ABT_pool pool, void *arg,
+                                void (*print_fn)(void *, ABT_thread))
+{
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    thread_mpsc_queue_t *p_queue = pool_mpsc_get_queue_ptr(p_pool->data);
+    thread_mpsc_queue_print_all(p_queue, arg, print_fn);
+}
+
+/* Unit functions */
+
+static ABT_bool pool_unit_is_in_pool(ABT_unit unit)
+{
+    ABTI_thread *p_thread = ABTI_unit_get_thread_from_builtin_unit(unit);
+    return ABTD_atomic_acquire_load_int(&p_thread->is_in_pool) ? ABT_TRUE
+                                                               : ABT_FALSE;
+}
+
+static ABT_unit pool_create_unit(ABT_pool pool, ABT_thread thread)
+{
+    /* Call ABTI_unit_init_builtin() instead. */
+    ABTI_ASSERT(0);
+    return ABT_UNIT_NULL;
+}
+
+static void pool_free_unit(ABT_pool pool, ABT_unit unit)
+{
+    /* A built-in unit does not need to be freed.  This function may not be
+     * called. */
+    ABTI_ASSERT(0);
+}
@@ -39,6 +39,9 @@ typedef struct {
     void (*print_fn)(void *, ABT_thread);
 } pool_print_unit_to_thread_arg_t;
 static void pool_print_unit_to_thread(void *arg, ABT_unit unit);
+static void pool_waiter_init(ABTI_pool_waiter *p_waiter, int num_nodes,
+                             ABTI_pool_waiter_node *nodes);
+static ABT_bool pool_waiter_notify(ABTI_pool_waiter *p_waiter);
 
 /** @defgroup POOL Pool
  * This group is for Pool.
@@ -722,7 +725,6 @@ int ABT_pool_push_threads_ex(ABT_pool pool, const ABT_thread *threads,
  * @errors
  * \DOC_ERROR_SUCCESS
  * \DOC_ERROR_INV_POOL_HANDLE{\c pool}
- * \DOC_ERROR_POOL_UNSUPPORTED_FEATURE{\c pool, \c ABT_pool_user_pop_wait_fn}
  *
  * @undefined
  * \DOC_UNDEFINED_UNINIT
@@ -753,13 +755,17 @@ int ABT_pool_pop_wait_thread(ABT_pool pool, ABT_thread *thread,
  * routine sets \c thread to a work unit handle associated with the returned
  * \c ABT_unit.  Otherwise, this routine sets \c thread to \c ABT_THREAD_NULL.
  *
+ * If \c pool does not implement \c ABT_pool_user_pop_wait_fn, this routine
+ * repeatedly pops a work unit by \c ABT_pool_user_pop_fn and blocks the
+ * underlying execution stream or external thread until a work unit is pushed
+ * to \c pool or \c time_sec seconds pass.
+ *
  * @contexts
  * \DOC_CONTEXT_INIT \DOC_CONTEXT_NOCTXSWITCH
  *
  * @errors
  * \DOC_ERROR_SUCCESS
  * \DOC_ERROR_INV_POOL_HANDLE{\c pool}
- * \DOC_ERROR_POOL_UNSUPPORTED_FEATURE{\c pool, \c ABT_pool_user_pop_wait_fn}
  *
  * @undefined
  * \DOC_UNDEFINED_UNINIT
@@ -892,12 +898,12 @@ int ABT_pool_pop(ABT_pool pool, ABT_unit *p_unit)
  * \c ABT_pool_pop_wait() pops a work unit from the pool \c pool and sets it to
  * \c p_unit.
  *
- * - If \c pool is created by \c ABT_pool_create():
+ * - If \c pool is created by \c ABT_pool_create() with \c p_pop_wait():
  *
  *   This routine sets \c p_unit to a value returned by \c p_pop_wait() called
  *   with \c pool as its first argument and \c time_sec as the second argument.
  *
- * - If \c pool is created by \c ABT_pool_create_basic():
+ * - Otherwise:
  *
  *   This routine tries to pop a work unit from \c pool.  If \c pool is empty,
  *   an underlying execution stream or an external thread that calls this
@@ -923,7 +929,6 @@ int ABT_pool_pop(ABT_pool pool, ABT_unit *p_unit)
  * @errors
  * \DOC_ERROR_SUCCESS
  * \DOC_ERROR_INV_POOL_HANDLE{\c pool}
- * \DOC_ERROR_POOL_UNSUPPORTED_FEATURE{\c pool, \c p_pop_wait()}
  *
  * @undefined
  * \DOC_UNDEFINED_UNINIT
@@ -941,7 +946,6 @@ int ABT_pool_pop_wait(ABT_pool pool, ABT_unit *p_unit, double time_secs)
 
     ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
     ABTI_CHECK_NULL_POOL_PTR(p_pool);
-    ABTI_CHECK_TRUE(p_pool->optional_def.p_pop_wait, ABT_ERR_POOL);
 
     ABT_thread thread =
         ABTI_pool_pop_wait(p_pool, time_secs, ABT_POOL_CONTEXT_OP_POOL_OTHER);
@@ -1416,6 +1420,16 @@ ABTU_ret_err int ABTI_pool_create_basic(ABT_pool_kind kind,
                 ABTI_pool_get_randws_def(access, &required_def, &optional_def,
                                          &deprecated_def);
             break;
+        case ABT_POOL_FIFO_LOCKFREE:
+            abt_errno =
+                ABTI_pool_get_fifo_lockfree_def(access, &required_def,
+                                                &optional_def, &deprecated_def);
+            break;
+        case ABT_POOL_PRIO_QUEUE:
+            abt_errno =
+                ABTI_pool_get_prio_queue_def(access, &required_def,
+                                             &optional_def, &deprecated_def);
+            break;
         default:
             abt_errno = ABT_ERR_INV_POOL_KIND;
             break;
@@ -1513,6 +1527,162 @@ void ABTI_pool_reset_id(void)
     ABTD_atomic_release_store_uint64(&g_pool_id, 0);
 }
 
+ABTU_ret_err int ABTI_pool_waiter_create(int num_pools,
+                                         ABTI_pool_waiter **pp_waiter)
+{
+    ABTI_pool_waiter *p_waiter;
+    int abt_errno;
+    abt_errno = ABTU_malloc(sizeof(ABTI_pool_waiter) +
+                                sizeof(ABTI_pool_waiter_node) * num_pools,
+                            (void **)&p_waiter);
+    ABTI_CHECK_ERROR(abt_errno);
+    pool_waiter_init(p_waiter, num_pools,
+                     (ABTI_pool_waiter_node *)(p_waiter + 1));
+    *pp_waiter = p_waiter;
+    return ABT_SUCCESS;
+}
+
+void ABTI_pool_waiter_free(ABTI_pool_waiter *p_waiter)
+{
+    ABTU_free(p_waiter);
+}
+
+/* Block the underlying Pthread until a work unit is pushed to one of pools,
+ * ABTI_pool_waiter_notify() is called, or time_secs passes.  If time_secs is
+ * negative, this routine does not time out.  This routine returns immediately
+ * if any of pools is not empty.  The caller must check the pools again after
+ * this routine returns since it might return spuriously.
+ *
+ * This routine and ABTI_pool_push() work as an eventcount: this waiter is
+ * registered to the pools before the pools are checked, while a pusher checks
+ * waiters after pushing a work unit, both separated by a sequentially
+ * consistent fence, so a push that this waiter does not see always wakes it
+ * up.  Parking is far less frequent than pushing, so if membarrier() is
+ * available, this routine makes every running thread execute the fence and
+ * pushers get by with a compiler barrier (see ABTI_pool_wake_waiters()). */
+void ABTI_pool_waiter_park(ABTI_pool_waiter *p_waiter, int num_pools,
+                           const ABT_pool *pools, double time_secs)
+{
+    int i;
+    ABTI_ASSERT(num_pools <= p_waiter->num_nodes);
+
+    /* Register this waiter to the pools. */
+    for (i = 0; i < num_pools; i++) {
+        ABTI_pool *p_pool = ABTI_pool_get_ptr(pools[i]);
+        ABTI_pool_waiter_node *p_node = &p_waiter->nodes[i];
+        ABTD_spinlock_acquire(&p_pool->waiter_lock);
+        p_node->p_prev = NULL;
+        p_node->p_next = p_pool->p_waiter_head;
+        if (p_node->p_next)
+            p_node->p_next->p_prev = p_node;
+        p_pool->p_waiter_head = p_node;
+        ABTD_atomic_fetch_add_int(&p_pool->num_waiters, 1);
+        ABTD_spinlock_release(&p_pool->waiter_lock);
+    }
+    /* Pairs with the barrier in ABTI_pool_wake_waiters(). */
+    if (ABTI_global_get_global()->use_membarrier) {
+        ABTD_membarrier_heavy();
+    } else {
+        ABTD_atomic_seq_cst_mem_barrier();
+    }
+
+    /* A work unit pushed before the registration did not notify this waiter,
+     * so check the pools again. */
+    ABT_bool is_empty = ABT_TRUE;
+    for (i = 0; i < num_pools; i++) {
+        if (!ABTI_pool_is_empty(ABTI_pool_get_ptr(pools[i]))) {
+            is_empty = ABT_FALSE;
+            break;
+        }
+    }
+    if (is_empty) {
+#ifndef ABT_CONFIG_ACTIVE_WAIT_POLICY
+        ABTD_spinlock_acquire(&p_waiter->lock);
+        if (ABTD_atomic_relaxed_load_int(&p_waiter->is_notified)) {
+            ABTD_spinlock_release(&p_waiter->lock);
+        } else if (time_secs < 0.0) {
+            ABTD_futex_wait_and_unlock(&p_waiter->futex, &p_waiter->lock);
+        } else {
+            ABTD_futex_timedwait_and_unlock(&p_waiter->futex, &p_waiter->lock,
+                                            time_secs);
+        }
+#else
+        double start_time = ABTI_get_wtime();
+        while (!ABTD_atomic_acquire_load_int(&p_waiter->is_notified)) {
+            if (time_secs >= 0.0 && ABTI_get_wtime() - start_time >= time_secs)
+                break;
+            ABTD_atomic_pause();
+        }
+#endif
+    }
+
+    /* Unregister this waiter. */
+    for (i = 0; i < num_pools; i++) {
+        ABTI_pool *p_pool = ABTI_pool_get_ptr(pools[i]);
+        ABTI_pool_waiter_node *p_node = &p_waiter->nodes[i];
+        ABTD_spinlock_acquire(&p_pool->waiter_lock);
+        if (p_node->p_prev) {
+            p_node->p_prev->p_next = p_node->p_next;
+        } else {
+            p_pool->p_waiter_head = p_node->p_next;
+        }
+        if (p_node->p_next)
+            p_node->p_next->p_prev = p_node->p_prev;
+        ABTD_atomic_fetch_sub_int(&p_pool->num_waiters, 1);
+        ABTD_spinlock_release(&p_pool->waiter_lock);
+    }
+    ABTD_spinlock_acquire(&p_waiter->lock);
+    ABTD_atomic_relaxed_store_int(&p_waiter->is_notified, 0);
+    ABTD_spinlock_release(&p_waiter->lock);
+}
+
+void ABTI_pool_waiter_notify(ABTI_pool_waiter *p_waiter)
+{
+    pool_waiter_notify(p_waiter);
+}
+
+/* Pop a work unit from a pool that does not implement p_pop_wait().  This
+ * routine parks the underlying Pthread on p_pool while it is empty. */
+ABT_thread ABTI_pool_pop_wait_generic(ABTI_pool *p_pool, double time_secs,
+                                      ABT_pool_context context)
+{
+    ABTI_pool_waiter waiter;
+    ABTI_pool_waiter_node node;
+    ABT_pool pool = ABTI_pool_get_handle(p_pool);
+    double start_time = 0.0;
+    pool_waiter_init(&waiter, 1, &node);
+    while (1) {
+        ABT_thread thread = ABTI_pool_pop(p_pool, context);
+        if (thread != ABT_THREAD_NULL)
+            return thread;
+        double elapsed_time;
+        if (start_time == 0.0) {
+            start_time = ABTI_get_wtime();
+            elapsed_time = 0.0;
+        } else {
+            elapsed_time = ABTI_get_wtime() - start_time;
+        }
+        if (elapsed_time >= time_secs)
+            return ABT_THREAD_NULL;
+        ABTI_pool_waiter_park(&waiter, 1, &pool, time_secs - elapsed_time);
+    }
+}
+
+/* Called by ABTI_pool_push() when a scheduler is parking on p_pool.  One work
+ * unit needs only one scheduler, so this routine wakes up the first waiter
+ * that has not been notified yet. */
+void ABTI_pool_notify_waiters(ABTI_pool *p_pool)
+{
+    ABTD_spinlock_acquire(&p_pool->waiter_lock);
+    ABTI_pool_waiter_node *p_node = p_pool->p_waiter_head;
+    while (p_node) {
+        if (pool_waiter_notify(p_node->p_waiter))
+            break;
+        p_node = p_node->p_next;
+    }
+    ABTD_spinlock_release(&p_pool->waiter_lock);
+}
+
 /*****************************************************************************/
 /* Internal static functions                                                 */
 /*****************************************************************************/
@@ -1710,6 +1880,9 @@ pool_create(ABT_pool_access access,
     p_pool->is_builtin = is_builtin;
     ABTD_atomic_release_store_int32(&p_pool->num_scheds, 0);
     ABTD_atomic_release_store_int32(&p_pool->num_blocked, 0);
+    ABTD_atomic_relaxed_store_int(&p_pool->num_waiters, 0);
+    ABTD_spinlock_clear(&p_pool->waiter_lock);
+    p_pool->p_waiter_head = NULL;
     p_pool->data = NULL;
     memcpy(&p_pool->required_def, p_required_def,
            sizeof(ABTI_pool_required_def));
@@ -1857,7 +2030,6 @@ static inline int pool_pop_wait_thread_ex(ABT_pool pool, ABT_thread *thread,
 
     ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
     ABTI_CHECK_NULL_POOL_PTR(p_pool);
-    ABTI_CHECK_TRUE(p_pool->optional_def.p_pop_wait, ABT_ERR_POOL);
 
     *thread = ABTI_pool_pop_wait(p_pool, time_secs, pool_ctx);
     return ABT_SUCCESS;
@@ -1880,3 +2052,37 @@ static void pool_print_unit_to_thread(void *arg, ABT_unit unit)
     ABT_thread thread = ABTI_thread_get_handle(p_thread);
     p_arg->print_fn(p_arg->arg, thread);
 }
+
+static void pool_waiter_init(ABTI_pool_waiter *p_waiter, int num_nodes,
+                             ABTI_pool_waiter_node *nodes)
+{
+    int i;
+    ABTD_spinlock_clear(&p_waiter->lock);
+    ABTD_atomic_relaxed_store_int(&p_waiter->is_notified, 0);
+#ifndef ABT_CONFIG_ACTIVE_WAIT_POLICY
+    ABTD_futex_multiple_init(&p_waiter->futex);
+#endif
+    p_waiter->num_nodes = num_nodes;
+    p_waiter->nodes = nodes;
+    for (i = 0; i < num_nodes; i++) {
+        nodes[i].p_waiter = p_waiter;
+        nodes[i].p_prev = NULL;
+        nodes[i].p_next = NULL;
+    }
+}
+
+/* Return ABT_TRUE if p_waiter has not been notified before. */
+static ABT_bool pool_waiter_notify(ABTI_pool_waiter *p_waiter)
+{
+    ABT_bool ret = ABT_FALSE;
+    ABTD_spinlock_acquire(&p_waiter->lock);
+    if (!ABTD_atomic_relaxed_load_int(&p_waiter->is_notified)) {
+        ABTD_atomic_release_store_int(&p_waiter->is_notified, 1);
+#ifndef ABT_CONFIG_ACTIVE_WAIT_POLICY
+        ABTD_futex_broadcast(&p_waiter->futex);
+#endif
+        ret = ABT_TRUE;
+    }
+    ABTD_spinlock_release(&p_waiter->lock);
+    return ret;
+}
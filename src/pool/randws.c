@@ -5,6 +5,7 @@
 
 #include "abti.h"
 #include "thread_queue.h"
+#include "thread_deque.h"
 #include <time.h>
 
 /* RANDWS pool implementation */
@@ -48,8 +49,32 @@ static ABT_bool pool_unit_is_in_pool(ABT_unit unit);
      ABT_POOL_CONTEXT_OP_THREAD_REVIVE | ABT_POOL_CONTEXT_OP_THREAD_REVIVE_TO)
 #define POOL_CONTEXT_POP_TAIL (ABT_POOL_CONTEXT_OWNER_SECONDARY)
 
+/*
+ * A shared RANDWS pool consists of a Chase-Lev deque and a spinlock-protected
+ * queue.  The pool is owned by the execution stream that is associated with it,
+ * that is, the execution stream whose main scheduler takes this pool as its
+ * first pool.  That execution stream becomes the owner when it first pops a
+ * work unit from this pool, so pops by a scheduler, which do not specify any
+ * ABT_POOL_CONTEXT_OWNER flag, are owner pops.  If no execution stream is
+ * associated with the pool, the execution stream that first pops a work unit
+ * with ABT_POOL_CONTEXT_OWNER_PRIMARY becomes the owner.
+ *
+ * - The owner pushes a work unit to the bottom of the deque if
+ *   POOL_CONTEXT_PUSH_HEAD is set.  All the other pushes (e.g., yield and
+ *   resume, and any push by a non-owner) go to the queue.
+ * - The owner pops a work unit from the bottom of the deque and then the head
+ *   of the queue.  Neither takes a lock or an atomic read-modify-write
+ *   operation in the common case.
+ * - The others steal a work unit from the top of the deque with CAS and then
+ *   from the head of the queue, so they also take work units in FIFO order.
+ *   ABT_POOL_CONTEXT_OWNER_SECONDARY takes the tail of the queue instead.
+ */
 struct data {
-    ABTD_spinlock mutex;
+    ABTD_atomic_ptr p_owner; /* ABTI_xstream that owns deque. */
+    ABTD_atomic_int num_removing;
+    thread_deque_t deque;
+    ABTU_align_member_var(ABT_CONFIG_STATIC_CACHELINE_SIZE)
+        ABTD_spinlock mutex;
     thread_queue_t queue;
 };
 typedef struct data data_t;
@@ -59,6 +84,99 @@ static inline data_t *pool_get_data_ptr(void *p_data)
     return (data_t *)p_data;
 }
 
+static inline ABTI_xstream *pool_get_local_xstream(void)
+{
+    return ABTI_local_get_xstream_or_null(ABTI_local_get_local());
+}
+
+/* Return ABT_TRUE if p_pool is the first pool of the main scheduler of
+ * p_xstream. */
+static inline ABT_bool pool_is_associated(ABTI_pool *p_pool,
+                                          ABTI_xstream *p_xstream)
+{
+    ABTI_sched *p_sched = p_xstream->p_main_sched;
+    return (p_sched && p_sched->num_pools > 0 &&
+            ABTI_pool_get_ptr(p_sched->pools[0]) == p_pool)
+               ? ABT_TRUE
+               : ABT_FALSE;
+}
+
+static inline ABTI_thread *pool_pop_queue_head(data_t *p_data)
+{
+    ABTI_thread *p_thread = NULL;
+    if (thread_queue_acquire_spinlock_if_not_empty(&p_data->queue,
+                                                   &p_data->mutex) == 0) {
+        p_thread = thread_queue_pop_head(&p_data->queue);
+        ABTD_spinlock_release(&p_data->mutex);
+    }
+    return p_thread;
+}
+
+static inline ABTI_thread *pool_pop_queue_tail(data_t *p_data)
+{
+    ABTI_thread *p_thread = NULL;
+    if (thread_queue_acquire_spinlock_if_not_empty(&p_data->queue,
+                                                   &p_data->mutex) == 0) {
+        p_thread = thread_queue_pop_tail(&p_data->queue);
+        ABTD_spinlock_release(&p_data->mutex);
+    }
+    return p_thread;
+}
+
+static inline void pool_push_internal(data_t *p_data, ABTI_thread *p_thread,
+                                      ABT_pool_context context)
+{
+    if (context & POOL_CONTEXT_PUSH_HEAD) {
+        ABTI_xstream *p_local_xstream = pool_get_local_xstream();
+        if (p_local_xstream &&
+            ABTD_atomic_relaxed_load_ptr(&p_data->p_owner) == p_local_xstream) {
+            if (thread_deque_push(&p_data->deque, p_thread) == ABT_SUCCESS)
+                return;
+            /* The deque cannot be extended.  Use the queue instead. */
+        }
+        ABTD_spinlock_acquire(&p_data->mutex);
+        thread_queue_push_head(&p_data->queue, p_thread);
+        ABTD_spinlock_release(&p_data->mutex);
+    } else {
+        ABTD_spinlock_acquire(&p_data->mutex);
+        thread_queue_push_tail(&p_data->queue, p_thread);
+        ABTD_spinlock_release(&p_data->mutex);
+    }
+}
+
+static inline ABTI_thread *pool_pop_internal(ABTI_pool *p_pool,
+                                             data_t *p_data,
+                                             ABT_pool_context context)
+{
+    if (!(context & POOL_CONTEXT_POP_TAIL)) {
+        ABTI_xstream *p_local_xstream = pool_get_local_xstream();
+        if (p_local_xstream) {
+            void *p_owner = ABTD_atomic_relaxed_load_ptr(&p_data->p_owner);
+            if (!p_owner && ((context & ABT_POOL_CONTEXT_OWNER_PRIMARY) ||
+                             pool_is_associated(p_pool, p_local_xstream))) {
+                /* Become the owner of this pool. */
+                ABTD_atomic_bool_cas_strong_ptr(&p_data->p_owner, NULL,
+                                                p_local_xstream);
+                p_owner = ABTD_atomic_relaxed_load_ptr(&p_data->p_owner);
+            }
+            if (p_owner == p_local_xstream) {
+                ABTI_thread *p_thread = thread_deque_pop(&p_data->deque);
+                if (p_thread)
+                    return p_thread;
+                return pool_pop_queue_head(p_data);
+            }
+        }
+        ABTI_thread *p_thread = thread_deque_steal(&p_data->deque);
+        if (p_thread)
+            return p_thread;
+        return pool_pop_queue_head(p_data);
+    }
+    ABTI_thread *p_thread = thread_deque_steal(&p_data->deque);
+    if (p_thread)
+        return p_thread;
+    return pool_pop_queue_tail(p_data);
+}
+
 /* Obtain the RANDWS pool definition according to the access type */
 ABTU_ret_err int
 ABTI_pool_get_randws_def(ABT_pool_access access,
@@ -67,7 +185,6 @@ ABTI_pool_get_randws_def(ABT_pool_access access,
                          ABTI_pool_deprecated_def *p_deprecated_def)
 {
     /* Definitions according to the access type */
-    /* FIXME: need better implementation, e.g., lock-free one */
     switch (access) {
         case ABT_POOL_ACCESS_PRIV:
             p_required_def->p_push = pool_push_private;
@@ -114,18 +231,24 @@ static int pool_init(ABT_pool pool, ABT_pool_config config)
     ABTI_UNUSED(config);
     int abt_errno = ABT_SUCCESS;
     ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
-    ABT_pool_access access;
 
     data_t *p_data;
-    abt_errno = ABTU_malloc(sizeof(data_t), (void **)&p_data);
+    abt_errno = ABTU_memalign(ABT_CONFIG_STATIC_CACHELINE_SIZE, sizeof(data_t),
+                              (void **)&p_data);
     ABTI_CHECK_ERROR(abt_errno);
 
-    access = p_pool->access;
-    if (access != ABT_POOL_ACCESS_PRIV) {
-        /* Initialize the mutex */
-        ABTD_spinlock_clear(&p_data->mutex);
-    }
+    /* A private pool uses only the queue, but the deque and the mutex are
+     * always initialized so that pop_wait() etc. work regardless of the
+     * access type. */
+    ABTD_spinlock_clear(&p_data->mutex);
     thread_queue_init(&p_data->queue);
+    abt_errno = thread_deque_init(&p_data->deque);
+    if (ABTI_IS_ERROR_CHECK_ENABLED && abt_errno != ABT_SUCCESS) {
+        ABTU_free(p_data);
+        ABTI_HANDLE_ERROR(abt_errno);
+    }
+    ABTD_atomic_relaxed_store_ptr(&p_data->p_owner, NULL);
+    ABTD_atomic_relaxed_store_int(&p_data->num_removing, 0);
 
     p_pool->data = p_data;
     return abt_errno;
@@ -135,6 +258,7 @@ static void pool_free(ABT_pool pool)
 {
     ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
     data_t *p_data = pool_get_data_ptr(p_pool->data);
+    thread_deque_free(&p_data->deque);
     thread_queue_free(&p_data->queue);
     ABTU_free(p_data);
 }
@@ -143,14 +267,21 @@ static ABT_bool pool_is_empty(ABT_pool pool)
 {
     ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
     data_t *p_data = pool_get_data_ptr(p_pool->data);
-    return thread_queue_is_empty(&p_data->queue);
+    /* A work unit that is being moved by remove() is regarded as in the
+     * pool. */
+    return (thread_deque_is_empty(&p_data->deque) &&
+            thread_queue_is_empty(&p_data->queue) &&
+            ABTD_atomic_acquire_load_int(&p_data->num_removing) == 0)
+               ? ABT_TRUE
+               : ABT_FALSE;
 }
 
 static size_t pool_get_size(ABT_pool pool)
 {
     ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
     data_t *p_data = pool_get_data_ptr(p_pool->data);
-    return thread_queue_get_size(&p_data->queue);
+    return thread_deque_get_size(&p_data->deque) +
+           thread_queue_get_size(&p_data->queue);
 }
 
 static void pool_push_shared(ABT_pool pool, ABT_unit unit,
@@ -159,13 +290,7 @@ static void pool_push_shared(ABT_pool pool, ABT_unit unit,
     ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
     data_t *p_data = pool_get_data_ptr(p_pool->data);
     ABTI_thread *p_thread = ABTI_unit_get_thread_from_builtin_unit(unit);
-    ABTD_spinlock_acquire(&p_data->mutex);
-    if (context & POOL_CONTEXT_PUSH_HEAD) {
-        thread_queue_push_head(&p_data->queue, p_thread);
-    } else {
-        thread_queue_push_tail(&p_data->queue, p_thread);
-    }
-    ABTD_spinlock_release(&p_data->mutex);
+    pool_push_internal(p_data, p_thread, context);
 }
 
 static void pool_push_private(ABT_pool pool, ABT_unit unit,
@@ -186,19 +311,11 @@ static void pool_push_many_shared(ABT_pool pool, const ABT_unit *units,
 {
     ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
     data_t *p_data = pool_get_data_ptr(p_pool->data);
-    if (num_units > 0) {
-        ABTD_spinlock_acquire(&p_data->mutex);
-        size_t i;
-        for (i = 0; i < num_units; i++) {
-            ABTI_thread *p_thread =
-                ABTI_unit_get_thread_from_builtin_unit(units[i]);
-            if (context & POOL_CONTEXT_PUSH_HEAD) {
-                thread_queue_push_head(&p_data->queue, p_thread);
-            } else {
-                thread_queue_push_tail(&p_data->queue, p_thread);
-            }
-        }
-        ABTD_spinlock_release(&p_data->mutex);
+    size_t i;
+    for (i = 0; i < num_units; i++) {
+        ABTI_thread *p_thread =
+            ABTI_unit_get_thread_from_builtin_unit(units[i]);
+        pool_push_internal(p_data, p_thread, context);
     }
 }
 
@@ -226,18 +343,9 @@ static ABT_thread pool_pop_wait(ABT_pool pool, double time_secs,
     data_t *p_data = pool_get_data_ptr(p_pool->data);
     double time_start = 0.0;
     while (1) {
-        if (thread_queue_acquire_spinlock_if_not_empty(&p_data->queue,
-                                                       &p_data->mutex) == 0) {
-            ABTI_thread *p_thread;
-            if (context & POOL_CONTEXT_POP_TAIL) {
-                p_thread = thread_queue_pop_tail(&p_data->queue);
-            } else {
-                p_thread = thread_queue_pop_head(&p_data->queue);
-            }
-            ABTD_spinlock_release(&p_data->mutex);
-            if (p_thread)
-                return ABTI_thread_get_handle(p_thread);
-        }
+        ABTI_thread *p_thread = pool_pop_internal(p_pool, p_data, context);
+        if (p_thread)
+            return ABTI_thread_get_handle(p_thread);
         if (time_start == 0.0) {
             time_start = ABTI_get_wtime();
         } else {
@@ -257,14 +365,10 @@ static ABT_unit pool_pop_timedwait(ABT_pool pool, double abstime_secs)
     ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
     data_t *p_data = pool_get_data_ptr(p_pool->data);
     while (1) {
-        if (thread_queue_acquire_spinlock_if_not_empty(&p_data->queue,
-                                                       &p_data->mutex) == 0) {
-            ABTI_thread *p_thread = thread_queue_pop_head(&p_data->queue);
-            ABTD_spinlock_release(&p_data->mutex);
-            if (p_thread) {
-                return ABTI_unit_get_builtin_unit(p_thread);
-            }
-        }
+        ABTI_thread *p_thread =
+            pool_pop_internal(p_pool, p_data, ABT_POOL_CONTEXT_OWNER_DEFAULT);
+        if (p_thread)
+            return ABTI_unit_get_builtin_unit(p_thread);
         const int sleep_nsecs = 100;
         struct timespec ts = { 0, sleep_nsecs };
         nanosleep(&ts, NULL);
@@ -278,19 +382,8 @@ static ABT_thread pool_pop_shared(ABT_pool pool, ABT_pool_context context)
 {
     ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
     data_t *p_data = pool_get_data_ptr(p_pool->data);
-    if (thread_queue_acquire_spinlock_if_not_empty(&p_data->queue,
-                                                   &p_data->mutex) == 0) {
-        ABTI_thread *p_thread;
-        if (context & POOL_CONTEXT_POP_TAIL) {
-            p_thread = thread_queue_pop_tail(&p_data->queue);
-        } else {
-            p_thread = thread_queue_pop_head(&p_data->queue);
-        }
-        ABTD_spinlock_release(&p_data->mutex);
-        return ABTI_thread_get_handle(p_thread);
-    } else {
-        return ABT_THREAD_NULL;
-    }
+    ABTI_thread *p_thread = pool_pop_internal(p_pool, p_data, context);
+    return ABTI_thread_get_handle(p_thread);
 }
 
 static ABT_thread pool_pop_private(ABT_pool pool, ABT_pool_context context)
@@ -312,26 +405,14 @@ static void pool_pop_many_shared(ABT_pool pool, ABT_thread *threads,
 {
     ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
     data_t *p_data = pool_get_data_ptr(p_pool->data);
-    if (max_threads != 0 &&
-        thread_queue_acquire_spinlock_if_not_empty(&p_data->queue,
-                                                   &p_data->mutex) == 0) {
-        size_t i;
-        for (i = 0; i < max_threads; i++) {
-            ABTI_thread *p_thread;
-            if (context & POOL_CONTEXT_POP_TAIL) {
-                p_thread = thread_queue_pop_tail(&p_data->queue);
-            } else {
-                p_thread = thread_queue_pop_head(&p_data->queue);
-            }
-            if (!p_thread)
-                break;
-            threads[i] = ABTI_thread_get_handle(p_thread);
-        }
-        *num_popped = i;
-        ABTD_spinlock_release(&p_data->mutex);
-    } else {
-        *num_popped = 0;
+    size_t i;
+    for (i = 0; i < max_threads; i++) {
+        ABTI_thread *p_thread = pool_pop_internal(p_pool, p_data, context);
+        if (!p_thread)
+            break;
+        threads[i] = ABTI_thread_get_handle(p_thread);
     }
+    *num_popped = i;
 }
 
 static void pool_pop_many_private(ABT_pool pool, ABT_thread *threads,
@@ -360,9 +441,36 @@ static int pool_remove_shared(ABT_pool pool, ABT_unit unit)
     ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
     data_t *p_data = pool_get_data_ptr(p_pool->data);
     ABTI_thread *p_thread = ABTI_unit_get_thread_from_builtin_unit(unit);
+    ABTI_CHECK_TRUE(ABTD_atomic_acquire_load_int(&p_thread->is_in_pool) == 1,
+                    ABT_ERR_POOL);
+
+    int abt_errno = ABT_ERR_POOL;
+    ABTD_atomic_fetch_add_int(&p_data->num_removing, 1);
     ABTD_spinlock_acquire(&p_data->mutex);
-    int abt_errno = thread_queue_remove(&p_data->queue, p_thread);
+    /* A work unit in the middle of the deque cannot be removed.  Steal work
+     * units until p_thread is found and move the others to the queue. */
+    while (!thread_deque_is_empty(&p_data->deque)) {
+        ABTI_thread *p_stolen = thread_deque_steal(&p_data->deque);
+        if (p_stolen == p_thread) {
+            abt_errno = ABT_SUCCESS;
+            break;
+        } else if (p_stolen) {
+            thread_queue_push_tail(&p_data->queue, p_stolen);
+        }
+    }
+    if (abt_errno != ABT_SUCCESS) {
+        /* Look for p_thread in the queue. */
+        ABTI_thread *p_cur = p_data->queue.p_head;
+        size_t i, num_threads = thread_queue_get_size(&p_data->queue);
+        for (i = 0; i < num_threads; i++, p_cur = p_cur->p_next) {
+            if (p_cur == p_thread) {
+                abt_errno = thread_queue_remove(&p_data->queue, p_thread);
+                break;
+            }
+        }
+    }
     ABTD_spinlock_release(&p_data->mutex);
+    ABTD_atomic_fetch_sub_int(&p_data->num_removing, 1);
     return abt_errno;
 }
 
@@ -382,6 +490,7 @@ static void pool_print_all(ABT_pool pool, void *arg,
     data_t *p_data = pool_get_data_ptr(p_pool->data);
 
     access = p_pool->access;
+    thread_deque_print_all(&p_data->deque, arg, print_fn);
     if (access != ABT_POOL_ACCESS_PRIV) {
         ABTD_spinlock_acquire(&p_data->mutex);
     }
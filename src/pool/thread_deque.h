@@ -0,0 +1,203 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#ifndef THREAD_DEQUE_H_INCLUDED
+#define THREAD_DEQUE_H_INCLUDED
+
+#include "abti.h"
+
+/*
+ * Chase-Lev work-stealing deque, following the C11 formulation by Le et al.
+ * ("Correct and Efficient Work-Stealing for Weak Memory Models", PPoPP '13).
+ *
+ * Only the owner pushes to and pops from the bottom.  A push is a plain store
+ * followed by a release store, and a pop takes a sequentially consistent fence
+ * but no atomic read-modify-write operation unless it competes with thieves for
+ * the last work unit.  Thieves take work units from the top with CAS.
+ *
+ * The array grows when it becomes full.  An old array may still be read by a
+ * thief, so it is kept until the deque is freed.
+ */
+
+#define THREAD_DEQUE_INIT_CAPACITY 64
+
+typedef struct thread_deque_array {
+    struct thread_deque_array *p_old; /* Retired array. */
+    size_t mask;
+    ABTD_atomic_ptr threads[1];
+} thread_deque_array_t;
+
+typedef struct {
+    ABTD_atomic_ptr p_array;
+    /* Updated only by the owner. */
+    ABTU_align_member_var(ABT_CONFIG_STATIC_CACHELINE_SIZE)
+        ABTD_atomic_size bottom;
+    /* Updated by thieves. */
+    ABTU_align_member_var(ABT_CONFIG_STATIC_CACHELINE_SIZE)
+        ABTD_atomic_size top;
+} thread_deque_t;
+
+ABTU_ret_err static inline int
+thread_deque_array_create(size_t capacity, thread_deque_array_t **pp_array)
+{
+    thread_deque_array_t *p_array;
+    int abt_errno =
+        ABTU_malloc(offsetof(thread_deque_array_t, threads) +
+                        sizeof(ABTD_atomic_ptr) * capacity,
+                    (void **)&p_array);
+    ABTI_CHECK_ERROR(abt_errno);
+    p_array->p_old = NULL;
+    p_array->mask = capacity - 1;
+    *pp_array = p_array;
+    return ABT_SUCCESS;
+}
+
+ABTU_ret_err static inline int thread_deque_init(thread_deque_t *p_deque)
+{
+    thread_deque_array_t *p_array;
+    int abt_errno =
+        thread_deque_array_create(THREAD_DEQUE_INIT_CAPACITY, &p_array);
+    ABTI_CHECK_ERROR(abt_errno);
+    ABTD_atomic_relaxed_store_ptr(&p_deque->p_array, (void *)p_array);
+    ABTD_atomic_relaxed_store_size(&p_deque->bottom, 0);
+    ABTD_atomic_relaxed_store_size(&p_deque->top, 0);
+    return ABT_SUCCESS;
+}
+
+static inline void thread_deque_free(thread_deque_t *p_deque)
+{
+    thread_deque_array_t *p_array =
+        (thread_deque_array_t *)ABTD_atomic_relaxed_load_ptr(
+            &p_deque->p_array);
+    while (p_array) {
+        thread_deque_array_t *p_old = p_array->p_old;
+        ABTU_free(p_array);
+        p_array = p_old;
+    }
+}
+
+static inline ABT_bool thread_deque_is_empty(const thread_deque_t *p_deque)
+{
+    size_t top = ABTD_atomic_acquire_load_size(&p_deque->top);
+    size_t bottom = ABTD_atomic_acquire_load_size(&p_deque->bottom);
+    return (intptr_t)(bottom - top) > 0 ? ABT_FALSE : ABT_TRUE;
+}
+
+static inline size_t thread_deque_get_size(const thread_deque_t *p_deque)
+{
+    size_t top = ABTD_atomic_acquire_load_size(&p_deque->top);
+    size_t bottom = ABTD_atomic_acquire_load_size(&p_deque->bottom);
+    return (intptr_t)(bottom - top) > 0 ? bottom - top : 0;
+}
+
+/* Push p_thread to the bottom.  Only the owner may call this function.  This
+ * function fails only when the array cannot be extended. */
+ABTU_ret_err static inline int thread_deque_push(thread_deque_t *p_deque,
+                                                 ABTI_thread *p_thread)
+{
+    size_t bottom = ABTD_atomic_relaxed_load_size(&p_deque->bottom);
+    size_t top = ABTD_atomic_acquire_load_size(&p_deque->top);
+    thread_deque_array_t *p_array =
+        (thread_deque_array_t *)ABTD_atomic_relaxed_load_ptr(
+            &p_deque->p_array);
+    if (bottom - top > p_array->mask) {
+        /* The array is full.  Extend it. */
+        thread_deque_array_t *p_new_array;
+        int abt_errno =
+            thread_deque_array_create((p_array->mask + 1) * 2, &p_new_array);
+        ABTI_CHECK_ERROR(abt_errno);
+        size_t i;
+        for (i = top; i != bottom; i++) {
+            ABTD_atomic_relaxed_store_ptr(
+                &p_new_array->threads[i & p_new_array->mask],
+                ABTD_atomic_relaxed_load_ptr(
+                    &p_array->threads[i & p_array->mask]));
+        }
+        p_new_array->p_old = p_array;
+        ABTD_atomic_release_store_ptr(&p_deque->p_array, (void *)p_new_array);
+        p_array = p_new_array;
+    }
+    ABTD_atomic_release_store_int(&p_thread->is_in_pool, 1);
+    ABTD_atomic_relaxed_store_ptr(&p_array->threads[bottom & p_array->mask],
+                                  (void *)p_thread);
+    ABTD_atomic_release_store_size(&p_deque->bottom, bottom + 1);
+    return ABT_SUCCESS;
+}
+
+/* Pop a work unit from the bottom.  Only the owner may call this function. */
+static inline ABTI_thread *thread_deque_pop(thread_deque_t *p_deque)
+{
+    size_t bottom = ABTD_atomic_relaxed_load_size(&p_deque->bottom);
+    /* top never decreases, so the deque is surely empty if top that might be
+     * stale has reached bottom.  This check avoids a fence when it is empty. */
+    if ((intptr_t)(bottom - ABTD_atomic_relaxed_load_size(&p_deque->top)) <= 0)
+        return NULL;
+    bottom--;
+    thread_deque_array_t *p_array =
+        (thread_deque_array_t *)ABTD_atomic_relaxed_load_ptr(
+            &p_deque->p_array);
+    ABTD_atomic_relaxed_store_size(&p_deque->bottom, bottom);
+    ABTD_atomic_seq_cst_mem_barrier();
+    size_t top = ABTD_atomic_relaxed_load_size(&p_deque->top);
+    ABTI_thread *p_thread = NULL;
+    if ((intptr_t)(bottom - top) >= 0) {
+        p_thread = (ABTI_thread *)ABTD_atomic_relaxed_load_ptr(
+            &p_array->threads[bottom & p_array->mask]);
+        if (bottom == top) {
+            /* This is the last one.  Compete with thieves. */
+            if (!ABTD_atomic_bool_cas_strong_size(&p_deque->top, top,
+                                                  top + 1)) {
+                p_thread = NULL;
+            }
+            ABTD_atomic_relaxed_store_size(&p_deque->bottom, bottom + 1);
+        }
+    } else {
+        ABTD_atomic_relaxed_store_size(&p_deque->bottom, bottom + 1);
+    }
+    if (p_thread)
+        ABTD_atomic_release_store_int(&p_thread->is_in_pool, 0);
+    return p_thread;
+}
+
+/* Steal a work unit from the top.  Any thread may call this function. */
+static inline ABTI_thread *thread_deque_steal(thread_deque_t *p_deque)
+{
+    while (1) {
+        size_t top = ABTD_atomic_acquire_load_size(&p_deque->top);
+        ABTD_atomic_seq_cst_mem_barrier();
+        size_t bottom = ABTD_atomic_acquire_load_size(&p_deque->bottom);
+        if ((intptr_t)(bottom - top) <= 0)
+            return NULL;
+        thread_deque_array_t *p_array =
+            (thread_deque_array_t *)ABTD_atomic_acquire_load_ptr(
+                &p_deque->p_array);
+        ABTI_thread *p_thread = (ABTI_thread *)ABTD_atomic_relaxed_load_ptr(
+            &p_array->threads[top & p_array->mask]);
+        if (ABTD_atomic_bool_cas_strong_size(&p_deque->top, top, top + 1)) {
+            ABTD_atomic_release_store_int(&p_thread->is_in_pool, 0);
+            return p_thread;
+        }
+        /* Lost a race with another thief or the owner.  Retry. */
+    }
+}
+
+/* Print work units in the deque.  The result is not accurate if the deque is
+ * concurrently updated. */
+static inline void thread_deque_print_all(thread_deque_t *p_deque, void *arg,
+                                          void (*print_fn)(void *, ABT_thread))
+{
+    size_t top = ABTD_atomic_acquire_load_size(&p_deque->top);
+    size_t bottom = ABTD_atomic_acquire_load_size(&p_deque->bottom);
+    thread_deque_array_t *p_array =
+        (thread_deque_array_t *)ABTD_atomic_acquire_load_ptr(
+            &p_deque->p_array);
+    for (; (intptr_t)(bottom - top) > 0; top++) {
+        ABTI_thread *p_thread = (ABTI_thread *)ABTD_atomic_relaxed_load_ptr(
+            &p_array->threads[top & p_array->mask]);
+        print_fn(arg, ABTI_thread_get_handle(p_thread));
+    }
+}
+
+#endif /* THREAD_DEQUE_H_INCLUDED */
@@ -0,0 +1,235 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#ifndef THREAD_HEAP_H_INCLUDED
+#define THREAD_HEAP_H_INCLUDED
+
+#include "abti.h"
+#include "thread_queue.h"
+
+/*
+ * Array-based binary min-heap of work units ordered by their priorities.  Work
+ * units that have the same priority are ordered by a sequence number assigned
+ * on push, so they are popped in FIFO order.
+ *
+ * The array is extended when it becomes full.  If the extension fails, a work
+ * unit is kept in an overflow queue and moved to the array when pop() makes
+ * room, so push() never fails.
+ */
+
+#define THREAD_HEAP_INIT_CAPACITY 64
+
+typedef struct {
+    int64_t priority;
+    uint64_t seq;
+    ABTI_thread *p_thread;
+} thread_heap_entry_t;
+
+typedef struct {
+    size_t num_entries;
+    size_t capacity;
+    uint64_t seq;
+    thread_heap_entry_t *entries;
+    thread_queue_t overflow;
+    /* If the pool is empty, pop() accesses only is_empty. */
+    ABTD_atomic_int is_empty;
+} thread_heap_t;
+
+ABTU_ret_err static inline int thread_heap_init(thread_heap_t *p_heap)
+{
+    int abt_errno =
+        ABTU_malloc(sizeof(thread_heap_entry_t) * THREAD_HEAP_INIT_CAPACITY,
+                    (void **)&p_heap->entries);
+    ABTI_CHECK_ERROR(abt_errno);
+    p_heap->num_entries = 0;
+    p_heap->capacity = THREAD_HEAP_INIT_CAPACITY;
+    p_heap->seq = 0;
+    thread_queue_init(&p_heap->overflow);
+    ABTD_atomic_relaxed_store_int(&p_heap->is_empty, 1);
+    return ABT_SUCCESS;
+}
+
+static inline void thread_heap_free(thread_heap_t *p_heap)
+{
+    thread_queue_free(&p_heap->overflow);
+    ABTU_free(p_heap->entries);
+}
+
+ABTU_ret_err static inline int
+thread_heap_acquire_spinlock_if_not_empty(thread_heap_t *p_heap,
+                                          ABTD_spinlock *p_lock)
+{
+    if (ABTD_atomic_acquire_load_int(&p_heap->is_empty)) {
+        /* The pool is empty.  Lock is not taken. */
+        return 1;
+    }
+    while (ABTD_spinlock_try_acquire(p_lock)) {
+        /* Lock acquisition failed.  Check the size. */
+        while (1) {
+            if (ABTD_atomic_acquire_load_int(&p_heap->is_empty)) {
+                /* The pool becomes empty.  Lock is not taken. */
+                return 1;
+            } else if (!ABTD_spinlock_is_locked(p_lock)) {
+                /* Lock seems released.  Let's try to take a lock again. */
+                break;
+            }
+        }
+    }
+    /* Lock is acquired. */
+    return 0;
+}
+
+static inline ABT_bool thread_heap_is_empty(const thread_heap_t *p_heap)
+{
+    return ABTD_atomic_acquire_load_int(&p_heap->is_empty) ? ABT_TRUE
+                                                           : ABT_FALSE;
+}
+
+static inline size_t thread_heap_get_size(const thread_heap_t *p_heap)
+{
+    return p_heap->num_entries + thread_queue_get_size(&p_heap->overflow);
+}
+
+static inline int thread_heap_entry_less(const thread_heap_entry_t *p_entry1,
+                                         const thread_heap_entry_t *p_entry2)
+{
+    return p_entry1->priority < p_entry2->priority ||
+           (p_entry1->priority == p_entry2->priority &&
+            p_entry1->seq < p_entry2->seq);
+}
+
+static inline void thread_heap_sift_up(thread_heap_t *p_heap, size_t i)
+{
+    thread_heap_entry_t *entries = p_heap->entries;
+    thread_heap_entry_t entry = entries[i];
+    while (i > 0) {
+        size_t parent = (i - 1) / 2;
+        if (!thread_heap_entry_less(&entry, &entries[parent]))
+            break;
+        entries[i] = entries[parent];
+        i = parent;
+    }
+    entries[i] = entry;
+}
+
+static inline void thread_heap_sift_down(thread_heap_t *p_heap, size_t i)
+{
+    thread_heap_entry_t *entries = p_heap->entries;
+    size_t num_entries = p_heap->num_entries;
+    thread_heap_entry_t entry = entries[i];
+    while (1) {
+        size_t child = i * 2 + 1;
+        if (child >= num_entries)
+            break;
+        if (child + 1 < num_entries &&
+            thread_heap_entry_less(&entries[child + 1], &entries[child]))
+            child++;
+        if (!thread_heap_entry_less(&entries[child], &entry))
+            break;
+        entries[i] = entries[child];
+        i = child;
+    }
+    entries[i] = entry;
+}
+
+/* Add p_thread to the array.  The array must have room. */
+static inline void thread_heap_insert(thread_heap_t *p_heap,
+                                      ABTI_thread *p_thread, uint64_t seq)
+{
+    size_t i = p_heap->num_entries++;
+    p_heap->entries[i].priority = p_thread->priority;
+    p_heap->entries[i].seq = seq;
+    p_heap->entries[i].p_thread = p_thread;
+    thread_heap_sift_up(p_heap, i);
+}
+
+static inline void thread_heap_push(thread_heap_t *p_heap,
+                                    ABTI_thread *p_thread)
+{
+    if (p_heap->num_entries == p_heap->capacity) {
+        int abt_errno =
+            ABTU_realloc(sizeof(thread_heap_entry_t) * p_heap->capacity,
+                         sizeof(thread_heap_entry_t) * p_heap->capacity * 2,
+                         (void **)&p_heap->entries);
+        if (abt_errno == ABT_SUCCESS) {
+            p_heap->capacity *= 2;
+        }
+    }
+    if (p_heap->num_entries < p_heap->capacity &&
+        thread_queue_is_empty(&p_heap->overflow)) {
+        thread_heap_insert(p_heap, p_thread, p_heap->seq++);
+        ABTD_atomic_release_store_int(&p_thread->is_in_pool, 1);
+    } else {
+        /* Keep the FIFO order of the overflow queue. */
+        thread_queue_push_tail(&p_heap->overflow, p_thread);
+    }
+    ABTD_atomic_release_store_int(&p_heap->is_empty, 0);
+}
+
+static inline ABTI_thread *thread_heap_pop(thread_heap_t *p_heap)
+{
+    ABTI_thread *p_thread;
+    if (p_heap->num_entries == 0) {
+        p_thread = thread_queue_pop_head(&p_heap->overflow);
+        if (!p_thread)
+            return NULL;
+    } else {
+        p_thread = p_heap->entries[0].p_thread;
+        if (--p_heap->num_entries > 0) {
+            p_heap->entries[0] = p_heap->entries[p_heap->num_entries];
+            thread_heap_sift_down(p_heap, 0);
+        }
+        /* There is room for a work unit in the overflow queue. */
+        ABTI_thread *p_overflow = thread_queue_pop_head(&p_heap->overflow);
+        if (p_overflow) {
+            thread_heap_insert(p_heap, p_overflow, p_heap->seq++);
+            ABTD_atomic_release_store_int(&p_overflow->is_in_pool, 1);
+        }
+        ABTD_atomic_release_store_int(&p_thread->is_in_pool, 0);
+    }
+    if (thread_heap_get_size(p_heap) == 0)
+        ABTD_atomic_release_store_int(&p_heap->is_empty, 1);
+    return p_thread;
+}
+
+ABTU_ret_err static inline int thread_heap_remove(thread_heap_t *p_heap,
+                                                  ABTI_thread *p_thread)
+{
+    ABTI_CHECK_TRUE(ABTD_atomic_acquire_load_int(&p_thread->is_in_pool) == 1,
+                    ABT_ERR_POOL);
+    size_t i;
+    for (i = 0; i < p_heap->num_entries; i++) {
+        if (p_heap->entries[i].p_thread == p_thread)
+            break;
+    }
+    if (i == p_heap->num_entries) {
+        int abt_errno = thread_queue_remove(&p_heap->overflow, p_thread);
+        ABTI_CHECK_ERROR(abt_errno);
+    } else {
+        if (i != --p_heap->num_entries) {
+            p_heap->entries[i] = p_heap->entries[p_heap->num_entries];
+            thread_heap_sift_down(p_heap, i);
+            thread_heap_sift_up(p_heap, i);
+        }
+        ABTD_atomic_release_store_int(&p_thread->is_in_pool, 0);
+    }
+    if (thread_heap_get_size(p_heap) == 0)
+        ABTD_atomic_release_store_int(&p_heap->is_empty, 1);
+    return ABT_SUCCESS;
+}
+
+/* Print work units.  They are not sorted by priority. */
+static inline void thread_heap_print_all(const thread_heap_t *p_heap,
+                                         void *arg,
+                                         void (*print_fn)(void *, ABT_thread))
+{
+    size_t i;
+    for (i = 0; i < p_heap->num_entries; i++) {
+        print_fn(arg, ABTI_thread_get_handle(p_heap->entries[i].p_thread));
+    }
+    thread_queue_print_all(&p_heap->overflow, arg, print_fn);
+}
+
+#endif /* THREAD_HEAP_H_INCLUDED */
@@ -0,0 +1,272 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#ifndef THREAD_MPSC_QUEUE_H_INCLUDED
+#define THREAD_MPSC_QUEUE_H_INCLUDED
+
+#include "abti.h"
+
+/*
+ * Intrusive multi-producer single-consumer queue based on Vyukov's algorithm.
+ * Work units are linked via p_mpsc_next of ABTI_thread, so neither push nor pop
+ * allocates memory.  A node of the list is p_mpsc_next of a work unit or the
+ * stub of the queue, and each node points to the next node.  A producer takes
+ * only one atomic exchange on tail (and one fetch-and-add to count the number
+ * of work units).  Producers never take any lock.
+ *
+ * The consumer side is protected by a spinlock that producers never touch.  It
+ * is uncontended unless the deprecated remove() is called, so the cache line
+ * stays local to the consumer.  Thanks to this lock, a pop operation is still
+ * safe even if the single-consumer restriction is violated.
+ */
+
+typedef struct {
+    /* Producer side. */
+    ABTD_atomic_ptr p_tail; /* Last node (ABTD_atomic_ptr *) */
+    ABTD_atomic_size num_pushed;
+    /* Consumer side.  p_head is atomic since is_empty() reads it without the
+     * lock. */
+    ABTU_align_member_var(ABT_CONFIG_STATIC_CACHELINE_SIZE)
+        ABTD_atomic_ptr p_head; /* Node to be popped next (ABTD_atomic_ptr *) */
+    size_t num_popped;
+    ABTD_spinlock lock;
+    /* A dummy node that keeps the list non-empty. */
+    ABTD_atomic_ptr stub;
+} thread_mpsc_queue_t;
+
+static inline ABTD_atomic_ptr *thread_mpsc_queue_get_node(ABTI_thread *p_thread)
+{
+    return &p_thread->p_mpsc_next;
+}
+
+static inline ABTI_thread *thread_mpsc_queue_get_thread(ABTD_atomic_ptr *p_node)
+{
+    return (ABTI_thread *)(((char *)p_node) -
+                           offsetof(ABTI_thread, p_mpsc_next));
+}
+
+static inline ABTD_atomic_ptr *
+thread_mpsc_queue_get_next(const ABTD_atomic_ptr *p_node)
+{
+    return (ABTD_atomic_ptr *)ABTD_atomic_acquire_load_ptr(p_node);
+}
+
+static inline ABTD_atomic_ptr *
+thread_mpsc_queue_get_head(const thread_mpsc_queue_t *p_queue)
+{
+    return (ABTD_atomic_ptr *)ABTD_atomic_acquire_load_ptr(&p_queue->p_head);
+}
+
+static inline void thread_mpsc_queue_set_head(thread_mpsc_queue_t *p_queue,
+                                              ABTD_atomic_ptr *p_node)
+{
+    ABTD_atomic_release_store_ptr(&p_queue->p_head, (void *)p_node);
+}
+
+static inline void thread_mpsc_queue_init(thread_mpsc_queue_t *p_queue)
+{
+    ABTD_atomic_relaxed_store_ptr(&p_queue->stub, NULL);
+    ABTD_atomic_relaxed_store_ptr(&p_queue->p_tail, (void *)&p_queue->stub);
+    ABTD_atomic_relaxed_store_size(&p_queue->num_pushed, 0);
+    ABTD_atomic_relaxed_store_ptr(&p_queue->p_head, (void *)&p_queue->stub);
+    p_queue->num_popped = 0;
+    ABTD_spinlock_clear(&p_queue->lock);
+}
+
+static inline void thread_mpsc_queue_free(thread_mpsc_queue_t *p_queue)
+{
+    ; /* Do nothing. */
+}
+
+static inline ABT_bool
+thread_mpsc_queue_is_empty(const thread_mpsc_queue_t *p_queue)
+{
+    /* A work unit is at the head unless the head is the stub.  Checking the
+     * tail instead is not correct since the consumer might be appending the
+     * stub after a work unit that a producer has just appended. */
+    ABTD_atomic_ptr *p_head = thread_mpsc_queue_get_head(p_queue);
+    if (p_head != &p_queue->stub)
+        return ABT_FALSE;
+    return thread_mpsc_queue_get_next(p_head) ? ABT_FALSE : ABT_TRUE;
+}
+
+static inline size_t
+thread_mpsc_queue_get_size(const thread_mpsc_queue_t *p_queue)
+{
+    size_t num_popped = p_queue->num_popped;
+    size_t num_pushed = ABTD_atomic_acquire_load_size(&p_queue->num_pushed);
+    /* The values can be inconsistent under concurrent updates. */
+    return (intptr_t)(num_pushed - num_popped) > 0 ? num_pushed - num_popped
+                                                   : 0;
+}
+
+static inline void thread_mpsc_queue_link(thread_mpsc_queue_t *p_queue,
+                                          ABTD_atomic_ptr *p_node)
+{
+    ABTD_atomic_relaxed_store_ptr(p_node, NULL);
+    ABTD_atomic_ptr *p_prev =
+        (ABTD_atomic_ptr *)ABTD_atomic_exchange_ptr(&p_queue->p_tail,
+                                                    (void *)p_node);
+    /* Until this store, the consumer cannot see p_node. */
+    ABTD_atomic_release_store_ptr(p_prev, (void *)p_node);
+}
+
+static inline void thread_mpsc_queue_push(thread_mpsc_queue_t *p_queue,
+                                          ABTI_thread *p_thread)
+{
+    ABTD_atomic_release_store_int(&p_thread->is_in_pool, 1);
+    ABTD_atomic_fetch_add_size(&p_queue->num_pushed, 1);
+    thread_mpsc_queue_link(p_queue, thread_mpsc_queue_get_node(p_thread));
+}
+
+/* Wait until a producer that has updated p_tail links the next node of
+ * p_node. */
+static inline ABTD_atomic_ptr *
+thread_mpsc_queue_wait_next(const ABTD_atomic_ptr *p_node)
+{
+    ABTD_atomic_ptr *p_next;
+    while (!(p_next = thread_mpsc_queue_get_next(p_node)))
+        ABTD_atomic_pause();
+    return p_next;
+}
+
+/* Detach p_node, which must be a work unit at the head, from the list.  The
+ * caller must hold the consumer lock. */
+static inline void thread_mpsc_queue_unlink_head(thread_mpsc_queue_t *p_queue,
+                                                 ABTD_atomic_ptr *p_node)
+{
+    ABTD_atomic_ptr *p_next = thread_mpsc_queue_get_next(p_node);
+    if (!p_next) {
+        if (ABTD_atomic_acquire_load_ptr(&p_queue->p_tail) == p_node) {
+            /* p_node is the last node.  Append the stub so that p_node has a
+             * successor. */
+            thread_mpsc_queue_link(p_queue, &p_queue->stub);
+        }
+        /* Either the stub or a work unit of a producer that is in the middle
+         * of push will be linked to p_node soon.  This wait keeps pop from
+         * failing while a work unit is in the queue. */
+        p_next = thread_mpsc_queue_wait_next(p_node);
+    }
+    thread_mpsc_queue_set_head(p_queue, p_next);
+}
+
+static inline ABTI_thread *
+thread_mpsc_queue_pop_locked(thread_mpsc_queue_t *p_queue)
+{
+    ABTD_atomic_ptr *p_head = thread_mpsc_queue_get_head(p_queue);
+    if (p_head == &p_queue->stub) {
+        /* Skip the stub. */
+        p_head = thread_mpsc_queue_get_next(p_head);
+        if (!p_head)
+            return NULL;
+    }
+    thread_mpsc_queue_unlink_head(p_queue, p_head);
+    p_queue->num_popped++;
+    ABTI_thread *p_thread = thread_mpsc_queue_get_thread(p_head);
+    ABTD_atomic_release_store_int(&p_thread->is_in_pool, 0);
+    return p_thread;
+}
+
+static inline ABTI_thread *thread_mpsc_queue_pop(thread_mpsc_queue_t *p_queue)
+{
+    if (thread_mpsc_queue_is_empty(p_queue))
+        return NULL;
+    ABTD_spinlock_acquire(&p_queue->lock);
+    ABTI_thread *p_thread = thread_mpsc_queue_pop_locked(p_queue);
+    ABTD_spinlock_release(&p_queue->lock);
+    return p_thread;
+}
+
+static inline void thread_mpsc_queue_pop_many(thread_mpsc_queue_t *p_queue,
+                                              ABT_thread *threads,
+                                              size_t max_threads,
+                                              size_t *p_num_popped)
+{
+    size_t i = 0;
+    if (max_threads != 0 && !thread_mpsc_queue_is_empty(p_queue)) {
+        ABTD_spinlock_acquire(&p_queue->lock);
+        for (; i < max_threads; i++) {
+            ABTI_thread *p_thread = thread_mpsc_queue_pop_locked(p_queue);
+            if (!p_thread)
+                break;
+            threads[i] = ABTI_thread_get_handle(p_thread);
+        }
+        ABTD_spinlock_release(&p_queue->lock);
+    }
+    *p_num_popped = i;
+}
+
+ABTU_ret_err static inline int
+thread_mpsc_queue_remove(thread_mpsc_queue_t *p_queue, ABTI_thread *p_thread)
+{
+    ABTI_CHECK_TRUE(ABTD_atomic_acquire_load_int(&p_thread->is_in_pool) == 1,
+                    ABT_ERR_POOL);
+    ABTD_atomic_ptr *p_node = thread_mpsc_queue_get_node(p_thread);
+    ABTD_spinlock_acquire(&p_queue->lock);
+    int abt_errno = ABT_ERR_POOL;
+    ABTD_atomic_ptr *p_head = thread_mpsc_queue_get_head(p_queue);
+    if (p_head == &p_queue->stub) {
+        ABTD_atomic_ptr *p_next = thread_mpsc_queue_get_next(p_head);
+        if (p_next) {
+            p_head = p_next;
+            thread_mpsc_queue_set_head(p_queue, p_head);
+        }
+    }
+    if (p_head == p_node) {
+        thread_mpsc_queue_unlink_head(p_queue, p_node);
+        abt_errno = ABT_SUCCESS;
+    } else {
+        /* Find the predecessor of p_node. */
+        ABTD_atomic_ptr *p_prev = p_head;
+        ABTD_atomic_ptr *p_cur;
+        while ((p_cur = thread_mpsc_queue_get_next(p_prev)) &&
+               p_cur != p_node) {
+            p_prev = p_cur;
+        }
+        if (p_cur) {
+            ABTD_atomic_ptr *p_next = thread_mpsc_queue_get_next(p_node);
+            if (!p_next) {
+                /* p_node might be the last node.  Make p_prev the last node if
+                 * no producer has appended a new node. */
+                ABTD_atomic_relaxed_store_ptr(p_prev, NULL);
+                if (!ABTD_atomic_bool_cas_strong_ptr(&p_queue->p_tail,
+                                                     (void *)p_node,
+                                                     (void *)p_prev)) {
+                    p_next = thread_mpsc_queue_wait_next(p_node);
+                }
+            }
+            if (p_next)
+                ABTD_atomic_release_store_ptr(p_prev, (void *)p_next);
+            abt_errno = ABT_SUCCESS;
+        }
+    }
+    if (abt_errno == ABT_SUCCESS) {
+        p_queue->num_popped++;
+        ABTD_atomic_release_store_int(&p_thread->is_in_pool, 0);
+    }
+    ABTD_spinlock_release(&p_queue->lock);
+    return abt_errno;
+}
+
+/* Print work units in the queue.  The result is not accurate if the queue is
+ * concurrently updated. */
+static inline void thread_mpsc_queue_print_all(thread_mpsc_queue_t *p_queue,
+                                               void *arg,
+                                               void (*print_fn)(void *,
+                                                                ABT_thread))
+{
+    ABTD_spinlock_acquire(&p_queue->lock);
+    ABTD_atomic_ptr *p_node = thread_mpsc_queue_get_head(p_queue);
+    while (p_node) {
+        if (p_node != &p_queue->stub) {
+            ABTI_thread *p_thread = thread_mpsc_queue_get_thread(p_node);
+            print_fn(arg, ABTI_thread_get_handle(p_thread));
+        }
+        p_node = thread_mpsc_queue_get_next(p_node);
+    }
+    ABTD_spinlock_release(&p_queue->lock);
+}
+
+#endif /* THREAD_MPSC_QUEUE_H_INCLUDED */
@@ -0,0 +1,302 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#ifndef THREAD_RING_H_INCLUDED
+#define THREAD_RING_H_INCLUDED
+
+#include "abti.h"
+#include "thread_queue.h"
+
+/*
+ * Bounded ring buffer of work units based on Vyukov's MPMC queue.  Each cell
+ * has a sequence number that tells whether the cell is ready to be written
+ * (seq == pos) or to be read (seq == pos + 1) at position pos.  Producers and
+ * consumers do not share any lock; a multi-producer (multi-consumer) variant
+ * claims a position with CAS on tail (head), while a single-producer
+ * (single-consumer) variant uses a plain store.
+ *
+ * A consumer claims a work unit in a cell by exchanging the pointer with NULL
+ * so that the deprecated remove() can detach a work unit in the middle of the
+ * ring by CAS, leaving a tombstone that a consumer skips later.
+ *
+ * The ring is bounded, so a work unit that does not fit in the ring spills to
+ * a spinlock-protected thread_queue_t.  While the overflow queue is not empty,
+ * all the push operations go to the overflow queue to keep FIFO order as much
+ * as possible.  The overflow path is taken only when the ring is full.
+ */
+
+#define THREAD_RING_DEFAULT_CAPACITY 1024
+
+typedef struct {
+    ABTD_atomic_size seq;
+    ABTD_atomic_ptr p_thread;
+} thread_ring_cell_t;
+
+typedef struct {
+    /* Read-mostly fields. */
+    thread_ring_cell_t *cells;
+    size_t mask;
+    /* Producer side. */
+    ABTU_align_member_var(ABT_CONFIG_STATIC_CACHELINE_SIZE)
+        ABTD_atomic_size tail;
+    /* Consumer side. */
+    ABTU_align_member_var(ABT_CONFIG_STATIC_CACHELINE_SIZE)
+        ABTD_atomic_size head;
+    /* Rarely touched fields. */
+    ABTU_align_member_var(ABT_CONFIG_STATIC_CACHELINE_SIZE)
+        ABTD_atomic_size num_tombstones;
+    ABTD_atomic_int overflow_active;
+    ABTD_spinlock overflow_lock;
+    thread_queue_t overflow;
+} thread_ring_t;
+
+ABTU_ret_err static inline int thread_ring_init(thread_ring_t *p_ring,
+                                                size_t capacity)
+{
+    /* capacity must be a power of two. */
+    ABTI_ASSERT(capacity >= 2 && (capacity & (capacity - 1)) == 0);
+    thread_ring_cell_t *cells;
+    int abt_errno =
+        ABTU_memalign(ABT_CONFIG_STATIC_CACHELINE_SIZE,
+                      sizeof(thread_ring_cell_t) * capacity, (void **)&cells);
+    ABTI_CHECK_ERROR(abt_errno);
+    size_t i;
+    for (i = 0; i < capacity; i++) {
+        ABTD_atomic_relaxed_store_size(&cells[i].seq, i);
+        ABTD_atomic_relaxed_store_ptr(&cells[i].p_thread, NULL);
+    }
+    p_ring->cells = cells;
+    p_ring->mask = capacity - 1;
+    ABTD_atomic_relaxed_store_size(&p_ring->tail, 0);
+    ABTD_atomic_relaxed_store_size(&p_ring->head, 0);
+    ABTD_atomic_relaxed_store_size(&p_ring->num_tombstones, 0);
+    ABTD_atomic_relaxed_store_int(&p_ring->overflow_active, 0);
+    ABTD_spinlock_clear(&p_ring->overflow_lock);
+    thread_queue_init(&p_ring->overflow);
+    return ABT_SUCCESS;
+}
+
+static inline void thread_ring_free(thread_ring_t *p_ring)
+{
+    thread_queue_free(&p_ring->overflow);
+    ABTU_free(p_ring->cells);
+}
+
+static inline void thread_ring_push_overflow(thread_ring_t *p_ring,
+                                             ABTI_thread *p_thread)
+{
+    ABTD_spinlock_acquire(&p_ring->overflow_lock);
+    thread_queue_push_tail(&p_ring->overflow, p_thread);
+    ABTD_atomic_relaxed_store_int(&p_ring->overflow_active, 1);
+    ABTD_spinlock_release(&p_ring->overflow_lock);
+}
+
+static inline ABTI_thread *thread_ring_pop_overflow(thread_ring_t *p_ring)
+{
+    if (!ABTD_atomic_acquire_load_int(&p_ring->overflow_active))
+        return NULL;
+    ABTI_thread *p_thread = NULL;
+    if (thread_queue_acquire_spinlock_if_not_empty(&p_ring->overflow,
+                                                   &p_ring->overflow_lock) ==
+        0) {
+        p_thread = thread_queue_pop_head(&p_ring->overflow);
+        if (thread_queue_is_empty(&p_ring->overflow))
+            ABTD_atomic_relaxed_store_int(&p_ring->overflow_active, 0);
+        ABTD_spinlock_release(&p_ring->overflow_lock);
+    }
+    return p_thread;
+}
+
+static inline void thread_ring_publish(thread_ring_cell_t *p_cell, size_t pos,
+                                       ABTI_thread *p_thread)
+{
+    /* is_in_pool must be set before a consumer can take p_thread. */
+    ABTD_atomic_release_store_int(&p_thread->is_in_pool, 1);
+    ABTD_atomic_relaxed_store_ptr(&p_cell->p_thread, (void *)p_thread);
+    ABTD_atomic_release_store_size(&p_cell->seq, pos + 1);
+}
+
+/* Multi-producer push. */
+static inline void thread_ring_push_mp(thread_ring_t *p_ring,
+                                       ABTI_thread *p_thread)
+{
+    if (!ABTD_atomic_relaxed_load_int(&p_ring->overflow_active)) {
+        size_t pos = ABTD_atomic_relaxed_load_size(&p_ring->tail);
+        while (1) {
+            thread_ring_cell_t *p_cell = &p_ring->cells[pos & p_ring->mask];
+            size_t seq = ABTD_atomic_acquire_load_size(&p_cell->seq);
+            intptr_t dif = (intptr_t)seq - (intptr_t)pos;
+            if (dif == 0) {
+                if (ABTD_atomic_bool_cas_weak_size(&p_ring->tail, pos,
+                                                   pos + 1)) {
+                    thread_ring_publish(p_cell, pos, p_thread);
+                    return;
+                }
+            } else if (dif < 0) {
+                /* The ring is full. */
+                break;
+            }
+            pos = ABTD_atomic_relaxed_load_size(&p_ring->tail);
+        }
+    }
+    thread_ring_push_overflow(p_ring, p_thread);
+}
+
+/* Single-producer push.  No read-modify-write operation is needed. */
+static inline void thread_ring_push_sp(thread_ring_t *p_ring,
+                                       ABTI_thread *p_thread)
+{
+    if (!ABTD_atomic_relaxed_load_int(&p_ring->overflow_active)) {
+        size_t pos = ABTD_atomic_relaxed_load_size(&p_ring->tail);
+        thread_ring_cell_t *p_cell = &p_ring->cells[pos & p_ring->mask];
+        if (ABTD_atomic_acquire_load_size(&p_cell->seq) == pos) {
+            ABTD_atomic_relaxed_store_size(&p_ring->tail, pos + 1);
+            thread_ring_publish(p_cell, pos, p_thread);
+            return;
+        }
+    }
+    thread_ring_push_overflow(p_ring, p_thread);
+}
+
+/* Take a work unit from a claimed cell and release the cell to producers.
+ * NULL is returned if the work unit has been removed. */
+static inline ABTI_thread *thread_ring_consume(thread_ring_t *p_ring,
+                                               thread_ring_cell_t *p_cell,
+                                               size_t pos)
+{
+    ABTI_thread *p_thread =
+        (ABTI_thread *)ABTD_atomic_exchange_ptr(&p_cell->p_thread, NULL);
+    ABTD_atomic_release_store_size(&p_cell->seq, pos + p_ring->mask + 1);
+    if (p_thread) {
+        ABTD_atomic_release_store_int(&p_thread->is_in_pool, 0);
+    } else {
+        ABTD_atomic_fetch_sub_size(&p_ring->num_tombstones, 1);
+    }
+    return p_thread;
+}
+
+/* Multi-consumer pop. */
+static inline ABTI_thread *thread_ring_pop_mc(thread_ring_t *p_ring)
+{
+    size_t pos = ABTD_atomic_relaxed_load_size(&p_ring->head);
+    while (1) {
+        thread_ring_cell_t *p_cell = &p_ring->cells[pos & p_ring->mask];
+        size_t seq = ABTD_atomic_acquire_load_size(&p_cell->seq);
+        intptr_t dif = (intptr_t)seq - (intptr_t)(pos + 1);
+        if (dif == 0) {
+            if (ABTD_atomic_bool_cas_weak_size(&p_ring->head, pos, pos + 1)) {
+                ABTI_thread *p_thread =
+                    thread_ring_consume(p_ring, p_cell, pos);
+                if (p_thread)
+                    return p_thread;
+            }
+        } else if (dif < 0) {
+            /* The ring is empty. */
+            return thread_ring_pop_overflow(p_ring);
+        }
+        pos = ABTD_atomic_relaxed_load_size(&p_ring->head);
+    }
+}
+
+/* Single-consumer pop.  No read-modify-write operation is needed on the ring
+ * indices. */
+static inline ABTI_thread *thread_ring_pop_sc(thread_ring_t *p_ring)
+{
+    while (1) {
+        size_t pos = ABTD_atomic_relaxed_load_size(&p_ring->head);
+        thread_ring_cell_t *p_cell = &p_ring->cells[pos & p_ring->mask];
+        if (ABTD_atomic_acquire_load_size(&p_cell->seq) != pos + 1) {
+            /* The ring is empty. */
+            return thread_ring_pop_overflow(p_ring);
+        }
+        ABTD_atomic_relaxed_store_size(&p_ring->head, pos + 1);
+        ABTI_thread *p_thread = thread_ring_consume(p_ring, p_cell, pos);
+        if (p_thread)
+            return p_thread;
+    }
+}
+
+static inline size_t thread_ring_get_size(thread_ring_t *p_ring)
+{
+    size_t head = ABTD_atomic_acquire_load_size(&p_ring->head);
+    size_t tail = ABTD_atomic_acquire_load_size(&p_ring->tail);
+    size_t num_tombstones =
+        ABTD_atomic_relaxed_load_size(&p_ring->num_tombstones);
+    /* The values can be inconsistent under concurrent updates. */
+    intptr_t num_threads = (intptr_t)(tail - head) - (intptr_t)num_tombstones;
+    return (num_threads > 0 ? (size_t)num_threads : 0) +
+           thread_queue_get_size(&p_ring->overflow);
+}
+
+static inline ABT_bool thread_ring_is_empty(thread_ring_t *p_ring)
+{
+    size_t head = ABTD_atomic_acquire_load_size(&p_ring->head);
+    size_t tail = ABTD_atomic_acquire_load_size(&p_ring->tail);
+    if ((intptr_t)(tail - head) > 0)
+        return ABT_FALSE;
+    return ABTD_atomic_acquire_load_int(&p_ring->overflow_active) ? ABT_FALSE
+                                                                  : ABT_TRUE;
+}
+
+ABTU_ret_err static inline int thread_ring_remove(thread_ring_t *p_ring,
+                                                  ABTI_thread *p_thread)
+{
+    ABTI_CHECK_TRUE(ABTD_atomic_acquire_load_int(&p_thread->is_in_pool) == 1,
+                    ABT_ERR_POOL);
+    size_t pos = ABTD_atomic_acquire_load_size(&p_ring->head);
+    size_t tail = ABTD_atomic_acquire_load_size(&p_ring->tail);
+    for (; (intptr_t)(tail - pos) > 0; pos++) {
+        thread_ring_cell_t *p_cell = &p_ring->cells[pos & p_ring->mask];
+        if (ABTD_atomic_acquire_load_size(&p_cell->seq) == pos + 1 &&
+            ABTD_atomic_relaxed_load_ptr(&p_cell->p_thread) ==
+                (void *)p_thread) {
+            /* Count a tombstone first so that a consumer that finds it never
+             * makes num_tombstones negative. */
+            ABTD_atomic_fetch_add_size(&p_ring->num_tombstones, 1);
+            if (ABTD_atomic_bool_cas_strong_ptr(&p_cell->p_thread, p_thread,
+                                                NULL)) {
+                ABTD_atomic_release_store_int(&p_thread->is_in_pool, 0);
+                return ABT_SUCCESS;
+            }
+            ABTD_atomic_fetch_sub_size(&p_ring->num_tombstones, 1);
+        }
+    }
+    /* Look for p_thread in the overflow queue. */
+    ABTD_spinlock_acquire(&p_ring->overflow_lock);
+    int abt_errno = ABT_ERR_POOL;
+    ABTI_thread *p_cur = p_ring->overflow.p_head;
+    size_t i, num_threads = thread_queue_get_size(&p_ring->overflow);
+    for (i = 0; i < num_threads; i++, p_cur = p_cur->p_next) {
+        if (p_cur == p_thread) {
+            abt_errno = thread_queue_remove(&p_ring->overflow, p_thread);
+            if (thread_queue_is_empty(&p_ring->overflow))
+                ABTD_atomic_relaxed_store_int(&p_ring->overflow_active, 0);
+            break;
+        }
+    }
+    ABTD_spinlock_release(&p_ring->overflow_lock);
+    return abt_errno;
+}
+
+/* Print work units in the ring.  The result is not accurate if the ring is
+ * concurrently updated. */
+static inline void thread_ring_print_all(thread_ring_t *p_ring, void *arg,
+                                         void (*print_fn)(void *, ABT_thread))
+{
+    size_t pos = ABTD_atomic_acquire_load_size(&p_ring->head);
+    size_t tail = ABTD_atomic_acquire_load_size(&p_ring->tail);
+    for (; (intptr_t)(tail - pos) > 0; pos++) {
+        thread_ring_cell_t *p_cell = &p_ring->cells[pos & p_ring->mask];
+        ABTI_thread *p_thread =
+            (ABTI_thread *)ABTD_atomic_acquire_load_ptr(&p_cell->p_thread);
+        if (ABTD_atomic_acquire_load_size(&p_cell->seq) == pos + 1 && p_thread)
+            print_fn(arg, ABTI_thread_get_handle(p_thread));
+    }
+    ABTD_spinlock_acquire(&p_ring->overflow_lock);
+    thread_queue_print_all(&p_ring->overflow, arg, print_fn);
+    ABTD_spinlock_release(&p_ring->overflow_lock);
+}
+
+#endif /* THREAD_RING_H_INCLUDED */
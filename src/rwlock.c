@@ -5,6 +5,11 @@
 
 #include "abti.h"
 
+ABTU_ret_err static int rwlock_create(ABT_bool prefer_writer,
+                                      ABTI_rwlock **pp_newrwlock);
+static inline ABT_bool rwlock_is_reader_blocked(ABTI_rwlock *p_rwlock);
+static inline void rwlock_try_set_reader_bias(ABTI_rwlock *p_rwlock);
+
 /** @defgroup RWLOCK Readers-Writer Lock
  * A Readers writer lock allows concurrent access for readers and exclusionary
  * access for writers.
@@ -15,7 +20,8 @@
  * @brief   Create a new readers-writer lock.
  *
  * \c ABT_rwlock_create() creates a new readers-writer lock and returns its
- * handle through \c newrwlock.
+ * handle through \c newrwlock.  This routine is the same as
+ * \c ABT_rwlock_create_with_preference() with \c ABT_RWLOCK_PREFER_READER.
  *
  * \c newrwlock must be freed by \c ABT_rwlock_free() after its use.
  *
@@ -47,14 +53,71 @@ int ABT_rwlock_create(ABT_rwlock *newrwlock)
     *newrwlock = ABT_RWLOCK_NULL;
 #endif
     ABTI_rwlock *p_newrwlock;
-
-    int abt_errno = ABTU_malloc(sizeof(ABTI_rwlock), (void **)&p_newrwlock);
+    int abt_errno = rwlock_create(ABT_FALSE, &p_newrwlock);
     ABTI_CHECK_ERROR(abt_errno);
 
-    ABTI_mutex_init(&p_newrwlock->mutex);
-    ABTI_cond_init(&p_newrwlock->cond);
-    p_newrwlock->reader_count = 0;
-    p_newrwlock->write_flag = 0;
+    /* Return value */
+    *newrwlock = ABTI_rwlock_get_handle(p_newrwlock);
+    return ABT_SUCCESS;
+}
+
+/**
+ * @ingroup RWLOCK
+ * @brief   Create a new readers-writer lock with a preference.
+ *
+ * \c ABT_rwlock_create_with_preference() creates a new readers-writer lock
+ * that prefers \c preference and returns its handle through \c newrwlock.
+ *
+ * If \c preference is \c ABT_RWLOCK_PREFER_READER, a reader can lock the
+ * readers-writer lock while a writer is waiting for it, so a writer might wait
+ * as long as readers hold it.  If \c preference is
+ * \c ABT_RWLOCK_PREFER_WRITER, a reader waits while a writer is waiting for
+ * the readers-writer lock.
+ *
+ * Both readers-writer locks are biased to readers: while no writer locks a
+ * readers-writer lock for a while, readers on execution streams lock it by
+ * updating per-execution-stream counters, which do not contend with each
+ * other.  A writer has to wait until all of such readers release the
+ * readers-writer lock, so writes are slower than those of a readers-writer
+ * lock that is not biased.
+ *
+ * \c newrwlock must be freed by \c ABT_rwlock_free() after its use.
+ *
+ * @note
+ * A reader that locks a writer-preferring readers-writer lock again while
+ * holding it might deadlock if a writer is waiting for it.
+ *
+ * @contexts
+ * \DOC_CONTEXT_INIT \DOC_CONTEXT_NOCTXSWITCH
+ *
+ * @errors
+ * \DOC_ERROR_SUCCESS
+ * \DOC_ERROR_INV_ARG_INV_RWLOCK_PREFERENCE{\c preference}
+ * \DOC_ERROR_RESOURCE
+ *
+ * @undefined
+ * \DOC_UNDEFINED_UNINIT
+ * \DOC_UNDEFINED_NULL_PTR{\c newrwlock}
+ *
+ * @param[in]  preference  preference of a readers-writer lock
+ * @param[out] newrwlock   readers-writer lock handle
+ * @return Error code
+ */
+int ABT_rwlock_create_with_preference(ABT_rwlock_preference preference,
+                                      ABT_rwlock *newrwlock)
+{
+    ABTI_UB_ASSERT(ABTI_initialized());
+    ABTI_UB_ASSERT(newrwlock);
+
+    ABTI_CHECK_TRUE(preference == ABT_RWLOCK_PREFER_READER ||
+                        preference == ABT_RWLOCK_PREFER_WRITER,
+                    ABT_ERR_INV_ARG);
+    ABTI_rwlock *p_newrwlock;
+    int abt_errno =
+        rwlock_create(preference == ABT_RWLOCK_PREFER_WRITER ? ABT_TRUE
+                                                              : ABT_FALSE,
+                      &p_newrwlock);
+    ABTI_CHECK_ERROR(abt_errno);
 
     /* Return value */
     *newrwlock = ABTI_rwlock_get_handle(p_newrwlock);
@@ -97,6 +160,7 @@ int ABT_rwlock_free(ABT_rwlock *rwlock)
     ABTI_CHECK_NULL_RWLOCK_PTR(p_rwlock);
 
     ABTI_cond_fini(&p_rwlock->cond);
+    ABTU_free(p_rwlock->reader_slots);
     ABTU_free(p_rwlock);
 
     /* Return value */
@@ -159,13 +223,17 @@ int ABT_rwlock_rdlock(ABT_rwlock rwlock)
     }
 #endif
 
+    if (!ABTI_rwlock_try_rdlock_reader_slot(&p_local, p_rwlock))
+        return ABT_SUCCESS;
+
     ABTI_mutex_lock(&p_local, &p_rwlock->mutex);
     int abt_errno = ABT_SUCCESS;
-    while (p_rwlock->write_flag && abt_errno == ABT_SUCCESS) {
+    while (rwlock_is_reader_blocked(p_rwlock) && abt_errno == ABT_SUCCESS) {
         abt_errno = ABTI_cond_wait(&p_local, &p_rwlock->cond, &p_rwlock->mutex);
     }
     if (abt_errno == ABT_SUCCESS) {
         p_rwlock->reader_count++;
+        rwlock_try_set_reader_bias(p_rwlock);
     }
     ABTI_mutex_unlock(p_local, &p_rwlock->mutex);
     ABTI_CHECK_ERROR(abt_errno);
@@ -224,12 +292,43 @@ int ABT_rwlock_wrlock(ABT_rwlock rwlock)
 
     ABTI_mutex_lock(&p_local, &p_rwlock->mutex);
     int abt_errno = ABT_SUCCESS;
-    while ((p_rwlock->write_flag || p_rwlock->reader_count) &&
+    p_rwlock->num_waiting_writers++;
+    while (ABTD_atomic_relaxed_load_int(&p_rwlock->write_flag) !=
+               ABTI_RWLOCK_WRITE_FLAG_NONE &&
            abt_errno == ABT_SUCCESS) {
         abt_errno = ABTI_cond_wait(&p_local, &p_rwlock->cond, &p_rwlock->mutex);
     }
+    p_rwlock->num_waiting_writers--;
     if (abt_errno == ABT_SUCCESS) {
-        p_rwlock->write_flag = 1;
+        /* Block the other writers and wait for readers. */
+        ABTD_atomic_relaxed_store_int(&p_rwlock->write_flag,
+                                      ABTI_RWLOCK_WRITE_FLAG_PENDING);
+        double revoke_start_time = 0.0;
+        ABT_bool is_revoked = ABT_FALSE;
+        if (ABTD_atomic_relaxed_load_int(&p_rwlock->reader_bias)) {
+            revoke_start_time = ABTI_get_wtime();
+            is_revoked = ABT_TRUE;
+            ABTI_rwlock_revoke_reader_bias(p_rwlock);
+        }
+        while (ABTI_rwlock_collect_readers(p_rwlock) != 0 &&
+               abt_errno == ABT_SUCCESS) {
+            abt_errno =
+                ABTI_cond_wait(&p_local, &p_rwlock->cond, &p_rwlock->mutex);
+        }
+        if (is_revoked) {
+            double cur_time = ABTI_get_wtime();
+            p_rwlock->reader_bias_inhibit_until =
+                cur_time + ABTI_RWLOCK_READER_BIAS_INHIBIT_FACTOR *
+                               (cur_time - revoke_start_time);
+        }
+        if (abt_errno == ABT_SUCCESS) {
+            ABTD_atomic_relaxed_store_int(&p_rwlock->write_flag,
+                                          ABTI_RWLOCK_WRITE_FLAG_LOCKED);
+        } else {
+            ABTD_atomic_relaxed_store_int(&p_rwlock->write_flag,
+                                          ABTI_RWLOCK_WRITE_FLAG_NONE);
+            ABTI_cond_broadcast(p_local, &p_rwlock->cond);
+        }
     }
     ABTI_mutex_unlock(p_local, &p_rwlock->mutex);
     ABTI_CHECK_ERROR(abt_errno);
@@ -268,14 +367,101 @@ int ABT_rwlock_unlock(ABT_rwlock rwlock)
     ABTI_rwlock *p_rwlock = ABTI_rwlock_get_ptr(rwlock);
     ABTI_CHECK_NULL_RWLOCK_PTR(p_rwlock);
 
+    /* write_flag is LOCKED only while a writer holds rwlock, so the caller is
+     * a reader if write_flag is not LOCKED. */
+    if (ABTD_atomic_relaxed_load_int(&p_rwlock->write_flag) !=
+        ABTI_RWLOCK_WRITE_FLAG_LOCKED) {
+        ABTI_xstream *p_local_xstream = ABTI_local_get_xstream_or_null(p_local);
+        if ((!ABTI_IS_EXT_THREAD_ENABLED || p_local_xstream) &&
+            ABTD_atomic_acquire_load_int(&p_rwlock->reader_bias)) {
+            /* Any reader can release a lock on a reader slot since only the
+             * total count of readers matters. */
+            ABTI_rwlock_release_reader_slot(&p_local, p_rwlock,
+                                            ABTI_rwlock_get_reader_slot(
+                                                p_rwlock, p_local_xstream));
+            return ABT_SUCCESS;
+        }
+    }
     ABTI_mutex_lock(&p_local, &p_rwlock->mutex);
-    if (p_rwlock->write_flag) {
-        p_rwlock->write_flag = 0;
+    if (ABTD_atomic_relaxed_load_int(&p_rwlock->write_flag) ==
+        ABTI_RWLOCK_WRITE_FLAG_LOCKED) {
+        ABTD_atomic_relaxed_store_int(&p_rwlock->write_flag,
+                                      ABTI_RWLOCK_WRITE_FLAG_NONE);
     } else {
-        ABTI_UB_ASSERT(p_rwlock->reader_count > 0);
         p_rwlock->reader_count--;
     }
     ABTI_cond_broadcast(p_local, &p_rwlock->cond);
     ABTI_mutex_unlock(p_local, &p_rwlock->mutex);
     return ABT_SUCCESS;
 }
+
+/*****************************************************************************/
+/* Internal static functions                                                 */
+/*****************************************************************************/
+
+ABTU_ret_err static int rwlock_create(ABT_bool prefer_writer,
+                                      ABTI_rwlock **pp_newrwlock)
+{
+    ABTI_global *p_global = ABTI_global_get_global();
+    ABTI_rwlock *p_newrwlock;
+    int abt_errno = ABTU_malloc(sizeof(ABTI_rwlock), (void **)&p_newrwlock);
+    ABTI_CHECK_ERROR(abt_errno);
+
+    /* Use at least one reader slot per core. */
+    int num_reader_slots = 1;
+    while (num_reader_slots < p_global->num_cores)
+        num_reader_slots *= 2;
+    abt_errno =
+        ABTU_memalign(ABT_CONFIG_STATIC_CACHELINE_SIZE,
+                      sizeof(ABTI_rwlock_reader_slot) * num_reader_slots,
+                      (void **)&p_newrwlock->reader_slots);
+    if (ABTI_IS_ERROR_CHECK_ENABLED && abt_errno != ABT_SUCCESS) {
+        ABTU_free(p_newrwlock);
+        ABTI_HANDLE_ERROR(abt_errno);
+    }
+    int i;
+    for (i = 0; i < num_reader_slots; i++) {
+        ABTD_atomic_relaxed_store_int(&p_newrwlock->reader_slots[i].num_readers,
+                                      0);
+    }
+    p_newrwlock->num_reader_slots = num_reader_slots;
+    ABTD_atomic_relaxed_store_int(&p_newrwlock->reader_bias, 1);
+    ABTI_mutex_init(&p_newrwlock->mutex);
+    ABTI_cond_init(&p_newrwlock->cond);
+    p_newrwlock->reader_count = 0;
+    ABTD_atomic_relaxed_store_int(&p_newrwlock->write_flag,
+                                  ABTI_RWLOCK_WRITE_FLAG_NONE);
+    p_newrwlock->num_waiting_writers = 0;
+    p_newrwlock->prefer_writer = prefer_writer;
+    p_newrwlock->reader_bias_inhibit_until = 0.0;
+    *pp_newrwlock = p_newrwlock;
+    return ABT_SUCCESS;
+}
+
+/* mutex must be locked. */
+static inline ABT_bool rwlock_is_reader_blocked(ABTI_rwlock *p_rwlock)
+{
+    int write_flag = ABTD_atomic_relaxed_load_int(&p_rwlock->write_flag);
+    if (write_flag == ABTI_RWLOCK_WRITE_FLAG_LOCKED) {
+        return ABT_TRUE;
+    } else if (p_rwlock->prefer_writer) {
+        return (write_flag != ABTI_RWLOCK_WRITE_FLAG_NONE ||
+                p_rwlock->num_waiting_writers)
+                   ? ABT_TRUE
+                   : ABT_FALSE;
+    } else {
+        return ABT_FALSE;
+    }
+}
+
+/* mutex must be locked. */
+static inline void rwlock_try_set_reader_bias(ABTI_rwlock *p_rwlock)
+{
+    if (!ABTD_atomic_relaxed_load_int(&p_rwlock->reader_bias) &&
+        ABTD_atomic_relaxed_load_int(&p_rwlock->write_flag) ==
+            ABTI_RWLOCK_WRITE_FLAG_NONE &&
+        p_rwlock->num_waiting_writers == 0 &&
+        ABTI_get_wtime() >= p_rwlock->reader_bias_inhibit_until) {
+        ABTD_atomic_release_store_int(&p_rwlock->reader_bias, 1);
+    }
+}
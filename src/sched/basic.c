@@ -4,12 +4,24 @@
  */
 
 #include "abti.h"
+#include <sched.h>
 
 static int sched_init(ABT_sched sched, ABT_sched_config config);
 static void sched_run(ABT_sched sched);
 static int sched_free(ABT_sched);
 static void sched_sort_pools(int num_pools, ABT_pool *pools);
 
+/* Idle policy.  If ABT_sched_basic_idle_spin is set, a scheduler that finds no
+ * work unit spins for idle_spin_count rounds, calls sched_yield() for
+ * idle_yield_count rounds, and then parks the underlying Pthread until a work
+ * unit is pushed to one of its pools.  A push never fails to wake the
+ * scheduler up, but events that do not notify it (e.g., a request for stack
+ * dump) are checked only when a park times out.  The park time starts from
+ * SCHED_IDLE_MIN_PARK_TIME and is doubled up to idle_max_park_time. */
+#define SCHED_IDLE_DEFAULT_YIELD_COUNT 16
+#define SCHED_IDLE_DEFAULT_MAX_PARK_TIME 1.0e-3
+#define SCHED_IDLE_MIN_PARK_TIME 1.0e-5
+
 static ABT_sched_def sched_basic_def = {
     .type = ABT_SCHED_TYPE_ULT,
     .init = sched_init,
@@ -22,6 +34,11 @@ typedef struct {
     uint32_t event_freq;
     int num_pools;
     ABT_pool *pools;
+    /* Idle policy.  p_waiter is NULL if it is disabled. */
+    ABTI_pool_waiter *p_waiter;
+    uint32_t idle_spin_count;
+    uint32_t idle_yield_count;
+    double idle_max_park_time;
 #ifdef ABT_CONFIG_USE_SCHED_SLEEP
     struct timespec sleep_time;
 #endif
@@ -59,6 +76,9 @@ static int sched_init(ABT_sched sched, ABT_sched_config config)
 
     /* Set the default value by default. */
     p_data->event_freq = p_global->sched_event_freq;
+    int idle_spin_count = -1;
+    int idle_yield_count = SCHED_IDLE_DEFAULT_YIELD_COUNT;
+    double idle_max_park_time = SCHED_IDLE_DEFAULT_MAX_PARK_TIME;
     if (p_config) {
         int event_freq;
         /* Set the variables from config */
@@ -67,7 +87,34 @@ static int sched_init(ABT_sched sched, ABT_sched_config config)
         if (abt_errno == ABT_SUCCESS) {
             p_data->event_freq = event_freq;
         }
+        abt_errno =
+            ABTI_sched_config_read(p_config, ABT_sched_basic_idle_spin.idx,
+                                   &idle_spin_count);
+        if (abt_errno != ABT_SUCCESS) {
+            idle_spin_count = -1;
+        }
+        abt_errno =
+            ABTI_sched_config_read(p_config, ABT_sched_basic_idle_yield.idx,
+                                   &idle_yield_count);
+        if (abt_errno != ABT_SUCCESS) {
+            idle_yield_count = SCHED_IDLE_DEFAULT_YIELD_COUNT;
+        }
+        abt_errno =
+            ABTI_sched_config_read(p_config, ABT_sched_basic_idle_max_park.idx,
+                                   &idle_max_park_time);
+        if (abt_errno != ABT_SUCCESS) {
+            idle_max_park_time = SCHED_IDLE_DEFAULT_MAX_PARK_TIME;
+        }
+    }
+    if (ABTI_IS_ERROR_CHECK_ENABLED &&
+        (idle_spin_count < -1 || idle_yield_count < 0 ||
+         !(idle_max_park_time > 0.0))) {
+        ABTU_free(p_data);
+        ABTI_HANDLE_ERROR(ABT_ERR_INV_ARG);
     }
+    p_data->idle_spin_count = (uint32_t)idle_spin_count;
+    p_data->idle_yield_count = (uint32_t)idle_yield_count;
+    p_data->idle_max_park_time = idle_max_park_time;
 
     /* Save the list of pools */
     num_pools = p_sched->num_pools;
@@ -80,6 +127,17 @@ static int sched_init(ABT_sched sched, ABT_sched_config config)
     }
     memcpy(p_data->pools, p_sched->pools, sizeof(ABT_pool) * num_pools);
 
+    p_data->p_waiter = NULL;
+    if (idle_spin_count >= 0) {
+        abt_errno = ABTI_pool_waiter_create(num_pools, &p_data->p_waiter);
+        if (ABTI_IS_ERROR_CHECK_ENABLED && abt_errno != ABT_SUCCESS) {
+            ABTU_free(p_data->pools);
+            ABTU_free(p_data);
+            ABTI_CHECK_ERROR(abt_errno);
+        }
+        ABTI_sched_set_waiter(p_sched, p_data->p_waiter);
+    }
+
     /* Sort pools according to their access mode so the scheduler can execute
        work units from the private pools. */
     if (num_pools > 1) {
@@ -102,6 +160,8 @@ static void sched_run(ABT_sched sched)
     int num_pools;
     ABT_pool *pools;
     int i;
+    uint32_t idle_count = 0;
+    double park_time = SCHED_IDLE_MIN_PARK_TIME;
 
     ABTI_sched *p_sched = ABTI_sched_get_ptr(sched);
     ABTI_ASSERT(p_sched);
@@ -122,6 +182,32 @@ static void sched_run(ABT_sched sched)
                 break;
             }
         }
+        if (thread != ABT_THREAD_NULL) {
+            idle_count = 0;
+            park_time = SCHED_IDLE_MIN_PARK_TIME;
+        } else if (p_data->p_waiter) {
+            if (idle_count < p_data->idle_spin_count) {
+                idle_count++;
+            } else {
+                /* Check events before releasing the core. */
+                ABTI_xstream_check_events(p_local_xstream, p_sched);
+                if (ABTI_sched_has_to_stop(p_sched) == ABT_TRUE)
+                    break;
+                pop_count = 0;
+                if (idle_count <
+                    p_data->idle_spin_count + p_data->idle_yield_count) {
+                    idle_count++;
+                    sched_yield();
+                } else {
+                    ABTI_pool_waiter_park(p_data->p_waiter, num_pools, pools,
+                                          park_time);
+                    park_time *= 2.0;
+                    if (park_time > p_data->idle_max_park_time)
+                        park_time = p_data->idle_max_park_time;
+                }
+                continue;
+            }
+        }
         /* if we attempted event_freq pops, check for events */
         if (pop_count >= event_freq) {
             ABTI_xstream_check_events(p_local_xstream, p_sched);
@@ -139,6 +225,10 @@ static int sched_free(ABT_sched sched)
     ABTI_ASSERT(p_sched);
 
     sched_data *p_data = sched_data_get_ptr(p_sched->data);
+    if (p_data->p_waiter) {
+        ABTI_sched_set_waiter(p_sched, NULL);
+        ABTI_pool_waiter_free(p_data->p_waiter);
+    }
     ABTU_free(p_data->pools);
     ABTU_free(p_data);
     return ABT_SUCCESS;
@@ -22,8 +22,13 @@ typedef struct {
     uint32_t event_freq;
     int num_pools;
     ABT_pool *pools;
+    ABTI_pool_waiter *p_waiter;
 } sched_data;
 
+/* The maximum time for which the scheduler blocks at once.  The scheduler
+ * wakes up periodically to check events that do not notify it. */
+#define SCHED_WAIT_PARK_TIME 0.1
+
 ABT_sched_def *ABTI_sched_get_basic_wait_def(void)
 {
     return &sched_basic_wait_def;
@@ -72,6 +77,14 @@ static int sched_init(ABT_sched sched, ABT_sched_config config)
     }
     memcpy(p_data->pools, p_sched->pools, sizeof(ABT_pool) * num_pools);
 
+    abt_errno = ABTI_pool_waiter_create(num_pools, &p_data->p_waiter);
+    if (ABTI_IS_ERROR_CHECK_ENABLED && abt_errno != ABT_SUCCESS) {
+        ABTU_free(p_data->pools);
+        ABTU_free(p_data);
+        ABTI_CHECK_ERROR(abt_errno);
+    }
+    ABTI_sched_set_waiter(p_sched, p_data->p_waiter);
+
     /* Sort pools according to their access mode so the scheduler can execute
        work units from the private pools. */
     if (num_pools > 1) {
@@ -121,30 +134,15 @@ static void sched_run(ABT_sched sched)
             }
         }
 
-        /* Block briefly on pop_wait() if we didn't find work to do in main loop
-         * above. */
+        /* Block until a work unit is pushed to one of the pools if we didn't
+         * find work to do in main loop above. */
         if (!run_cnt_nowait) {
-            ABTI_pool *p_pool = ABTI_pool_get_ptr(pools[0]);
-            ABT_thread thread;
-            if (p_pool->optional_def.p_pop_wait) {
-                thread = ABTI_pool_pop_wait(p_pool, 0.1,
-                                            ABT_POOL_CONTEXT_OP_POOL_OTHER);
-            } else if (p_pool->deprecated_def.p_pop_timedwait) {
-                thread =
-                    ABTI_pool_pop_timedwait(p_pool, ABTI_get_wtime() + 0.1);
-            } else {
-                /* No "wait" pop, so let's use a normal one. */
-                thread = ABTI_pool_pop(p_pool, ABT_POOL_CONTEXT_OP_POOL_OTHER);
-            }
-            if (thread != ABT_THREAD_NULL) {
-                ABTI_thread *p_thread = ABTI_thread_get_ptr(thread);
-                ABTI_ythread_schedule(p_global, &p_local_xstream, p_thread);
-                break;
-            }
+            ABTI_pool_waiter_park(p_data->p_waiter, num_pools, pools,
+                                  SCHED_WAIT_PARK_TIME);
         }
 
         /* If run_cnt_nowait is zero, that means that no units were found in
-         * first pass through pools and we must have called pop_wait above.  We
+         * first pass through pools and we must have blocked above.  We
          * should check events regardless of work_count in that case for them to
          * be processed in a timely manner. */
         if (!run_cnt_nowait || (++work_count >= event_freq)) {
@@ -162,6 +160,8 @@ static int sched_free(ABT_sched sched)
     ABTI_ASSERT(p_sched);
 
     sched_data *p_data = sched_data_get_ptr(p_sched->data);
+    ABTI_sched_set_waiter(p_sched, NULL);
+    ABTI_pool_waiter_free(p_data->p_waiter);
     ABTU_free(p_data->pools);
     ABTU_free(p_data);
     return ABT_SUCCESS;
@@ -0,0 +1,274 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include "abti.h"
+
+/* Earliest-deadline-first scheduler.  The first pool is a deadline pool, which
+ * should be ABT_POOL_PRIO_QUEUE so that the work unit that has the earliest
+ * deadline is popped first.  The deadline of a work unit is stored as its
+ * priority (see ABT_thread_attr_set_deadline()).  The other pools are checked
+ * in order only when the deadline pool is empty.
+ *
+ * A work unit in the deadline pool that does not have a deadline (i.e., its
+ * priority is not positive) would be popped before all the work units that
+ * have deadlines.  Such a work unit is moved to the background pool, which is
+ * the first pool other than the deadline pool and the late pool (or the late
+ * pool if there is no such pool).  It runs immediately only if the scheduler
+ * has no other pool.
+ *
+ * When a work unit popped from the deadline pool has passed its deadline, the
+ * scheduler counts it as a deadline miss.  If a late pool is specified by
+ * ABT_sched_edf_late_pool, such a work unit is moved to the late pool, which
+ * is checked right after the deadline pool, so that work units that have
+ * already missed their deadlines do not make other ones late. */
+
+static int sched_init(ABT_sched sched, ABT_sched_config config);
+static void sched_run(ABT_sched sched);
+static int sched_free(ABT_sched);
+
+static ABT_sched_def sched_edf_def = {
+    .type = ABT_SCHED_TYPE_ULT,
+    .init = sched_init,
+    .run = sched_run,
+    .free = sched_free,
+    .get_migr_pool = NULL,
+};
+
+typedef struct {
+    uint32_t event_freq;
+    int num_pools;
+    /* pools[0] is the deadline pool.  If the late pool is specified, it is
+     * pools[1]. */
+    ABT_pool *pools;
+    ABTI_pool *p_late_pool;
+    ABTI_pool *p_background_pool;
+    /* Statistics.  Only the owner updates them.  They count pop operations, so
+     * a late work unit that yields in the deadline pool is counted again. */
+    uint64_t num_deadline_units;
+    uint64_t num_deadline_misses;
+    int64_t max_lateness_ns;
+#ifdef ABT_CONFIG_USE_SCHED_SLEEP
+    struct timespec sleep_time;
+#endif
+} sched_data;
+
+ABT_sched_def *ABTI_sched_get_edf_def(void)
+{
+    return &sched_edf_def;
+}
+
+static inline sched_data *sched_data_get_ptr(void *data)
+{
+    return (sched_data *)data;
+}
+
+static int sched_init(ABT_sched sched, ABT_sched_config config)
+{
+    int abt_errno;
+    int num_pools, late_pool = -1;
+    ABTI_global *p_global = ABTI_global_get_global();
+
+    ABTI_sched *p_sched = ABTI_sched_get_ptr(sched);
+    ABTI_CHECK_NULL_SCHED_PTR(p_sched);
+    ABTI_sched_config *p_config = ABTI_sched_config_get_ptr(config);
+    num_pools = p_sched->num_pools;
+    ABTI_CHECK_TRUE(num_pools > 0, ABT_ERR_SCHED);
+
+    /* Default settings */
+    sched_data *p_data;
+    abt_errno = ABTU_malloc(sizeof(sched_data), (void **)&p_data);
+    ABTI_CHECK_ERROR(abt_errno);
+
+#ifdef ABT_CONFIG_USE_SCHED_SLEEP
+    p_data->sleep_time.tv_sec = 0;
+    p_data->sleep_time.tv_nsec = p_global->sched_sleep_nsec;
+#endif
+
+    /* Set the default value by default. */
+    p_data->event_freq = p_global->sched_event_freq;
+    if (p_config) {
+        int event_freq;
+        /* Set the variables from config */
+        abt_errno = ABTI_sched_config_read(p_config, ABT_sched_basic_freq.idx,
+                                           &event_freq);
+        if (abt_errno == ABT_SUCCESS) {
+            p_data->event_freq = event_freq;
+        }
+        abt_errno = ABTI_sched_config_read(p_config,
+                                           ABT_sched_edf_late_pool.idx,
+                                           &late_pool);
+        if (abt_errno != ABT_SUCCESS) {
+            late_pool = -1;
+        }
+    }
+    /* The deadline pool cannot be the late pool. */
+    if (ABTI_IS_ERROR_CHECK_ENABLED && (late_pool == 0 || late_pool < -1 ||
+                                        late_pool >= num_pools)) {
+        ABTU_free(p_data);
+        ABTI_HANDLE_ERROR(ABT_ERR_INV_ARG);
+    }
+
+    /* Save the list of pools.  The late pool is moved next to the deadline
+     * pool. */
+    p_data->num_pools = num_pools;
+    abt_errno =
+        ABTU_malloc(num_pools * sizeof(ABT_pool), (void **)&p_data->pools);
+    if (ABTI_IS_ERROR_CHECK_ENABLED && abt_errno != ABT_SUCCESS) {
+        ABTU_free(p_data);
+        ABTI_CHECK_ERROR(abt_errno);
+    }
+    int i, num_copied = 0;
+    p_data->pools[num_copied++] = p_sched->pools[0];
+    if (late_pool > 0) {
+        p_data->pools[num_copied++] = p_sched->pools[late_pool];
+        p_data->p_late_pool = ABTI_pool_get_ptr(p_sched->pools[late_pool]);
+    } else {
+        p_data->p_late_pool = NULL;
+    }
+    for (i = 1; i < num_pools; i++) {
+        if (i != late_pool)
+            p_data->pools[num_copied++] = p_sched->pools[i];
+    }
+    /* The background pool follows the deadline pool and the late pool. */
+    int background_pool = (late_pool > 0) ? 2 : 1;
+    if (background_pool < num_pools) {
+        p_data->p_background_pool =
+            ABTI_pool_get_ptr(p_data->pools[background_pool]);
+    } else {
+        p_data->p_background_pool = p_data->p_late_pool;
+    }
+
+    p_data->num_deadline_units = 0;
+    p_data->num_deadline_misses = 0;
+    p_data->max_lateness_ns = 0;
+
+    p_sched->data = p_data;
+    return ABT_SUCCESS;
+}
+
+/* Pop a work unit from the deadline pool.  A work unit that has passed its
+ * deadline is moved to the late pool if any, and one that does not have a
+ * deadline is moved to the background pool if any. */
+static inline ABT_thread sched_pop_deadline(ABTI_global *p_global,
+                                           sched_data *p_data,
+                                           ABTI_pool *p_pool)
+{
+    ABTI_pool *p_late_pool = p_data->p_late_pool;
+    int64_t now_ns = 0;
+    while (1) {
+        ABT_thread thread =
+            ABTI_pool_pop(p_pool, ABT_POOL_CONTEXT_OP_POOL_OTHER);
+        if (thread == ABT_THREAD_NULL)
+            return ABT_THREAD_NULL;
+        ABTI_thread *p_thread = ABTI_thread_get_ptr(thread);
+        int64_t deadline_ns = p_thread->priority;
+        if (deadline_ns <= 0) {
+            /* This work unit does not have a deadline.  It may not go ahead of
+             * work units that have deadlines. */
+            ABTI_pool *p_background_pool = p_data->p_background_pool;
+            if (!p_background_pool ||
+                ABTI_thread_set_associated_pool(p_global, p_thread,
+                                                p_background_pool) !=
+                    ABT_SUCCESS) {
+                return thread;
+            }
+            ABTI_pool_push(p_background_pool, p_thread->unit,
+                           ABT_POOL_CONTEXT_OP_POOL_OTHER);
+            continue;
+        }
+        p_data->num_deadline_units++;
+        if (now_ns == 0)
+            now_ns = ABTI_deadline_to_priority(ABTI_get_wtime());
+        if (ABTU_likely(deadline_ns >= now_ns))
+            return thread;
+
+        /* The deadline has passed. */
+        p_data->num_deadline_misses++;
+        if (now_ns - deadline_ns > p_data->max_lateness_ns)
+            p_data->max_lateness_ns = now_ns - deadline_ns;
+        if (!p_late_pool)
+            return thread;
+        int abt_errno =
+            ABTI_thread_set_associated_pool(p_global, p_thread, p_late_pool);
+        if (abt_errno != ABT_SUCCESS) {
+            /* Run it now. */
+            return thread;
+        }
+        ABTI_pool_push(p_late_pool, p_thread->unit,
+                       ABT_POOL_CONTEXT_OP_POOL_OTHER);
+    }
+}
+
+static void sched_run(ABT_sched sched)
+{
+    ABTI_global *p_global = ABTI_global_get_global();
+    ABTI_xstream *p_local_xstream =
+        ABTI_local_get_xstream(ABTI_local_get_local());
+    ABT_thread thread = ABT_THREAD_NULL;
+    uint32_t pop_count = 0;
+    sched_data *p_data;
+    uint32_t event_freq;
+    int num_pools;
+    ABT_pool *pools;
+    int i;
+
+    ABTI_sched *p_sched = ABTI_sched_get_ptr(sched);
+    ABTI_ASSERT(p_sched);
+
+    p_data = sched_data_get_ptr(p_sched->data);
+    event_freq = p_data->event_freq;
+    num_pools = p_data->num_pools;
+    pools = p_data->pools;
+
+    while (1) {
+        ++pop_count;
+        thread = sched_pop_deadline(p_global, p_data,
+                                    ABTI_pool_get_ptr(pools[0]));
+        for (i = 1; thread == ABT_THREAD_NULL && i < num_pools; i++) {
+            ABTI_pool *p_pool = ABTI_pool_get_ptr(pools[i]);
+            ++pop_count;
+            thread = ABTI_pool_pop(p_pool, ABT_POOL_CONTEXT_OP_POOL_OTHER);
+        }
+        if (thread != ABT_THREAD_NULL) {
+            ABTI_thread *p_thread = ABTI_thread_get_ptr(thread);
+            ABTI_ythread_schedule(p_global, &p_local_xstream, p_thread);
+        }
+        /* if we attempted event_freq pops, check for events */
+        if (pop_count >= event_freq) {
+            ABTI_xstream_check_events(p_local_xstream, p_sched);
+            if (ABTI_sched_has_to_stop(p_sched) == ABT_TRUE)
+                break;
+            SCHED_SLEEP(thread != ABT_THREAD_NULL, p_data->sleep_time);
+            pop_count = 0;
+        }
+    }
+}
+
+static int sched_free(ABT_sched sched)
+{
+    ABTI_sched *p_sched = ABTI_sched_get_ptr(sched);
+    ABTI_ASSERT(p_sched);
+
+    sched_data *p_data = sched_data_get_ptr(p_sched->data);
+    ABTU_free(p_data->pools);
+    ABTU_free(p_data);
+    return ABT_SUCCESS;
+}
+
+void ABTI_sched_edf_print_stats(ABTI_sched *p_sched, FILE *p_os, int indent)
+{
+    sched_data *p_data = (sched_data *)p_sched->data;
+    if (!p_data)
+        return;
+    fprintf(p_os,
+            "%*slate_pool      : %p\n"
+            "%*sdeadline_units : %" PRIu64 "\n"
+            "%*sdeadline_misses: %" PRIu64 "\n"
+            "%*smax_lateness   : %.9f [s]\n",
+            indent, "", (void *)p_data->p_late_pool, indent, "",
+            p_data->num_deadline_units, indent, "",
+            p_data->num_deadline_misses, indent, "",
+            p_data->max_lateness_ns * 1.0e-9);
+}
@@ -5,10 +5,16 @@
 
 #include "abti.h"
 
-/* Random Work-stealing Scheduler Implementation */
+/* Random Work-stealing Scheduler Implementation
+ *
+ * ABT_SCHED_HRANDWS is a hierarchical variant.  It groups victim pools by the
+ * distance between CPUs where this scheduler and the owner of each victim pool
+ * run, and tries a closer group first. */
 
 static int sched_init(ABT_sched sched, ABT_sched_config config);
+static int sched_hrandws_init(ABT_sched sched, ABT_sched_config config);
 static void sched_run(ABT_sched sched);
+static void sched_hrandws_run(ABT_sched sched);
 static int sched_free(ABT_sched);
 
 static ABT_sched_def sched_randws_def = {
@@ -19,21 +25,67 @@ static ABT_sched_def sched_randws_def = {
     .get_migr_pool = NULL,
 };
 
+static ABT_sched_def sched_hrandws_def = {
+    .type = ABT_SCHED_TYPE_ULT,
+    .init = sched_hrandws_init,
+    .run = sched_hrandws_run,
+    .free = sched_free,
+    .get_migr_pool = NULL,
+};
+
+/* The maximum number of work units stolen at once. */
+#define SCHED_RANDWS_MAX_STEAL_NUM 64
+
+/* The first pool of a running ABT_SCHED_HRANDWS scheduler and a CPU where the
+ * scheduler runs. */
+typedef struct sched_home {
+    ABT_pool pool;
+    int cpuid; /* -1 if unknown. */
+    struct sched_home *p_prev;
+    struct sched_home *p_next;
+} sched_home;
+
 typedef struct {
     uint32_t event_freq;
     int num_pools;
     ABT_pool *pools;
+    int steal_num; /* 0 means steal-half. */
 #ifdef ABT_CONFIG_USE_SCHED_SLEEP
     struct timespec sleep_time;
 #endif
+    /* Statistics.  Only the execution stream running this scheduler updates
+     * them. */
+    uint64_t num_steal_attempts;
+    uint64_t num_steal_successes;
+    uint64_t num_stolen_threads;
+    /* Used only by ABT_SCHED_HRANDWS.  victims[victim_offsets[d]] to
+     * victims[victim_offsets[d + 1] - 1] are indices of pools whose distance
+     * is d.  victim_dists is a buffer to sort victims. */
+    sched_home home;
+    int home_version;
+    int *victims;
+    int *victim_dists;
+    int victim_offsets[ABTD_AFFINITY_NUM_DISTANCES + 1];
 } sched_data;
 
+/* The list of sched_home.  g_home_version is incremented when it is updated so
+ * that schedulers can update their victims. */
+static ABTD_spinlock g_home_lock = ABTD_SPINLOCK_STATIC_INITIALIZER();
+static sched_home *gp_home_head = NULL;
+static ABTD_atomic_int g_home_version = ABTD_ATOMIC_INT_STATIC_INITIALIZER(0);
+
 ABT_sched_def *ABTI_sched_get_randws_def(void)
 {
     return &sched_randws_def;
 }
 
-static int sched_init(ABT_sched sched, ABT_sched_config config)
+ABT_sched_def *ABTI_sched_get_hrandws_def(void)
+{
+    return &sched_hrandws_def;
+}
+
+static int sched_init_common(ABT_sched sched, ABT_sched_config config,
+                             ABT_bool is_hierarchical)
 {
     int abt_errno;
     int num_pools;
@@ -54,15 +106,31 @@ static int sched_init(ABT_sched sched, ABT_sched_config config)
 
     /* Set the default value by default. */
     p_data->event_freq = p_global->sched_event_freq;
+    p_data->steal_num = 1;
     if (p_config) {
-        int event_freq;
+        int event_freq, steal_num;
         /* Set the variables from config */
         abt_errno = ABTI_sched_config_read(p_config, ABT_sched_basic_freq.idx,
                                            &event_freq);
         if (abt_errno == ABT_SUCCESS) {
             p_data->event_freq = event_freq;
         }
+        abt_errno =
+            ABTI_sched_config_read(p_config, ABT_sched_randws_steal_num.idx,
+                                   &steal_num);
+        if (abt_errno == ABT_SUCCESS) {
+            if (ABTI_IS_ERROR_CHECK_ENABLED && steal_num < 0) {
+                ABTU_free(p_data);
+                ABTI_HANDLE_ERROR(ABT_ERR_INV_ARG);
+            }
+            p_data->steal_num = steal_num > SCHED_RANDWS_MAX_STEAL_NUM
+                                    ? SCHED_RANDWS_MAX_STEAL_NUM
+                                    : steal_num;
+        }
     }
+    p_data->num_steal_attempts = 0;
+    p_data->num_steal_successes = 0;
+    p_data->num_stolen_threads = 0;
 
     /* Save the list of pools */
     num_pools = p_sched->num_pools;
@@ -75,10 +143,106 @@ static int sched_init(ABT_sched sched, ABT_sched_config config)
     }
     memcpy(p_data->pools, p_sched->pools, sizeof(ABT_pool) * num_pools);
 
+    p_data->victims = NULL;
+    p_data->victim_dists = NULL;
+    if (is_hierarchical && num_pools > 1) {
+        abt_errno = ABTU_malloc(sizeof(int) * (num_pools - 1) * 2,
+                                (void **)&p_data->victims);
+        if (ABTI_IS_ERROR_CHECK_ENABLED && abt_errno != ABT_SUCCESS) {
+            ABTU_free(p_data->pools);
+            ABTU_free(p_data);
+            ABTI_HANDLE_ERROR(abt_errno);
+        }
+        p_data->victim_dists = p_data->victims + (num_pools - 1);
+    }
+    /* All the victims are remote until the scheduler starts. */
+    int d;
+    for (d = 0; d <= ABTD_AFFINITY_NUM_DISTANCES; d++) {
+        p_data->victim_offsets[d] =
+            (d == ABTD_AFFINITY_NUM_DISTANCES) ? (num_pools - 1) : 0;
+    }
+    p_data->home_version = -1;
+
     p_sched->data = p_data;
     return ABT_SUCCESS;
 }
 
+static int sched_init(ABT_sched sched, ABT_sched_config config)
+{
+    return sched_init_common(sched, config, ABT_FALSE);
+}
+
+static int sched_hrandws_init(ABT_sched sched, ABT_sched_config config)
+{
+    return sched_init_common(sched, config, ABT_TRUE);
+}
+
+/* Steal work units from p_victim.  One of them is returned and the others are
+ * moved to p_pool. */
+static ABT_thread sched_steal(ABTI_global *p_global, sched_data *p_data,
+                              ABTI_pool *p_victim, ABTI_pool *p_pool)
+{
+    size_t i, num = 0, len = (size_t)p_data->steal_num;
+    ABT_thread threads[SCHED_RANDWS_MAX_STEAL_NUM];
+
+    p_data->num_steal_attempts++;
+    if (len != 1) {
+        if (!p_victim->optional_def.p_pop_many ||
+            !p_pool->optional_def.p_push_many || p_victim == p_pool) {
+            /* Batch stealing is not supported. */
+            len = 1;
+        } else if (len == 0) {
+            /* Steal half.  Round up so that the last work unit is stolen. */
+            if (!p_victim->optional_def.p_get_size) {
+                len = 1;
+            } else {
+                len = (ABTI_pool_get_size(p_victim) + 1) / 2;
+                if (len == 0) {
+                    return ABT_THREAD_NULL;
+                } else if (len > SCHED_RANDWS_MAX_STEAL_NUM) {
+                    len = SCHED_RANDWS_MAX_STEAL_NUM;
+                }
+            }
+        }
+    }
+    if (len == 1) {
+        threads[0] = ABTI_pool_pop(p_victim, ABT_POOL_CONTEXT_OWNER_SECONDARY);
+        num = (threads[0] != ABT_THREAD_NULL) ? 1 : 0;
+    } else {
+        ABTI_pool_pop_many(p_victim, threads, len, &num,
+                           ABT_POOL_CONTEXT_OWNER_SECONDARY);
+    }
+    if (num == 0)
+        return ABT_THREAD_NULL;
+    p_data->num_steal_successes++;
+    p_data->num_stolen_threads += num;
+
+    if (num > 1) {
+        /* The first work unit is executed immediately.  Move the others to
+         * p_pool. */
+        ABT_unit units[SCHED_RANDWS_MAX_STEAL_NUM];
+        size_t num_units = 0;
+        for (i = 1; i < num; i++) {
+            ABTI_thread *p_thread = ABTI_thread_get_ptr(threads[i]);
+            int abt_errno =
+                ABTI_thread_set_associated_pool(p_global, p_thread, p_pool);
+            if (abt_errno == ABT_SUCCESS) {
+                units[num_units++] = p_thread->unit;
+            } else {
+                /* Return it to the original pool. */
+                ABTI_pool_push(p_victim, p_thread->unit,
+                               ABT_POOL_CONTEXT_OP_POOL_OTHER);
+            }
+        }
+        if (num_units > 0) {
+            ABTI_pool_push_many(p_pool, units, num_units,
+                                ABT_POOL_CONTEXT_OP_POOL_OTHER |
+                                    ABT_POOL_CONTEXT_OWNER_PRIMARY);
+        }
+    }
+    return threads[0];
+}
+
 static void sched_run(ABT_sched sched)
 {
     ABTI_global *p_global = ABTI_global_get_global();
@@ -115,9 +279,8 @@ static void sched_run(ABT_sched sched)
             /* Steal a work unit from other pools */
             target =
                 (num_pools == 2) ? 1 : (rand_r(&seed) % (num_pools - 1) + 1);
-            pool = pools[target];
-            p_pool = ABTI_pool_get_ptr(pool);
-            thread = ABTI_pool_pop(p_pool, ABT_POOL_CONTEXT_OWNER_SECONDARY);
+            ABTI_pool *p_victim = ABTI_pool_get_ptr(pools[target]);
+            thread = sched_steal(p_global, p_data, p_victim, p_pool);
             if (thread != ABT_THREAD_NULL) {
                 ABTI_thread *p_thread = ABTI_thread_get_ptr(thread);
                 ABTI_ythread_schedule(p_global, &p_local_xstream, p_thread);
@@ -135,13 +298,188 @@ static void sched_run(ABT_sched sched)
     }
 }
 
+static void sched_home_register(sched_home *p_home)
+{
+    ABTD_spinlock_acquire(&g_home_lock);
+    p_home->p_prev = NULL;
+    p_home->p_next = gp_home_head;
+    if (gp_home_head)
+        gp_home_head->p_prev = p_home;
+    gp_home_head = p_home;
+    ABTD_atomic_release_store_int(&g_home_version,
+                                  ABTD_atomic_relaxed_load_int(
+                                      &g_home_version) +
+                                      1);
+    ABTD_spinlock_release(&g_home_lock);
+}
+
+static void sched_home_unregister(sched_home *p_home)
+{
+    ABTD_spinlock_acquire(&g_home_lock);
+    if (p_home->p_prev) {
+        p_home->p_prev->p_next = p_home->p_next;
+    } else {
+        gp_home_head = p_home->p_next;
+    }
+    if (p_home->p_next)
+        p_home->p_next->p_prev = p_home->p_prev;
+    ABTD_atomic_release_store_int(&g_home_version,
+                                  ABTD_atomic_relaxed_load_int(
+                                      &g_home_version) +
+                                      1);
+    ABTD_spinlock_release(&g_home_lock);
+}
+
+/* Sort victims by the distance to this scheduler. */
+static void sched_update_victims(sched_data *p_data)
+{
+    int i, d, num_victims = p_data->num_pools - 1;
+    int cpuid = p_data->home.cpuid;
+    int num_victims_dist[ABTD_AFFINITY_NUM_DISTANCES] = { 0 };
+
+    ABTD_spinlock_acquire(&g_home_lock);
+    p_data->home_version = ABTD_atomic_relaxed_load_int(&g_home_version);
+    for (i = 0; i < num_victims; i++) {
+        /* If a pool is shared by multiple schedulers, take the closest one.
+         * If no scheduler owns the pool, it is regarded as remote. */
+        ABT_pool pool = p_data->pools[i + 1];
+        int dist = ABTD_AFFINITY_DISTANCE_REMOTE;
+        sched_home *p_home;
+        for (p_home = gp_home_head; p_home; p_home = p_home->p_next) {
+            if (p_home->pool == pool && p_home->cpuid != -1 && cpuid != -1) {
+                int new_dist =
+                    (int)ABTD_affinity_get_distance(cpuid, p_home->cpuid);
+                if (new_dist < dist)
+                    dist = new_dist;
+            }
+        }
+        p_data->victim_dists[i] = dist;
+        num_victims_dist[dist]++;
+    }
+    ABTD_spinlock_release(&g_home_lock);
+
+    /* Counting sort. */
+    p_data->victim_offsets[0] = 0;
+    for (d = 0; d < ABTD_AFFINITY_NUM_DISTANCES; d++) {
+        p_data->victim_offsets[d + 1] =
+            p_data->victim_offsets[d] + num_victims_dist[d];
+        num_victims_dist[d] = p_data->victim_offsets[d];
+    }
+    for (i = 0; i < num_victims; i++) {
+        p_data->victims[num_victims_dist[p_data->victim_dists[i]]++] = i + 1;
+    }
+}
+
+static void sched_hrandws_run(ABT_sched sched)
+{
+    ABTI_global *p_global = ABTI_global_get_global();
+    ABTI_xstream *p_local_xstream =
+        ABTI_local_get_xstream(ABTI_local_get_local());
+    uint32_t work_count = 0;
+    sched_data *p_data;
+    int num_pools;
+    ABT_pool *pools;
+    unsigned seed = time(NULL);
+    CNT_DECL(run_cnt);
+
+    ABTI_sched *p_sched = ABTI_sched_get_ptr(sched);
+    ABTI_ASSERT(p_sched);
+
+    p_data = (sched_data *)p_sched->data;
+    num_pools = p_sched->num_pools;
+    pools = p_data->pools;
+
+    /* Register the first pool so that other schedulers can know where it is.
+     * The first CPU in the affinity of this execution stream is used. */
+    int cpuid, num_cpuids;
+    int abt_errno = ABTD_affinity_cpuset_read(&p_local_xstream->ctx, 1,
+                                              &cpuid, &num_cpuids);
+    p_data->home.pool = pools[0];
+    p_data->home.cpuid =
+        (abt_errno == ABT_SUCCESS && num_cpuids > 0) ? cpuid : -1;
+    sched_home_register(&p_data->home);
+    if (num_pools > 1)
+        sched_update_victims(p_data);
+
+    while (1) {
+        CNT_INIT(run_cnt, 0);
+
+        /* Execute one work unit from the scheduler's pool */
+        ABTI_pool *p_pool = ABTI_pool_get_ptr(pools[0]);
+        ABT_thread thread =
+            ABTI_pool_pop(p_pool, ABT_POOL_CONTEXT_OWNER_PRIMARY);
+        if (thread == ABT_THREAD_NULL && num_pools > 1) {
+            /* Steal a work unit from other pools.  Try one victim in each
+             * group, starting from the closest group. */
+            int d;
+            for (d = 0; d < ABTD_AFFINITY_NUM_DISTANCES; d++) {
+                int offset = p_data->victim_offsets[d];
+                int num_victims = p_data->victim_offsets[d + 1] - offset;
+                if (num_victims == 0)
+                    continue;
+                int target =
+                    p_data->victims[offset + (num_victims == 1
+                                                  ? 0
+                                                  : (rand_r(&seed) %
+                                                     num_victims))];
+                ABTI_pool *p_victim = ABTI_pool_get_ptr(pools[target]);
+                thread = sched_steal(p_global, p_data, p_victim, p_pool);
+                if (thread != ABT_THREAD_NULL)
+                    break;
+            }
+        }
+        if (thread != ABT_THREAD_NULL) {
+            ABTI_thread *p_thread = ABTI_thread_get_ptr(thread);
+            ABTI_ythread_schedule(p_global, &p_local_xstream, p_thread);
+            CNT_INC(run_cnt);
+        }
+
+        if (++work_count >= p_data->event_freq) {
+            ABTI_xstream_check_events(p_local_xstream, p_sched);
+            if (ABTI_sched_has_to_stop(p_sched) == ABT_TRUE)
+                break;
+            work_count = 0;
+            if (num_pools > 1 &&
+                ABTD_atomic_acquire_load_int(&g_home_version) !=
+                    p_data->home_version) {
+                sched_update_victims(p_data);
+            }
+            SCHED_SLEEP(run_cnt, p_data->sleep_time);
+        }
+    }
+    sched_home_unregister(&p_data->home);
+}
+
 static int sched_free(ABT_sched sched)
 {
     ABTI_sched *p_sched = ABTI_sched_get_ptr(sched);
     ABTI_ASSERT(p_sched);
 
     sched_data *p_data = (sched_data *)p_sched->data;
+    ABTU_free(p_data->victims);
     ABTU_free(p_data->pools);
     ABTU_free(p_data);
     return ABT_SUCCESS;
 }
+
+void ABTI_sched_randws_print_stats(ABTI_sched *p_sched, FILE *p_os, int indent)
+{
+    sched_data *p_data = (sched_data *)p_sched->data;
+    if (!p_data)
+        return;
+    fprintf(p_os,
+            "%*ssteal_num      : %d\n"
+            "%*ssteal_attempts : %" PRIu64 "\n"
+            "%*ssteal_successes: %" PRIu64 "\n"
+            "%*sstolen_units   : %" PRIu64 "\n",
+            indent, "", p_data->steal_num, indent, "",
+            p_data->num_steal_attempts, indent, "", p_data->num_steal_successes,
+            indent, "", p_data->num_stolen_threads);
+    if (p_data->victims) {
+        fprintf(p_os, "%*svictims        : core %d, cache %d, remote %d\n",
+                indent, "",
+                p_data->victim_offsets[1] - p_data->victim_offsets[0],
+                p_data->victim_offsets[2] - p_data->victim_offsets[1],
+                p_data->victim_offsets[3] - p_data->victim_offsets[2]);
+    }
+}
@@ -732,9 +732,12 @@ ABTU_ret_err int ABTI_sched_create_basic(ABT_sched_predef predef, int num_pools,
             for (p = 0; p < num_pools; p++) {
                 if (pools[p] == ABT_POOL_NULL) {
                     ABTI_pool *p_newpool;
-                    abt_errno =
-                        ABTI_pool_create_basic(ABT_POOL_FIFO, def_access,
-                                               ABT_TRUE, &p_newpool);
+                    ABT_pool_kind pool_kind =
+                        (predef == ABT_SCHED_EDF && p == 0)
+                            ? ABT_POOL_PRIO_QUEUE
+                            : ABT_POOL_FIFO;
+                    abt_errno = ABTI_pool_create_basic(pool_kind, def_access,
+                                                       ABT_TRUE, &p_newpool);
                     if (ABTI_IS_ERROR_CHECK_ENABLED &&
                         abt_errno != ABT_SUCCESS) {
                         /* Remove pools that are already created. */
@@ -781,6 +784,16 @@ ABTU_ret_err int ABTI_sched_create_basic(ABT_sched_predef predef, int num_pools,
                                          pool_list, p_config, def_automatic,
                                          pp_newsched);
                 break;
+            case ABT_SCHED_HRANDWS:
+                abt_errno = sched_create(ABTI_sched_get_hrandws_def(),
+                                         num_pools, pool_list, p_config,
+                                         def_automatic, pp_newsched);
+                break;
+            case ABT_SCHED_EDF:
+                abt_errno = sched_create(ABTI_sched_get_edf_def(), num_pools,
+                                         pool_list, p_config, def_automatic,
+                                         pp_newsched);
+                break;
             default:
                 abt_errno = ABT_ERR_INV_SCHED_PREDEF;
                 break;
@@ -814,8 +827,13 @@ ABTU_ret_err int ABTI_sched_create_basic(ABT_sched_predef predef, int num_pools,
                 num_pools = ABTI_SCHED_NUM_PRIO;
                 break;
             case ABT_SCHED_RANDWS:
+            case ABT_SCHED_HRANDWS:
                 num_pools = 1;
                 break;
+            case ABT_SCHED_EDF:
+                /* A deadline pool and a pool for the other work units */
+                num_pools = 2;
+                break;
             default:
                 abt_errno = ABT_ERR_INV_SCHED_PREDEF;
                 ABTI_CHECK_ERROR(abt_errno);
@@ -832,8 +850,12 @@ ABTU_ret_err int ABTI_sched_create_basic(ABT_sched_predef predef, int num_pools,
             pool_list[p] = ABT_POOL_NULL;
         for (p = 0; p < num_pools; p++) {
             ABTI_pool *p_newpool;
-            abt_errno =
-                ABTI_pool_create_basic(kind, def_access, ABT_TRUE, &p_newpool);
+            /* The deadline pool of EDF sched is ordered by deadlines. */
+            ABT_pool_kind pool_kind = (predef == ABT_SCHED_EDF && p == 0)
+                                          ? ABT_POOL_PRIO_QUEUE
+                                          : kind;
+            abt_errno = ABTI_pool_create_basic(pool_kind, def_access, ABT_TRUE,
+                                               &p_newpool);
             if (ABTI_IS_ERROR_CHECK_ENABLED && abt_errno != ABT_SUCCESS) {
                 /* Remove pools that are already created. */
                 int i;
@@ -869,6 +891,16 @@ ABTU_ret_err int ABTI_sched_create_basic(ABT_sched_predef predef, int num_pools,
                                          pool_list, p_config, def_automatic,
                                          pp_newsched);
                 break;
+            case ABT_SCHED_HRANDWS:
+                abt_errno = sched_create(ABTI_sched_get_hrandws_def(),
+                                         num_pools, pool_list, p_config,
+                                         def_automatic, pp_newsched);
+                break;
+            case ABT_SCHED_EDF:
+                abt_errno = sched_create(ABTI_sched_get_edf_def(), num_pools,
+                                         pool_list, p_config, def_automatic,
+                                         pp_newsched);
+                break;
             default:
                 abt_errno = ABT_ERR_INV_SCHED_PREDEF;
                 break;
@@ -1015,6 +1047,10 @@ void ABTI_sched_print(ABTI_sched *p_sched, FILE *p_os, int indent,
             kind_str = "PRIO";
         } else if (kind == sched_get_kind(ABTI_sched_get_randws_def())) {
             kind_str = "RANDWS";
+        } else if (kind == sched_get_kind(ABTI_sched_get_hrandws_def())) {
+            kind_str = "HRANDWS";
+        } else if (kind == sched_get_kind(ABTI_sched_get_edf_def())) {
+            kind_str = "EDF";
         } else {
             kind_str = "USER";
         }
@@ -1057,6 +1093,12 @@ void ABTI_sched_print(ABTI_sched *p_sched, FILE *p_os, int indent,
                 "", p_sched->num_pools, indent, "",
                 (ABTI_sched_has_unit(p_sched) ? "TRUE" : "FALSE"), indent, "",
                 (void *)p_sched->p_ythread, indent, "", p_sched->data);
+        if (kind == sched_get_kind(ABTI_sched_get_randws_def()) ||
+            kind == sched_get_kind(ABTI_sched_get_hrandws_def())) {
+            ABTI_sched_randws_print_stats(p_sched, p_os, indent);
+        } else if (kind == sched_get_kind(ABTI_sched_get_edf_def())) {
+            ABTI_sched_edf_print_stats(p_sched, p_os, indent);
+        }
         if (print_sub == ABT_TRUE) {
             size_t i;
             for (i = 0; i < p_sched->num_pools; i++) {
@@ -1151,6 +1193,8 @@ ABTU_ret_err static int sched_create(ABT_sched_def *def, int num_pools,
     p_sched->type = def->type;
     p_sched->p_ythread = NULL;
     p_sched->data = NULL;
+    ABTD_atomic_relaxed_store_ptr(&p_sched->p_waiter, NULL);
+    ABTD_spinlock_clear(&p_sched->waiter_lock);
 
     p_sched->init = def->init;
     p_sched->run = def->run;
@@ -51,6 +51,25 @@ ABT_sched_config_var ABT_sched_config_automatic = { .idx = -3,
 ABT_sched_config_var ABT_sched_basic_freq = { .idx = -4,
                                               .type = ABT_SCHED_CONFIG_INT };
 
+ABT_sched_config_var ABT_sched_randws_steal_num = { .idx = -5,
+                                                    .type =
+                                                        ABT_SCHED_CONFIG_INT };
+
+ABT_sched_config_var ABT_sched_edf_late_pool = { .idx = -6,
+                                                 .type = ABT_SCHED_CONFIG_INT };
+
+ABT_sched_config_var ABT_sched_basic_idle_spin = { .idx = -7,
+                                                   .type =
+                                                       ABT_SCHED_CONFIG_INT };
+
+ABT_sched_config_var ABT_sched_basic_idle_yield = { .idx = -8,
+                                                    .type =
+                                                        ABT_SCHED_CONFIG_INT };
+
+ABT_sched_config_var ABT_sched_basic_idle_max_park = {
+    .idx = -9, .type = ABT_SCHED_CONFIG_DOUBLE
+};
+
 /**
  * @ingroup SCHED_CONFIG
  * @brief   Create a new scheduler configuration.
@@ -70,6 +89,46 @@ ABT_sched_config_var ABT_sched_basic_freq = { .idx = -4,
  *   indicates more frequent check.  If this is not specified, the default value
  *   is used for scheduler creation.
  *
+ * - \c ABT_sched_randws_steal_num:
+ *
+ *   The maximum number of work units that the predefined random work-stealing
+ *   scheduler steals from a victim pool at once.  If the value is zero, the
+ *   scheduler steals half of the work units in the victim pool.  Work units
+ *   other than the one that is executed immediately are moved to the first
+ *   pool of the scheduler.  If this is not specified, the scheduler steals one
+ *   work unit at once.
+ *
+ * - \c ABT_sched_edf_late_pool:
+ *
+ *   The index of the late pool of the predefined earliest-deadline-first
+ *   scheduler in the pools given to the scheduler.  A work unit in the first
+ *   pool that has passed its deadline is moved to the late pool, which the
+ *   scheduler checks next to the first pool.  The index must not be zero.  If
+ *   this is not specified or the value is -1, the scheduler executes such a
+ *   work unit immediately.
+ *
+ * - \c ABT_sched_basic_idle_spin:
+ *
+ *   The number of rounds for which the predefined basic scheduler keeps
+ *   checking its pools after it finds them empty.  After spinning, the
+ *   scheduler yields the underlying Pthread and then blocks it until a work
+ *   unit is pushed to one of its pools.  If this is not specified or the value
+ *   is -1, the scheduler keeps checking its pools without blocking.
+ *
+ * - \c ABT_sched_basic_idle_yield:
+ *
+ *   The number of rounds for which the predefined basic scheduler yields the
+ *   underlying Pthread after spinning.  This is used only if
+ *   \c ABT_sched_basic_idle_spin is specified.  The default value is 16.
+ *
+ * - \c ABT_sched_basic_idle_max_park:
+ *
+ *   The maximum time in seconds for which the predefined basic scheduler blocks
+ *   the underlying Pthread at once.  The blocking time is doubled every time
+ *   the scheduler blocks without finding a work unit, up to this value.  This
+ *   is used only if \c ABT_sched_basic_idle_spin is specified.  The default
+ *   value is 0.001.
+ *
  * - \c ABT_sched_config_automatic:
  *
  *   Whether the scheduler is automatically freed or not.  If the value is
@@ -602,6 +602,7 @@ int ABT_xstream_cancel(ABT_xstream xstream)
     ABTD_atomic_fetch_or_uint32(&p_xstream->p_main_sched->p_ythread->thread
                                      .request,
                                 ABTI_THREAD_REQ_CANCEL);
+    ABTI_sched_wake(p_xstream->p_main_sched);
     return ABT_SUCCESS;
 }
 
@@ -754,6 +755,9 @@ int ABT_xstream_set_rank(ABT_xstream xstream, int rank)
     if (p_global->set_affinity == ABT_TRUE) {
         ABTD_affinity_cpuset_apply_default(&p_xstream->ctx, p_xstream->rank);
     }
+    ABTI_mem_set_local_node(p_xstream,
+                            ABTI_mem_get_default_node(p_global,
+                                                      p_xstream->rank));
     return ABT_SUCCESS;
 }
 
@@ -1386,8 +1390,9 @@ int ABT_xstream_set_cpubind(ABT_xstream xstream, int cpuid)
     cpuset.num_cpuids = 1;
     cpuset.cpuids = &cpuid;
     int abt_errno = ABTD_affinity_cpuset_apply(&p_xstream->ctx, &cpuset);
-    /* Do not free cpuset since cpuids points to a user pointer. */
     ABTI_CHECK_ERROR(abt_errno);
+    ABTI_mem_set_local_node(p_xstream, ABTD_affinity_cpuset_get_node(&cpuset));
+    /* Do not free cpuset since cpuids points to a user pointer. */
     return ABT_SUCCESS;
 }
 
@@ -1491,8 +1496,10 @@ int ABT_xstream_set_affinity(ABT_xstream xstream, int num_cpuids, int *cpuids)
     affinity.num_cpuids = num_cpuids;
     affinity.cpuids = cpuids;
     int abt_errno = ABTD_affinity_cpuset_apply(&p_xstream->ctx, &affinity);
-    /* Do not free affinity since cpuids may not be freed. */
     ABTI_CHECK_ERROR(abt_errno);
+    ABTI_mem_set_local_node(p_xstream,
+                            ABTD_affinity_cpuset_get_node(&affinity));
+    /* Do not free affinity since cpuids may not be freed. */
     return ABT_SUCCESS;
 }
 
@@ -1619,6 +1626,8 @@ void ABTI_xstream_start_primary(ABTI_global *p_global,
 void ABTI_xstream_check_events(ABTI_xstream *p_xstream, ABTI_sched *p_sched)
 {
     ABTI_info_check_print_all_thread_stacks();
+    ABTI_mem_check_trim(ABTI_global_get_global());
+    ABTI_mem_flush_local_stats(p_xstream);
 
     uint32_t request = ABTD_atomic_acquire_load_uint32(
         &p_xstream->p_main_sched->p_ythread->thread.request);
@@ -9,7 +9,7 @@ ABTU_ret_err static int task_create(ABTI_global *p_global, ABTI_local *p_local,
                                     ABTI_pool *p_pool,
                                     void (*task_func)(void *), void *arg,
                                     ABTI_sched *p_sched, int refcount,
-                                    ABTI_thread **pp_newtask);
+                                    ABT_bool push, ABTI_thread **pp_newtask);
 
 /** @defgroup TASK Tasklet
  * This group is for Tasklet.  A tasklet is a work unit that cannot yield.
@@ -72,7 +72,7 @@ int ABT_task_create(ABT_pool pool, void (*task_func)(void *), void *arg,
 
     int refcount = (newtask != NULL) ? 1 : 0;
     int abt_errno = task_create(p_global, p_local, p_pool, task_func, arg, NULL,
-                                refcount, &p_newtask);
+                                refcount, ABT_TRUE, &p_newtask);
     ABTI_CHECK_ERROR(abt_errno);
 
     /* Return value */
@@ -142,7 +142,7 @@ int ABT_task_create_on_xstream(ABT_xstream xstream, void (*task_func)(void *),
     ABTI_pool *p_pool = ABTI_xstream_get_main_pool(p_xstream);
     int refcount = (newtask != NULL) ? 1 : 0;
     int abt_errno = task_create(p_global, p_local, p_pool, task_func, arg, NULL,
-                                refcount, &p_newtask);
+                                refcount, ABT_TRUE, &p_newtask);
     ABTI_CHECK_ERROR(abt_errno);
 
     /* Return value */
@@ -565,6 +565,25 @@ int ABT_task_set_specific(ABT_task task, ABT_key key, void *value);
 int ABT_task_get_specific(ABT_task task, ABT_key key, void **value);
 #endif
 
+/*****************************************************************************/
+/* Private APIs                                                              */
+/*****************************************************************************/
+
+/* Create a tasklet that is associated with p_pool but not pushed to p_pool.
+ * The caller must push it to p_pool later. */
+ABTU_ret_err int ABTI_task_create_unpushed(ABTI_global *p_global,
+                                           ABTI_local *p_local,
+                                           ABTI_pool *p_pool,
+                                           void (*task_func)(void *), void *arg,
+                                           ABT_bool is_named,
+                                           ABTI_thread **pp_newtask)
+{
+    int abt_errno = task_create(p_global, p_local, p_pool, task_func, arg, NULL,
+                                is_named ? 1 : 0, ABT_FALSE, pp_newtask);
+    ABTI_CHECK_ERROR(abt_errno);
+    return ABT_SUCCESS;
+}
+
 /*****************************************************************************/
 /* Internal static functions                                                 */
 /*****************************************************************************/
@@ -573,7 +592,7 @@ ABTU_ret_err static int task_create(ABTI_global *p_global, ABTI_local *p_local,
                                     ABTI_pool *p_pool,
                                     void (*task_func)(void *), void *arg,
                                     ABTI_sched *p_sched, int refcount,
-                                    ABTI_thread **pp_newtask)
+                                    ABT_bool push, ABTI_thread **pp_newtask)
 {
     ABTI_thread *p_newtask;
 
@@ -594,6 +613,7 @@ ABTU_ret_err static int task_create(ABTI_global *p_global, ABTI_local *p_local,
     p_newtask->p_arg = arg;
     ABTD_atomic_relaxed_store_ptr(&p_newtask->p_keytable, NULL);
     p_newtask->id = ABTI_TASK_INIT_ID;
+    p_newtask->priority = 0;
 
     /* Create a wrapper work unit */
     ABTI_thread_type thread_type =
@@ -611,7 +631,10 @@ ABTU_ret_err static int task_create(ABTI_global *p_global, ABTI_local *p_local,
                              p_pool);
 
     /* Add this task to the scheduler's pool */
-    ABTI_pool_push(p_pool, p_newtask->unit, ABT_POOL_CONTEXT_OP_THREAD_CREATE);
+    if (push) {
+        ABTI_pool_push(p_pool, p_newtask->unit,
+                       ABT_POOL_CONTEXT_OP_THREAD_CREATE);
+    }
 
     /* Return value */
     *pp_newtask = p_newtask;
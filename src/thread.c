@@ -15,6 +15,11 @@ ythread_create(ABTI_global *p_global, ABTI_local *p_local, ABTI_pool *p_pool,
                void (*thread_func)(void *), void *arg, ABTI_thread_attr *p_attr,
                ABTI_thread_type thread_type, ABTI_sched *p_sched,
                thread_pool_op_kind pool_op, ABTI_ythread **pp_newthread);
+ABTU_ret_err static int
+ythread_create_many(ABTI_global *p_global, ABTI_local *p_local, int num_threads,
+                    ABT_pool *pool_list, void (**thread_func_list)(void *),
+                    void **arg_list, ABTI_thread_attr *p_attr,
+                    ABTI_thread_type thread_type, ABT_thread *newthread_list);
 ABTU_ret_err static inline int
 thread_revive(ABTI_global *p_global, ABTI_local *p_local, ABTI_pool *p_pool,
               void (*thread_func)(void *), void *arg,
@@ -328,6 +333,11 @@ int ABT_thread_create_on_xstream(ABT_xstream xstream,
  * unnamed ULT is automatically released on the completion of \c thread_func().
  * Otherwise, the creates ULTs must be explicitly freed by \c ABT_thread_free().
  *
+ * If the ULTs use a stack of the default size, this routine allocates them in
+ * batches and pushes consecutive ULTs that have the same pool in \c pool_list
+ * at once if the pool supports \c ABT_pool_user_push_many_fn.  The order of
+ * ULTs pushed to each pool is the same as that in \c pool_list.
+ *
  * This routine is deprecated because this routine does not provide a way for
  * the user to keep track of an error that happens during this routine.  The
  * user should call \c ABT_thread_create() multiple times instead.
@@ -356,48 +366,53 @@ int ABT_thread_create_many(int num_threads, ABT_pool *pool_list,
     ABTI_global *p_global;
     ABTI_SETUP_GLOBAL(&p_global);
     ABTI_local *p_local = ABTI_local_get_local();
+    ABTI_thread_attr *p_attr = ABTI_thread_attr_get_ptr(attr);
     int i;
 
-    if (attr != ABT_THREAD_ATTR_NULL) {
+    if (p_attr) {
         /* This implies that the stack is given by a user.  Since threads
          * cannot use the same stack region, this is illegal. */
-        ABTI_CHECK_TRUE(ABTI_thread_attr_get_ptr(attr)->p_stack == NULL,
-                        ABT_ERR_INV_THREAD_ATTR);
+        ABTI_CHECK_TRUE(p_attr->p_stack == NULL, ABT_ERR_INV_THREAD_ATTR);
+    }
+    /* Check all the pools before creating any ULT. */
+    for (i = 0; i < num_threads; i++) {
+        ABTI_pool *p_pool = ABTI_pool_get_ptr(pool_list[i]);
+        ABTI_CHECK_NULL_POOL_PTR(p_pool);
     }
 
-    if (newthread_list == NULL) {
-        for (i = 0; i < num_threads; i++) {
-            ABTI_ythread *p_newthread;
-            ABT_pool pool = pool_list[i];
-            ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
-            ABTI_CHECK_NULL_POOL_PTR(p_pool);
-
-            void (*thread_f)(void *) = thread_func_list[i];
-            void *arg = arg_list ? arg_list[i] : NULL;
-            int abt_errno = ythread_create(p_global, p_local, p_pool, thread_f,
-                                           arg, ABTI_thread_attr_get_ptr(attr),
-                                           ABTI_THREAD_TYPE_YIELDABLE, NULL,
-                                           THREAD_POOL_OP_PUSH, &p_newthread);
-            ABTI_CHECK_ERROR(abt_errno);
-        }
+    ABTI_thread_type unit_type =
+        newthread_list ? (ABTI_THREAD_TYPE_YIELDABLE | ABTI_THREAD_TYPE_NAMED)
+                       : ABTI_THREAD_TYPE_YIELDABLE;
+    if (!p_attr || (p_attr->stacksize == p_global->thread_stacksize
+#ifndef ABT_CONFIG_DISABLE_MIGRATION
+                    && !p_attr->f_cb
+#endif
+                    )) {
+        /* ULTs that use a stack of the default size are created in batches. */
+        int abt_errno =
+            ythread_create_many(p_global, p_local, num_threads, pool_list,
+                                thread_func_list, arg_list, p_attr, unit_type,
+                                newthread_list);
+        ABTI_CHECK_ERROR(abt_errno);
     } else {
         for (i = 0; i < num_threads; i++) {
             ABTI_ythread *p_newthread;
-            ABT_pool pool = pool_list[i];
-            ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
-            ABTI_CHECK_NULL_POOL_PTR(p_pool);
-
+            ABTI_pool *p_pool = ABTI_pool_get_ptr(pool_list[i]);
             void (*thread_f)(void *) = thread_func_list[i];
             void *arg = arg_list ? arg_list[i] : NULL;
             int abt_errno =
-                ythread_create(p_global, p_local, p_pool, thread_f, arg,
-                               ABTI_thread_attr_get_ptr(attr),
-                               ABTI_THREAD_TYPE_YIELDABLE |
-                                   ABTI_THREAD_TYPE_NAMED,
-                               NULL, THREAD_POOL_OP_PUSH, &p_newthread);
-            newthread_list[i] = ABTI_ythread_get_handle(p_newthread);
-            /* TODO: Release threads that have been already created. */
-            ABTI_CHECK_ERROR(abt_errno);
+                ythread_create(p_global, p_local, p_pool, thread_f, arg, p_attr,
+                               unit_type, NULL, THREAD_POOL_OP_PUSH,
+                               &p_newthread);
+            if (ABTI_IS_ERROR_CHECK_ENABLED && abt_errno != ABT_SUCCESS) {
+                if (newthread_list) {
+                    for (; i < num_threads; i++)
+                        newthread_list[i] = ABT_THREAD_NULL;
+                }
+                ABTI_HANDLE_ERROR(abt_errno);
+            }
+            if (newthread_list)
+                newthread_list[i] = ABTI_ythread_get_handle(p_newthread);
         }
     }
 
@@ -2216,6 +2231,114 @@ int ABT_thread_get_id(ABT_thread thread, ABT_unit_id *thread_id)
     return ABT_SUCCESS;
 }
 
+/**
+ * @ingroup ULT
+ * @brief   Set a priority of a work unit.
+ *
+ * \c ABT_thread_set_priority() sets the priority \c priority of the work unit
+ * \c thread.  A smaller value means a higher priority.  The priority is used
+ * by a pool that orders work units by priority (e.g., \c ABT_POOL_PRIO_QUEUE).
+ * If \c thread is already in such a pool, the new priority takes effect when
+ * \c thread is pushed to a pool next time.
+ *
+ * @contexts
+ * \DOC_CONTEXT_INIT \DOC_CONTEXT_NOCTXSWITCH
+ *
+ * @errors
+ * \DOC_ERROR_SUCCESS
+ * \DOC_ERROR_INV_THREAD_HANDLE{\c thread}
+ *
+ * @undefined
+ * \DOC_UNDEFINED_UNINIT
+ * \DOC_UNDEFINED_THREAD_UNSAFE{\c thread}
+ *
+ * @param[in] thread    work unit handle
+ * @param[in] priority  priority
+ * @return Error code
+ */
+int ABT_thread_set_priority(ABT_thread thread, int64_t priority)
+{
+    ABTI_UB_ASSERT(ABTI_initialized());
+
+    ABTI_thread *p_thread = ABTI_thread_get_ptr(thread);
+    ABTI_CHECK_NULL_THREAD_PTR(p_thread);
+
+    p_thread->priority = priority;
+    return ABT_SUCCESS;
+}
+
+/**
+ * @ingroup ULT
+ * @brief   Set a deadline of a work unit.
+ *
+ * \c ABT_thread_set_deadline() sets the deadline \c deadline of the work unit
+ * \c thread.  \c deadline is an absolute time in seconds based on
+ * \c ABT_get_wtime().  The deadline is stored as the priority of \c thread as
+ * \c ABT_thread_attr_set_deadline() does.  If \c thread is already in a pool,
+ * the new deadline takes effect when \c thread is pushed to a pool next time.
+ *
+ * @contexts
+ * \DOC_CONTEXT_INIT \DOC_CONTEXT_NOCTXSWITCH
+ *
+ * @errors
+ * \DOC_ERROR_SUCCESS
+ * \DOC_ERROR_INV_THREAD_HANDLE{\c thread}
+ * \DOC_ERROR_INV_ARG_NEG{\c deadline}
+ *
+ * @undefined
+ * \DOC_UNDEFINED_UNINIT
+ * \DOC_UNDEFINED_THREAD_UNSAFE{\c thread}
+ *
+ * @param[in] thread    work unit handle
+ * @param[in] deadline  deadline in seconds
+ * @return Error code
+ */
+int ABT_thread_set_deadline(ABT_thread thread, double deadline)
+{
+    ABTI_UB_ASSERT(ABTI_initialized());
+
+    ABTI_thread *p_thread = ABTI_thread_get_ptr(thread);
+    ABTI_CHECK_NULL_THREAD_PTR(p_thread);
+    ABTI_CHECK_TRUE(deadline >= 0.0, ABT_ERR_INV_ARG);
+
+    p_thread->priority = ABTI_deadline_to_priority(deadline);
+    return ABT_SUCCESS;
+}
+
+/**
+ * @ingroup ULT
+ * @brief   Get a priority of a work unit.
+ *
+ * \c ABT_thread_get_priority() returns the priority of the work unit \c thread
+ * through \c priority.  The priority of a tasklet is 0.
+ *
+ * @contexts
+ * \DOC_CONTEXT_INIT \DOC_CONTEXT_NOCTXSWITCH
+ *
+ * @errors
+ * \DOC_ERROR_SUCCESS
+ * \DOC_ERROR_INV_THREAD_HANDLE{\c thread}
+ *
+ * @undefined
+ * \DOC_UNDEFINED_UNINIT
+ * \DOC_UNDEFINED_NULL_PTR{\c priority}
+ *
+ * @param[in]  thread    work unit handle
+ * @param[out] priority  priority
+ * @return Error code
+ */
+int ABT_thread_get_priority(ABT_thread thread, int64_t *priority)
+{
+    ABTI_UB_ASSERT(ABTI_initialized());
+    ABTI_UB_ASSERT(priority);
+
+    ABTI_thread *p_thread = ABTI_thread_get_ptr(thread);
+    ABTI_CHECK_NULL_THREAD_PTR(p_thread);
+
+    *priority = p_thread->priority;
+    return ABT_SUCCESS;
+}
+
 /**
  * @ingroup ULT
  * @brief   Set an argument for a work-unit function of a work unit.
@@ -2477,6 +2600,7 @@ int ABT_thread_get_attr(ABT_thread thread, ABT_thread_attr *attr)
         thread_attr.p_stack = NULL;
         thread_attr.stacksize = 0;
     }
+    thread_attr.priority = p_thread->priority;
 #ifndef ABT_CONFIG_DISABLE_MIGRATION
     thread_attr.migratable =
         (p_thread->type & ABTI_THREAD_TYPE_MIGRATABLE) ? ABT_TRUE : ABT_FALSE;
@@ -2606,6 +2730,29 @@ ABTU_ret_err int ABTI_ythread_create_sched(ABTI_global *p_global,
     return ABT_SUCCESS;
 }
 
+/* Create a ULT that is associated with p_pool but not pushed to p_pool.  The
+ * caller must push it to p_pool later. */
+ABTU_ret_err int ABTI_thread_create_unpushed(ABTI_global *p_global,
+                                             ABTI_local *p_local,
+                                             ABTI_pool *p_pool,
+                                             void (*thread_func)(void *),
+                                             void *arg,
+                                             ABTI_thread_attr *p_attr,
+                                             ABT_bool is_named,
+                                             ABTI_thread **pp_newthread)
+{
+    ABTI_ythread *p_newthread;
+    ABTI_thread_type unit_type =
+        is_named ? (ABTI_THREAD_TYPE_YIELDABLE | ABTI_THREAD_TYPE_NAMED)
+                 : ABTI_THREAD_TYPE_YIELDABLE;
+    int abt_errno =
+        ythread_create(p_global, p_local, p_pool, thread_func, arg, p_attr,
+                       unit_type, NULL, THREAD_POOL_OP_INIT, &p_newthread);
+    ABTI_CHECK_ERROR(abt_errno);
+    *pp_newthread = &p_newthread->thread;
+    return ABT_SUCCESS;
+}
+
 void ABTI_thread_join(ABTI_local **pp_local, ABTI_thread *p_thread)
 {
     thread_join(pp_local, p_thread);
@@ -2766,6 +2913,7 @@ void ABTI_thread_print(ABTI_thread *p_thread, FILE *p_os, int indent)
                 "%*snamed      : %s\n"
                 "%*smigratable : %s\n"
                 "%*srequest    : 0x%x\n"
+                "%*spriority   : %" PRId64 "\n"
                 "%*smig_cb_arg : %p\n"
                 "%*skeytable   : %p\n",
                 indent, "", (void *)p_thread, indent, "",
@@ -2775,7 +2923,7 @@ void ABTI_thread_print(ABTI_thread *p_thread, FILE *p_os, int indent)
                 "", p_thread->p_arg, indent, "", (void *)p_thread->p_pool,
                 indent, "", named, indent, "", migratable, indent, "",
                 ABTD_atomic_acquire_load_uint32(&p_thread->request), indent, "",
-                p_migration_cb_arg, indent, "",
+                p_thread->priority, indent, "", p_migration_cb_arg, indent, "",
                 ABTD_atomic_acquire_load_ptr(&p_thread->p_keytable));
 
         if (p_thread->type & ABTI_THREAD_TYPE_YIELDABLE) {
@@ -2842,7 +2990,8 @@ ythread_create(ABTI_global *p_global, ABTI_local *p_local, ABTI_pool *p_pool,
          *  -> size == 0, p_stack = NULL
          * 4. A thread that uses a user-allocated stack.
          *  -> p_stack != NULL
-         * Only 1. is important for the performance.
+         * 1. and 2. are important for the performance.  2. uses a memory
+         * pool of a stack size class if any.
          */
         if (ABTU_likely(p_attr->p_stack == NULL)) {
             const size_t default_stacksize = p_global->thread_stacksize;
@@ -2855,10 +3004,8 @@ ythread_create(ABTI_global *p_global, ABTI_local *p_local, ABTI_pool *p_pool,
                                                               &p_newthread);
             } else if (stacksize != 0) {
                 /* 2. A thread that uses a stack of a non-default size. */
-                abt_errno =
-                    ABTI_mem_alloc_ythread_malloc_desc_stack(p_global,
-                                                             stacksize,
-                                                             &p_newthread);
+                abt_errno = ABTI_mem_alloc_ythread_mempool_class_desc_stack(
+                    p_global, p_local, stacksize, &p_newthread);
             } else {
                 /* 3. A thread that uses OS-level thread's stack */
                 abt_errno =
@@ -2914,6 +3061,7 @@ ythread_create(ABTI_global *p_global, ABTI_local *p_local, ABTI_pool *p_pool,
     p_newthread->thread.p_parent = NULL;
     p_newthread->thread.type |= thread_type;
     p_newthread->thread.id = ABTI_THREAD_INIT_ID;
+    p_newthread->thread.priority = p_attr ? p_attr->priority : 0;
     if (p_sched && !(thread_type & (ABTI_THREAD_TYPE_PRIMARY |
                                     ABTI_THREAD_TYPE_MAIN_SCHED))) {
         /* Set a destructor for p_sched. */
@@ -2968,6 +3116,114 @@ ythread_create(ABTI_global *p_global, ABTI_local *p_local, ABTI_pool *p_pool,
     return ABT_SUCCESS;
 }
 
+/* The number of ULTs that ythread_create_many() allocates at once. */
+#define THREAD_CREATE_MANY_BATCH_SIZE 64
+
+/* Create ULTs that use a stack of the default size.  Descriptors are taken
+ * from a memory pool in batches and ULTs that are consecutively pushed to the
+ * same pool are pushed by a single push_many() call if the pool supports it.
+ * If it fails, ULTs that have been already pushed are not released. */
+ABTU_ret_err static int
+ythread_create_many(ABTI_global *p_global, ABTI_local *p_local, int num_threads,
+                    ABT_pool *pool_list, void (**thread_func_list)(void *),
+                    void **arg_list, ABTI_thread_attr *p_attr,
+                    ABTI_thread_type thread_type, ABT_thread *newthread_list)
+{
+    ABTI_ythread *p_newthreads[THREAD_CREATE_MANY_BATCH_SIZE];
+    ABT_unit units[THREAD_CREATE_MANY_BATCH_SIZE];
+    ABTI_thread *p_caller = ABTI_local_get_xstream_or_null(p_local)
+                                ? ABTI_local_get_xstream(p_local)->p_thread
+                                : NULL;
+    const int64_t priority = p_attr ? p_attr->priority : 0;
+#ifndef ABT_CONFIG_DISABLE_MIGRATION
+    if (!p_attr || p_attr->migratable)
+        thread_type |= ABTI_THREAD_TYPE_MIGRATABLE;
+#endif
+
+    int offset = 0;
+    while (offset < num_threads) {
+        int i, j, num = num_threads - offset;
+        if (num > THREAD_CREATE_MANY_BATCH_SIZE)
+            num = THREAD_CREATE_MANY_BATCH_SIZE;
+        int abt_errno =
+            ABTI_mem_alloc_ythread_default_many(p_global, p_local, (size_t)num,
+                                                p_newthreads);
+        if (ABTI_IS_ERROR_CHECK_ENABLED && abt_errno != ABT_SUCCESS) {
+            if (newthread_list) {
+                for (i = offset; i < num_threads; i++)
+                    newthread_list[i] = ABT_THREAD_NULL;
+            }
+            return abt_errno;
+        }
+
+        for (i = 0; i < num; i++) {
+            ABTI_ythread *p_newthread = p_newthreads[i];
+            ABTI_pool *p_pool = ABTI_pool_get_ptr(pool_list[offset + i]);
+            p_newthread->thread.f_thread = thread_func_list[offset + i];
+            p_newthread->thread.p_arg = arg_list ? arg_list[offset + i] : NULL;
+            ABTD_atomic_release_store_int(&p_newthread->thread.state,
+                                          ABT_THREAD_STATE_READY);
+            ABTD_atomic_release_store_uint32(&p_newthread->thread.request, 0);
+            p_newthread->thread.p_last_xstream = NULL;
+            p_newthread->thread.p_parent = NULL;
+            p_newthread->thread.type |= thread_type;
+            p_newthread->thread.id = ABTI_THREAD_INIT_ID;
+            p_newthread->thread.priority = priority;
+            ABTD_atomic_relaxed_store_ptr(&p_newthread->thread.p_keytable,
+                                          NULL);
+            abt_errno =
+                ABTI_thread_init_pool(p_global, &p_newthread->thread, p_pool);
+            if (ABTI_IS_ERROR_CHECK_ENABLED &&
+                ABTU_unlikely(abt_errno != ABT_SUCCESS)) {
+                /* Release ULTs that have not been pushed yet. */
+                for (j = 0; j < i; j++) {
+                    thread_free(p_global, p_local, &p_newthreads[j]->thread,
+                                ABT_TRUE);
+                }
+                for (j = i; j < num; j++) {
+                    ABTI_mem_free_thread(p_global, p_local,
+                                         &p_newthreads[j]->thread);
+                }
+                if (newthread_list) {
+                    for (j = offset; j < num_threads; j++)
+                        newthread_list[j] = ABT_THREAD_NULL;
+                }
+                return abt_errno;
+            }
+            /* Invoke a thread creation event. */
+            ABTI_event_thread_create(p_local, &p_newthread->thread, p_caller,
+                                     p_pool);
+            units[i] = p_newthread->thread.unit;
+        }
+        if (newthread_list) {
+            for (i = 0; i < num; i++) {
+                newthread_list[offset + i] =
+                    ABTI_ythread_get_handle(p_newthreads[i]);
+            }
+        }
+
+        /* Add these threads to the pools. */
+        for (i = 0; i < num; i = j) {
+            ABTI_pool *p_pool = p_newthreads[i]->thread.p_pool;
+            for (j = i + 1; j < num && p_newthreads[j]->thread.p_pool == p_pool;
+                 j++)
+                ;
+            if (j - i > 1 && p_pool->optional_def.p_push_many) {
+                ABTI_pool_push_many(p_pool, &units[i], (size_t)(j - i),
+                                    ABT_POOL_CONTEXT_OP_THREAD_CREATE);
+            } else {
+                int k;
+                for (k = i; k < j; k++) {
+                    ABTI_pool_push(p_pool, units[k],
+                                   ABT_POOL_CONTEXT_OP_THREAD_CREATE);
+                }
+            }
+        }
+        offset += num;
+    }
+    return ABT_SUCCESS;
+}
+
 ABTU_ret_err static inline int
 thread_revive(ABTI_global *p_global, ABTI_local *p_local, ABTI_pool *p_pool,
               void (*thread_func)(void *), void *arg,
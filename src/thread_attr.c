@@ -382,6 +382,118 @@ int ABT_thread_attr_set_migratable(ABT_thread_attr attr, ABT_bool is_migratable)
 #endif
 }
 
+/**
+ * @ingroup ULT_ATTR
+ * @brief   Set a priority in a ULT attribute.
+ *
+ * \c ABT_thread_attr_set_priority() sets the priority \c priority in the ULT
+ * attribute \c attr.  A smaller value means a higher priority.  A pool that
+ * orders work units by priority (e.g., \c ABT_POOL_PRIO_QUEUE) pops a ULT
+ * created with this attribute according to \c priority.  The default priority
+ * is 0.
+ *
+ * @contexts
+ * \DOC_CONTEXT_INIT \DOC_CONTEXT_NOCTXSWITCH
+ *
+ * @errors
+ * \DOC_ERROR_SUCCESS
+ * \DOC_ERROR_INV_THREAD_ATTR_HANDLE{\c attr}
+ *
+ * @undefined
+ * \DOC_UNDEFINED_UNINIT
+ * \DOC_UNDEFINED_THREAD_UNSAFE{\c attr}
+ *
+ * @param[in] attr      ULT attribute handle
+ * @param[in] priority  priority
+ * @return Error code
+ */
+int ABT_thread_attr_set_priority(ABT_thread_attr attr, int64_t priority)
+{
+    ABTI_UB_ASSERT(ABTI_initialized());
+
+    ABTI_thread_attr *p_attr = ABTI_thread_attr_get_ptr(attr);
+    ABTI_CHECK_NULL_THREAD_ATTR_PTR(p_attr);
+
+    /* Set the value */
+    p_attr->priority = priority;
+    return ABT_SUCCESS;
+}
+
+/**
+ * @ingroup ULT_ATTR
+ * @brief   Get a priority from a ULT attribute.
+ *
+ * \c ABT_thread_attr_get_priority() retrieves the priority from the ULT
+ * attribute \c attr and returns it through \c priority.
+ *
+ * @contexts
+ * \DOC_CONTEXT_INIT \DOC_CONTEXT_NOCTXSWITCH
+ *
+ * @errors
+ * \DOC_ERROR_SUCCESS
+ * \DOC_ERROR_INV_THREAD_ATTR_HANDLE{\c attr}
+ *
+ * @undefined
+ * \DOC_UNDEFINED_UNINIT
+ * \DOC_UNDEFINED_NULL_PTR{\c priority}
+ *
+ * @param[in]  attr      ULT attribute handle
+ * @param[out] priority  priority
+ * @return Error code
+ */
+int ABT_thread_attr_get_priority(ABT_thread_attr attr, int64_t *priority)
+{
+    ABTI_UB_ASSERT(ABTI_initialized());
+    ABTI_UB_ASSERT(priority);
+
+    ABTI_thread_attr *p_attr = ABTI_thread_attr_get_ptr(attr);
+    ABTI_CHECK_NULL_THREAD_ATTR_PTR(p_attr);
+
+    *priority = p_attr->priority;
+    return ABT_SUCCESS;
+}
+
+/**
+ * @ingroup ULT_ATTR
+ * @brief   Set a deadline in a ULT attribute.
+ *
+ * \c ABT_thread_attr_set_deadline() sets the deadline \c deadline in the ULT
+ * attribute \c attr.  \c deadline is an absolute time in seconds based on
+ * \c ABT_get_wtime().  The deadline is stored as the priority of \c attr, so
+ * this routine overwrites the priority set by
+ * \c ABT_thread_attr_set_priority().  A ULT that has an earlier deadline has a
+ * higher priority.  The scheduler \c ABT_SCHED_EDF runs ULTs in the
+ * earliest-deadline-first order.
+ *
+ * @contexts
+ * \DOC_CONTEXT_INIT \DOC_CONTEXT_NOCTXSWITCH
+ *
+ * @errors
+ * \DOC_ERROR_SUCCESS
+ * \DOC_ERROR_INV_THREAD_ATTR_HANDLE{\c attr}
+ * \DOC_ERROR_INV_ARG_NEG{\c deadline}
+ *
+ * @undefined
+ * \DOC_UNDEFINED_UNINIT
+ * \DOC_UNDEFINED_THREAD_UNSAFE{\c attr}
+ *
+ * @param[in] attr      ULT attribute handle
+ * @param[in] deadline  deadline in seconds
+ * @return Error code
+ */
+int ABT_thread_attr_set_deadline(ABT_thread_attr attr, double deadline)
+{
+    ABTI_UB_ASSERT(ABTI_initialized());
+
+    ABTI_thread_attr *p_attr = ABTI_thread_attr_get_ptr(attr);
+    ABTI_CHECK_NULL_THREAD_ATTR_PTR(p_attr);
+    ABTI_CHECK_TRUE(deadline >= 0.0, ABT_ERR_INV_ARG);
+
+    /* Set the value */
+    p_attr->priority = ABTI_deadline_to_priority(deadline);
+    return ABT_SUCCESS;
+}
+
 /*****************************************************************************/
 /* Private APIs                                                              */
 /*****************************************************************************/
@@ -396,10 +508,12 @@ void ABTI_thread_attr_print(ABTI_thread_attr *p_attr, FILE *p_os, int indent)
                 "%*sULT attr: ["
                 "stack:%p "
                 "stacksize:%zu "
+                "priority:%" PRId64 " "
                 "migratable:%s "
                 "cb_arg:%p"
                 "]\n",
                 indent, "", p_attr->p_stack, p_attr->stacksize,
+                p_attr->priority,
                 (p_attr->migratable == ABT_TRUE ? "TRUE" : "FALSE"),
                 p_attr->p_cb_arg);
 #else
@@ -407,8 +521,10 @@ void ABTI_thread_attr_print(ABTI_thread_attr *p_attr, FILE *p_os, int indent)
                 "%*sULT attr: ["
                 "stack:%p "
                 "stacksize:%zu "
+                "priority:%" PRId64 " "
                 "]\n",
-                indent, "", p_attr->p_stack, p_attr->stacksize);
+                indent, "", p_attr->p_stack, p_attr->stacksize,
+                p_attr->priority);
 #endif
     }
     fflush(p_os);
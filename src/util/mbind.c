@@ -0,0 +1,35 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include "abti.h"
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/syscall.h>
+#endif
+
+/* The following is taken from <numaif.h> so that Argobots does not depend on
+ * libnuma. */
+#define ABTU_MBIND_MPOL_PREFERRED 1
+#define ABTU_MBIND_MAX_NODES 1024
+
+ABTU_ret_err int ABTU_mbind_preferred(void *addr, size_t size, int node)
+{
+#if defined(__linux__) && defined(SYS_mbind)
+    const size_t bits_per_elem = sizeof(unsigned long) * 8;
+    unsigned long nodemask[ABTU_MBIND_MAX_NODES / (sizeof(unsigned long) * 8)];
+    if (node < 0 || node >= ABTU_MBIND_MAX_NODES)
+        return ABT_ERR_INV_ARG;
+    memset(nodemask, 0, sizeof(nodemask));
+    nodemask[node / bits_per_elem] = 1ul << (node % bits_per_elem);
+    /* The kernel ignores the last bit of maxnode. */
+    long ret = syscall(SYS_mbind, addr, (unsigned long)size,
+                       ABTU_MBIND_MPOL_PREFERRED, nodemask,
+                       (unsigned long)ABTU_MBIND_MAX_NODES + 1, 0u);
+    return ret == 0 ? ABT_SUCCESS : ABT_ERR_SYS;
+#else
+    return ABT_ERR_FEATURE_NA;
+#endif
+}
@@ -20,3 +20,13 @@ ABTU_ret_err int ABTU_mprotect(void *addr, size_t size, ABT_bool protect)
     return ABT_ERR_SYS;
 #endif
 }
+
+ABTU_ret_err int ABTU_madvise_dontneed(void *addr, size_t size)
+{
+#if defined(HAVE_MADVISE) && defined(MADV_DONTNEED)
+    int ret = madvise(addr, size, MADV_DONTNEED);
+    return ret == 0 ? ABT_SUCCESS : ABT_ERR_SYS;
+#else
+    return ABT_ERR_FEATURE_NA;
+#endif
+}
@@ -0,0 +1,154 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+/* This test checks split-phase barrier operations (ABT_barrier_arrive() and
+ * ABT_barrier_wait_phase()).  ULTs on multiple execution streams and external
+ * threads pass a barrier many times.  Some of them call ABT_barrier_wait() and
+ * the others call ABT_barrier_arrive() and ABT_barrier_wait_phase() with some
+ * work in between. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS 4
+#define DEFAULT_NUM_THREADS 16
+#define DEFAULT_NUM_ITER 100
+#define NUM_PTHREADS 2
+
+static ABT_barrier g_barrier;
+static int g_num_waiters;
+static int g_iter = DEFAULT_NUM_ITER;
+static volatile int g_num_arrivals = 0;
+
+static void pass_barrier(int id, ABT_bool is_ult)
+{
+    int i, ret;
+    uint64_t phase;
+    for (i = 0; i < g_iter; i++) {
+        ATS_atomic_fetch_add(&g_num_arrivals, 1);
+        if ((i + id) % 3 == 0) {
+            ret = ABT_barrier_wait(g_barrier);
+            ATS_ERROR(ret, "ABT_barrier_wait");
+        } else {
+            ret = ABT_barrier_arrive(g_barrier, &phase);
+            ATS_ERROR(ret, "ABT_barrier_arrive");
+            /* The phase is incremented once per iteration. */
+            assert(phase == (uint64_t)i);
+            if (is_ult && (i + id) % 3 == 1) {
+                ret = ABT_thread_yield();
+                ATS_ERROR(ret, "ABT_thread_yield");
+            }
+            ret = ABT_barrier_wait_phase(g_barrier, phase);
+            ATS_ERROR(ret, "ABT_barrier_wait_phase");
+            /* Waiting for a completed phase returns immediately. */
+            ret = ABT_barrier_wait_phase(g_barrier, phase);
+            ATS_ERROR(ret, "ABT_barrier_wait_phase");
+        }
+        /* All the waiters must have arrived. */
+        assert(ATS_atomic_load(&g_num_arrivals) >= g_num_waiters * (i + 1));
+    }
+}
+
+static void thread_func(void *arg)
+{
+    pass_barrier((int)(intptr_t)arg, ABT_TRUE);
+}
+
+static void *pthread_func(void *arg)
+{
+    pass_barrier((int)(intptr_t)arg, ABT_FALSE);
+    return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+    int i, ret;
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    int num_threads = DEFAULT_NUM_THREADS;
+
+    /* Initialize */
+    ATS_read_args(argc, argv);
+    if (argc >= 2) {
+        num_xstreams = ATS_get_arg_val(ATS_ARG_N_ES);
+        num_threads = ATS_get_arg_val(ATS_ARG_N_ULT);
+        g_iter = ATS_get_arg_val(ATS_ARG_N_ITER);
+    }
+    ATS_init(argc, argv, num_xstreams);
+
+    ABT_bool support_external_thread;
+    ret = ABT_info_query_config(ABT_INFO_QUERY_KIND_ENABLED_EXTERNAL_THREAD,
+                                (void *)&support_external_thread);
+    ATS_ERROR(ret, "ABT_info_query_config");
+    const int num_pthreads = support_external_thread ? NUM_PTHREADS : 0;
+    const int num_ults = num_xstreams * num_threads;
+    g_num_waiters = num_ults + num_pthreads;
+
+    ABT_xstream *xstreams =
+        (ABT_xstream *)malloc(sizeof(ABT_xstream) * num_xstreams);
+    ABT_pool *pools = (ABT_pool *)malloc(sizeof(ABT_pool) * num_xstreams);
+    ABT_thread *threads = (ABT_thread *)malloc(sizeof(ABT_thread) * num_ults);
+    pthread_t *pthreads = (pthread_t *)malloc(sizeof(pthread_t) * NUM_PTHREADS);
+
+    ret = ABT_barrier_create((uint32_t)g_num_waiters, &g_barrier);
+    ATS_ERROR(ret, "ABT_barrier_create");
+
+    /* Create Execution Streams */
+    ret = ABT_xstream_self(&xstreams[0]);
+    ATS_ERROR(ret, "ABT_xstream_self");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_create");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_get_main_pools(xstreams[i], 1, &pools[i]);
+        ATS_ERROR(ret, "ABT_xstream_get_main_pools");
+    }
+
+    /* Create ULTs and Pthreads */
+    for (i = 0; i < num_ults; i++) {
+        ret = ABT_thread_create(pools[i % num_xstreams], thread_func,
+                                (void *)(intptr_t)i, ABT_THREAD_ATTR_NULL,
+                                &threads[i]);
+        ATS_ERROR(ret, "ABT_thread_create");
+    }
+    for (i = 0; i < num_pthreads; i++) {
+        ret = pthread_create(&pthreads[i], NULL, pthread_func,
+                             (void *)(intptr_t)(num_ults + i));
+        assert(ret == 0);
+    }
+
+    /* Join and free them.  ULTs are joined first since pthread_join() blocks
+     * the primary execution stream. */
+    for (i = 0; i < num_ults; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ATS_ERROR(ret, "ABT_thread_free");
+    }
+    for (i = 0; i < num_pthreads; i++) {
+        ret = pthread_join(pthreads[i], NULL);
+        assert(ret == 0);
+    }
+    ret = ABT_barrier_free(&g_barrier);
+    ATS_ERROR(ret, "ABT_barrier_free");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_free");
+    }
+    assert(ATS_atomic_load(&g_num_arrivals) == g_num_waiters * g_iter);
+
+    /* Finalize */
+    ret = ATS_finalize(0);
+
+    free(xstreams);
+    free(pools);
+    free(threads);
+    free(pthreads);
+
+    return ret;
+}
@@ -0,0 +1,174 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+/* This test checks continuations of futures (ABT_future_add_thread() and
+ * ABT_future_add_task()).  ULTs on multiple execution streams set compartments
+ * of a future at the same time while ULTs and tasklets are registered to the
+ * future before and after it gets ready.  Every continuation must run exactly
+ * once after the callback function is called. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS 4
+#define DEFAULT_NUM_THREADS 8
+#define DEFAULT_NUM_ITER 50
+#define NUM_CONTINUATIONS 4
+
+static ABT_future g_future;
+static int g_num_compartments;
+static volatile int g_num_callbacks = 0;
+static volatile int g_num_continuations = 0;
+static volatile int g_sum = 0;
+
+static void future_callback(void **args)
+{
+    int i, sum = 0;
+    for (i = 0; i < g_num_compartments; i++)
+        sum += (int)(intptr_t)args[i];
+    g_sum = sum;
+    ATS_atomic_fetch_add(&g_num_callbacks, 1);
+}
+
+static void continuation_func(void *arg)
+{
+    /* The callback must have been called. */
+    assert(ATS_atomic_load(&g_num_callbacks) == (int)(intptr_t)arg);
+    ABT_bool is_ready = ABT_FALSE;
+    int ret = ABT_future_test(g_future, &is_ready);
+    ATS_ERROR(ret, "ABT_future_test");
+    assert(is_ready == ABT_TRUE);
+    ATS_atomic_fetch_add(&g_num_continuations, 1);
+}
+
+static void set_func(void *arg)
+{
+    int ret = ABT_future_set(g_future, arg);
+    ATS_ERROR(ret, "ABT_future_set");
+}
+
+static void add_continuations(ABT_pool *pools, int num_pools, int iter,
+                              ABT_thread *threads, ABT_task *tasks)
+{
+    int i, ret;
+    void *arg = (void *)(intptr_t)(iter + 1);
+    for (i = 0; i < NUM_CONTINUATIONS; i++) {
+        ABT_pool pool = pools[(iter + i) % num_pools];
+        /* Named and unnamed work units. */
+        ret = ABT_future_add_thread(g_future, pool, continuation_func, arg,
+                                    ABT_THREAD_ATTR_NULL,
+                                    i % 2 ? &threads[i / 2] : NULL);
+        ATS_ERROR(ret, "ABT_future_add_thread");
+        ret = ABT_future_add_task(g_future, pool, continuation_func, arg,
+                                  i % 2 ? &tasks[i / 2] : NULL);
+        ATS_ERROR(ret, "ABT_future_add_task");
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int i, j, ret;
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    int num_threads = DEFAULT_NUM_THREADS;
+    int num_iter = DEFAULT_NUM_ITER;
+
+    /* Initialize */
+    ATS_read_args(argc, argv);
+    if (argc >= 2) {
+        num_xstreams = ATS_get_arg_val(ATS_ARG_N_ES);
+        num_threads = ATS_get_arg_val(ATS_ARG_N_ULT);
+        num_iter = ATS_get_arg_val(ATS_ARG_N_ITER);
+    }
+    ATS_init(argc, argv, num_xstreams);
+    g_num_compartments = num_xstreams * num_threads;
+
+    ABT_xstream *xstreams =
+        (ABT_xstream *)malloc(sizeof(ABT_xstream) * num_xstreams);
+    ABT_pool *pools = (ABT_pool *)malloc(sizeof(ABT_pool) * num_xstreams);
+    ABT_thread *threads =
+        (ABT_thread *)malloc(sizeof(ABT_thread) * g_num_compartments);
+    ABT_thread named_threads[NUM_CONTINUATIONS];
+    ABT_task named_tasks[NUM_CONTINUATIONS];
+
+    /* Create Execution Streams */
+    ret = ABT_xstream_self(&xstreams[0]);
+    ATS_ERROR(ret, "ABT_xstream_self");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_create");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_get_main_pools(xstreams[i], 1, &pools[i]);
+        ATS_ERROR(ret, "ABT_xstream_get_main_pools");
+    }
+
+    ret = ABT_future_create((uint32_t)g_num_compartments, future_callback,
+                            &g_future);
+    ATS_ERROR(ret, "ABT_future_create");
+
+    int expected_sum = 0;
+    for (i = 0; i < g_num_compartments; i++)
+        expected_sum += i;
+
+    for (i = 0; i < num_iter; i++) {
+        /* Half of continuations are registered before the future gets ready.
+         * The other half might be registered after it. */
+        add_continuations(pools, num_xstreams, i, named_threads, named_tasks);
+        for (j = 0; j < g_num_compartments; j++) {
+            ret = ABT_thread_create(pools[j % num_xstreams], set_func,
+                                    (void *)(intptr_t)j, ABT_THREAD_ATTR_NULL,
+                                    &threads[j]);
+            ATS_ERROR(ret, "ABT_thread_create");
+        }
+        add_continuations(pools, num_xstreams, i,
+                          &named_threads[NUM_CONTINUATIONS / 2],
+                          &named_tasks[NUM_CONTINUATIONS / 2]);
+        ret = ABT_future_wait(g_future);
+        ATS_ERROR(ret, "ABT_future_wait");
+        assert(ATS_atomic_load(&g_num_callbacks) == i + 1);
+        assert(g_sum == expected_sum);
+
+        for (j = 0; j < g_num_compartments; j++) {
+            ret = ABT_thread_free(&threads[j]);
+            ATS_ERROR(ret, "ABT_thread_free");
+        }
+        for (j = 0; j < NUM_CONTINUATIONS; j++) {
+            ret = ABT_thread_free(&named_threads[j]);
+            ATS_ERROR(ret, "ABT_thread_free");
+            ret = ABT_task_free(&named_tasks[j]);
+            ATS_ERROR(ret, "ABT_task_free");
+        }
+        /* Wait for unnamed continuations. */
+        while (ATS_atomic_load(&g_num_continuations) !=
+               (i + 1) * NUM_CONTINUATIONS * 4) {
+            ret = ABT_thread_yield();
+            ATS_ERROR(ret, "ABT_thread_yield");
+        }
+        ret = ABT_future_reset(g_future);
+        ATS_ERROR(ret, "ABT_future_reset");
+    }
+
+    ret = ABT_future_free(&g_future);
+    ATS_ERROR(ret, "ABT_future_free");
+
+    /* Join and free Execution Streams */
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_free");
+    }
+
+    /* Finalize */
+    ret = ATS_finalize(0);
+
+    free(xstreams);
+    free(pools);
+    free(threads);
+
+    return ret;
+}
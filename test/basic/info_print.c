@@ -125,6 +125,10 @@ int main(int argc, char *argv[])
         ATS_ERROR(ret, "ABT_task_free");
     }
 
+    ret = ABT_info_print_mem_stats(stdout);
+    ATS_ERROR(ret, "ABT_info_print_mem_stats");
+    fprintf(stdout, "\n");
+
     /* Join and free Execution Streams */
     for (i = 1; i < num_xstreams; i++) {
         ret = ABT_xstream_join(xstreams[i]);
@@ -0,0 +1,151 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+/* This test checks memory pools that keep buckets per NUMA node.  Two nodes
+ * are emulated by ABT_MEM_NUM_NODES, so the primary execution stream (rank 0)
+ * and the execution stream of rank 1 are on different nodes.  ULTs created by
+ * the primary execution stream are freed on the other node, so the primary
+ * execution stream must take buckets of the other node instead of allocating
+ * new memory in every round. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS 4
+#define DEFAULT_NUM_THREADS 256
+#define NUM_ROUNDS 4
+
+static int num_xstreams = DEFAULT_NUM_XSTREAMS;
+static int num_threads = DEFAULT_NUM_THREADS;
+static ABT_thread *g_threads;
+static volatile int g_counter;
+
+static void thread_func(void *arg)
+{
+    ATS_UNUSED(arg);
+    ATS_atomic_fetch_add(&g_counter, 1);
+}
+
+static void free_func(void *arg)
+{
+    int i, ret;
+    ATS_UNUSED(arg);
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_free(&g_threads[i]);
+        ATS_ERROR(ret, "ABT_thread_free");
+    }
+}
+
+static uint64_t get_num_remote_buckets(void)
+{
+    uint64_t num_remote_buckets;
+    int ret = ABT_info_query_config(ABT_INFO_QUERY_KIND_NUM_MEM_REMOTE_BUCKETS,
+                                    (void *)&num_remote_buckets);
+    ATS_ERROR(ret, "ABT_info_query_config");
+    return num_remote_buckets;
+}
+
+int main(int argc, char *argv[])
+{
+    ABT_xstream *xstreams;
+    ABT_pool *pools;
+    int i, round, ret, num_nodes;
+    uint64_t num_remote_buckets[NUM_ROUNDS];
+
+    setenv("ABT_MEM_NUM_NODES", "2", 1);
+    /* Freed elements must stay on the node of the freeing execution stream. */
+    setenv("ABT_MEM_REMOTE_FREE", "0", 1);
+    /* Execution streams keep only a few elements so that most of them are
+     * returned to the global memory pools. */
+    setenv("ABT_MEM_MAX_NUM_STACKS", "8", 1);
+    setenv("ABT_MEM_MAX_NUM_DESCS", "8", 1);
+    /* Each page holds only a few stacks (the value is rounded up to the
+     * minimum), so a partially used page of node 0 cannot serve a round. */
+    setenv("ABT_MEM_STACK_PAGE_SIZE", "1", 1);
+
+    /* Initialize */
+    ATS_read_args(argc, argv);
+    if (argc > 1) {
+        num_xstreams = ATS_get_arg_val(ATS_ARG_N_ES);
+        num_threads = ATS_get_arg_val(ATS_ARG_N_ULT);
+    }
+    /* The execution stream of rank 1 is needed. */
+    if (num_xstreams < 2)
+        num_xstreams = 2;
+    ATS_init(argc, argv, num_xstreams);
+
+    ret = ABT_info_query_config(ABT_INFO_QUERY_KIND_NUM_MEM_NODES,
+                                (void *)&num_nodes);
+    ATS_ERROR(ret, "ABT_info_query_config");
+    assert(num_nodes == 2);
+
+    xstreams = (ABT_xstream *)malloc(num_xstreams * sizeof(ABT_xstream));
+    pools = (ABT_pool *)malloc(num_xstreams * sizeof(ABT_pool));
+    g_threads = (ABT_thread *)malloc(num_threads * sizeof(ABT_thread));
+
+    ret = ABT_xstream_self(&xstreams[0]);
+    ATS_ERROR(ret, "ABT_xstream_self");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_create");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        int rank;
+        ret = ABT_xstream_get_rank(xstreams[i], &rank);
+        ATS_ERROR(ret, "ABT_xstream_get_rank");
+        assert(rank == i);
+        ret = ABT_xstream_get_main_pools(xstreams[i], 1, &pools[i]);
+        ATS_ERROR(ret, "ABT_xstream_get_main_pools");
+    }
+
+    for (round = 0; round < NUM_ROUNDS; round++) {
+        ABT_thread free_thread;
+        g_counter = 0;
+        /* This execution stream allocates ULTs on node 0. */
+        for (i = 0; i < num_threads; i++) {
+            ret = ABT_thread_create(pools[i % num_xstreams], thread_func, NULL,
+                                    ABT_THREAD_ATTR_NULL, &g_threads[i]);
+            ATS_ERROR(ret, "ABT_thread_create");
+        }
+        /* The execution stream of rank 1 frees them on node 1. */
+        ret = ABT_thread_create(pools[1], free_func, NULL,
+                                ABT_THREAD_ATTR_NULL, &free_thread);
+        ATS_ERROR(ret, "ABT_thread_create");
+        ret = ABT_thread_free(&free_thread);
+        ATS_ERROR(ret, "ABT_thread_free");
+        assert(g_counter == num_threads);
+        num_remote_buckets[round] = get_num_remote_buckets();
+        ATS_printf(1, "[round %d] # of remote buckets: %" PRIu64 "\n", round,
+                   num_remote_buckets[round]);
+        /* Node 0 has run out of elements in the first round, so the primary
+         * execution stream takes buckets from node 1 in every later round. */
+        if (round > 0 && num_threads >= 32)
+            assert(num_remote_buckets[round] > num_remote_buckets[round - 1]);
+    }
+
+    /* Trimming rebuilds buckets of each node. */
+    size_t trimmed_size;
+    ret = ABT_mem_trim(&trimmed_size);
+    ATS_ERROR(ret, "ABT_mem_trim");
+
+    /* Join and free execution streams */
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_free");
+    }
+
+    /* Finalize */
+    ret = ATS_finalize(0);
+
+    free(xstreams);
+    free(pools);
+    free(g_threads);
+
+    return ret;
+}
@@ -0,0 +1,104 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+/* This test checks memory pools whose stacks and descriptors are preallocated
+ * in ABT_init() (ABT_MEM_PREALLOC_THREADS).  ABT_init() with
+ * ABT_MEM_PREALLOC_STRICT may fail with ABT_ERR_MEM if huge pages are not
+ * sufficient, in which case Argobots is initialized again without it.  The
+ * test creates more ULTs than preallocated ones. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS 4
+#define DEFAULT_NUM_THREADS 256
+#define NUM_PREALLOC_THREADS "128"
+
+static int num_xstreams = DEFAULT_NUM_XSTREAMS;
+static int num_threads = DEFAULT_NUM_THREADS;
+
+static void thread_func(void *arg)
+{
+    int ret = ABT_thread_yield();
+    ATS_ERROR(ret, "ABT_thread_yield");
+    *(int *)arg += 1;
+}
+
+int main(int argc, char *argv[])
+{
+    ABT_xstream *xstreams;
+    ABT_pool *pools;
+    ABT_thread *threads;
+    int *counts;
+    int i, ret;
+
+    setenv("ABT_MEM_PREALLOC_THREADS", NUM_PREALLOC_THREADS, 1);
+    setenv("ABT_MEM_PREALLOC_STRICT", "1", 1);
+
+    /* Initialize */
+    ATS_read_args(argc, argv);
+    if (argc > 1) {
+        num_xstreams = ATS_get_arg_val(ATS_ARG_N_ES);
+        num_threads = ATS_get_arg_val(ATS_ARG_N_ULT);
+    }
+    ret = ABT_init(argc, argv);
+    if (ret == ABT_ERR_MEM) {
+        /* The preallocation failed.  Retry without the strict mode. */
+        ATS_printf(1, "strict preallocation failed\n");
+        setenv("ABT_MEM_PREALLOC_STRICT", "0", 1);
+    } else {
+        ATS_ERROR(ret, "ABT_init");
+        ret = ABT_finalize();
+        ATS_ERROR(ret, "ABT_finalize");
+    }
+    ATS_init(argc, argv, num_xstreams);
+
+    xstreams = (ABT_xstream *)malloc(num_xstreams * sizeof(ABT_xstream));
+    pools = (ABT_pool *)malloc(num_xstreams * sizeof(ABT_pool));
+    threads = (ABT_thread *)malloc(num_threads * sizeof(ABT_thread));
+    counts = (int *)calloc(num_threads, sizeof(int));
+
+    ret = ABT_xstream_self(&xstreams[0]);
+    ATS_ERROR(ret, "ABT_xstream_self");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_create");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_get_main_pools(xstreams[i], 1, &pools[i]);
+        ATS_ERROR(ret, "ABT_xstream_get_main_pools");
+    }
+
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_create(pools[i % num_xstreams], thread_func,
+                                &counts[i], ABT_THREAD_ATTR_NULL, &threads[i]);
+        ATS_ERROR(ret, "ABT_thread_create");
+    }
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ATS_ERROR(ret, "ABT_thread_free");
+        assert(counts[i] == 1);
+    }
+
+    /* Join and free Execution Streams */
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_free");
+    }
+
+    /* Finalize */
+    ret = ATS_finalize(0);
+
+    free(xstreams);
+    free(pools);
+    free(threads);
+    free(counts);
+
+    return ret;
+}
@@ -0,0 +1,204 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+/* This test checks the remote free of memory pools (ABT_MEM_REMOTE_FREE).
+ * ULTs and tasklets created by one execution stream are freed by ULTs on the
+ * other execution streams and by an external thread.  Work units created by an
+ * execution stream are also freed after that execution stream is freed, and
+ * then the execution stream is created again. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS 4
+#define DEFAULT_NUM_THREADS 200
+#define NUM_ROUNDS 4
+
+static int num_xstreams = DEFAULT_NUM_XSTREAMS;
+static int num_threads = DEFAULT_NUM_THREADS;
+static ABT_pool *g_pools;
+static ABT_thread *g_threads;
+static volatile int g_counter;
+
+typedef struct {
+    int begin, end;
+} range_t;
+
+static void thread_func(void *arg)
+{
+    ATS_UNUSED(arg);
+    ATS_atomic_fetch_add(&g_counter, 1);
+}
+
+/* Create work units [begin, end) in the first num_pools pools.  Even ones are
+ * ULTs and odd ones are tasklets. */
+static void create_units(int begin, int end, int num_pools)
+{
+    int i, ret;
+    for (i = begin; i < end; i++) {
+        ABT_pool pool = g_pools[i % num_pools];
+        if (i % 2 == 0) {
+            ret = ABT_thread_create(pool, thread_func, NULL,
+                                    ABT_THREAD_ATTR_NULL, &g_threads[i]);
+            ATS_ERROR(ret, "ABT_thread_create");
+        } else {
+            ret = ABT_task_create(pool, thread_func, NULL,
+                                  (ABT_task *)&g_threads[i]);
+            ATS_ERROR(ret, "ABT_task_create");
+        }
+    }
+}
+
+static void free_units(int begin, int end)
+{
+    int i, ret;
+    for (i = begin; i < end; i++) {
+        ret = ABT_thread_free(&g_threads[i]);
+        ATS_ERROR(ret, "ABT_thread_free");
+    }
+}
+
+static void free_func(void *arg)
+{
+    range_t *p_range = (range_t *)arg;
+    free_units(p_range->begin, p_range->end);
+}
+
+static void create_func(void *arg)
+{
+    /* Do not use the pool of the caller's execution stream, which is freed
+     * before the work units are freed. */
+    ATS_UNUSED(arg);
+    create_units(0, num_threads, num_xstreams - 1);
+}
+
+static void *ext_thread_func(void *arg)
+{
+    range_t *p_range = (range_t *)arg;
+    free_units(p_range->begin, p_range->end);
+    return NULL;
+}
+
+static void check_counter(int expected)
+{
+    int ret;
+    while (ATS_atomic_load(&g_counter) != expected) {
+        ret = ABT_thread_yield();
+        ATS_ERROR(ret, "ABT_thread_yield");
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    ABT_xstream *xstreams;
+    ABT_thread *free_threads;
+    range_t *ranges;
+    int i, round, ret, expected = 0;
+
+    /* Use small buckets so that elements go across bucket boundaries. */
+    setenv("ABT_MEM_REMOTE_FREE", "1", 1);
+    setenv("ABT_MEM_NUM_LOCAL_BUCKETS", "4", 1);
+    setenv("ABT_MEM_MAX_NUM_STACKS", "32", 1);
+    setenv("ABT_MEM_MAX_NUM_DESCS", "64", 1);
+
+    /* Initialize */
+    ATS_read_args(argc, argv);
+    if (argc > 1) {
+        num_xstreams = ATS_get_arg_val(ATS_ARG_N_ES);
+        num_threads = ATS_get_arg_val(ATS_ARG_N_ULT);
+    }
+    ATS_init(argc, argv, num_xstreams);
+
+    xstreams = (ABT_xstream *)malloc(num_xstreams * sizeof(ABT_xstream));
+    g_pools = (ABT_pool *)malloc(num_xstreams * sizeof(ABT_pool));
+    g_threads = (ABT_thread *)malloc(num_threads * sizeof(ABT_thread));
+    free_threads = (ABT_thread *)malloc(num_xstreams * sizeof(ABT_thread));
+    ranges = (range_t *)malloc(num_xstreams * sizeof(range_t));
+
+    ret = ABT_xstream_self(&xstreams[0]);
+    ATS_ERROR(ret, "ABT_xstream_self");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_create");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_get_main_pools(xstreams[i], 1, &g_pools[i]);
+        ATS_ERROR(ret, "ABT_xstream_get_main_pools");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ranges[i].begin = num_threads * i / num_xstreams;
+        ranges[i].end = num_threads * (i + 1) / num_xstreams;
+    }
+
+    for (round = 0; round < NUM_ROUNDS; round++) {
+        pthread_t ext_thread;
+        /* The primary ES creates work units.  The first range is freed by an
+         * external thread and the others are freed by ULTs on the other
+         * execution streams. */
+        create_units(0, num_threads, num_xstreams);
+        expected += num_threads;
+        ret = pthread_create(&ext_thread, NULL, ext_thread_func, &ranges[0]);
+        assert(ret == 0);
+        for (i = 1; i < num_xstreams; i++) {
+            ret = ABT_thread_create(g_pools[i], free_func, &ranges[i],
+                                    ABT_THREAD_ATTR_NULL, &free_threads[i]);
+            ATS_ERROR(ret, "ABT_thread_create");
+        }
+        for (i = 1; i < num_xstreams; i++) {
+            ret = ABT_thread_free(&free_threads[i]);
+            ATS_ERROR(ret, "ABT_thread_free");
+        }
+        /* Work units in the primary pool must keep running while the external
+         * thread is freeing work units. */
+        check_counter(expected);
+        ret = pthread_join(ext_thread, NULL);
+        assert(ret == 0);
+
+        if (num_xstreams > 1) {
+            /* The last ES creates work units, and they are freed after the ES
+             * is freed. */
+            int last = num_xstreams - 1;
+            ABT_thread create_thread;
+            ret = ABT_thread_create(g_pools[last], create_func, NULL,
+                                    ABT_THREAD_ATTR_NULL, &create_thread);
+            ATS_ERROR(ret, "ABT_thread_create");
+            ret = ABT_thread_free(&create_thread);
+            ATS_ERROR(ret, "ABT_thread_free");
+            expected += num_threads;
+            check_counter(expected);
+            ret = ABT_xstream_join(xstreams[last]);
+            ATS_ERROR(ret, "ABT_xstream_join");
+            ret = ABT_xstream_free(&xstreams[last]);
+            ATS_ERROR(ret, "ABT_xstream_free");
+            free_units(0, num_threads);
+            ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[last]);
+            ATS_ERROR(ret, "ABT_xstream_create");
+            ret = ABT_xstream_get_main_pools(xstreams[last], 1, &g_pools[last]);
+            ATS_ERROR(ret, "ABT_xstream_get_main_pools");
+        }
+    }
+
+    /* Join and free Execution Streams */
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_free");
+    }
+
+    /* Finalize */
+    ret = ATS_finalize(0);
+
+    free(xstreams);
+    free(g_pools);
+    free(g_threads);
+    free(free_threads);
+    free(ranges);
+
+    return ret;
+}
@@ -0,0 +1,151 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+/* This test checks memory pools that keep buckets in sharded LIFOs
+ * (ABT_MEM_SHARDED_LIFO).  ULTs on all the execution streams keep creating and
+ * freeing ULTs and tasklets in pools of other execution streams, so buckets are
+ * pushed to and popped from the sharded LIFOs concurrently.  Some ULTs use a
+ * non-default stack size to use the memory pools of stack size classes. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS 4
+#define DEFAULT_NUM_THREADS 64
+#define DEFAULT_NUM_ITER 20
+
+static int num_xstreams = DEFAULT_NUM_XSTREAMS;
+static int num_threads = DEFAULT_NUM_THREADS;
+static int num_iter = DEFAULT_NUM_ITER;
+static ABT_pool *g_pools;
+static ABT_thread_attr g_attr;
+static volatile int g_counter;
+
+static void thread_func(void *arg)
+{
+    /* Touch the stack. */
+    volatile char buffer[256];
+    int i;
+    for (i = 0; i < (int)sizeof(buffer); i++)
+        buffer[i] = (char)(intptr_t)arg;
+    ATS_atomic_fetch_add(&g_counter, 1);
+}
+
+static void churn_func(void *arg)
+{
+    int rank = (int)(intptr_t)arg;
+    int i, iter, ret;
+    ABT_thread *threads =
+        (ABT_thread *)malloc(num_threads * sizeof(ABT_thread));
+    for (iter = 0; iter < num_iter; iter++) {
+        for (i = 0; i < num_threads; i++) {
+            ABT_pool pool = g_pools[(rank + i) % num_xstreams];
+            if (i % 3 == 0) {
+                ret = ABT_thread_create(pool, thread_func, (void *)(intptr_t)i,
+                                        ABT_THREAD_ATTR_NULL, &threads[i]);
+                ATS_ERROR(ret, "ABT_thread_create");
+            } else if (i % 3 == 1) {
+                ret = ABT_thread_create(pool, thread_func, (void *)(intptr_t)i,
+                                        g_attr, &threads[i]);
+                ATS_ERROR(ret, "ABT_thread_create");
+            } else {
+                ret = ABT_task_create(pool, thread_func, (void *)(intptr_t)i,
+                                      (ABT_task *)&threads[i]);
+                ATS_ERROR(ret, "ABT_task_create");
+            }
+        }
+        for (i = 0; i < num_threads; i++) {
+            ret = ABT_thread_free(&threads[i]);
+            ATS_ERROR(ret, "ABT_thread_free");
+        }
+    }
+    free(threads);
+}
+
+int main(int argc, char *argv[])
+{
+    ABT_xstream *xstreams;
+    ABT_thread *churn_threads;
+    int i, ret;
+
+    setenv("ABT_MEM_SHARDED_LIFO", "1", 1);
+    /* Execution streams keep only a few elements so that buckets go through
+     * the global memory pools. */
+    setenv("ABT_MEM_MAX_NUM_STACKS", "8", 1);
+    setenv("ABT_MEM_MAX_NUM_DESCS", "8", 1);
+
+    /* Initialize */
+    ATS_read_args(argc, argv);
+    if (argc > 1) {
+        num_xstreams = ATS_get_arg_val(ATS_ARG_N_ES);
+        num_threads = ATS_get_arg_val(ATS_ARG_N_ULT);
+        num_iter = ATS_get_arg_val(ATS_ARG_N_ITER);
+    }
+    ATS_init(argc, argv, num_xstreams);
+
+    xstreams = (ABT_xstream *)malloc(num_xstreams * sizeof(ABT_xstream));
+    g_pools = (ABT_pool *)malloc(num_xstreams * sizeof(ABT_pool));
+    churn_threads = (ABT_thread *)malloc(num_xstreams * sizeof(ABT_thread));
+
+    size_t stacksize;
+    ret = ABT_info_query_config(ABT_INFO_QUERY_KIND_DEFAULT_THREAD_STACKSIZE,
+                                (void *)&stacksize);
+    ATS_ERROR(ret, "ABT_info_query_config");
+    ret = ABT_thread_attr_create(&g_attr);
+    ATS_ERROR(ret, "ABT_thread_attr_create");
+    ret = ABT_thread_attr_set_stacksize(g_attr, stacksize / 2);
+    ATS_ERROR(ret, "ABT_thread_attr_set_stacksize");
+
+    ret = ABT_xstream_self(&xstreams[0]);
+    ATS_ERROR(ret, "ABT_xstream_self");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_create");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_get_main_pools(xstreams[i], 1, &g_pools[i]);
+        ATS_ERROR(ret, "ABT_xstream_get_main_pools");
+    }
+
+    g_counter = 0;
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_thread_create(g_pools[i], churn_func, (void *)(intptr_t)i,
+                                ABT_THREAD_ATTR_NULL, &churn_threads[i]);
+        ATS_ERROR(ret, "ABT_thread_create");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_thread_free(&churn_threads[i]);
+        ATS_ERROR(ret, "ABT_thread_free");
+    }
+    assert(g_counter == num_xstreams * num_threads * num_iter);
+
+    /* Trimming takes all the buckets from the sharded LIFOs and pushes the
+     * remaining ones back. */
+    size_t trimmed_size;
+    ret = ABT_mem_trim(&trimmed_size);
+    ATS_ERROR(ret, "ABT_mem_trim");
+
+    ret = ABT_thread_attr_free(&g_attr);
+    ATS_ERROR(ret, "ABT_thread_attr_free");
+
+    /* Join and free execution streams */
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_free");
+    }
+
+    /* Finalize */
+    ret = ATS_finalize(0);
+
+    free(xstreams);
+    free(g_pools);
+    free(churn_threads);
+
+    return ret;
+}
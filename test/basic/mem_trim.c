@@ -0,0 +1,185 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+/* This test checks ABT_mem_trim().  A burst of ULTs makes the memory pools
+ * grow, and then idle memory is returned to the OS.  Trimmed memory must be
+ * reusable by subsequently created ULTs, and stacks that have been dirtied
+ * again must be trimmed again, including those taken in batches by
+ * ABT_thread_create_many().  The background trimming is also checked by
+ * setting ABT_MEM_TRIM_HIGH_WATER. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS 4
+#define DEFAULT_NUM_THREADS 256
+#define NUM_ROUNDS 3
+
+static int num_xstreams = DEFAULT_NUM_XSTREAMS;
+static int num_threads = DEFAULT_NUM_THREADS;
+static ABT_xstream *xstreams;
+static ABT_pool *pools;
+static ABT_thread *threads;
+static volatile int g_num_started;
+static volatile int g_counter;
+
+static void thread_func(void *arg)
+{
+    int i, ret;
+    /* Touch the stack so that it is backed by physical memory. */
+    volatile char buffer[4096];
+    for (i = 0; i < (int)sizeof(buffer); i += 64)
+        buffer[i] = (char)(intptr_t)arg;
+    /* Keep this ULT and its stack alive until all the ULTs start. */
+    ATS_atomic_fetch_add(&g_num_started, 1);
+    while (ATS_atomic_load(&g_num_started) < num_threads) {
+        ret = ABT_thread_yield();
+        ATS_ERROR(ret, "ABT_thread_yield");
+    }
+    for (i = 0; i < (int)sizeof(buffer); i += 64)
+        assert(buffer[i] == (char)(intptr_t)arg);
+    ATS_atomic_fetch_add(&g_counter, 1);
+}
+
+static void run_burst(ABT_bool create_many)
+{
+    int i, ret;
+    g_num_started = 0;
+    g_counter = 0;
+    if (create_many) {
+        ABT_pool *pool_list =
+            (ABT_pool *)malloc(num_threads * sizeof(ABT_pool));
+        void (**func_list)(void *) =
+            (void (**)(void *))malloc(num_threads * sizeof(void (*)(void *)));
+        void **arg_list = (void **)malloc(num_threads * sizeof(void *));
+        for (i = 0; i < num_threads; i++) {
+            pool_list[i] = pools[i % num_xstreams];
+            func_list[i] = thread_func;
+            arg_list[i] = (void *)(intptr_t)i;
+        }
+        ret = ABT_thread_create_many(num_threads, pool_list, func_list,
+                                     arg_list, ABT_THREAD_ATTR_NULL, threads);
+        ATS_ERROR(ret, "ABT_thread_create_many");
+        free(pool_list);
+        free(func_list);
+        free(arg_list);
+    } else {
+        for (i = 0; i < num_threads; i++) {
+            ret = ABT_thread_create(pools[i % num_xstreams], thread_func,
+                                    (void *)(intptr_t)i, ABT_THREAD_ATTR_NULL,
+                                    &threads[i]);
+            ATS_ERROR(ret, "ABT_thread_create");
+        }
+    }
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ATS_ERROR(ret, "ABT_thread_free");
+    }
+    assert(g_counter == num_threads);
+}
+
+static void create_xstreams(void)
+{
+    int i, ret;
+    ret = ABT_xstream_self(&xstreams[0]);
+    ATS_ERROR(ret, "ABT_xstream_self");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_create");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_get_main_pools(xstreams[i], 1, &pools[i]);
+        ATS_ERROR(ret, "ABT_xstream_get_main_pools");
+    }
+}
+
+static void free_xstreams(void)
+{
+    int i, ret;
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_free");
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int round, ret;
+    size_t trimmed_size;
+
+    /* Execution streams keep only a few stacks so that most of stacks are
+     * returned to the global memory pool. */
+    setenv("ABT_MEM_MAX_NUM_STACKS", "8", 1);
+    setenv("ABT_MEM_MAX_NUM_DESCS", "8", 1);
+
+    ATS_read_args(argc, argv);
+    if (argc > 1) {
+        num_xstreams = ATS_get_arg_val(ATS_ARG_N_ES);
+        num_threads = ATS_get_arg_val(ATS_ARG_N_ULT);
+    }
+    xstreams = (ABT_xstream *)malloc(num_xstreams * sizeof(ABT_xstream));
+    pools = (ABT_pool *)malloc(num_xstreams * sizeof(ABT_pool));
+    threads = (ABT_thread *)malloc(num_threads * sizeof(ABT_thread));
+
+    /* Check the background trimming.  The total size of memory pool pages
+     * always exceeds 1 byte. */
+    char max_num_xstreams[16];
+    sprintf(max_num_xstreams, "%d", num_xstreams);
+    setenv("ABT_MAX_NUM_XSTREAMS", max_num_xstreams, 1);
+    setenv("ABT_MEM_TRIM_HIGH_WATER", "1", 1);
+    ret = ABT_init(0, NULL);
+    ATS_ERROR(ret, "ABT_init");
+    create_xstreams();
+    for (round = 0; round < NUM_ROUNDS; round++) {
+        run_burst(ABT_FALSE);
+    }
+    /* Let schedulers run for a while so that the background trimming, which
+     * is performed at most once per second, happens after the bursts. */
+    double start_time = ABT_get_wtime();
+    while (ABT_get_wtime() - start_time < 1.5) {
+        ret = ABT_thread_yield();
+        ATS_ERROR(ret, "ABT_thread_yield");
+    }
+    free_xstreams();
+    ret = ABT_mem_trim(&trimmed_size);
+    ATS_ERROR(ret, "ABT_mem_trim");
+    ret = ABT_finalize();
+    ATS_ERROR(ret, "ABT_finalize");
+    unsetenv("ABT_MEM_TRIM_HIGH_WATER");
+
+    /* Initialize */
+    ATS_init(argc, argv, num_xstreams);
+
+    create_xstreams();
+    for (round = 0; round < NUM_ROUNDS * 2; round++) {
+        /* The first rounds create ULTs one by one and the others create them
+         * in batches. */
+        ABT_bool create_many = round >= NUM_ROUNDS ? ABT_TRUE : ABT_FALSE;
+        run_burst(create_many);
+        ret = ABT_mem_trim(&trimmed_size);
+        ATS_ERROR(ret, "ABT_mem_trim");
+        ATS_printf(1, "[round %d] trimmed %zu bytes\n", round, trimmed_size);
+        /* The burst has touched stacks that were trimmed in the last round. */
+        assert(trimmed_size > 0);
+        /* Nothing is left to trim. */
+        ret = ABT_mem_trim(&trimmed_size);
+        ATS_ERROR(ret, "ABT_mem_trim");
+        assert(trimmed_size == 0);
+    }
+    free_xstreams();
+
+    /* Finalize */
+    ret = ATS_finalize(0);
+
+    free(xstreams);
+    free(pools);
+    free(threads);
+
+    return ret;
+}
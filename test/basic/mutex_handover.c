@@ -0,0 +1,383 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+/* This test checks how unlock passes a mutex to its waiters.
+ * 1. Unlock hands over a mutex to a suspended ULT on the same execution stream.
+ *    ABT_mutex_trylock() and ABT_mutex_spinlock() take over the mutex while the
+ *    handover is pending.
+ * 2. Suspended ULTs on the same execution stream take a mutex in order although
+ *    the number of consecutive handovers is limited.
+ * 3. Unlock wakes up ABT_MUTEX_MAX_WAKEUPS ULTs on another execution stream.
+ * 4. A tasklet waits for a mutex behind a suspended ULT on the same execution
+ *    stream while another execution stream unlocks the mutex.  The tasklet
+ *    must take the mutex although the ULT cannot run.
+ * 5. ULTs, tasklets, and external threads lock a mutex at the same time.
+ * This test runs with ABT_MUTEX_MAX_HANDOVERS=2, first with
+ * ABT_MUTEX_MAX_WAKEUPS=1 and then with ABT_MUTEX_MAX_WAKEUPS=3. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS 3
+#define DEFAULT_NUM_THREADS 4
+#define DEFAULT_NUM_ITER 200
+#define NUM_PTHREADS 2
+#define NUM_WAITERS 5
+
+static int g_num_xstreams = DEFAULT_NUM_XSTREAMS;
+static int g_num_threads = DEFAULT_NUM_THREADS;
+static int g_iter = DEFAULT_NUM_ITER;
+static ABT_mutex g_mutex;
+static int g_counter = 0;
+static int g_order[NUM_WAITERS];
+static volatile int g_stop = 0;
+
+static void waiter_func(void *arg)
+{
+    int ret = ABT_mutex_lock(g_mutex);
+    ATS_ERROR(ret, "ABT_mutex_lock");
+    g_counter++;
+    ret = ABT_mutex_unlock(g_mutex);
+    ATS_ERROR(ret, "ABT_mutex_unlock");
+}
+
+static void ordered_waiter_func(void *arg)
+{
+    int ret = ABT_mutex_lock(g_mutex);
+    ATS_ERROR(ret, "ABT_mutex_lock");
+    g_order[g_counter++] = (int)(intptr_t)arg;
+    ret = ABT_mutex_unlock(g_mutex);
+    ATS_ERROR(ret, "ABT_mutex_unlock");
+}
+
+static void stop_func(void *arg)
+{
+    ATS_UNUSED(arg);
+    while (ATS_atomic_load(&g_stop) == 1)
+        ;
+}
+
+static void wait_until_blocked(ABT_thread thread)
+{
+    ABT_thread_state state;
+    do {
+        int ret = ABT_thread_yield();
+        ATS_ERROR(ret, "ABT_thread_yield");
+        ret = ABT_thread_get_state(thread, &state);
+        ATS_ERROR(ret, "ABT_thread_get_state");
+    } while (state != ABT_THREAD_STATE_BLOCKED);
+}
+
+/* kind = 0: the waiter takes the mutex.  kind = 1: ABT_mutex_trylock() takes
+ * it over.  kind = 2: ABT_mutex_spinlock() takes it over. */
+static void handover(ABT_pool pool, int kind)
+{
+    int ret;
+    ABT_thread waiter;
+
+    ret = ABT_mutex_lock(g_mutex);
+    ATS_ERROR(ret, "ABT_mutex_lock");
+    ret = ABT_thread_create(pool, waiter_func, NULL, ABT_THREAD_ATTR_NULL,
+                            &waiter);
+    ATS_ERROR(ret, "ABT_thread_create");
+    wait_until_blocked(waiter);
+    /* The waiter cannot run until this ULT yields. */
+    ret = ABT_mutex_unlock(g_mutex);
+    ATS_ERROR(ret, "ABT_mutex_unlock");
+    if (kind != 0) {
+        if (kind == 1) {
+            ret = ABT_mutex_trylock(g_mutex);
+            ATS_ERROR(ret, "ABT_mutex_trylock");
+        } else {
+            ret = ABT_mutex_spinlock(g_mutex);
+            ATS_ERROR(ret, "ABT_mutex_spinlock");
+        }
+        g_counter++;
+        ret = ABT_mutex_unlock(g_mutex);
+        ATS_ERROR(ret, "ABT_mutex_unlock");
+    }
+    ret = ABT_thread_free(&waiter);
+    ATS_ERROR(ret, "ABT_thread_free");
+    assert(g_counter == (kind == 0 ? 1 : 2));
+    g_counter = 0;
+}
+
+/* The waiters hand over the mutex to each other more times than
+ * ABT_MUTEX_MAX_HANDOVERS.  pool must be associated with the caller's execution
+ * stream. */
+static void handover_chain(ABT_pool pool)
+{
+    int i, ret;
+    ABT_thread waiters[NUM_WAITERS];
+
+    ret = ABT_mutex_lock(g_mutex);
+    ATS_ERROR(ret, "ABT_mutex_lock");
+    for (i = 0; i < NUM_WAITERS; i++) {
+        ret = ABT_thread_create(pool, ordered_waiter_func, (void *)(intptr_t)i,
+                                ABT_THREAD_ATTR_NULL, &waiters[i]);
+        ATS_ERROR(ret, "ABT_thread_create");
+        wait_until_blocked(waiters[i]);
+    }
+    ret = ABT_mutex_unlock(g_mutex);
+    ATS_ERROR(ret, "ABT_mutex_unlock");
+    for (i = 0; i < NUM_WAITERS; i++) {
+        ret = ABT_thread_free(&waiters[i]);
+        ATS_ERROR(ret, "ABT_thread_free");
+    }
+    assert(g_counter == NUM_WAITERS);
+    for (i = 0; i < NUM_WAITERS; i++)
+        assert(g_order[i] == i);
+    g_counter = 0;
+}
+
+/* Unlock wakes up max_wakeups waiters.  pool must be associated with an
+ * execution stream other than the caller's. */
+static void wake_n(ABT_pool pool, int max_wakeups)
+{
+    int i, ret, num_ready = 0;
+    ABT_thread waiters[NUM_WAITERS];
+    ABT_task task;
+    ABT_task_state task_state;
+
+    ret = ABT_mutex_lock(g_mutex);
+    ATS_ERROR(ret, "ABT_mutex_lock");
+    for (i = 0; i < NUM_WAITERS; i++) {
+        ret = ABT_thread_create(pool, ordered_waiter_func, (void *)(intptr_t)i,
+                                ABT_THREAD_ATTR_NULL, &waiters[i]);
+        ATS_ERROR(ret, "ABT_thread_create");
+        wait_until_blocked(waiters[i]);
+    }
+    /* Occupy the execution stream of the waiters so that woken-up waiters stay
+     * ready. */
+    ATS_atomic_store(&g_stop, 1);
+    ret = ABT_task_create(pool, stop_func, NULL, &task);
+    ATS_ERROR(ret, "ABT_task_create");
+    do {
+        ret = ABT_thread_yield();
+        ATS_ERROR(ret, "ABT_thread_yield");
+        ret = ABT_task_get_state(task, &task_state);
+        ATS_ERROR(ret, "ABT_task_get_state");
+    } while (task_state != ABT_TASK_STATE_RUNNING);
+    ret = ABT_mutex_unlock(g_mutex);
+    ATS_ERROR(ret, "ABT_mutex_unlock");
+    for (i = 0; i < NUM_WAITERS; i++) {
+        ABT_thread_state state;
+        ret = ABT_thread_get_state(waiters[i], &state);
+        ATS_ERROR(ret, "ABT_thread_get_state");
+        if (state == ABT_THREAD_STATE_READY) {
+            /* Waiters are woken up in order. */
+            assert(i == num_ready);
+            num_ready++;
+        } else {
+            assert(state == ABT_THREAD_STATE_BLOCKED);
+        }
+    }
+    assert(num_ready == max_wakeups);
+    ATS_atomic_store(&g_stop, 0);
+    ret = ABT_task_free(&task);
+    ATS_ERROR(ret, "ABT_task_free");
+    for (i = 0; i < NUM_WAITERS; i++) {
+        ret = ABT_thread_free(&waiters[i]);
+        ATS_ERROR(ret, "ABT_thread_free");
+    }
+    assert(g_counter == NUM_WAITERS);
+    g_counter = 0;
+}
+
+/* pool must be associated with an execution stream other than the caller's. */
+static void tasklet_behind_ult(ABT_pool pool)
+{
+    int ret;
+    ABT_thread waiter;
+    ABT_task task;
+    ABT_task_state state;
+
+    ret = ABT_mutex_lock(g_mutex);
+    ATS_ERROR(ret, "ABT_mutex_lock");
+    ret = ABT_thread_create(pool, waiter_func, NULL, ABT_THREAD_ATTR_NULL,
+                            &waiter);
+    ATS_ERROR(ret, "ABT_thread_create");
+    wait_until_blocked(waiter);
+    ret = ABT_task_create(pool, waiter_func, NULL, &task);
+    ATS_ERROR(ret, "ABT_task_create");
+    do {
+        ret = ABT_thread_yield();
+        ATS_ERROR(ret, "ABT_thread_yield");
+        ret = ABT_task_get_state(task, &state);
+        ATS_ERROR(ret, "ABT_task_get_state");
+    } while (state != ABT_TASK_STATE_RUNNING);
+    /* Let the tasklet start waiting for the mutex. */
+    double start_time = ABT_get_wtime();
+    while (ABT_get_wtime() - start_time < 0.01) {
+        ret = ABT_thread_yield();
+        ATS_ERROR(ret, "ABT_thread_yield");
+    }
+    ret = ABT_mutex_unlock(g_mutex);
+    ATS_ERROR(ret, "ABT_mutex_unlock");
+    ret = ABT_task_free(&task);
+    ATS_ERROR(ret, "ABT_task_free");
+    ret = ABT_thread_free(&waiter);
+    ATS_ERROR(ret, "ABT_thread_free");
+    assert(g_counter == 2);
+    g_counter = 0;
+}
+
+static void lock_and_unlock(ABT_bool can_yield)
+{
+    int i, ret;
+    for (i = 0; i < g_iter; i++) {
+        if (i % 3 == 2) {
+            ret = ABT_mutex_spinlock(g_mutex);
+            ATS_ERROR(ret, "ABT_mutex_spinlock");
+        } else {
+            ret = ABT_mutex_lock(g_mutex);
+            ATS_ERROR(ret, "ABT_mutex_lock");
+        }
+        g_counter++;
+        ret = ABT_mutex_unlock(g_mutex);
+        ATS_ERROR(ret, "ABT_mutex_unlock");
+        /* A ULT may not yield while holding the mutex since a tasklet on the
+         * same execution stream might be waiting for it. */
+        if (can_yield && i % 2 == 0) {
+            ret = ABT_thread_yield();
+            ATS_ERROR(ret, "ABT_thread_yield");
+        }
+    }
+}
+
+static void thread_func(void *arg)
+{
+    lock_and_unlock(ABT_TRUE);
+}
+
+static void task_func(void *arg)
+{
+    lock_and_unlock(ABT_FALSE);
+}
+
+static void *pthread_func(void *arg)
+{
+    lock_and_unlock(ABT_FALSE);
+    return NULL;
+}
+
+static void program(int max_wakeups)
+{
+    int i, j, ret;
+    ABT_bool support_external_thread;
+    ret = ABT_info_query_config(ABT_INFO_QUERY_KIND_ENABLED_EXTERNAL_THREAD,
+                                (void *)&support_external_thread);
+    ATS_ERROR(ret, "ABT_info_query_config");
+    const int num_pthreads = support_external_thread ? NUM_PTHREADS : 0;
+
+    ABT_xstream *xstreams =
+        (ABT_xstream *)malloc(sizeof(ABT_xstream) * g_num_xstreams);
+    ABT_pool *pools = (ABT_pool *)malloc(sizeof(ABT_pool) * g_num_xstreams);
+    ABT_thread *threads = (ABT_thread *)malloc(sizeof(ABT_thread) *
+                                               g_num_xstreams * g_num_threads);
+    pthread_t *pthreads = (pthread_t *)malloc(sizeof(pthread_t) * NUM_PTHREADS);
+
+    ret = ABT_xstream_self(&xstreams[0]);
+    ATS_ERROR(ret, "ABT_xstream_self");
+    for (i = 1; i < g_num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_create");
+    }
+    for (i = 0; i < g_num_xstreams; i++) {
+        ret = ABT_xstream_get_main_pools(xstreams[i], 1, &pools[i]);
+        ATS_ERROR(ret, "ABT_xstream_get_main_pools");
+    }
+    ret = ABT_mutex_create(&g_mutex);
+    ATS_ERROR(ret, "ABT_mutex_create");
+
+    for (i = 0; i < 3; i++)
+        handover(pools[0], i);
+    handover_chain(pools[0]);
+    wake_n(pools[1], max_wakeups);
+    tasklet_behind_ult(pools[1]);
+
+    /* ULTs and tasklets on all the execution streams and external threads. */
+    for (i = 0; i < g_num_xstreams; i++) {
+        for (j = 0; j < g_num_threads; j++) {
+            ABT_thread *p_thread = &threads[i * g_num_threads + j];
+            if (j % 2 == 0) {
+                ret = ABT_thread_create(pools[i], thread_func, NULL,
+                                        ABT_THREAD_ATTR_NULL, p_thread);
+                ATS_ERROR(ret, "ABT_thread_create");
+            } else {
+                ret = ABT_task_create(pools[i], task_func, NULL, p_thread);
+                ATS_ERROR(ret, "ABT_task_create");
+            }
+        }
+    }
+    for (i = 0; i < num_pthreads; i++) {
+        ret = pthread_create(&pthreads[i], NULL, pthread_func, NULL);
+        assert(ret == 0);
+    }
+    /* ULTs and tasklets are joined first since pthread_join() blocks the
+     * primary execution stream. */
+    for (i = 0; i < g_num_xstreams * g_num_threads; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ATS_ERROR(ret, "ABT_thread_free");
+    }
+    for (i = 0; i < num_pthreads; i++) {
+        ret = pthread_join(pthreads[i], NULL);
+        assert(ret == 0);
+    }
+    assert(g_counter ==
+           (g_num_xstreams * g_num_threads + num_pthreads) * g_iter);
+    g_counter = 0;
+
+    ret = ABT_mutex_free(&g_mutex);
+    ATS_ERROR(ret, "ABT_mutex_free");
+    for (i = 1; i < g_num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_free");
+    }
+    free(xstreams);
+    free(pools);
+    free(threads);
+    free(pthreads);
+}
+
+int main(int argc, char *argv[])
+{
+    int ret;
+
+    ATS_read_args(argc, argv);
+    if (argc >= 2) {
+        g_num_xstreams = ATS_get_arg_val(ATS_ARG_N_ES);
+        g_num_threads = ATS_get_arg_val(ATS_ARG_N_ULT);
+        g_iter = ATS_get_arg_val(ATS_ARG_N_ITER);
+    }
+    /* tasklet_behind_ult() needs two execution streams. */
+    if (g_num_xstreams < 2)
+        g_num_xstreams = 2;
+    char max_num_xstreams[16];
+    sprintf(max_num_xstreams, "%d", g_num_xstreams);
+    setenv("ABT_MAX_NUM_XSTREAMS", max_num_xstreams, 1);
+    setenv("ABT_MUTEX_MAX_HANDOVERS", "2", 1);
+
+    /* Each unlock wakes up one ULT. */
+    setenv("ABT_MUTEX_MAX_WAKEUPS", "1", 1);
+    ret = ABT_init(0, NULL);
+    ATS_ERROR(ret, "ABT_init");
+    program(1);
+    ret = ABT_finalize();
+    ATS_ERROR(ret, "ABT_finalize");
+
+    /* Each unlock wakes up at most three ULTs. */
+    setenv("ABT_MUTEX_MAX_WAKEUPS", "3", 1);
+    ATS_init(argc, argv, g_num_xstreams);
+    program(3);
+
+    /* Finalize */
+    return ATS_finalize(0);
+}
@@ -0,0 +1,306 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+/* This test checks queued mutexes (ABT_mutex_attr_set_queued()).  ULTs and
+ * external threads lock queued mutexes at the same time.  ULTs sometimes yield
+ * while holding a mutex so that the other ULTs are suspended in the queue.
+ * Before that, ABT_mutex_spinlock() is called on a mutex that is being handed
+ * over to a suspended ULT on the same execution stream, and a tasklet locks a
+ * mutex behind a suspended ULT on the same execution stream. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS 4
+#define DEFAULT_NUM_THREADS 8
+#define DEFAULT_NUM_ITER 200
+#define NUM_PTHREADS 2
+
+typedef struct {
+    ABT_mutex mutex;
+    ABT_bool is_recursive;
+    int counter;
+} mutex_set;
+static mutex_set g_mutex_sets[2];
+#define NUM_MUTEX_SETS ((int)(sizeof(g_mutex_sets) / sizeof(g_mutex_sets[0])))
+
+static int g_iter = DEFAULT_NUM_ITER;
+
+static void lock_and_unlock(int i, ABT_bool can_yield)
+{
+    int j, k, ret;
+    for (j = 0; j < NUM_MUTEX_SETS; j++) {
+        mutex_set *p_set = &g_mutex_sets[j];
+        int num_nests = p_set->is_recursive ? 3 : 1;
+        for (k = 0; k < num_nests; k++) {
+            if (k == 0 && i % 4 == 3) {
+                /* Do not retry trylock; a ULT must not busy-wait on a queued
+                 * mutex. */
+                ret = ABT_mutex_trylock(p_set->mutex);
+                if (ret != ABT_SUCCESS)
+                    ret = ABT_mutex_lock(p_set->mutex);
+            } else {
+                ret = ABT_mutex_lock(p_set->mutex);
+            }
+            ATS_ERROR(ret, "ABT_mutex_lock");
+        }
+        p_set->counter++;
+        if (can_yield && i % 2 == 0) {
+            ret = ABT_thread_yield();
+            ATS_ERROR(ret, "ABT_thread_yield");
+        }
+        for (k = 0; k < num_nests; k++) {
+            ret = ABT_mutex_unlock(p_set->mutex);
+            ATS_ERROR(ret, "ABT_mutex_unlock");
+        }
+    }
+}
+
+static void waiter_func(void *arg)
+{
+    mutex_set *p_set = (mutex_set *)arg;
+    int ret = ABT_mutex_lock(p_set->mutex);
+    ATS_ERROR(ret, "ABT_mutex_lock");
+    p_set->counter++;
+    ret = ABT_mutex_unlock(p_set->mutex);
+    ATS_ERROR(ret, "ABT_mutex_unlock");
+}
+
+/* Two ULTs on the primary execution stream. */
+static void spinlock_on_handover(mutex_set *p_set)
+{
+    int ret;
+    ABT_xstream xstream;
+    ABT_pool pool;
+    ABT_thread waiter;
+    ABT_thread_state state;
+    ret = ABT_xstream_self(&xstream);
+    ATS_ERROR(ret, "ABT_xstream_self");
+    ret = ABT_xstream_get_main_pools(xstream, 1, &pool);
+    ATS_ERROR(ret, "ABT_xstream_get_main_pools");
+
+    ret = ABT_mutex_lock(p_set->mutex);
+    ATS_ERROR(ret, "ABT_mutex_lock");
+    ret = ABT_thread_create(pool, waiter_func, (void *)p_set,
+                            ABT_THREAD_ATTR_NULL, &waiter);
+    ATS_ERROR(ret, "ABT_thread_create");
+    do {
+        ret = ABT_thread_yield();
+        ATS_ERROR(ret, "ABT_thread_yield");
+        ret = ABT_thread_get_state(waiter, &state);
+        ATS_ERROR(ret, "ABT_thread_get_state");
+    } while (state != ABT_THREAD_STATE_BLOCKED);
+    /* The mutex is handed over to the suspended waiter, which cannot run until
+     * this ULT yields. */
+    ret = ABT_mutex_unlock(p_set->mutex);
+    ATS_ERROR(ret, "ABT_mutex_unlock");
+    ret = ABT_mutex_spinlock(p_set->mutex);
+    ATS_ERROR(ret, "ABT_mutex_spinlock");
+    p_set->counter++;
+    ret = ABT_mutex_unlock(p_set->mutex);
+    ATS_ERROR(ret, "ABT_mutex_unlock");
+    ret = ABT_thread_free(&waiter);
+    ATS_ERROR(ret, "ABT_thread_free");
+    assert(p_set->counter == 2);
+    p_set->counter = 0;
+}
+
+/* A tasklet waits behind a suspended ULT on an execution stream of pool, which
+ * must not be the caller's one. */
+static void tasklet_behind_ult(mutex_set *p_set, ABT_pool pool)
+{
+    int ret;
+    ABT_thread waiter;
+    ABT_thread_state thread_state;
+    ABT_task task;
+    ABT_task_state task_state;
+
+    ret = ABT_mutex_lock(p_set->mutex);
+    ATS_ERROR(ret, "ABT_mutex_lock");
+    ret = ABT_thread_create(pool, waiter_func, (void *)p_set,
+                            ABT_THREAD_ATTR_NULL, &waiter);
+    ATS_ERROR(ret, "ABT_thread_create");
+    do {
+        ret = ABT_thread_yield();
+        ATS_ERROR(ret, "ABT_thread_yield");
+        ret = ABT_thread_get_state(waiter, &thread_state);
+        ATS_ERROR(ret, "ABT_thread_get_state");
+    } while (thread_state != ABT_THREAD_STATE_BLOCKED);
+    ret = ABT_task_create(pool, waiter_func, (void *)p_set, &task);
+    ATS_ERROR(ret, "ABT_task_create");
+    do {
+        ret = ABT_thread_yield();
+        ATS_ERROR(ret, "ABT_thread_yield");
+        ret = ABT_task_get_state(task, &task_state);
+        ATS_ERROR(ret, "ABT_task_get_state");
+    } while (task_state != ABT_TASK_STATE_RUNNING);
+    /* Let the tasklet start waiting for the mutex.  The mutex is then handed
+     * over to the suspended ULT, which cannot run until the tasklet takes the
+     * mutex. */
+    double start_time = ABT_get_wtime();
+    while (ABT_get_wtime() - start_time < 0.01) {
+        ret = ABT_thread_yield();
+        ATS_ERROR(ret, "ABT_thread_yield");
+    }
+    ret = ABT_mutex_unlock(p_set->mutex);
+    ATS_ERROR(ret, "ABT_mutex_unlock");
+    ret = ABT_task_free(&task);
+    ATS_ERROR(ret, "ABT_task_free");
+    ret = ABT_thread_free(&waiter);
+    ATS_ERROR(ret, "ABT_thread_free");
+    assert(p_set->counter == 2);
+    p_set->counter = 0;
+}
+
+static void thread_func(void *arg)
+{
+    int i;
+    for (i = 0; i < g_iter; i++)
+        lock_and_unlock(i, ABT_TRUE);
+}
+
+static void *pthread_func(void *arg)
+{
+    int i;
+    for (i = 0; i < g_iter; i++)
+        lock_and_unlock(i, ABT_FALSE);
+    return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+    int i, j, ret;
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    int num_threads = DEFAULT_NUM_THREADS;
+
+    /* Initialize */
+    ATS_read_args(argc, argv);
+    if (argc >= 2) {
+        num_xstreams = ATS_get_arg_val(ATS_ARG_N_ES);
+        num_threads = ATS_get_arg_val(ATS_ARG_N_ULT);
+        g_iter = ATS_get_arg_val(ATS_ARG_N_ITER);
+    }
+    ATS_init(argc, argv, num_xstreams);
+
+    ABT_bool support_external_thread;
+    ret = ABT_info_query_config(ABT_INFO_QUERY_KIND_ENABLED_EXTERNAL_THREAD,
+                                (void *)&support_external_thread);
+    ATS_ERROR(ret, "ABT_info_query_config");
+    const int num_pthreads = support_external_thread ? NUM_PTHREADS : 0;
+
+    /* Create queued mutexes. */
+    for (i = 0; i < NUM_MUTEX_SETS; i++) {
+        ABT_mutex_attr mutex_attr;
+        ABT_bool is_queued = ABT_FALSE;
+        ret = ABT_mutex_attr_create(&mutex_attr);
+        ATS_ERROR(ret, "ABT_mutex_attr_create");
+        ret = ABT_mutex_attr_get_queued(mutex_attr, &is_queued);
+        ATS_ERROR(ret, "ABT_mutex_attr_get_queued");
+        assert(is_queued == ABT_FALSE);
+        ret = ABT_mutex_attr_set_queued(mutex_attr, ABT_TRUE);
+        ATS_ERROR(ret, "ABT_mutex_attr_set_queued");
+        g_mutex_sets[i].is_recursive = (i % 2 == 1) ? ABT_TRUE : ABT_FALSE;
+        ret = ABT_mutex_attr_set_recursive(mutex_attr,
+                                           g_mutex_sets[i].is_recursive);
+        ATS_ERROR(ret, "ABT_mutex_attr_set_recursive");
+        ret = ABT_mutex_create_with_attr(mutex_attr, &g_mutex_sets[i].mutex);
+        ATS_ERROR(ret, "ABT_mutex_create_with_attr");
+        ret = ABT_mutex_attr_free(&mutex_attr);
+        ATS_ERROR(ret, "ABT_mutex_attr_free");
+        g_mutex_sets[i].counter = 0;
+
+        /* The mutex must keep the queued property. */
+        ret = ABT_mutex_get_attr(g_mutex_sets[i].mutex, &mutex_attr);
+        ATS_ERROR(ret, "ABT_mutex_get_attr");
+        ret = ABT_mutex_attr_get_queued(mutex_attr, &is_queued);
+        ATS_ERROR(ret, "ABT_mutex_attr_get_queued");
+        assert(is_queued == ABT_TRUE);
+        ret = ABT_mutex_attr_free(&mutex_attr);
+        ATS_ERROR(ret, "ABT_mutex_attr_free");
+    }
+
+    for (i = 0; i < NUM_MUTEX_SETS; i++)
+        spinlock_on_handover(&g_mutex_sets[i]);
+
+    ABT_xstream *xstreams =
+        (ABT_xstream *)malloc(sizeof(ABT_xstream) * num_xstreams);
+    ABT_pool *pools = (ABT_pool *)malloc(sizeof(ABT_pool) * num_xstreams);
+    ABT_thread *threads =
+        (ABT_thread *)malloc(sizeof(ABT_thread) * num_xstreams * num_threads);
+    pthread_t *pthreads = (pthread_t *)malloc(sizeof(pthread_t) * NUM_PTHREADS);
+
+    /* Create Execution Streams */
+    ret = ABT_xstream_self(&xstreams[0]);
+    ATS_ERROR(ret, "ABT_xstream_self");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_create");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_get_main_pools(xstreams[i], 1, &pools[i]);
+        ATS_ERROR(ret, "ABT_xstream_get_main_pools");
+    }
+    if (num_xstreams >= 2) {
+        for (i = 0; i < NUM_MUTEX_SETS; i++)
+            tasklet_behind_ult(&g_mutex_sets[i], pools[1]);
+    }
+
+    /* Create ULTs and Pthreads */
+    for (i = 0; i < num_xstreams; i++) {
+        for (j = 0; j < num_threads; j++) {
+            ret = ABT_thread_create(pools[i], thread_func, NULL,
+                                    ABT_THREAD_ATTR_NULL,
+                                    &threads[i * num_threads + j]);
+            ATS_ERROR(ret, "ABT_thread_create");
+        }
+    }
+    for (i = 0; i < num_pthreads; i++) {
+        ret = pthread_create(&pthreads[i], NULL, pthread_func, NULL);
+        assert(ret == 0);
+    }
+
+    /* Join and free them.  ULTs are joined first since pthread_join() blocks
+     * the primary execution stream. */
+    for (i = 0; i < num_xstreams * num_threads; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ATS_ERROR(ret, "ABT_thread_free");
+    }
+    for (i = 0; i < num_pthreads; i++) {
+        ret = pthread_join(pthreads[i], NULL);
+        assert(ret == 0);
+    }
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_free");
+    }
+
+    /* Validation */
+    int expected = (num_xstreams * num_threads + num_pthreads) * g_iter;
+    int num_errors = 0;
+    for (i = 0; i < NUM_MUTEX_SETS; i++) {
+        if (g_mutex_sets[i].counter != expected) {
+            printf("counter[%d] = %d vs. expected = %d\n", i,
+                   g_mutex_sets[i].counter, expected);
+            num_errors++;
+        }
+        ret = ABT_mutex_free(&g_mutex_sets[i].mutex);
+        ATS_ERROR(ret, "ABT_mutex_free");
+    }
+
+    /* Finalize */
+    ret = ATS_finalize(num_errors);
+
+    free(xstreams);
+    free(pools);
+    free(threads);
+    free(pthreads);
+
+    return ret;
+}
@@ -0,0 +1,182 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+/* This test checks ABT_POOL_FIFO_LOCKFREE.  It first checks the order and the
+ * size of the pool with all the access types and then runs ULTs on a pool that
+ * is shared by all the execution streams.  The number of ULTs is larger than
+ * the capacity of the internal ring buffer so that the overflow path is also
+ * tested. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS 4
+#define DEFAULT_NUM_THREADS 3000
+#define NUM_YIELDS 4
+
+static int num_threads = DEFAULT_NUM_THREADS;
+static volatile int g_counter = 0;
+
+static void thread_func(void *arg)
+{
+    int i, ret;
+    ATS_UNUSED(arg);
+    for (i = 0; i < NUM_YIELDS; i++) {
+        ret = ABT_thread_yield();
+        ATS_ERROR(ret, "ABT_thread_yield");
+    }
+    ATS_atomic_fetch_add(&g_counter, 1);
+}
+
+static void check_order(ABT_pool_access access)
+{
+    int i, ret;
+    size_t size;
+    ABT_pool pool, main_pool;
+    ABT_xstream xstream;
+    ABT_thread *threads =
+        (ABT_thread *)malloc(sizeof(ABT_thread) * num_threads);
+
+    ret = ABT_pool_create_basic(ABT_POOL_FIFO_LOCKFREE, access, ABT_FALSE,
+                                &pool);
+    ATS_ERROR(ret, "ABT_pool_create_basic");
+    ret = ABT_xstream_self(&xstream);
+    ATS_ERROR(ret, "ABT_xstream_self");
+    ret = ABT_xstream_get_main_pools(xstream, 1, &main_pool);
+    ATS_ERROR(ret, "ABT_xstream_get_main_pools");
+
+    /* No scheduler is associated with pool, so the ULTs stay in pool. */
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_create(pool, thread_func, NULL, ABT_THREAD_ATTR_NULL,
+                                &threads[i]);
+        ATS_ERROR(ret, "ABT_thread_create");
+    }
+    ret = ABT_pool_get_size(pool, &size);
+    ATS_ERROR(ret, "ABT_pool_get_size");
+    assert(size == (size_t)num_threads);
+
+    /* Pop the first half one by one and the rest at once. */
+    for (i = 0; i < num_threads / 2; i++) {
+        ABT_thread thread;
+        ret = ABT_pool_pop_thread(pool, &thread);
+        ATS_ERROR(ret, "ABT_pool_pop_thread");
+        assert(thread == threads[i]);
+    }
+    size_t num_popped;
+    ABT_thread *popped = (ABT_thread *)malloc(sizeof(ABT_thread) * num_threads);
+    ret = ABT_pool_pop_threads(pool, popped, num_threads, &num_popped);
+    ATS_ERROR(ret, "ABT_pool_pop_threads");
+    assert(num_popped == (size_t)(num_threads - num_threads / 2));
+    for (i = 0; i < (int)num_popped; i++) {
+        assert(popped[i] == threads[num_threads / 2 + i]);
+    }
+    ret = ABT_pool_get_size(pool, &size);
+    ATS_ERROR(ret, "ABT_pool_get_size");
+    assert(size == 0);
+
+    /* Push them back at once and pop them again. */
+    ret = ABT_pool_push_threads(pool, threads, num_threads);
+    ATS_ERROR(ret, "ABT_pool_push_threads");
+    for (i = 0; i < num_threads; i++) {
+        ABT_thread thread;
+        ret = ABT_pool_pop_thread(pool, &thread);
+        ATS_ERROR(ret, "ABT_pool_pop_thread");
+        assert(thread == threads[i]);
+    }
+    free(popped);
+
+    /* Run and free the ULTs. */
+    ret = ABT_pool_push_threads(main_pool, threads, num_threads);
+    ATS_ERROR(ret, "ABT_pool_push_threads");
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ATS_ERROR(ret, "ABT_thread_free");
+    }
+    free(threads);
+    ret = ABT_pool_free(&pool);
+    ATS_ERROR(ret, "ABT_pool_free");
+}
+
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    ABT_xstream *xstreams;
+    ABT_thread *threads;
+    ABT_pool pool;
+    int i, ret;
+
+    /* Initialize */
+    ATS_read_args(argc, argv);
+    if (argc > 1) {
+        num_xstreams = ATS_get_arg_val(ATS_ARG_N_ES);
+        num_threads = ATS_get_arg_val(ATS_ARG_N_ULT);
+    }
+    ATS_init(argc, argv, num_xstreams);
+
+    ATS_printf(1,
+               "# of ESs : %d\n"
+               "# of ULTs: %d\n",
+               num_xstreams, num_threads);
+
+    ABT_pool_access accesses[] = { ABT_POOL_ACCESS_PRIV, ABT_POOL_ACCESS_SPSC,
+                                   ABT_POOL_ACCESS_MPSC, ABT_POOL_ACCESS_SPMC,
+                                   ABT_POOL_ACCESS_MPMC };
+    for (i = 0; i < (int)(sizeof(accesses) / sizeof(accesses[0])); i++) {
+        check_order(accesses[i]);
+    }
+
+    xstreams = (ABT_xstream *)malloc(num_xstreams * sizeof(ABT_xstream));
+    threads = (ABT_thread *)malloc(num_threads * sizeof(ABT_thread));
+
+    /* All the execution streams share the same pool. */
+    ret = ABT_pool_create_basic(ABT_POOL_FIFO_LOCKFREE, ABT_POOL_ACCESS_MPMC,
+                                ABT_TRUE, &pool);
+    ATS_ERROR(ret, "ABT_pool_create_basic");
+    ret = ABT_xstream_self(&xstreams[0]);
+    ATS_ERROR(ret, "ABT_xstream_self");
+    ret = ABT_xstream_set_main_sched_basic(xstreams[0], ABT_SCHED_DEFAULT, 1,
+                                           &pool);
+    ATS_ERROR(ret, "ABT_xstream_set_main_sched_basic");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create_basic(ABT_SCHED_DEFAULT, 1, &pool,
+                                       ABT_SCHED_CONFIG_NULL, &xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_create_basic");
+    }
+
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_create(pool, thread_func, NULL, ABT_THREAD_ATTR_NULL,
+                                &threads[i]);
+        ATS_ERROR(ret, "ABT_thread_create");
+    }
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ATS_ERROR(ret, "ABT_thread_free");
+    }
+
+    /* Join and free Execution Streams */
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_free");
+    }
+
+    /* Validation */
+    int expected = num_threads * 6;
+    if (g_counter != expected) {
+        fprintf(stderr, "expected=%d vs. g_counter=%d\n", expected, g_counter);
+    }
+    assert(g_counter == expected);
+
+    /* Finalize */
+    ret = ATS_finalize(0);
+
+    free(xstreams);
+    free(threads);
+
+    return ret;
+}
@@ -0,0 +1,113 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+/* This test checks that ABT_pool_pop_wait_thread() and ABT_SCHED_BASIC_WAIT
+ * work with all the built-in pools.  A ULT running on a blocking scheduler
+ * waits on a pool for a long time while the primary ULT pushes a ULT to that
+ * pool after a while.  Pushing a ULT must wake the waiter up. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define NUM_ROUNDS 4
+#define WAIT_TIME 10.0
+
+static ABT_pool_kind kinds[] = {
+    ABT_POOL_FIFO,       ABT_POOL_FIFO_WAIT,  ABT_POOL_RANDWS,
+    ABT_POOL_PRIO_QUEUE, ABT_POOL_FIFO_LOCKFREE,
+};
+
+static ABT_pool g_sched_pool;
+static ABT_pool g_wait_pool;
+static volatile int g_counter = 0;
+
+static void sleep_ms(int ms)
+{
+    struct timespec ts = { 0, ms * 1000 * 1000 };
+    nanosleep(&ts, NULL);
+}
+
+static void pushed_func(void *arg)
+{
+    ATS_UNUSED(arg);
+    ATS_atomic_fetch_add(&g_counter, 1);
+}
+
+static void waiter_func(void *arg)
+{
+    ABT_thread thread;
+    int ret;
+    ATS_UNUSED(arg);
+    double start_time = ABT_get_wtime();
+    ret = ABT_pool_pop_wait_thread(g_wait_pool, &thread, WAIT_TIME);
+    ATS_ERROR(ret, "ABT_pool_pop_wait_thread");
+    /* The waiter must be woken up by a push, not by timeout. */
+    assert(thread != ABT_THREAD_NULL);
+    assert(ABT_get_wtime() - start_time < WAIT_TIME);
+    ret = ABT_pool_push_thread(g_sched_pool, thread);
+    ATS_ERROR(ret, "ABT_pool_push_thread");
+}
+
+int main(int argc, char *argv[])
+{
+    int k, round, ret;
+
+    /* Initialize */
+    ATS_read_args(argc, argv);
+    ATS_init(argc, argv, 2);
+
+    for (k = 0; k < (int)(sizeof(kinds) / sizeof(kinds[0])); k++) {
+        ABT_xstream xstream;
+        ABT_thread thread;
+        ret = ABT_pool_create_basic(kinds[k], ABT_POOL_ACCESS_MPMC, ABT_TRUE,
+                                    &g_sched_pool);
+        ATS_ERROR(ret, "ABT_pool_create_basic");
+        ret = ABT_pool_create_basic(kinds[k], ABT_POOL_ACCESS_MPMC, ABT_FALSE,
+                                    &g_wait_pool);
+        ATS_ERROR(ret, "ABT_pool_create_basic");
+        ret = ABT_xstream_create_basic(ABT_SCHED_BASIC_WAIT, 1, &g_sched_pool,
+                                       ABT_SCHED_CONFIG_NULL, &xstream);
+        ATS_ERROR(ret, "ABT_xstream_create_basic");
+
+        /* Waiting on an empty pool times out. */
+        ret = ABT_pool_pop_wait_thread(g_wait_pool, &thread, 1.0e-3);
+        ATS_ERROR(ret, "ABT_pool_pop_wait_thread");
+        assert(thread == ABT_THREAD_NULL);
+
+        for (round = 0; round < NUM_ROUNDS; round++) {
+            ABT_thread waiter, pushed;
+            /* Let the scheduler block. */
+            sleep_ms(10);
+            ret = ABT_thread_create(g_sched_pool, waiter_func, NULL,
+                                    ABT_THREAD_ATTR_NULL, &waiter);
+            ATS_ERROR(ret, "ABT_thread_create");
+            /* Let the waiter block. */
+            sleep_ms(10);
+            ret = ABT_thread_create(g_wait_pool, pushed_func, NULL,
+                                    ABT_THREAD_ATTR_NULL, &pushed);
+            ATS_ERROR(ret, "ABT_thread_create");
+            ret = ABT_thread_free(&waiter);
+            ATS_ERROR(ret, "ABT_thread_free");
+            ret = ABT_thread_free(&pushed);
+            ATS_ERROR(ret, "ABT_thread_free");
+        }
+
+        ret = ABT_xstream_join(xstream);
+        ATS_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstream);
+        ATS_ERROR(ret, "ABT_xstream_free");
+        ret = ABT_pool_free(&g_wait_pool);
+        ATS_ERROR(ret, "ABT_pool_free");
+    }
+    assert(g_counter == NUM_ROUNDS * (int)(sizeof(kinds) / sizeof(kinds[0])));
+
+    /* Finalize */
+    ret = ATS_finalize(0);
+
+    return ret;
+}
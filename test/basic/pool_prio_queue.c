@@ -0,0 +1,169 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+/* This test checks ABT_POOL_PRIO_QUEUE.  It first pushes ULTs that have various
+ * priorities to a pool that is not associated with any scheduler and checks
+ * that they are popped in ascending order of priorities and in FIFO order
+ * among the same priority.  It then runs ULTs with schedulers that use this
+ * pool. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS 4
+#define DEFAULT_NUM_THREADS 200
+#define NUM_PRIORITIES 5
+#define NUM_YIELDS 4
+
+static volatile int g_counter = 0;
+
+static void thread_func(void *arg)
+{
+    int i, ret;
+    for (i = 0; i < NUM_YIELDS; i++) {
+        ret = ABT_thread_yield();
+        ATS_ERROR(ret, "ABT_thread_yield");
+    }
+    ATS_atomic_fetch_add(&g_counter, 1);
+}
+
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    int num_threads = DEFAULT_NUM_THREADS;
+    ABT_xstream *xstreams;
+    ABT_pool *pools;
+    ABT_thread *threads;
+    ABT_thread_attr attr;
+    int i, ret;
+
+    /* Initialize */
+    ATS_read_args(argc, argv);
+    if (argc > 1) {
+        num_xstreams = ATS_get_arg_val(ATS_ARG_N_ES);
+        num_threads = ATS_get_arg_val(ATS_ARG_N_ULT);
+    }
+    ATS_init(argc, argv, num_xstreams);
+
+    xstreams = (ABT_xstream *)malloc(num_xstreams * sizeof(ABT_xstream));
+    pools = (ABT_pool *)malloc(num_xstreams * sizeof(ABT_pool));
+    threads = (ABT_thread *)malloc(num_threads * sizeof(ABT_thread));
+
+    ret = ABT_thread_attr_create(&attr);
+    ATS_ERROR(ret, "ABT_thread_attr_create");
+
+    /* Check the order of work units. */
+    ABT_pool pool;
+    ret = ABT_pool_create_basic(ABT_POOL_PRIO_QUEUE, ABT_POOL_ACCESS_MPMC,
+                                ABT_FALSE, &pool);
+    ATS_ERROR(ret, "ABT_pool_create_basic");
+    for (i = 0; i < num_threads; i++) {
+        int64_t priority = (i * 3) % NUM_PRIORITIES - NUM_PRIORITIES / 2;
+        ret = ABT_thread_attr_set_priority(attr, priority);
+        ATS_ERROR(ret, "ABT_thread_attr_set_priority");
+        ret = ABT_thread_create(pool, thread_func, (void *)(intptr_t)i, attr,
+                                &threads[i]);
+        ATS_ERROR(ret, "ABT_thread_create");
+    }
+    size_t pool_size;
+    ret = ABT_pool_get_size(pool, &pool_size);
+    ATS_ERROR(ret, "ABT_pool_get_size");
+    assert(pool_size == (size_t)num_threads);
+
+    int64_t prev_priority = INT64_MIN;
+    intptr_t prev_index = -1;
+    for (i = 0; i < num_threads; i++) {
+        ABT_thread thread;
+        int64_t priority, attr_priority;
+        void *arg;
+        ret = ABT_pool_pop_thread(pool, &thread);
+        ATS_ERROR(ret, "ABT_pool_pop_thread");
+        assert(thread != ABT_THREAD_NULL);
+        ret = ABT_thread_get_priority(thread, &priority);
+        ATS_ERROR(ret, "ABT_thread_get_priority");
+        ret = ABT_thread_get_arg(thread, &arg);
+        ATS_ERROR(ret, "ABT_thread_get_arg");
+
+        ABT_thread_attr thread_attr;
+        ret = ABT_thread_get_attr(thread, &thread_attr);
+        ATS_ERROR(ret, "ABT_thread_get_attr");
+        ret = ABT_thread_attr_get_priority(thread_attr, &attr_priority);
+        ATS_ERROR(ret, "ABT_thread_attr_get_priority");
+        ret = ABT_thread_attr_free(&thread_attr);
+        ATS_ERROR(ret, "ABT_thread_attr_free");
+        assert(priority == attr_priority);
+
+        if (priority < prev_priority ||
+            (priority == prev_priority && (intptr_t)arg < prev_index)) {
+            fprintf(stderr,
+                    "wrong order: (%d, %d) is popped after (%d, %d)\n",
+                    (int)priority, (int)(intptr_t)arg, (int)prev_priority,
+                    (int)prev_index);
+        }
+        assert(priority > prev_priority ||
+               (priority == prev_priority && (intptr_t)arg > prev_index));
+        prev_priority = priority;
+        prev_index = (intptr_t)arg;
+    }
+    ABT_bool is_empty;
+    ABT_thread thread;
+    ret = ABT_pool_is_empty(pool, &is_empty);
+    ATS_ERROR(ret, "ABT_pool_is_empty");
+    assert(is_empty == ABT_TRUE);
+    ret = ABT_pool_pop_thread(pool, &thread);
+    ATS_ERROR(ret, "ABT_pool_pop_thread");
+    assert(thread == ABT_THREAD_NULL);
+
+    /* Run the popped ULTs on schedulers that use priority queue pools. */
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_pool_create_basic(ABT_POOL_PRIO_QUEUE, ABT_POOL_ACCESS_MPMC,
+                                    ABT_TRUE, &pools[i]);
+        ATS_ERROR(ret, "ABT_pool_create_basic");
+    }
+    ret = ABT_xstream_self(&xstreams[0]);
+    ATS_ERROR(ret, "ABT_xstream_self");
+    ret = ABT_xstream_set_main_sched_basic(xstreams[0], ABT_SCHED_DEFAULT, 1,
+                                           &pools[0]);
+    ATS_ERROR(ret, "ABT_xstream_set_main_sched_basic");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create_basic(ABT_SCHED_DEFAULT, 1, &pools[i],
+                                       ABT_SCHED_CONFIG_NULL, &xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_create_basic");
+    }
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_set_priority(threads[i], i % NUM_PRIORITIES);
+        ATS_ERROR(ret, "ABT_thread_set_priority");
+        ret = ABT_pool_push_thread(pools[i % num_xstreams], threads[i]);
+        ATS_ERROR(ret, "ABT_pool_push_thread");
+    }
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ATS_ERROR(ret, "ABT_thread_free");
+    }
+    assert(g_counter == num_threads);
+
+    /* Join and free Execution Streams */
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_free");
+    }
+    ret = ABT_pool_free(&pool);
+    ATS_ERROR(ret, "ABT_pool_free");
+    ret = ABT_thread_attr_free(&attr);
+    ATS_ERROR(ret, "ABT_thread_attr_free");
+
+    /* Finalize */
+    ret = ATS_finalize(0);
+
+    free(xstreams);
+    free(pools);
+    free(threads);
+
+    return ret;
+}
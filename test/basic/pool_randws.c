@@ -0,0 +1,225 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+/* This test checks ABT_POOL_RANDWS with ABT_SCHED_RANDWS.  It runs a recursive
+ * fork-join program so that work units are pushed to and popped from the
+ * owner's deque and stolen by other execution streams.  It then calls
+ * ABT_thread_yield_to(), which removes a work unit from the middle of a pool.
+ * Finally, it checks that ULTs that yield on a RANDWS pool of ABT_SCHED_BASIC
+ * run in a round-robin manner.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS 4
+#define DEFAULT_NUM_THREADS 16
+#define FIB_N 16
+#define NUM_YIELDS 8
+
+static int num_threads = DEFAULT_NUM_THREADS;
+static ABT_thread *g_threads;
+static volatile int g_counter = 0;
+static int *g_num_yields;
+
+typedef struct {
+    int n;
+    int ret;
+} fib_arg_t;
+
+static void fib(void *arg)
+{
+    fib_arg_t *p_arg = (fib_arg_t *)arg;
+    if (p_arg->n <= 1) {
+        p_arg->ret = p_arg->n;
+        return;
+    }
+    int ret;
+    ABT_pool pool;
+    ABT_thread thread;
+    fib_arg_t child1 = { p_arg->n - 1, 0 }, child2 = { p_arg->n - 2, 0 };
+
+    ret = ABT_self_get_last_pool(&pool);
+    ATS_ERROR(ret, "ABT_self_get_last_pool");
+    ret = ABT_thread_create(pool, fib, &child1, ABT_THREAD_ATTR_NULL, &thread);
+    ATS_ERROR(ret, "ABT_thread_create");
+    fib(&child2);
+    ret = ABT_thread_free(&thread);
+    ATS_ERROR(ret, "ABT_thread_free");
+    p_arg->ret = child1.ret + child2.ret;
+}
+
+static void yield_to_func(void *arg)
+{
+    int i, ret, id = (int)(intptr_t)arg;
+    for (i = 1; i < 4; i++) {
+        ABT_thread next = g_threads[(id + i) % num_threads];
+        ABT_thread_state state = ABT_THREAD_STATE_TERMINATED;
+        if (next != ABT_THREAD_NULL) {
+            ret = ABT_thread_get_state(next, &state);
+            ATS_ERROR(ret, "ABT_thread_get_state");
+        }
+        if (state == ABT_THREAD_STATE_READY) {
+            /* yield_to() may fail if next is popped concurrently. */
+            ABT_thread_yield_to(next);
+        } else {
+            ret = ABT_thread_yield();
+            ATS_ERROR(ret, "ABT_thread_yield");
+        }
+    }
+    ATS_atomic_fetch_add(&g_counter, 1);
+}
+
+static void yield_func(void *arg)
+{
+    int i, j, ret, id = (int)(intptr_t)arg;
+    for (i = 0; i < NUM_YIELDS; i++) {
+        /* A ULT that yields must not run again before the others. */
+        for (j = 0; j < num_threads; j++)
+            assert(g_num_yields[j] == i || g_num_yields[j] == i + 1);
+        g_num_yields[id] = i + 1;
+        ret = ABT_thread_yield();
+        ATS_ERROR(ret, "ABT_thread_yield");
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    ABT_xstream *xstreams;
+    ABT_sched *scheds;
+    ABT_pool *pools, *my_pools;
+    int i, k, ret;
+
+    /* Initialize */
+    ATS_read_args(argc, argv);
+    if (argc > 1) {
+        num_xstreams = ATS_get_arg_val(ATS_ARG_N_ES);
+        num_threads = ATS_get_arg_val(ATS_ARG_N_ULT);
+    }
+    /* One more execution stream runs ABT_SCHED_BASIC. */
+    ATS_init(argc, argv, num_xstreams + 1);
+
+    xstreams = (ABT_xstream *)malloc(num_xstreams * sizeof(ABT_xstream));
+    scheds = (ABT_sched *)malloc(num_xstreams * sizeof(ABT_sched));
+    pools = (ABT_pool *)malloc(num_xstreams * sizeof(ABT_pool));
+    g_threads = (ABT_thread *)malloc(num_threads * sizeof(ABT_thread));
+
+    /* Create pools and schedulers */
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_pool_create_basic(ABT_POOL_RANDWS, ABT_POOL_ACCESS_MPMC,
+                                    ABT_TRUE, &pools[i]);
+        ATS_ERROR(ret, "ABT_pool_create_basic");
+    }
+    my_pools = (ABT_pool *)malloc(num_xstreams * sizeof(ABT_pool));
+    for (i = 0; i < num_xstreams; i++) {
+        for (k = 0; k < num_xstreams; k++) {
+            my_pools[k] = pools[(i + k) % num_xstreams];
+        }
+        ret = ABT_sched_create_basic(ABT_SCHED_RANDWS, num_xstreams, my_pools,
+                                     ABT_SCHED_CONFIG_NULL, &scheds[i]);
+        ATS_ERROR(ret, "ABT_sched_create_basic");
+    }
+    free(my_pools);
+
+    /* Create Execution Streams */
+    ret = ABT_xstream_self(&xstreams[0]);
+    ATS_ERROR(ret, "ABT_xstream_self");
+    ret = ABT_xstream_set_main_sched(xstreams[0], scheds[0]);
+    ATS_ERROR(ret, "ABT_xstream_set_main_sched");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(scheds[i], &xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_create");
+    }
+
+    /* Fork-join */
+    fib_arg_t arg = { FIB_N, 0 };
+    fib(&arg);
+    int fib_ans[2] = { 0, 1 };
+    for (i = 2; i <= FIB_N; i++) {
+        int tmp = fib_ans[0] + fib_ans[1];
+        fib_ans[0] = fib_ans[1];
+        fib_ans[1] = tmp;
+    }
+    if (arg.ret != fib_ans[1]) {
+        fprintf(stderr, "fib(%d): expected=%d vs. ret=%d\n", FIB_N,
+                fib_ans[1], arg.ret);
+    }
+    assert(arg.ret == fib_ans[1]);
+
+    /* ULTs created here are pushed to the deque of this execution stream's
+     * pool, so yield_to() needs to remove a ULT from the deque. */
+    ABT_pool pool;
+    ret = ABT_self_get_last_pool(&pool);
+    ATS_ERROR(ret, "ABT_self_get_last_pool");
+    for (i = 0; i < num_threads; i++) {
+        g_threads[i] = ABT_THREAD_NULL;
+    }
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_create(pool, yield_to_func, (void *)(intptr_t)i,
+                                ABT_THREAD_ATTR_NULL, &g_threads[i]);
+        ATS_ERROR(ret, "ABT_thread_create");
+    }
+    /* Other ULTs may access g_threads until all of them finish. */
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_join(g_threads[i]);
+        ATS_ERROR(ret, "ABT_thread_join");
+    }
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_free(&g_threads[i]);
+        ATS_ERROR(ret, "ABT_thread_free");
+    }
+    assert(g_counter == num_threads);
+
+    /* ABT_SCHED_BASIC pops work units without ABT_POOL_CONTEXT_OWNER_PRIMARY.
+     * The execution stream associated with the pool must still own it. */
+    ABT_pool basic_pool;
+    ABT_sched basic_sched;
+    ABT_xstream basic_xstream;
+    ret = ABT_pool_create_basic(ABT_POOL_RANDWS, ABT_POOL_ACCESS_MPMC,
+                                ABT_TRUE, &basic_pool);
+    ATS_ERROR(ret, "ABT_pool_create_basic");
+    ret = ABT_sched_create_basic(ABT_SCHED_BASIC, 1, &basic_pool,
+                                 ABT_SCHED_CONFIG_NULL, &basic_sched);
+    ATS_ERROR(ret, "ABT_sched_create_basic");
+    g_num_yields = (int *)calloc(num_threads, sizeof(int));
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_create(basic_pool, yield_func, (void *)(intptr_t)i,
+                                ABT_THREAD_ATTR_NULL, &g_threads[i]);
+        ATS_ERROR(ret, "ABT_thread_create");
+    }
+    ret = ABT_xstream_create(basic_sched, &basic_xstream);
+    ATS_ERROR(ret, "ABT_xstream_create");
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_free(&g_threads[i]);
+        ATS_ERROR(ret, "ABT_thread_free");
+        assert(g_num_yields[i] == NUM_YIELDS);
+    }
+    ret = ABT_xstream_join(basic_xstream);
+    ATS_ERROR(ret, "ABT_xstream_join");
+    ret = ABT_xstream_free(&basic_xstream);
+    ATS_ERROR(ret, "ABT_xstream_free");
+    free(g_num_yields);
+
+    /* Join and free Execution Streams */
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_free");
+    }
+
+    /* Finalize */
+    ret = ATS_finalize(0);
+
+    free(xstreams);
+    free(scheds);
+    free(pools);
+    free(g_threads);
+
+    return ret;
+}
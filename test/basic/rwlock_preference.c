@@ -0,0 +1,201 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+/* This test checks readers-writer locks created with preferences
+ * (ABT_rwlock_create_with_preference()).  First, a reader locks a lock while a
+ * writer is waiting for the lock on the primary execution stream; a reader
+ * must go ahead of the writer only if the lock prefers readers.  Second,
+ * readers and writers on multiple execution streams lock the lock at the same
+ * time and readers check that no writer is updating data. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS 4
+#define DEFAULT_NUM_THREADS 8
+#define DEFAULT_NUM_ITER 500
+
+static ABT_rwlock g_rwlock;
+static int g_order[2];
+static int g_num_ordered;
+static int g_writer_started;
+static int g_iter = DEFAULT_NUM_ITER;
+static volatile int g_data[2];
+
+static void order_func(void *arg)
+{
+    int is_writer = (int)(intptr_t)arg, ret;
+    if (is_writer) {
+        g_writer_started = 1;
+        ret = ABT_rwlock_wrlock(g_rwlock);
+        ATS_ERROR(ret, "ABT_rwlock_wrlock");
+    } else {
+        ret = ABT_rwlock_rdlock(g_rwlock);
+        ATS_ERROR(ret, "ABT_rwlock_rdlock");
+    }
+    g_order[g_num_ordered++] = is_writer;
+    ret = ABT_rwlock_unlock(g_rwlock);
+    ATS_ERROR(ret, "ABT_rwlock_unlock");
+}
+
+static void check_order(ABT_pool pool, ABT_rwlock_preference preference)
+{
+    int ret;
+    ABT_thread writer, reader;
+
+    ret = ABT_rwlock_create_with_preference(preference, &g_rwlock);
+    ATS_ERROR(ret, "ABT_rwlock_create_with_preference");
+    g_num_ordered = 0;
+    g_writer_started = 0;
+
+    ret = ABT_rwlock_rdlock(g_rwlock);
+    ATS_ERROR(ret, "ABT_rwlock_rdlock");
+    /* The writer blocks since this ULT holds the lock. */
+    ret = ABT_thread_create(pool, order_func, (void *)(intptr_t)1,
+                            ABT_THREAD_ATTR_NULL, &writer);
+    ATS_ERROR(ret, "ABT_thread_create");
+    while (!g_writer_started) {
+        ret = ABT_thread_yield();
+        ATS_ERROR(ret, "ABT_thread_yield");
+    }
+    ret = ABT_thread_create(pool, order_func, (void *)(intptr_t)0,
+                            ABT_THREAD_ATTR_NULL, &reader);
+    ATS_ERROR(ret, "ABT_thread_create");
+    ret = ABT_thread_yield();
+    ATS_ERROR(ret, "ABT_thread_yield");
+    ret = ABT_rwlock_unlock(g_rwlock);
+    ATS_ERROR(ret, "ABT_rwlock_unlock");
+
+    ret = ABT_thread_free(&writer);
+    ATS_ERROR(ret, "ABT_thread_free");
+    ret = ABT_thread_free(&reader);
+    ATS_ERROR(ret, "ABT_thread_free");
+    ret = ABT_rwlock_free(&g_rwlock);
+    ATS_ERROR(ret, "ABT_rwlock_free");
+
+    assert(g_num_ordered == 2);
+    if (preference == ABT_RWLOCK_PREFER_READER) {
+        assert(g_order[0] == 0 && g_order[1] == 1);
+    } else {
+        assert(g_order[0] == 1 && g_order[1] == 0);
+    }
+}
+
+static void thread_func(void *arg)
+{
+    int tid = (int)(intptr_t)arg;
+    int i, ret;
+    for (i = 0; i < g_iter; i++) {
+        if ((i + tid) % 10 == 0) {
+            ret = ABT_rwlock_wrlock(g_rwlock);
+            ATS_ERROR(ret, "ABT_rwlock_wrlock");
+            g_data[0]++;
+            if (i % 2 == 0) {
+                ret = ABT_thread_yield();
+                ATS_ERROR(ret, "ABT_thread_yield");
+            }
+            g_data[1]++;
+        } else {
+            ret = ABT_rwlock_rdlock(g_rwlock);
+            ATS_ERROR(ret, "ABT_rwlock_rdlock");
+            assert(g_data[0] == g_data[1]);
+            if (i % 2 == 0) {
+                /* This ULT might release the lock on another execution
+                 * stream. */
+                ret = ABT_thread_yield();
+                ATS_ERROR(ret, "ABT_thread_yield");
+            }
+            assert(g_data[0] == g_data[1]);
+        }
+        ret = ABT_rwlock_unlock(g_rwlock);
+        ATS_ERROR(ret, "ABT_rwlock_unlock");
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int i, p, ret;
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    int num_threads = DEFAULT_NUM_THREADS;
+    ABT_rwlock_preference preferences[] = { ABT_RWLOCK_PREFER_READER,
+                                            ABT_RWLOCK_PREFER_WRITER };
+
+    /* Initialize */
+    ATS_read_args(argc, argv);
+    if (argc >= 2) {
+        num_xstreams = ATS_get_arg_val(ATS_ARG_N_ES);
+        num_threads = ATS_get_arg_val(ATS_ARG_N_ULT);
+        g_iter = ATS_get_arg_val(ATS_ARG_N_ITER);
+    }
+    ATS_init(argc, argv, num_xstreams);
+
+    ABT_xstream *xstreams =
+        (ABT_xstream *)malloc(sizeof(ABT_xstream) * num_xstreams);
+    ABT_pool *pools = (ABT_pool *)malloc(sizeof(ABT_pool) * num_xstreams);
+    ABT_thread *threads =
+        (ABT_thread *)malloc(sizeof(ABT_thread) * num_xstreams * num_threads);
+
+    ret = ABT_xstream_self(&xstreams[0]);
+    ATS_ERROR(ret, "ABT_xstream_self");
+    ret = ABT_xstream_get_main_pools(xstreams[0], 1, &pools[0]);
+    ATS_ERROR(ret, "ABT_xstream_get_main_pools");
+
+    /* Check the order on the primary execution stream. */
+    for (p = 0; p < 2; p++)
+        check_order(pools[0], preferences[p]);
+
+    /* Create Execution Streams */
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_create");
+        ret = ABT_xstream_get_main_pools(xstreams[i], 1, &pools[i]);
+        ATS_ERROR(ret, "ABT_xstream_get_main_pools");
+    }
+
+    for (p = 0; p < 2; p++) {
+        ret = ABT_rwlock_create_with_preference(preferences[p], &g_rwlock);
+        ATS_ERROR(ret, "ABT_rwlock_create_with_preference");
+        g_data[0] = g_data[1] = 0;
+        for (i = 0; i < num_xstreams * num_threads; i++) {
+            ret = ABT_thread_create(pools[i % num_xstreams], thread_func,
+                                    (void *)(intptr_t)i, ABT_THREAD_ATTR_NULL,
+                                    &threads[i]);
+            ATS_ERROR(ret, "ABT_thread_create");
+        }
+        for (i = 0; i < num_xstreams * num_threads; i++) {
+            ret = ABT_thread_free(&threads[i]);
+            ATS_ERROR(ret, "ABT_thread_free");
+        }
+        ret = ABT_rwlock_free(&g_rwlock);
+        ATS_ERROR(ret, "ABT_rwlock_free");
+        /* Each ULT writes once in ten iterations. */
+        int expected = 0;
+        for (i = 0; i < num_xstreams * num_threads; i++) {
+            int j;
+            for (j = 0; j < g_iter; j++)
+                expected += ((j + i) % 10 == 0) ? 1 : 0;
+        }
+        assert(g_data[0] == expected && g_data[1] == expected);
+    }
+
+    /* Join and free Execution Streams */
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_free");
+    }
+
+    /* Finalize */
+    ret = ATS_finalize(0);
+
+    free(xstreams);
+    free(pools);
+    free(threads);
+
+    return ret;
+}
@@ -0,0 +1,131 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+/* This test checks the idle policy of ABT_SCHED_BASIC.  Execution streams are
+ * repeatedly left idle so that their schedulers block, and then work units are
+ * pushed by the primary ULT and by ULTs running on other execution streams.
+ * All the work units must be executed and the execution streams must be
+ * joined even if their schedulers are blocking. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS 4
+#define DEFAULT_NUM_THREADS 16
+#define NUM_ROUNDS 5
+
+static int num_xstreams = DEFAULT_NUM_XSTREAMS;
+static ABT_pool *g_pools;
+static volatile int g_counter = 0;
+
+static void child_func(void *arg)
+{
+    ATS_UNUSED(arg);
+    ATS_atomic_fetch_add(&g_counter, 1);
+}
+
+static void thread_func(void *arg)
+{
+    int ret, rank;
+    ret = ABT_xstream_self_rank(&rank);
+    ATS_ERROR(ret, "ABT_xstream_self_rank");
+    /* Push a child ULT to a private pool of another execution stream. */
+    ret = ABT_thread_create(g_pools[(rank + 1) % num_xstreams + 1], child_func,
+                            NULL, ABT_THREAD_ATTR_NULL, NULL);
+    ATS_ERROR(ret, "ABT_thread_create");
+    ATS_atomic_fetch_add(&g_counter, 1);
+}
+
+int main(int argc, char *argv[])
+{
+    int num_threads = DEFAULT_NUM_THREADS;
+    ABT_xstream *xstreams;
+    ABT_sched_config config;
+    ABT_thread *threads;
+    int i, round, ret;
+
+    /* Initialize */
+    ATS_read_args(argc, argv);
+    if (argc > 1) {
+        num_xstreams = ATS_get_arg_val(ATS_ARG_N_ES);
+        num_threads = ATS_get_arg_val(ATS_ARG_N_ULT);
+    }
+    ATS_init(argc, argv, num_xstreams);
+
+    xstreams = (ABT_xstream *)malloc(num_xstreams * sizeof(ABT_xstream));
+    threads = (ABT_thread *)malloc(num_threads * sizeof(ABT_thread));
+    /* g_pools[0] is shared by all the execution streams. */
+    g_pools = (ABT_pool *)malloc((num_xstreams + 1) * sizeof(ABT_pool));
+    for (i = 0; i < num_xstreams + 1; i++) {
+        ret = ABT_pool_create_basic(ABT_POOL_FIFO, ABT_POOL_ACCESS_MPMC,
+                                    ABT_TRUE, &g_pools[i]);
+        ATS_ERROR(ret, "ABT_pool_create_basic");
+    }
+
+    ret = ABT_sched_config_create(&config, ABT_sched_basic_idle_spin, 10,
+                                  ABT_sched_basic_idle_yield, 2,
+                                  ABT_sched_basic_idle_max_park, 1.0e-2,
+                                  ABT_sched_config_var_end);
+    ATS_ERROR(ret, "ABT_sched_config_create");
+    ret = ABT_xstream_self(&xstreams[0]);
+    ATS_ERROR(ret, "ABT_xstream_self");
+    for (i = 0; i < num_xstreams; i++) {
+        ABT_sched sched;
+        ABT_pool pools[2] = { g_pools[i + 1], g_pools[0] };
+        ret = ABT_sched_create_basic(ABT_SCHED_BASIC, 2, pools, config, &sched);
+        ATS_ERROR(ret, "ABT_sched_create_basic");
+        if (i == 0) {
+            ret = ABT_xstream_set_main_sched(xstreams[0], sched);
+            ATS_ERROR(ret, "ABT_xstream_set_main_sched");
+        } else {
+            ret = ABT_xstream_create(sched, &xstreams[i]);
+            ATS_ERROR(ret, "ABT_xstream_create");
+        }
+    }
+    ret = ABT_sched_config_free(&config);
+    ATS_ERROR(ret, "ABT_sched_config_free");
+
+    for (round = 0; round < NUM_ROUNDS; round++) {
+        /* Let the schedulers block. */
+        struct timespec ts = { 0, 20 * 1000 * 1000 };
+        nanosleep(&ts, NULL);
+        for (i = 0; i < num_threads; i++) {
+            ret = ABT_thread_create(g_pools[i % 2 ? 0 : i % num_xstreams + 1],
+                                    thread_func, NULL, ABT_THREAD_ATTR_NULL,
+                                    &threads[i]);
+            ATS_ERROR(ret, "ABT_thread_create");
+        }
+        for (i = 0; i < num_threads; i++) {
+            ret = ABT_thread_free(&threads[i]);
+            ATS_ERROR(ret, "ABT_thread_free");
+        }
+    }
+
+    /* Join and free Execution Streams */
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_free");
+    }
+    /* Execute child ULTs left in the private pool of the primary execution
+     * stream. */
+    while (g_counter != num_threads * NUM_ROUNDS * 2) {
+        ret = ABT_thread_yield();
+        ATS_ERROR(ret, "ABT_thread_yield");
+    }
+
+    /* Finalize */
+    ret = ATS_finalize(0);
+
+    free(xstreams);
+    free(threads);
+    free(g_pools);
+
+    return ret;
+}
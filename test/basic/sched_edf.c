@@ -0,0 +1,170 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+/* This test checks ABT_SCHED_EDF.  The primary execution stream runs ULTs that
+ * have deadlines, ULTs that have already missed their deadlines, and ULTs that
+ * do not have deadlines.  ULTs that have deadlines must run first in the
+ * earliest-deadline-first order, late ULTs must run next via the late pool,
+ * and the others must run last.  Half of the ULTs that do not have deadlines
+ * are created in the deadline pool, so the scheduler needs to move them to the
+ * background pool. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_THREADS 32
+
+enum { KIND_DEADLINE, KIND_LATE, KIND_BACKGROUND };
+
+typedef struct {
+    int kind;
+    int index;
+} thread_arg_t;
+
+static int num_threads = DEFAULT_NUM_THREADS;
+static thread_arg_t **g_order;
+static int g_counter = 0;
+
+static void thread_func(void *arg)
+{
+    g_order[g_counter++] = (thread_arg_t *)arg;
+}
+
+int main(int argc, char *argv[])
+{
+    ABT_xstream xstream;
+    ABT_sched sched;
+    ABT_sched_config config;
+    ABT_pool pools[3];
+    ABT_thread *threads;
+    thread_arg_t *args;
+    ABT_thread_attr attr;
+    int i, kind, ret;
+
+    /* Initialize */
+    ATS_read_args(argc, argv);
+    if (argc > 1) {
+        num_threads = ATS_get_arg_val(ATS_ARG_N_ULT);
+    }
+    ATS_init(argc, argv, 1);
+
+    int num_total_threads = num_threads * 3;
+    threads = (ABT_thread *)malloc(num_total_threads * sizeof(ABT_thread));
+    args = (thread_arg_t *)malloc(num_total_threads * sizeof(thread_arg_t));
+    g_order =
+        (thread_arg_t **)malloc(num_total_threads * sizeof(thread_arg_t *));
+
+    /* pools[0]: deadline pool, pools[1]: background pool,
+     * pools[2]: late pool */
+    ret = ABT_pool_create_basic(ABT_POOL_PRIO_QUEUE, ABT_POOL_ACCESS_MPMC,
+                                ABT_TRUE, &pools[0]);
+    ATS_ERROR(ret, "ABT_pool_create_basic");
+    for (i = 1; i < 3; i++) {
+        ret = ABT_pool_create_basic(ABT_POOL_FIFO, ABT_POOL_ACCESS_MPMC,
+                                    ABT_TRUE, &pools[i]);
+        ATS_ERROR(ret, "ABT_pool_create_basic");
+    }
+    ret = ABT_sched_config_create(&config, ABT_sched_edf_late_pool, 2,
+                                  ABT_sched_config_var_end);
+    ATS_ERROR(ret, "ABT_sched_config_create");
+    ret = ABT_sched_create_basic(ABT_SCHED_EDF, 3, pools, config, &sched);
+    ATS_ERROR(ret, "ABT_sched_create_basic");
+    ret = ABT_sched_config_free(&config);
+    ATS_ERROR(ret, "ABT_sched_config_free");
+    ret = ABT_xstream_self(&xstream);
+    ATS_ERROR(ret, "ABT_xstream_self");
+    ret = ABT_xstream_set_main_sched(xstream, sched);
+    ATS_ERROR(ret, "ABT_xstream_set_main_sched");
+
+    /* Create ULTs.  The primary ULT does not yield until all of them are
+     * created. */
+    ret = ABT_thread_attr_create(&attr);
+    ATS_ERROR(ret, "ABT_thread_attr_create");
+    double now = ABT_get_wtime();
+    for (i = 0; i < num_total_threads; i++) {
+        thread_arg_t *p_arg = &args[i];
+        p_arg->kind = i % 3;
+        p_arg->index = i / 3;
+        ABT_pool pool = pools[0];
+        if (p_arg->kind == KIND_DEADLINE) {
+            /* A later ULT has an earlier deadline. */
+            ret = ABT_thread_attr_set_deadline(attr, now + 1000.0 -
+                                                         p_arg->index);
+            ATS_ERROR(ret, "ABT_thread_attr_set_deadline");
+        } else if (p_arg->kind == KIND_LATE) {
+            ret = ABT_thread_attr_set_deadline(attr, now - 1000.0 +
+                                                         p_arg->index);
+            ATS_ERROR(ret, "ABT_thread_attr_set_deadline");
+        } else {
+            /* ULTs of odd indices are in the background pool from the
+             * beginning. */
+            if (p_arg->index % 2 == 1)
+                pool = pools[1];
+            ret = ABT_thread_attr_set_priority(attr, 0);
+            ATS_ERROR(ret, "ABT_thread_attr_set_priority");
+        }
+        ret = ABT_thread_create(pool, thread_func, (void *)p_arg, attr,
+                                &threads[i]);
+        ATS_ERROR(ret, "ABT_thread_create");
+    }
+    ret = ABT_thread_attr_free(&attr);
+    ATS_ERROR(ret, "ABT_thread_attr_free");
+
+    for (i = 0; i < num_total_threads; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ATS_ERROR(ret, "ABT_thread_free");
+    }
+    assert(g_counter == num_total_threads);
+
+    /* Check the execution order. */
+    for (kind = 0; kind < 3; kind++) {
+        for (i = 0; i < num_threads; i++) {
+            thread_arg_t *p_arg = g_order[kind * num_threads + i];
+            int expected_index = i;
+            if (kind == KIND_DEADLINE) {
+                expected_index = num_threads - 1 - i;
+            } else if (kind == KIND_BACKGROUND) {
+                /* ULTs moved from the deadline pool run after the others. */
+                expected_index = (i < num_threads / 2)
+                                     ? (i * 2 + 1)
+                                     : ((i - num_threads / 2) * 2);
+            }
+            if (p_arg->kind != kind || p_arg->index != expected_index) {
+                fprintf(stderr, "[%d] expected (%d, %d) but (%d, %d)\n",
+                        kind * num_threads + i, kind, expected_index,
+                        p_arg->kind, p_arg->index);
+            }
+            assert(p_arg->kind == kind && p_arg->index == expected_index);
+        }
+    }
+
+    /* Check the statistics. */
+    FILE *fp = tmpfile();
+    assert(fp);
+    ret = ABT_info_print_sched(fp, sched);
+    ATS_ERROR(ret, "ABT_info_print_sched");
+    rewind(fp);
+    char line[256];
+    int num_misses = -1;
+    while (fgets(line, sizeof(line), fp)) {
+        char *p = strstr(line, "deadline_misses:");
+        if (p)
+            num_misses = atoi(p + strlen("deadline_misses:"));
+    }
+    fclose(fp);
+    assert(num_misses == num_threads);
+
+    /* Finalize */
+    ret = ATS_finalize(0);
+
+    free(threads);
+    free(args);
+    free(g_order);
+
+    return ret;
+}
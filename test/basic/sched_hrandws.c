@@ -0,0 +1,123 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+/* This test checks ABT_SCHED_HRANDWS.  All the ULTs are created in the pool of
+ * the primary execution stream, so the other execution streams need to steal
+ * them.  Some schedulers steal half of the work units at once. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS 4
+#define DEFAULT_NUM_THREADS 64
+
+static int num_threads = DEFAULT_NUM_THREADS;
+static volatile int g_counter = 0;
+
+static void thread_func(void *arg)
+{
+    ATS_UNUSED(arg);
+    int i, ret;
+    for (i = 0; i < 3; i++) {
+        ret = ABT_thread_yield();
+        ATS_ERROR(ret, "ABT_thread_yield");
+    }
+    ATS_atomic_fetch_add(&g_counter, 1);
+}
+
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    ABT_xstream *xstreams;
+    ABT_pool *pools, *my_pools;
+    ABT_thread *threads;
+    int i, k, ret;
+
+    /* Initialize */
+    ATS_read_args(argc, argv);
+    if (argc > 1) {
+        num_xstreams = ATS_get_arg_val(ATS_ARG_N_ES);
+        num_threads = ATS_get_arg_val(ATS_ARG_N_ULT);
+    }
+    ATS_init(argc, argv, num_xstreams);
+
+    xstreams = (ABT_xstream *)malloc(num_xstreams * sizeof(ABT_xstream));
+    pools = (ABT_pool *)malloc(num_xstreams * sizeof(ABT_pool));
+    my_pools = (ABT_pool *)malloc(num_xstreams * sizeof(ABT_pool));
+    threads = (ABT_thread *)malloc(num_threads * sizeof(ABT_thread));
+
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_pool_create_basic(ABT_POOL_RANDWS, ABT_POOL_ACCESS_MPMC,
+                                    ABT_TRUE, &pools[i]);
+        ATS_ERROR(ret, "ABT_pool_create_basic");
+    }
+
+    /* Create Execution Streams */
+    ret = ABT_xstream_self(&xstreams[0]);
+    ATS_ERROR(ret, "ABT_xstream_self");
+    for (i = 0; i < num_xstreams; i++) {
+        for (k = 0; k < num_xstreams; k++) {
+            my_pools[k] = pools[(i + k) % num_xstreams];
+        }
+        ABT_sched_config config = ABT_SCHED_CONFIG_NULL;
+        if (i % 2 == 1) {
+            ret = ABT_sched_config_create(&config, ABT_sched_randws_steal_num,
+                                          0, ABT_sched_config_var_end);
+            ATS_ERROR(ret, "ABT_sched_config_create");
+        }
+        if (i == 0) {
+            ret = ABT_xstream_set_main_sched_basic(xstreams[0],
+                                                   ABT_SCHED_HRANDWS,
+                                                   num_xstreams, my_pools);
+            ATS_ERROR(ret, "ABT_xstream_set_main_sched_basic");
+        } else {
+            ret = ABT_xstream_create_basic(ABT_SCHED_HRANDWS, num_xstreams,
+                                           my_pools, config, &xstreams[i]);
+            ATS_ERROR(ret, "ABT_xstream_create_basic");
+        }
+        if (config != ABT_SCHED_CONFIG_NULL) {
+            ret = ABT_sched_config_free(&config);
+            ATS_ERROR(ret, "ABT_sched_config_free");
+        }
+    }
+
+    /* Create ULTs */
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_create(pools[0], thread_func, NULL,
+                                ABT_THREAD_ATTR_NULL, &threads[i]);
+        ATS_ERROR(ret, "ABT_thread_create");
+    }
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ATS_ERROR(ret, "ABT_thread_free");
+    }
+
+    /* Join and free Execution Streams */
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_free");
+    }
+
+    /* Validation */
+    if (g_counter != num_threads) {
+        fprintf(stderr, "expected=%d vs. g_counter=%d\n", num_threads,
+                g_counter);
+    }
+    assert(g_counter == num_threads);
+
+    /* Finalize */
+    ret = ATS_finalize(0);
+
+    free(xstreams);
+    free(pools);
+    free(my_pools);
+    free(threads);
+
+    return ret;
+}
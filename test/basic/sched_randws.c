@@ -131,16 +131,28 @@ int main(int argc, char *argv[])
         ATS_ERROR(ret, "ABT_pool_create_basic");
     }
 
-    /* Create schedulers */
+    /* Create schedulers.  Some of them steal one work unit at once (default),
+     * some steal half, and the others steal at most four work units. */
     my_pools = (ABT_pool *)malloc(num_xstreams * sizeof(ABT_pool));
     for (i = 0; i < num_xstreams; i++) {
         for (k = 0; k < num_xstreams; k++) {
             my_pools[k] = pools[(i + k) % num_xstreams];
         }
 
+        ABT_sched_config config = ABT_SCHED_CONFIG_NULL;
+        if (i % 3 != 0) {
+            ret = ABT_sched_config_create(&config, ABT_sched_randws_steal_num,
+                                          (i % 3 == 1) ? 0 : 4,
+                                          ABT_sched_config_var_end);
+            ATS_ERROR(ret, "ABT_sched_config_create");
+        }
         ret = ABT_sched_create_basic(ABT_SCHED_RANDWS, num_xstreams, my_pools,
-                                     ABT_SCHED_CONFIG_NULL, &scheds[i]);
+                                     config, &scheds[i]);
         ATS_ERROR(ret, "ABT_sched_create_basic");
+        if (config != ABT_SCHED_CONFIG_NULL) {
+            ret = ABT_sched_config_free(&config);
+            ATS_ERROR(ret, "ABT_sched_config_free");
+        }
     }
     free(my_pools);
 
@@ -0,0 +1,168 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+/* This test checks ABT_thread_create_many().  ULTs are created in runs of the
+ * same pool and in alternating pools, with and without ULT attributes.  Every
+ * ULT must run exactly once, and ULTs pushed to the same pool must keep the
+ * order in the pool list. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS 4
+#define DEFAULT_NUM_THREADS 1000
+
+static volatile int *g_flags;
+
+static void thread_func(void *arg)
+{
+    int index = (int)(intptr_t)arg;
+    ATS_atomic_fetch_add(&g_flags[index], 1);
+}
+
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    int num_threads = DEFAULT_NUM_THREADS;
+    ABT_xstream *xstreams;
+    ABT_pool *pools, order_pool;
+    ABT_pool *pool_list;
+    void (**func_list)(void *);
+    void **arg_list;
+    ABT_thread *threads;
+    ABT_thread_attr attrs[3];
+    int i, k, named, ret;
+
+    /* Initialize */
+    ATS_read_args(argc, argv);
+    if (argc > 1) {
+        num_xstreams = ATS_get_arg_val(ATS_ARG_N_ES);
+        num_threads = ATS_get_arg_val(ATS_ARG_N_ULT);
+    }
+    ATS_init(argc, argv, num_xstreams);
+
+    xstreams = (ABT_xstream *)malloc(num_xstreams * sizeof(ABT_xstream));
+    pools = (ABT_pool *)malloc(num_xstreams * sizeof(ABT_pool));
+    pool_list = (ABT_pool *)malloc(num_threads * sizeof(ABT_pool));
+    func_list =
+        (void (**)(void *))malloc(num_threads * sizeof(void (*)(void *)));
+    arg_list = (void **)malloc(num_threads * sizeof(void *));
+    threads = (ABT_thread *)malloc(num_threads * sizeof(ABT_thread));
+    g_flags = (volatile int *)calloc(num_threads, sizeof(int));
+
+    ret = ABT_xstream_self(&xstreams[0]);
+    ATS_ERROR(ret, "ABT_xstream_self");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_create");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_get_main_pools(xstreams[i], 1, &pools[i]);
+        ATS_ERROR(ret, "ABT_xstream_get_main_pools");
+    }
+
+    /* attrs[0]: default, attrs[1]: default stack size and priority,
+     * attrs[2]: non-default stack size */
+    attrs[0] = ABT_THREAD_ATTR_NULL;
+    ret = ABT_thread_attr_create(&attrs[1]);
+    ATS_ERROR(ret, "ABT_thread_attr_create");
+    ret = ABT_thread_attr_set_priority(attrs[1], 1);
+    ATS_ERROR(ret, "ABT_thread_attr_set_priority");
+    ret = ABT_thread_attr_create(&attrs[2]);
+    ATS_ERROR(ret, "ABT_thread_attr_create");
+    ret = ABT_thread_attr_set_stacksize(attrs[2], 32768);
+    ATS_ERROR(ret, "ABT_thread_attr_set_stacksize");
+
+    for (i = 0; i < num_threads; i++) {
+        func_list[i] = thread_func;
+        arg_list[i] = (void *)(intptr_t)i;
+    }
+
+    for (k = 0; k < 3; k++) {
+        for (named = 0; named < 2; named++) {
+            /* The first half is pushed to pools in runs and the second half is
+             * pushed to pools alternately. */
+            for (i = 0; i < num_threads; i++) {
+                if (i < num_threads / 2) {
+                    pool_list[i] = pools[(i / 100) % num_xstreams];
+                } else {
+                    pool_list[i] = pools[i % num_xstreams];
+                }
+                g_flags[i] = 0;
+            }
+            ret = ABT_thread_create_many(num_threads, pool_list, func_list,
+                                         arg_list, attrs[k],
+                                         named ? threads : NULL);
+            ATS_ERROR(ret, "ABT_thread_create_many");
+            if (named) {
+                ret = ABT_thread_free_many(num_threads, threads);
+                ATS_ERROR(ret, "ABT_thread_free_many");
+            }
+            for (i = 0; i < num_threads; i++) {
+                while (g_flags[i] == 0) {
+                    ret = ABT_thread_yield();
+                    ATS_ERROR(ret, "ABT_thread_yield");
+                }
+                assert(g_flags[i] == 1);
+            }
+        }
+    }
+
+    /* ULTs pushed to a pool that is not associated with any scheduler must be
+     * in the order of the pool list. */
+    ret = ABT_pool_create_basic(ABT_POOL_FIFO, ABT_POOL_ACCESS_MPMC, ABT_FALSE,
+                                &order_pool);
+    ATS_ERROR(ret, "ABT_pool_create_basic");
+    for (i = 0; i < num_threads; i++) {
+        pool_list[i] = order_pool;
+        g_flags[i] = 0;
+    }
+    ret = ABT_thread_create_many(num_threads, pool_list, func_list, arg_list,
+                                 ABT_THREAD_ATTR_NULL, threads);
+    ATS_ERROR(ret, "ABT_thread_create_many");
+    for (i = 0; i < num_threads; i++) {
+        ABT_thread thread;
+        ret = ABT_pool_pop_thread(order_pool, &thread);
+        ATS_ERROR(ret, "ABT_pool_pop_thread");
+        assert(thread == threads[i]);
+        ret = ABT_pool_push_thread(pools[i % num_xstreams], thread);
+        ATS_ERROR(ret, "ABT_pool_push_thread");
+    }
+    ret = ABT_thread_free_many(num_threads, threads);
+    ATS_ERROR(ret, "ABT_thread_free_many");
+    for (i = 0; i < num_threads; i++) {
+        assert(g_flags[i] == 1);
+    }
+    ret = ABT_pool_free(&order_pool);
+    ATS_ERROR(ret, "ABT_pool_free");
+
+    for (k = 1; k < 3; k++) {
+        ret = ABT_thread_attr_free(&attrs[k]);
+        ATS_ERROR(ret, "ABT_thread_attr_free");
+    }
+
+    /* Join and free Execution Streams */
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_free");
+    }
+
+    /* Finalize */
+    ret = ATS_finalize(0);
+
+    free(xstreams);
+    free(pools);
+    free(pool_list);
+    free(func_list);
+    free(arg_list);
+    free(threads);
+    free((void *)g_flags);
+
+    return ret;
+}
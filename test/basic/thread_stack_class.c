@@ -0,0 +1,170 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+/* This test checks ULTs that have non-default stack sizes, which are taken
+ * from memory pools of stack size classes.  ULTs are repeatedly created on
+ * multiple execution streams, consume their stacks, and are freed by either
+ * the primary ULT or an external thread so that stacks are returned to
+ * different local pools. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS 4
+#define DEFAULT_NUM_THREADS 16
+#define NUM_ROUNDS 4
+
+#define DUMMY_SIZE ((int)(1024 / sizeof(double)))
+
+static int num_xstreams = DEFAULT_NUM_XSTREAMS;
+static int num_threads = DEFAULT_NUM_THREADS;
+static ABT_thread *g_threads;
+static volatile int g_ext_done;
+
+/* The last one is larger than the default maximum size of stack size
+ * classes. */
+static size_t stacksizes[] = { 20 * 1024, 64 * 1024, 256 * 1024,
+                               2 * 1024 * 1024 };
+
+static void dummy_rec(volatile double *top_dummy, volatile double *prev_dummy,
+                      size_t stacksize)
+{
+    int i;
+    volatile double dummy[DUMMY_SIZE];
+    for (i = 0; i < DUMMY_SIZE; i++)
+        dummy[i] = prev_dummy[i] + i;
+    uintptr_t dummy_ptr = (uintptr_t)dummy;
+    uintptr_t top_dummy_ptr = (uintptr_t)top_dummy;
+    size_t used = (top_dummy_ptr > dummy_ptr) ? (top_dummy_ptr - dummy_ptr)
+                                              : (dummy_ptr - top_dummy_ptr);
+    if (used > stacksize / 2)
+        return;
+    dummy_rec(top_dummy, dummy, stacksize);
+    /* Avoid tail recursion elimination. */
+    for (i = 0; i < DUMMY_SIZE; i++)
+        prev_dummy[i] += dummy[i];
+}
+
+static void thread_func(void *arg)
+{
+    size_t stacksize = *((size_t *)arg), stacksize2;
+    ABT_thread thread;
+    ABT_thread_attr attr;
+    int i, ret;
+
+    ret = ABT_self_get_thread(&thread);
+    ATS_ERROR(ret, "ABT_self_get_thread");
+    ret = ABT_thread_get_attr(thread, &attr);
+    ATS_ERROR(ret, "ABT_thread_get_attr");
+    ret = ABT_thread_attr_get_stacksize(attr, &stacksize2);
+    ATS_ERROR(ret, "ABT_thread_attr_get_stacksize");
+    assert(stacksize == stacksize2);
+    ret = ABT_thread_attr_free(&attr);
+    ATS_ERROR(ret, "ABT_thread_attr_free");
+
+    volatile double dummy[DUMMY_SIZE];
+    for (i = 0; i < DUMMY_SIZE; i++)
+        dummy[i] = (double)i;
+    dummy_rec(dummy, dummy, stacksize);
+}
+
+static void *ext_thread_func(void *arg)
+{
+    int i, ret;
+    ATS_UNUSED(arg);
+    for (i = 0; i < num_threads; i += 2) {
+        ret = ABT_thread_free(&g_threads[i]);
+        ATS_ERROR(ret, "ABT_thread_free");
+    }
+    ATS_atomic_store(&g_ext_done, 1);
+    return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+    ABT_xstream *xstreams;
+    ABT_pool *pools;
+    int i, k, round, ret;
+
+    /* Initialize */
+    ATS_read_args(argc, argv);
+    if (argc > 1) {
+        num_xstreams = ATS_get_arg_val(ATS_ARG_N_ES);
+        num_threads = ATS_get_arg_val(ATS_ARG_N_ULT);
+    }
+    ATS_init(argc, argv, num_xstreams);
+
+    xstreams = (ABT_xstream *)malloc(num_xstreams * sizeof(ABT_xstream));
+    pools = (ABT_pool *)malloc(num_xstreams * sizeof(ABT_pool));
+    g_threads = (ABT_thread *)malloc(num_threads * sizeof(ABT_thread));
+
+    ret = ABT_xstream_self(&xstreams[0]);
+    ATS_ERROR(ret, "ABT_xstream_self");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_create");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_get_main_pools(xstreams[i], 1, &pools[i]);
+        ATS_ERROR(ret, "ABT_xstream_get_main_pools");
+    }
+
+    for (round = 0; round < NUM_ROUNDS; round++) {
+        for (k = 0; k < (int)(sizeof(stacksizes) / sizeof(stacksizes[0]));
+             k++) {
+            ABT_thread_attr attr;
+            pthread_t ext_thread;
+            ret = ABT_thread_attr_create(&attr);
+            ATS_ERROR(ret, "ABT_thread_attr_create");
+            ret = ABT_thread_attr_set_stacksize(attr, stacksizes[k]);
+            ATS_ERROR(ret, "ABT_thread_attr_set_stacksize");
+            for (i = 0; i < num_threads; i++) {
+                ret = ABT_thread_create(pools[(i + round) % num_xstreams],
+                                        thread_func, (void *)&stacksizes[k],
+                                        attr, &g_threads[i]);
+                ATS_ERROR(ret, "ABT_thread_create");
+            }
+            ret = ABT_thread_attr_free(&attr);
+            ATS_ERROR(ret, "ABT_thread_attr_free");
+
+            /* An external thread frees ULTs of even indices. */
+            g_ext_done = 0;
+            ret = pthread_create(&ext_thread, NULL, ext_thread_func, NULL);
+            assert(ret == 0);
+            for (i = 1; i < num_threads; i += 2) {
+                ret = ABT_thread_free(&g_threads[i]);
+                ATS_ERROR(ret, "ABT_thread_free");
+            }
+            /* ULTs in the primary pool must keep running while the external
+             * thread is freeing ULTs. */
+            while (ATS_atomic_load(&g_ext_done) == 0) {
+                ret = ABT_thread_yield();
+                ATS_ERROR(ret, "ABT_thread_yield");
+            }
+            ret = pthread_join(ext_thread, NULL);
+            assert(ret == 0);
+        }
+    }
+
+    /* Join and free Execution Streams */
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_free");
+    }
+
+    /* Finalize */
+    ret = ATS_finalize(0);
+
+    free(xstreams);
+    free(pools);
+    free(g_threads);
+
+    return ret;
+}
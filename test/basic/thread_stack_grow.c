@@ -0,0 +1,128 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+/* This test checks growable ULT stacks (ABT_STACK_GROW_MAX_SIZE).  ULTs of
+ * even indices use much more stack than the initially accessible size, so
+ * their stacks grow, while the other ULTs use only a small part of their
+ * stacks.  Stacks are recycled over rounds, so grown stacks are shrunk and
+ * grow again. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS 4
+#define DEFAULT_NUM_THREADS 16
+#define NUM_ROUNDS 4
+
+#define DUMMY_SIZE ((int)(1024 / sizeof(double)))
+
+static int num_xstreams = DEFAULT_NUM_XSTREAMS;
+static int num_threads = DEFAULT_NUM_THREADS;
+static size_t g_stacksize;
+
+static void dummy_rec(volatile double *top_dummy, volatile double *prev_dummy,
+                      size_t usage)
+{
+    int i;
+    volatile double dummy[DUMMY_SIZE];
+    for (i = 0; i < DUMMY_SIZE; i++)
+        dummy[i] = prev_dummy[i] + i;
+    uintptr_t dummy_ptr = (uintptr_t)dummy;
+    uintptr_t top_dummy_ptr = (uintptr_t)top_dummy;
+    size_t used = (top_dummy_ptr > dummy_ptr) ? (top_dummy_ptr - dummy_ptr)
+                                              : (dummy_ptr - top_dummy_ptr);
+    if (used > usage)
+        return;
+    dummy_rec(top_dummy, dummy, usage);
+    /* Avoid tail recursion elimination. */
+    for (i = 0; i < DUMMY_SIZE; i++)
+        prev_dummy[i] += dummy[i];
+}
+
+static void thread_func(void *arg)
+{
+    int id = (int)(intptr_t)arg, i, ret;
+    volatile double dummy[DUMMY_SIZE];
+    for (i = 0; i < DUMMY_SIZE; i++)
+        dummy[i] = (double)i;
+    dummy_rec(dummy, dummy, (id % 2 == 0) ? g_stacksize / 2 : 4096);
+    /* Yield so that the stack is kept while other ULTs run. */
+    ret = ABT_thread_yield();
+    ATS_ERROR(ret, "ABT_thread_yield");
+    dummy_rec(dummy, dummy, (id % 2 == 0) ? g_stacksize / 2 : 4096);
+}
+
+int main(int argc, char *argv[])
+{
+    ABT_xstream *xstreams;
+    ABT_pool *pools;
+    ABT_thread *threads;
+    int i, round, ret;
+
+    /* Only the top 16 KB of each 1 MB stack is accessible at first. */
+    setenv("ABT_THREAD_STACKSIZE", "16384", 1);
+    setenv("ABT_STACK_GROW_MAX_SIZE", "1048576", 1);
+
+    /* Initialize */
+    ATS_read_args(argc, argv);
+    if (argc > 1) {
+        num_xstreams = ATS_get_arg_val(ATS_ARG_N_ES);
+        num_threads = ATS_get_arg_val(ATS_ARG_N_ULT);
+    }
+    ATS_init(argc, argv, num_xstreams);
+
+    /* If growable stacks are not supported, the default stack size is not
+     * changed. */
+    ret = ABT_info_query_config(ABT_INFO_QUERY_KIND_DEFAULT_THREAD_STACKSIZE,
+                                &g_stacksize);
+    ATS_ERROR(ret, "ABT_info_query_config");
+
+    xstreams = (ABT_xstream *)malloc(num_xstreams * sizeof(ABT_xstream));
+    pools = (ABT_pool *)malloc(num_xstreams * sizeof(ABT_pool));
+    threads = (ABT_thread *)malloc(num_threads * sizeof(ABT_thread));
+
+    ret = ABT_xstream_self(&xstreams[0]);
+    ATS_ERROR(ret, "ABT_xstream_self");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_create");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_get_main_pools(xstreams[i], 1, &pools[i]);
+        ATS_ERROR(ret, "ABT_xstream_get_main_pools");
+    }
+
+    for (round = 0; round < NUM_ROUNDS; round++) {
+        for (i = 0; i < num_threads; i++) {
+            ret = ABT_thread_create(pools[(i + round) % num_xstreams],
+                                    thread_func, (void *)(intptr_t)i,
+                                    ABT_THREAD_ATTR_NULL, &threads[i]);
+            ATS_ERROR(ret, "ABT_thread_create");
+        }
+        for (i = 0; i < num_threads; i++) {
+            ret = ABT_thread_free(&threads[i]);
+            ATS_ERROR(ret, "ABT_thread_free");
+        }
+    }
+
+    /* Join and free Execution Streams */
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_free");
+    }
+
+    /* Finalize */
+    ret = ATS_finalize(0);
+
+    free(xstreams);
+    free(pools);
+    free(threads);
+
+    return ret;
+}
@@ -0,0 +1,153 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+/* This test checks the stack usage tracking.  All the ULT stacks taken from
+ * memory pools are tracked, so the histogram must count every ULT, and the
+ * maximum usage must reflect the deepest ULT. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS 4
+#define DEFAULT_NUM_THREADS 64
+#define NUM_ROUNDS 3
+#define DEEP_USAGE (8 * 1024)
+
+#define DUMMY_SIZE ((int)(256 / sizeof(double)))
+
+static void dummy_rec(volatile double *top_dummy, volatile double *prev_dummy,
+                      size_t depth)
+{
+    int i;
+    volatile double dummy[DUMMY_SIZE];
+    for (i = 0; i < DUMMY_SIZE; i++)
+        dummy[i] = prev_dummy[i] + i;
+    uintptr_t dummy_ptr = (uintptr_t)dummy;
+    uintptr_t top_dummy_ptr = (uintptr_t)top_dummy;
+    size_t used = (top_dummy_ptr > dummy_ptr) ? (top_dummy_ptr - dummy_ptr)
+                                              : (dummy_ptr - top_dummy_ptr);
+    if (used > depth)
+        return;
+    dummy_rec(top_dummy, dummy, depth);
+    /* Avoid tail recursion elimination. */
+    for (i = 0; i < DUMMY_SIZE; i++)
+        prev_dummy[i] += dummy[i];
+}
+
+static void thread_func(void *arg)
+{
+    int i;
+    size_t depth = (size_t)(intptr_t)arg;
+    volatile double dummy[DUMMY_SIZE];
+    for (i = 0; i < DUMMY_SIZE; i++)
+        dummy[i] = (double)i;
+    if (depth)
+        dummy_rec(dummy, dummy, depth);
+}
+
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    int num_threads = DEFAULT_NUM_THREADS;
+    ABT_xstream *xstreams;
+    ABT_pool *pools;
+    ABT_thread *threads;
+    ABT_thread_attr attr;
+    uint64_t histogram[ABT_INFO_STACK_USAGE_HISTOGRAM_SIZE];
+    uint64_t num_tracked = 0;
+    size_t max_usage;
+    int i, round, ret;
+
+    /* Track all the stacks. */
+    setenv("ABT_STACK_USAGE_SAMPLING", "1", 1);
+    setenv("ABT_STACK_USAGE_KEEP_SIZE", "4096", 1);
+
+    /* Initialize */
+    ATS_read_args(argc, argv);
+    if (argc > 1) {
+        num_xstreams = ATS_get_arg_val(ATS_ARG_N_ES);
+        num_threads = ATS_get_arg_val(ATS_ARG_N_ULT);
+    }
+    ATS_init(argc, argv, num_xstreams);
+
+    xstreams = (ABT_xstream *)malloc(num_xstreams * sizeof(ABT_xstream));
+    pools = (ABT_pool *)malloc(num_xstreams * sizeof(ABT_pool));
+    threads = (ABT_thread *)malloc(num_threads * sizeof(ABT_thread));
+
+    ret = ABT_xstream_self(&xstreams[0]);
+    ATS_ERROR(ret, "ABT_xstream_self");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_create");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_get_main_pools(xstreams[i], 1, &pools[i]);
+        ATS_ERROR(ret, "ABT_xstream_get_main_pools");
+    }
+
+    /* ULTs of a non-default stack size use stacks of a stack size class. */
+    ret = ABT_thread_attr_create(&attr);
+    ATS_ERROR(ret, "ABT_thread_attr_create");
+    ret = ABT_thread_attr_set_stacksize(attr, 64 * 1024);
+    ATS_ERROR(ret, "ABT_thread_attr_set_stacksize");
+
+    for (round = 0; round < NUM_ROUNDS; round++) {
+        /* Only one ULT goes deep in each round. */
+        for (i = 0; i < num_threads; i++) {
+            size_t depth = (i == round) ? DEEP_USAGE : 0;
+            ret = ABT_thread_create(pools[i % num_xstreams], thread_func,
+                                    (void *)(intptr_t)depth,
+                                    (i % 2) ? attr : ABT_THREAD_ATTR_NULL,
+                                    &threads[i]);
+            ATS_ERROR(ret, "ABT_thread_create");
+        }
+        for (i = 0; i < num_threads; i++) {
+            ret = ABT_thread_free(&threads[i]);
+            ATS_ERROR(ret, "ABT_thread_free");
+        }
+    }
+
+    ret = ABT_thread_attr_free(&attr);
+    ATS_ERROR(ret, "ABT_thread_attr_free");
+
+    ret = ABT_info_query_config(ABT_INFO_QUERY_KIND_STACK_USAGE_HISTOGRAM,
+                                (void *)histogram);
+    ATS_ERROR(ret, "ABT_info_query_config");
+    ret = ABT_info_query_config(ABT_INFO_QUERY_KIND_MAX_STACK_USAGE,
+                                (void *)&max_usage);
+    ATS_ERROR(ret, "ABT_info_query_config");
+    for (i = 0; i < ABT_INFO_STACK_USAGE_HISTOGRAM_SIZE; i++) {
+        ATS_printf(1, "histogram[%d] = %" PRIu64 "\n", i, histogram[i]);
+        num_tracked += histogram[i];
+    }
+    ATS_printf(1, "max. stack usage = %zu\n", max_usage);
+    /* Nothing is tracked if the memory pool is disabled.  Otherwise, every ULT
+     * has a stack taken from a memory pool. */
+    if (num_tracked != 0) {
+        assert(num_tracked == (uint64_t)num_threads * NUM_ROUNDS);
+        assert(max_usage >= DEEP_USAGE && max_usage < 64 * 1024);
+    } else {
+        assert(max_usage == 0);
+    }
+
+    /* Join and free Execution Streams */
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_free");
+    }
+
+    /* Finalize */
+    ret = ATS_finalize(0);
+
+    free(xstreams);
+    free(pools);
+    free(threads);
+
+    return ret;
+}
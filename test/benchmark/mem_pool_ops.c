@@ -0,0 +1,187 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+/* This benchmark measures the LIFOs that global memory pools use to exchange
+ * buckets (ABT_MEM_SHARDED_LIFO).  Every execution stream repeatedly creates
+ * and frees ULTs while each execution stream caches only a few descriptors, so
+ * most of the creation and the free take or return buckets through the global
+ * memory pool. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+enum {
+    T_SINGLE = 0,
+    T_SHARDED,
+    T_LAST
+};
+static char *t_names[] = { "single LIFO", "sharded LIFO" };
+static char *t_envs[] = { "0", "1" };
+
+static int iter;
+static int num_xstreams;
+static int num_threads;
+
+static ABT_xstream_barrier g_xbarrier = ABT_XSTREAM_BARRIER_NULL;
+
+static ABT_pool *g_pools;
+static ABT_thread **g_threads;
+
+static uint64_t *t_times;
+static uint64_t t_all;
+
+void thread_func(void *arg)
+{
+    ATS_UNUSED(arg);
+}
+
+void thread_test(void *arg)
+{
+    int eid = (int)(size_t)arg;
+    ABT_thread *my_threads = g_threads[eid];
+    ABT_pool *pool_list;
+    void (**thread_func_list)(void *);
+    uint64_t t_all_start = 0, t_start;
+    int i;
+
+    pool_list = (ABT_pool *)malloc(num_threads * sizeof(ABT_pool));
+    thread_func_list =
+        (void (**)(void *))malloc(num_threads * sizeof(void (*)(void *)));
+    for (i = 0; i < num_threads; i++) {
+        pool_list[i] = g_pools[eid];
+        thread_func_list[i] = thread_func;
+    }
+
+    /* cache warm-up */
+    ABT_thread_create_many(num_threads, pool_list, thread_func_list, NULL,
+                           ABT_THREAD_ATTR_NULL, my_threads);
+    ABT_thread_free_many(num_threads, my_threads);
+
+    /* measure the time */
+    ABT_xstream_barrier_wait(g_xbarrier);
+    if (eid == 0)
+        t_all_start = ATS_get_cycles();
+    t_start = ATS_get_cycles();
+    for (i = 0; i < iter; i++) {
+        ABT_thread_create_many(num_threads, pool_list, thread_func_list, NULL,
+                               ABT_THREAD_ATTR_NULL, my_threads);
+        ABT_thread_free_many(num_threads, my_threads);
+    }
+    t_times[eid] = (ATS_get_cycles() - t_start) / (iter * num_threads);
+    ABT_xstream_barrier_wait(g_xbarrier);
+    if (eid == 0)
+        t_all = (ATS_get_cycles() - t_all_start) / iter;
+
+    free(pool_list);
+    free(thread_func_list);
+}
+
+int main(int argc, char *argv[])
+{
+    int i, t;
+    uint64_t t_avg[T_LAST], t_min[T_LAST], t_max[T_LAST], t_alls[T_LAST];
+    char snprintf_buffer[128];
+    ABT_xstream *xstreams;
+
+    /* read command-line arguments */
+    ATS_read_args(argc, argv);
+    num_xstreams = ATS_get_arg_val(ATS_ARG_N_ES);
+    num_threads = ATS_get_arg_val(ATS_ARG_N_ULT);
+    iter = ATS_get_arg_val(ATS_ARG_N_ITER);
+
+    xstreams = (ABT_xstream *)malloc(num_xstreams * sizeof(ABT_xstream));
+    g_pools = (ABT_pool *)malloc(num_xstreams * sizeof(ABT_pool));
+    g_threads = (ABT_thread **)malloc(num_xstreams * sizeof(ABT_thread *));
+    for (i = 0; i < num_xstreams; i++) {
+        g_threads[i] = (ABT_thread *)malloc(num_threads * sizeof(ABT_thread));
+    }
+    t_times = (uint64_t *)calloc(num_xstreams, sizeof(uint64_t));
+
+    /* Each ES keeps two buckets of eight descriptors. */
+    sprintf(snprintf_buffer, "%d", num_xstreams);
+    setenv("ABT_MAX_NUM_XSTREAMS", snprintf_buffer, 1);
+    setenv("ABT_MEM_NUM_LOCAL_BUCKETS", "2", 1);
+    setenv("ABT_MEM_MAX_NUM_DESCS", "16", 1);
+    setenv("ABT_MEM_MAX_NUM_STACKS", "16", 1);
+
+    for (t = 0; t < T_LAST; t++) {
+        /* Argobots reads environmental variables when it is initialized. */
+        setenv("ABT_MEM_SHARDED_LIFO", t_envs[t], 1);
+        ABT_init(argc, argv);
+
+        ABT_xstream_barrier_create(num_xstreams, &g_xbarrier);
+        for (i = 0; i < num_xstreams; i++) {
+            ABT_pool_create_basic(ABT_POOL_FIFO, ABT_POOL_ACCESS_PRIV, ABT_TRUE,
+                                  &g_pools[i]);
+        }
+        for (i = 1; i < num_xstreams; i++) {
+            ABT_thread_create(g_pools[i], thread_test, (void *)(size_t)i,
+                              ABT_THREAD_ATTR_NULL, NULL);
+        }
+        ABT_xstream_self(&xstreams[0]);
+        ABT_xstream_set_main_sched_basic(xstreams[0], ABT_SCHED_DEFAULT, 1,
+                                         &g_pools[0]);
+        for (i = 1; i < num_xstreams; i++) {
+            ABT_xstream_create_basic(ABT_SCHED_DEFAULT, 1, &g_pools[i],
+                                     ABT_SCHED_CONFIG_NULL, &xstreams[i]);
+        }
+
+        /* execute thread_test() using the primary ULT */
+        thread_test((void *)0);
+
+        for (i = 1; i < num_xstreams; i++) {
+            ABT_xstream_join(xstreams[i]);
+            ABT_xstream_free(&xstreams[i]);
+        }
+        ABT_xstream_barrier_free(&g_xbarrier);
+        ABT_finalize();
+
+        t_avg[t] = 0;
+        t_min[t] = UINTMAX_MAX;
+        t_max[t] = 0;
+        for (i = 0; i < num_xstreams; i++) {
+            if (t_times[i] < t_min[t])
+                t_min[t] = t_times[i];
+            if (t_times[i] > t_max[t])
+                t_max[t] = t_times[i];
+            t_avg[t] += t_times[i];
+        }
+        t_avg[t] = t_avg[t] / num_xstreams;
+        t_alls[t] = t_all;
+    }
+
+    /* output */
+    int line_size = 66;
+    ATS_print_line(stdout, '-', line_size);
+    printf("%s\n", "Argobots");
+    ATS_print_line(stdout, '-', line_size);
+    printf("# of ESs        : %d\n", num_xstreams);
+    printf("# of ULTs per ES: %d\n", num_threads);
+    ATS_print_line(stdout, '-', line_size);
+    printf("Avg. create_many/free_many time per ULT (in cycles, %d times)\n",
+           iter);
+    ATS_print_line(stdout, '-', line_size);
+    printf("%-18s %11s %11s %11s %11s\n", "bucket LIFO", "avg", "min", "max",
+           "all");
+    ATS_print_line(stdout, '-', line_size);
+    for (t = 0; t < T_LAST; t++) {
+        printf("%-18s %11" PRIu64 " %11" PRIu64 " %11" PRIu64 " %11" PRIu64
+               "\n",
+               t_names[t], t_avg[t], t_min[t], t_max[t], t_alls[t]);
+    }
+    ATS_print_line(stdout, '-', line_size);
+
+    free(xstreams);
+    free(g_pools);
+    for (i = 0; i < num_xstreams; i++) {
+        free(g_threads[i]);
+    }
+    free(g_threads);
+    free(t_times);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,196 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+/* This benchmark measures the throughput of push and pop operations on a
+ * shared MPMC pool while changing the number of execution streams that access
+ * the pool concurrently. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+enum {
+    T_POOL_FIFO = 0,
+    T_POOL_FIFO_LOCKFREE,
+    T_LAST
+};
+static char *t_names[] = {
+    "FIFO",
+    "FIFO_LOCKFREE",
+};
+static ABT_pool_kind t_kinds[] = {
+    ABT_POOL_FIFO,
+    ABT_POOL_FIFO_LOCKFREE,
+};
+
+typedef struct {
+    int eid; /* ES id */
+} launch_t;
+
+static int iter;
+static int num_xstreams;
+static int num_threads;
+
+static ABT_pool g_pool = ABT_POOL_NULL;
+static ABT_barrier g_barrier = ABT_BARRIER_NULL;
+static double g_time_start;
+static double g_time_end;
+
+static void dummy_func(void *arg)
+{
+    ATS_UNUSED(arg);
+}
+
+static void push_pop(void *arg)
+{
+    launch_t *my_arg = (launch_t *)arg;
+    int i;
+
+    ABT_barrier_wait(g_barrier);
+    if (my_arg->eid == 0)
+        g_time_start = ABT_get_wtime();
+
+    for (i = 0; i < iter; i++) {
+        ABT_thread thread = ABT_THREAD_NULL;
+        while (thread == ABT_THREAD_NULL) {
+            ABT_pool_pop_thread(g_pool, &thread);
+        }
+        ABT_pool_push_thread(g_pool, thread);
+    }
+
+    ABT_barrier_wait(g_barrier);
+    if (my_arg->eid == 0)
+        g_time_end = ABT_get_wtime();
+}
+
+int main(int argc, char *argv[])
+{
+    ABT_xstream *xstreams;
+    ABT_pool *pools;
+    ABT_thread *threads;
+    ABT_thread *workers;
+    launch_t *largs;
+    double *t_mops;
+    int i, k, n, num_counts;
+
+    /* read command-line arguments */
+    ATS_read_args(argc, argv);
+    num_xstreams = ATS_get_arg_val(ATS_ARG_N_ES);
+    num_threads = ATS_get_arg_val(ATS_ARG_N_ULT);
+    iter = ATS_get_arg_val(ATS_ARG_N_ITER);
+
+    /* initialize */
+    ATS_init(argc, argv, num_xstreams);
+
+    xstreams = (ABT_xstream *)malloc(num_xstreams * sizeof(ABT_xstream));
+    pools = (ABT_pool *)malloc(num_xstreams * sizeof(ABT_pool));
+    threads =
+        (ABT_thread *)malloc(num_xstreams * num_threads * sizeof(ABT_thread));
+    workers = (ABT_thread *)malloc(num_xstreams * sizeof(ABT_thread));
+    largs = (launch_t *)malloc(num_xstreams * sizeof(launch_t));
+    /* The number of ESs is doubled each time: 1, 2, 4, ..., num_xstreams. */
+    num_counts = 0;
+    for (n = 1; n < num_xstreams; n *= 2)
+        num_counts++;
+    num_counts++;
+    t_mops = (double *)calloc(num_counts * T_LAST, sizeof(double));
+
+    ABT_xstream_self(&xstreams[0]);
+    ABT_xstream_get_main_pools(xstreams[0], 1, &pools[0]);
+    for (i = 1; i < num_xstreams; i++) {
+        ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ABT_xstream_get_main_pools(xstreams[i], 1, &pools[i]);
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        largs[i].eid = i;
+    }
+
+    for (k = 0; k < T_LAST; k++) {
+        /* g_pool is not associated with any scheduler, so ULTs in g_pool are
+         * never executed during the measurement. */
+        ABT_pool_create_basic(t_kinds[k], ABT_POOL_ACCESS_MPMC, ABT_FALSE,
+                              &g_pool);
+        for (i = 0; i < num_xstreams * num_threads; i++) {
+            ABT_thread_create(g_pool, dummy_func, NULL, ABT_THREAD_ATTR_NULL,
+                              &threads[i]);
+        }
+
+        int c = 0;
+        for (n = 1;; n = (n * 2 < num_xstreams) ? n * 2 : num_xstreams) {
+            ABT_barrier_create(n, &g_barrier);
+            for (i = 1; i < n; i++) {
+                ABT_thread_create(pools[i], push_pop, (void *)&largs[i],
+                                  ABT_THREAD_ATTR_NULL, &workers[i]);
+            }
+            push_pop((void *)&largs[0]);
+            for (i = 1; i < n; i++) {
+                ABT_thread_free(&workers[i]);
+            }
+            ABT_barrier_free(&g_barrier);
+
+            /* One iteration consists of one pop and one push. */
+            t_mops[c * T_LAST + k] =
+                2.0 * iter * n / (g_time_end - g_time_start) / 1.0e6;
+            c++;
+            if (n == num_xstreams)
+                break;
+        }
+
+        /* Move all the ULTs to the main pool to run and free them. */
+        while (1) {
+            ABT_thread thread;
+            ABT_pool_pop_thread(g_pool, &thread);
+            if (thread == ABT_THREAD_NULL)
+                break;
+            ABT_pool_push_thread(pools[0], thread);
+        }
+        for (i = 0; i < num_xstreams * num_threads; i++) {
+            ABT_thread_free(&threads[i]);
+        }
+        ABT_pool_free(&g_pool);
+    }
+
+    for (i = 1; i < num_xstreams; i++) {
+        ABT_xstream_join(xstreams[i]);
+        ABT_xstream_free(&xstreams[i]);
+    }
+
+    /* finalize */
+    ATS_finalize(0);
+
+    /* output */
+    int line_size = 45;
+    ATS_print_line(stdout, '-', line_size);
+    printf("# of ESs         : %d\n", num_xstreams);
+    printf("# of ULTs per ES : %d\n", num_threads);
+    printf("# of push/pop    : %d per ES\n", iter);
+    ATS_print_line(stdout, '-', line_size);
+    printf("Throughput of push+pop (in Mops/s, MPMC pool)\n");
+    ATS_print_line(stdout, '-', line_size);
+    printf("%-6s", "# ESs");
+    for (k = 0; k < T_LAST; k++) {
+        printf("  %15s", t_names[k]);
+    }
+    printf("\n");
+    for (n = 1, i = 0; i < num_counts;
+         n = (n * 2 < num_xstreams) ? n * 2 : num_xstreams, i++) {
+        printf("%-6d", n);
+        for (k = 0; k < T_LAST; k++) {
+            printf("  %15.3f", t_mops[i * T_LAST + k]);
+        }
+        printf("\n");
+    }
+    ATS_print_line(stdout, '-', line_size);
+
+    free(xstreams);
+    free(pools);
+    free(threads);
+    free(workers);
+    free(largs);
+    free(t_mops);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,151 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+/* This benchmark measures readers-writer locks.  All the ULTs repeatedly lock
+ * and unlock a single readers-writer lock, and a given ratio of them lock it
+ * as a writer.  It is measured with both reader-preferring and
+ * writer-preferring readers-writer locks. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DATA_SIZE 8
+
+typedef struct {
+    const char *name;
+    int write_permille; /* Writes per 1000 operations */
+    ABT_rwlock_preference preference;
+} rwlock_test_t;
+
+static rwlock_test_t g_tests[] = {
+    { "reader-pref: read only", 0, ABT_RWLOCK_PREFER_READER },
+    { "reader-pref: 0.1% writes", 1, ABT_RWLOCK_PREFER_READER },
+    { "reader-pref: 1% writes", 10, ABT_RWLOCK_PREFER_READER },
+    { "reader-pref: 10% writes", 100, ABT_RWLOCK_PREFER_READER },
+    { "writer-pref: read only", 0, ABT_RWLOCK_PREFER_WRITER },
+    { "writer-pref: 0.1% writes", 1, ABT_RWLOCK_PREFER_WRITER },
+    { "writer-pref: 1% writes", 10, ABT_RWLOCK_PREFER_WRITER },
+    { "writer-pref: 10% writes", 100, ABT_RWLOCK_PREFER_WRITER },
+};
+#define NUM_TESTS ((int)(sizeof(g_tests) / sizeof(g_tests[0])))
+
+static int iter;
+static int num_xstreams;
+static int num_threads;
+
+static ABT_barrier g_barrier = ABT_BARRIER_NULL;
+static ABT_rwlock g_rwlock = ABT_RWLOCK_NULL;
+static int g_write_permille;
+static volatile int g_data[DATA_SIZE];
+
+static uint64_t g_start_cycles;
+static uint64_t g_cycles;
+
+void rwlock_test(void *arg)
+{
+    int tid = (int)(intptr_t)arg;
+    int i, j;
+
+    ABT_barrier_wait(g_barrier);
+    if (tid == 0)
+        g_start_cycles = ATS_get_cycles();
+
+    for (i = 0; i < iter; i++) {
+        /* Spread writes over ULTs. */
+        if ((i + tid * 7) % 1000 < g_write_permille) {
+            ABT_rwlock_wrlock(g_rwlock);
+            for (j = 0; j < DATA_SIZE; j++)
+                g_data[j]++;
+        } else {
+            int sum = 0;
+            ABT_rwlock_rdlock(g_rwlock);
+            for (j = 0; j < DATA_SIZE; j++)
+                sum += g_data[j];
+            ATS_UNUSED(sum);
+        }
+        ABT_rwlock_unlock(g_rwlock);
+    }
+
+    ABT_barrier_wait(g_barrier);
+    if (tid == 0)
+        g_cycles = ATS_get_cycles() - g_start_cycles;
+}
+
+int main(int argc, char *argv[])
+{
+    ABT_xstream *xstreams;
+    ABT_pool *pools;
+    ABT_thread *threads;
+    uint64_t t_cycles[NUM_TESTS];
+    int i, t;
+
+    /* read command-line arguments */
+    ATS_read_args(argc, argv);
+    num_xstreams = ATS_get_arg_val(ATS_ARG_N_ES);
+    num_threads = ATS_get_arg_val(ATS_ARG_N_ULT);
+    iter = ATS_get_arg_val(ATS_ARG_N_ITER);
+    const int num_all_threads = num_xstreams * num_threads;
+
+    /* initialize */
+    ATS_init(argc, argv, num_xstreams);
+
+    xstreams = (ABT_xstream *)malloc(num_xstreams * sizeof(ABT_xstream));
+    pools = (ABT_pool *)malloc(num_xstreams * sizeof(ABT_pool));
+    threads = (ABT_thread *)malloc(num_all_threads * sizeof(ABT_thread));
+
+    ABT_xstream_self(&xstreams[0]);
+    for (i = 1; i < num_xstreams; i++) {
+        ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ABT_xstream_get_main_pools(xstreams[i], 1, &pools[i]);
+    }
+
+    for (t = 0; t < NUM_TESTS; t++) {
+        g_write_permille = g_tests[t].write_permille;
+        ABT_barrier_create(num_all_threads, &g_barrier);
+        ABT_rwlock_create_with_preference(g_tests[t].preference, &g_rwlock);
+        for (i = 0; i < num_all_threads; i++) {
+            ABT_thread_create(pools[i % num_xstreams], rwlock_test,
+                              (void *)(intptr_t)i, ABT_THREAD_ATTR_NULL,
+                              &threads[i]);
+        }
+        for (i = 0; i < num_all_threads; i++) {
+            ABT_thread_free(&threads[i]);
+        }
+        ABT_rwlock_free(&g_rwlock);
+        ABT_barrier_free(&g_barrier);
+        t_cycles[t] = g_cycles / iter;
+    }
+
+    for (i = 1; i < num_xstreams; i++) {
+        ABT_xstream_join(xstreams[i]);
+        ABT_xstream_free(&xstreams[i]);
+    }
+
+    /* finalize */
+    ATS_finalize(0);
+
+    /* output */
+    int line_size = 50;
+    ATS_print_line(stdout, '-', line_size);
+    printf("# of ESs        : %d\n", num_xstreams);
+    printf("# of ULTs per ES: %d\n", num_threads);
+    ATS_print_line(stdout, '-', line_size);
+    printf("Avg. time of all ULTs per iteration (in cycles, %d times)\n", iter);
+    ATS_print_line(stdout, '-', line_size);
+    for (t = 0; t < NUM_TESTS; t++) {
+        printf("%-30s %11" PRIu64 "\n", g_tests[t].name, t_cycles[t]);
+    }
+    ATS_print_line(stdout, '-', line_size);
+
+    free(xstreams);
+    free(pools);
+    free(threads);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,155 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+/* This benchmark measures the idle policies of the basic scheduler.  The
+ * primary execution stream repeatedly sleeps for a given idle period and then
+ * pushes a ULT to a pool of another execution stream.  The benchmark reports
+ * the wakeup latency (the time from the push to the start of the ULT) and the
+ * CPU time that the other execution stream consumes while it is idle. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <time.h>
+#include "abt.h"
+#include "abttest.h"
+
+enum {
+    T_POLLING = 0,
+    T_SPIN_YIELD,
+    T_SPIN_YIELD_PARK,
+    T_LAST
+};
+static char *t_names[] = {
+    "polling",
+    "spin+yield",
+    "spin+yield+park",
+};
+
+#define NUM_IDLE_PERIODS 3
+static double idle_periods[NUM_IDLE_PERIODS] = { 1.0e-5, 1.0e-4, 1.0e-3 };
+
+typedef struct {
+    double wake_time;
+    double cpu_time;
+} sample_t;
+
+static double get_thread_cpu_time(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1.0e-9;
+}
+
+static void wakeup_func(void *arg)
+{
+    sample_t *p_sample = (sample_t *)arg;
+    p_sample->wake_time = ABT_get_wtime();
+    /* This ULT runs on the target execution stream, so this is the CPU time
+     * consumed by it. */
+    p_sample->cpu_time = get_thread_cpu_time();
+}
+
+static void idle_sleep(double secs)
+{
+    struct timespec ts;
+    ts.tv_sec = (time_t)secs;
+    ts.tv_nsec = (long)((secs - (double)(time_t)secs) * 1.0e9);
+    nanosleep(&ts, NULL);
+}
+
+static ABT_sched_config create_config(int t)
+{
+    ABT_sched_config config = ABT_SCHED_CONFIG_NULL;
+    if (t == T_SPIN_YIELD) {
+        /* Never park. */
+        ABT_sched_config_create(&config, ABT_sched_basic_idle_spin, 100,
+                                ABT_sched_basic_idle_yield, INT_MAX,
+                                ABT_sched_config_var_end);
+    } else if (t == T_SPIN_YIELD_PARK) {
+        ABT_sched_config_create(&config, ABT_sched_basic_idle_spin, 100,
+                                ABT_sched_config_var_end);
+    }
+    return config;
+}
+
+int main(int argc, char *argv[])
+{
+    int i, k, t, iter;
+    double t_latency[NUM_IDLE_PERIODS][T_LAST];
+    double t_cpu[NUM_IDLE_PERIODS][T_LAST];
+
+    /* read command-line arguments */
+    ATS_read_args(argc, argv);
+    iter = ATS_get_arg_val(ATS_ARG_N_ITER);
+
+    /* initialize */
+    ATS_init(argc, argv, 2);
+
+    for (t = 0; t < T_LAST; t++) {
+        for (k = 0; k < NUM_IDLE_PERIODS; k++) {
+            ABT_xstream xstream;
+            ABT_pool pool;
+            ABT_thread thread;
+            sample_t sample, first_sample;
+            double latency_sum = 0.0;
+
+            ABT_sched_config config = create_config(t);
+            ABT_pool_create_basic(ABT_POOL_FIFO, ABT_POOL_ACCESS_MPMC,
+                                  ABT_TRUE, &pool);
+            ABT_xstream_create_basic(ABT_SCHED_BASIC, 1, &pool, config,
+                                     &xstream);
+            if (config != ABT_SCHED_CONFIG_NULL)
+                ABT_sched_config_free(&config);
+
+            /* The first ULT records the start point. */
+            ABT_thread_create(pool, wakeup_func, &first_sample,
+                              ABT_THREAD_ATTR_NULL, &thread);
+            ABT_thread_free(&thread);
+
+            for (i = 0; i < iter; i++) {
+                idle_sleep(idle_periods[k]);
+                double start_time = ABT_get_wtime();
+                ABT_thread_create(pool, wakeup_func, &sample,
+                                  ABT_THREAD_ATTR_NULL, &thread);
+                ABT_thread_free(&thread);
+                latency_sum += sample.wake_time - start_time;
+            }
+            t_latency[k][t] = latency_sum / iter * 1.0e6;
+            /* CPU usage of the target execution stream in percent. */
+            t_cpu[k][t] = (sample.cpu_time - first_sample.cpu_time) /
+                          (sample.wake_time - first_sample.wake_time) * 100.0;
+
+            ABT_xstream_join(xstream);
+            ABT_xstream_free(&xstream);
+        }
+    }
+
+    /* finalize */
+    ATS_finalize(0);
+
+    /* output */
+    int line_size = 63;
+    ATS_print_line(stdout, '-', line_size);
+    printf("# of iterations  : %d per idle period\n", iter);
+    ATS_print_line(stdout, '-', line_size);
+    printf("Wakeup latency (in us) / CPU usage while idle (in %%)\n");
+    ATS_print_line(stdout, '-', line_size);
+    printf("%-10s", "idle [us]");
+    for (t = 0; t < T_LAST; t++) {
+        printf("  %17s", t_names[t]);
+    }
+    printf("\n");
+    for (k = 0; k < NUM_IDLE_PERIODS; k++) {
+        printf("%-10.0f", idle_periods[k] * 1.0e6);
+        for (t = 0; t < T_LAST; t++) {
+            printf("  %9.2f /%5.1f%%", t_latency[k][t], t_cpu[k][t]);
+        }
+        printf("\n");
+    }
+    ATS_print_line(stdout, '-', line_size);
+
+    return EXIT_SUCCESS;
+}
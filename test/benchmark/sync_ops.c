@@ -8,6 +8,12 @@
 #include "abt.h"
 #include "abttest.h"
 
+/* "mutex: lock/yield/unlock" yields while holding a mutex, so most ULTs are
+ * blocked on the mutex.  It measures how the mutex hands over the lock to
+ * waiters (ABT_MUTEX_MAX_HANDOVERS and ABT_MUTEX_MAX_WAKEUPS).  "qmutex" is a
+ * queued mutex (ABT_mutex_attr_set_queued()).  "barrier: arrive/wait_phase"
+ * uses the split-phase barrier operations. */
+
 enum {
     T_MUTEX_CREATE_COLD = 0,
     T_MUTEX_FREE_COLD,
@@ -17,6 +23,16 @@ enum {
     T_MUTEX_CREATE_FREE,
     T_MUTEX_LOCK_UNLOCK,
     T_MUTEX_LOCK_UNLOCK_ALL,
+    T_MUTEX_LOCK_YIELD_UNLOCK,
+    T_MUTEX_LOCK_YIELD_UNLOCK_ALL,
+    T_QMUTEX_LOCK_UNLOCK,
+    T_QMUTEX_LOCK_UNLOCK_ALL,
+    T_QMUTEX_LOCK_YIELD_UNLOCK,
+    T_QMUTEX_LOCK_YIELD_UNLOCK_ALL,
+    T_BARRIER_WAIT,
+    T_BARRIER_WAIT_ALL,
+    T_BARRIER_ARRIVE_WAIT_PHASE,
+    T_BARRIER_ARRIVE_WAIT_PHASE_ALL,
     T_LAST
 };
 static char *t_names[] = {
@@ -28,6 +44,16 @@ static char *t_names[] = {
     "mutex: create/free",
     "mutex: lock/unlock",
     "mutex: lock/unlock (all)",
+    "mutex: lock/yield/unlock",
+    "mutex: lock/yield/unlock (all)",
+    "qmutex: lock/unlock",
+    "qmutex: lock/unlock (all)",
+    "qmutex: lock/yield/unlock",
+    "qmutex: lock/yield/unlock (all)",
+    "barrier: wait",
+    "barrier: wait (all)",
+    "barrier: arrive/wait_phase",
+    "barrier: arrive/wait_phase (all)",
 };
 
 typedef struct {
@@ -38,6 +64,7 @@ typedef struct {
 typedef struct {
     int eid;
     int tid;
+    int test_kind;
 } arg_t;
 
 static int iter;
@@ -83,7 +110,91 @@ void mutex_lock_unlock(void *arg)
     /* stop timer */
     if (eid == 0 && tid == 0) {
         ABT_timer_stop_and_read(timer, &t_time);
-        t_timers[T_MUTEX_LOCK_UNLOCK] = (t_time - t_overhead) / iter;
+        t_timers[my_arg->test_kind] = (t_time - t_overhead) / iter;
+        ABT_timer_free(&timer);
+    }
+}
+
+void mutex_lock_yield_unlock(void *arg)
+{
+    arg_t *my_arg = (arg_t *)arg;
+    int eid = my_arg->eid;
+    int tid = my_arg->tid;
+
+    ABT_timer timer;
+    double t_time;
+    int i;
+
+    if (eid == 0 && tid == 0) {
+        ABT_timer_create(&timer);
+    }
+
+    /* barrier */
+    ABT_barrier_wait(g_barrier);
+
+    /* start timer */
+    if (eid == 0 && tid == 0)
+        ABT_timer_start(timer);
+
+    /* measure mutex lock/unlock time while the mutex is contended */
+    for (i = 0; i < iter; i++) {
+        ABT_mutex_lock(g_mutex);
+        ABT_thread_yield();
+        ABT_mutex_unlock(g_mutex);
+    }
+
+    /* barrier */
+    ABT_barrier_wait(g_barrier);
+
+    /* stop timer */
+    if (eid == 0 && tid == 0) {
+        ABT_timer_stop_and_read(timer, &t_time);
+        t_timers[my_arg->test_kind] = (t_time - t_overhead) / iter;
+        ABT_timer_free(&timer);
+    }
+}
+
+void barrier_wait(void *arg)
+{
+    arg_t *my_arg = (arg_t *)arg;
+    int eid = my_arg->eid;
+    int tid = my_arg->tid;
+
+    ABT_timer timer;
+    double t_time;
+    uint64_t phase;
+    int i;
+
+    if (eid == 0 && tid == 0) {
+        ABT_timer_create(&timer);
+    }
+
+    /* barrier */
+    ABT_barrier_wait(g_barrier);
+
+    /* start timer */
+    if (eid == 0 && tid == 0)
+        ABT_timer_start(timer);
+
+    /* measure barrier time */
+    if (my_arg->test_kind == T_BARRIER_WAIT) {
+        for (i = 0; i < iter; i++) {
+            ABT_barrier_wait(g_barrier);
+        }
+    } else {
+        for (i = 0; i < iter; i++) {
+            ABT_barrier_arrive(g_barrier, &phase);
+            ABT_barrier_wait_phase(g_barrier, phase);
+        }
+    }
+
+    /* barrier */
+    ABT_barrier_wait(g_barrier);
+
+    /* stop timer */
+    if (eid == 0 && tid == 0) {
+        ABT_timer_stop_and_read(timer, &t_time);
+        t_timers[my_arg->test_kind] = (t_time - t_overhead) / iter;
         ABT_timer_free(&timer);
     }
 }
@@ -104,8 +215,17 @@ void launch_test(void *arg)
 
     switch (test_kind) {
         case T_MUTEX_LOCK_UNLOCK:
+        case T_QMUTEX_LOCK_UNLOCK:
             test_fn = mutex_lock_unlock;
             break;
+        case T_MUTEX_LOCK_YIELD_UNLOCK:
+        case T_QMUTEX_LOCK_YIELD_UNLOCK:
+            test_fn = mutex_lock_yield_unlock;
+            break;
+        case T_BARRIER_WAIT:
+        case T_BARRIER_ARRIVE_WAIT_PHASE:
+            test_fn = barrier_wait;
+            break;
         default:
             fprintf(stderr, "Unknown test kind!\n");
             exit(EXIT_FAILURE);
@@ -120,6 +240,7 @@ void launch_test(void *arg)
     for (i = 0; i < num_threads; i++) {
         args[i].eid = eid;
         args[i].tid = i;
+        args[i].test_kind = test_kind;
         ABT_thread_create(pool, test_fn, (void *)&args[i], ABT_THREAD_ATTR_NULL,
                           &threads[i]);
     }
@@ -132,6 +253,49 @@ void launch_test(void *arg)
     free(args);
 }
 
+void run_test(int test_kind, ABT_xstream *xstreams, ABT_pool *pools)
+{
+    launch_t *largs;
+    int i;
+
+    largs = (launch_t *)malloc(num_xstreams * sizeof(launch_t));
+    ABT_barrier_create(num_xstreams * num_threads, &g_barrier);
+    if (test_kind == T_QMUTEX_LOCK_UNLOCK ||
+        test_kind == T_QMUTEX_LOCK_YIELD_UNLOCK) {
+        ABT_mutex_attr mutex_attr;
+        ABT_mutex_attr_create(&mutex_attr);
+        ABT_mutex_attr_set_queued(mutex_attr, ABT_TRUE);
+        ABT_mutex_create_with_attr(mutex_attr, &g_mutex);
+        ABT_mutex_attr_free(&mutex_attr);
+    } else {
+        ABT_mutex_create(&g_mutex);
+    }
+
+    ABT_xstream_self(&xstreams[0]);
+    for (i = 1; i < num_xstreams; i++) {
+        ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+    }
+    for (i = 1; i < num_xstreams; i++) {
+        ABT_xstream_get_main_pools(xstreams[i], 1, &pools[i]);
+        largs[i].eid = i;
+        largs[i].test_kind = test_kind;
+        ABT_thread_create(pools[i], launch_test, (void *)&largs[i],
+                          ABT_THREAD_ATTR_NULL, NULL);
+    }
+
+    largs[0].eid = 0;
+    largs[0].test_kind = test_kind;
+    launch_test((void *)&largs[0]);
+
+    for (i = 1; i < num_xstreams; i++) {
+        ABT_xstream_join(xstreams[i]);
+        ABT_xstream_free(&xstreams[i]);
+    }
+    ABT_barrier_free(&g_barrier);
+    ABT_mutex_free(&g_mutex);
+    free(largs);
+}
+
 int main(int argc, char *argv[])
 {
     ABT_xstream *xstreams;
@@ -139,7 +303,6 @@ int main(int argc, char *argv[])
     ABT_thread *threads;
     ABT_mutex *mutexes;
     ABT_timer timer;
-    launch_t *largs;
     double t_time;
     int i;
 
@@ -207,44 +370,46 @@ int main(int argc, char *argv[])
 
     /* mutex lock/unlock time */
     ABT_timer_start(timer);
+    run_test(T_MUTEX_LOCK_UNLOCK, xstreams, pools);
+    ABT_timer_stop_and_read(timer, &t_time);
+    t_timers[T_MUTEX_LOCK_UNLOCK_ALL] = (t_time - t_overhead) / iter;
 
-    largs = (launch_t *)malloc(num_xstreams * sizeof(launch_t));
-    ABT_barrier_create(num_xstreams * num_threads, &g_barrier);
-    ABT_mutex_create(&g_mutex);
+    /* mutex lock/yield/unlock time */
+    ABT_timer_start(timer);
+    run_test(T_MUTEX_LOCK_YIELD_UNLOCK, xstreams, pools);
+    ABT_timer_stop_and_read(timer, &t_time);
+    t_timers[T_MUTEX_LOCK_YIELD_UNLOCK_ALL] = (t_time - t_overhead) / iter;
 
-    ABT_xstream_self(&xstreams[0]);
-    for (i = 1; i < num_xstreams; i++) {
-        ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
-    }
-    for (i = 1; i < num_xstreams; i++) {
-        ABT_xstream_get_main_pools(xstreams[i], 1, &pools[i]);
-        largs[i].eid = i;
-        largs[i].test_kind = T_MUTEX_LOCK_UNLOCK;
-        ABT_thread_create(pools[i], launch_test, (void *)&largs[i],
-                          ABT_THREAD_ATTR_NULL, NULL);
-    }
+    /* queued mutex lock/unlock time */
+    ABT_timer_start(timer);
+    run_test(T_QMUTEX_LOCK_UNLOCK, xstreams, pools);
+    ABT_timer_stop_and_read(timer, &t_time);
+    t_timers[T_QMUTEX_LOCK_UNLOCK_ALL] = (t_time - t_overhead) / iter;
 
-    largs[0].eid = 0;
-    largs[0].test_kind = T_MUTEX_LOCK_UNLOCK;
-    launch_test((void *)&largs[0]);
+    /* queued mutex lock/yield/unlock time */
+    ABT_timer_start(timer);
+    run_test(T_QMUTEX_LOCK_YIELD_UNLOCK, xstreams, pools);
+    ABT_timer_stop_and_read(timer, &t_time);
+    t_timers[T_QMUTEX_LOCK_YIELD_UNLOCK_ALL] = (t_time - t_overhead) / iter;
 
-    for (i = 1; i < num_xstreams; i++) {
-        ABT_xstream_join(xstreams[i]);
-        ABT_xstream_free(&xstreams[i]);
-    }
-    ABT_barrier_free(&g_barrier);
-    ABT_mutex_free(&g_mutex);
-    free(largs);
+    /* barrier wait time */
+    ABT_timer_start(timer);
+    run_test(T_BARRIER_WAIT, xstreams, pools);
+    ABT_timer_stop_and_read(timer, &t_time);
+    t_timers[T_BARRIER_WAIT_ALL] = (t_time - t_overhead) / iter;
 
+    /* barrier arrive/wait_phase time */
+    ABT_timer_start(timer);
+    run_test(T_BARRIER_ARRIVE_WAIT_PHASE, xstreams, pools);
     ABT_timer_stop_and_read(timer, &t_time);
-    t_timers[T_MUTEX_LOCK_UNLOCK_ALL] = (t_time - t_overhead) / iter;
+    t_timers[T_BARRIER_ARRIVE_WAIT_PHASE_ALL] = (t_time - t_overhead) / iter;
 
     /* finalize */
     ABT_timer_free(&timer);
     ATS_finalize(0);
 
     /* output */
-    int line_size = 45;
+    int line_size = 50;
     ATS_print_line(stdout, '-', line_size);
     printf("# of ESs        : %d\n", num_xstreams);
     printf("# of ULTs per ES: %d\n", num_threads);
@@ -252,7 +417,7 @@ int main(int argc, char *argv[])
     printf("Avg. execution time (in seconds, %d times)\n", iter);
     ATS_print_line(stdout, '-', line_size);
     for (i = 0; i < T_LAST; i++) {
-        printf("%-25s  %.9f\n", t_names[i], t_timers[i]);
+        printf("%-32s  %.9f\n", t_names[i], t_timers[i]);
     }
     ATS_print_line(stdout, '-', line_size);
 
@@ -146,8 +146,10 @@ ABT_sched create_sched_basic(ABT_sched_predef predef, int automatic,
     ABT_sched_config sched_config;
     if (!automatic) {
         sched_config = (ABT_sched_config)RAND_PTR;
+        /* ABT_sched_basic_idle_spin is ignored by the other schedulers. */
         ret = ABT_sched_config_create(&sched_config, ABT_sched_config_automatic,
-                                      ABT_FALSE, ABT_sched_config_var_end);
+                                      ABT_FALSE, ABT_sched_basic_idle_spin, 0,
+                                      ABT_sched_config_var_end);
         if (ret != ABT_SUCCESS) {
             assert(sched_config == (ABT_sched_config)RAND_PTR);
             ret = ABT_pool_free(&pools[1]);
@@ -378,7 +380,8 @@ int main()
 #ifdef COMPLETE_CHECK
     ABT_sched_predef predefs[] = { ABT_SCHED_DEFAULT,    ABT_SCHED_BASIC,
                                    ABT_SCHED_PRIO,       ABT_SCHED_RANDWS,
-                                   ABT_SCHED_BASIC_WAIT, SCHED_PREDEF_USER };
+                                   ABT_SCHED_BASIC_WAIT, ABT_SCHED_HRANDWS,
+                                   ABT_SCHED_EDF,        SCHED_PREDEF_USER };
 #else
     ABT_sched_predef predefs[] = { ABT_SCHED_DEFAULT, SCHED_PREDEF_USER };
 #endif
@@ -402,7 +405,8 @@ int main()
 #ifndef COMPLETE_CHECK
     ABT_sched_predef extra_predefs[] = { ABT_SCHED_BASIC, ABT_SCHED_PRIO,
                                          ABT_SCHED_RANDWS,
-                                         ABT_SCHED_BASIC_WAIT };
+                                         ABT_SCHED_BASIC_WAIT,
+                                         ABT_SCHED_HRANDWS, ABT_SCHED_EDF };
     for (i = 0; i < (int)(sizeof(extra_predefs) / sizeof(extra_predefs[0]));
          i++) {
         for (automatic = 0; automatic <= 1; automatic++) {